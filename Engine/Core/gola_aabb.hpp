@@ -0,0 +1,52 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm.hpp>
+
+// std
+#include <limits>
+
+namespace gola {
+    // 轴对齐包围盒. 默认构造为空盒 (min > max), 与任何盒合并都得到另一个盒
+    struct GolaAabb {
+        glm::vec3 min{std::numeric_limits<float>::max()};
+        glm::vec3 max{-std::numeric_limits<float>::max()};
+
+        static GolaAabb fromSphere(const glm::vec3 &center, float radius) {
+            return {center - glm::vec3(radius), center + glm::vec3(radius)};
+        }
+
+        static GolaAabb merge(const GolaAabb &a, const GolaAabb &b) {
+            return {glm::min(a.min, b.min), glm::max(a.max, b.max)};
+        }
+
+        void expand(const GolaAabb &other) {
+            min = glm::min(min, other.min);
+            max = glm::max(max, other.max);
+        }
+
+        void expand(const glm::vec3 &point) {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+
+        glm::vec3 center() const { return (min + max) * 0.5f; }
+        glm::vec3 extent() const { return max - min; }
+
+        // SAH 只比较相对大小, 用半表面积即可
+        float halfArea() const {
+            glm::vec3 e = glm::max(max - min, glm::vec3(0.0f));
+            return e.x * e.y + e.y * e.z + e.z * e.x;
+        }
+
+        bool contains(const GolaAabb &other) const {
+            return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+        }
+
+        bool overlaps(const GolaAabb &other) const {
+            return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::greaterThanEqual(max, other.min));
+        }
+    };
+}
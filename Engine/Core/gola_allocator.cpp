@@ -0,0 +1,360 @@
+#include "gola_allocator.hpp"
+
+#include "gola_device.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <print>
+#include <random>
+#include <stdexcept>
+
+namespace gola {
+    static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    GolaAllocator::GolaAllocator(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize preferredBlockSize)
+        : device{device} {
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        bufferImageGranularity = std::max<VkDeviceSize>(properties.limits.bufferImageGranularity, 1);
+
+        // 小堆 (例如 256MB 的 BAR 区域) 用更小的块, 避免一个块占掉大部分堆
+        pools.resize(memoryProperties.memoryTypeCount);
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[i].heapIndex].size;
+            VkDeviceSize blockSize = std::min(preferredBlockSize, heapSize / 8);
+            pools[i].blockSize = alignUp(std::max<VkDeviceSize>(blockSize, 1024 * 1024), bufferImageGranularity);
+        }
+    }
+
+    GolaAllocator::~GolaAllocator() {
+        for (uint32_t i = 0; i < pools.size(); i++) {
+            for (auto &block: pools[i].blocks) {
+                if (block) {
+                    freeDeviceMemory(block->memory, block->mapped != nullptr);
+                }
+            }
+        }
+    }
+
+    GolaAllocation GolaAllocator::allocate(
+        const VkMemoryRequirements &requirements, uint32_t memoryTypeIndex, ResourceKind kind) {
+        std::lock_guard<std::mutex> lock{mutex};
+        Pool &pool = pools[memoryTypeIndex];
+
+        VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+        VkDeviceSize size = requirements.size;
+        if (kind == ResourceKind::Image) {
+            // 图像的起止都落在 granularity 页边界上, 相邻的 buffer 就不可能与它共享一页
+            alignment = std::max(alignment, bufferImageGranularity);
+            size = alignUp(size, bufferImageGranularity);
+        }
+
+        bool dedicated = size > pool.blockSize / 2 ||
+                         (kind == ResourceKind::Image && size >= DEDICATED_IMAGE_THRESHOLD);
+        if (dedicated) {
+            return allocateDedicated(size, memoryTypeIndex, nullptr);
+        }
+
+        GolaAllocation allocation{};
+        allocation.memoryTypeIndex = memoryTypeIndex;
+        allocation.size = size;
+
+        auto placeInBlock = [&](uint32_t blockIndex) {
+            Block &block = *pool.blocks[blockIndex];
+            uint64_t offset = block.ranges.allocate(size, alignment);
+            if (offset == GolaRangeAllocator::INVALID_OFFSET) {
+                return false;
+            }
+            block.allocationCount++;
+            allocation.memory = block.memory;
+            allocation.offset = offset;
+            allocation.mapped = block.mapped ? static_cast<char *>(block.mapped) + offset : nullptr;
+            allocation.blockIndex = blockIndex;
+            return true;
+        };
+
+        for (uint32_t i = 0; i < pool.blocks.size(); i++) {
+            if (pool.blocks[i] && placeInBlock(i)) {
+                return allocation;
+            }
+        }
+
+        // 所有块都放不下: 新建一个块 (优先复用已释放的槽位, 保持 blockIndex 稳定)
+        auto block = std::make_unique<Block>();
+        block->memory = allocateDeviceMemory(pool.blockSize, memoryTypeIndex, &block->mapped);
+        block->ranges.reset(pool.blockSize);
+
+        auto emptySlot = std::find(pool.blocks.begin(), pool.blocks.end(), nullptr);
+        uint32_t blockIndex = static_cast<uint32_t>(emptySlot - pool.blocks.begin());
+        if (emptySlot == pool.blocks.end()) {
+            pool.blocks.push_back(std::move(block));
+        } else {
+            *emptySlot = std::move(block);
+        }
+
+        if (!placeInBlock(blockIndex)) {
+            throw std::runtime_error("failed to sub-allocate from a new memory block!");
+        }
+        return allocation;
+    }
+
+    GolaAllocation GolaAllocator::allocate(
+        const GolaResourceRequirements &requirements, uint32_t memoryTypeIndex, ResourceKind kind) {
+        if (!requirements.prefersDedicated && !requirements.requiresDedicated) {
+            return allocate(requirements.memory, memoryTypeIndex, kind);
+        }
+
+        VkMemoryDedicatedAllocateInfo dedicatedInfo{};
+        dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+        dedicatedInfo.buffer = requirements.buffer;
+        dedicatedInfo.image = requirements.image;
+
+        std::lock_guard<std::mutex> lock{mutex};
+        driverDedicatedAllocations++;
+        return allocateDedicated(requirements.memory.size, memoryTypeIndex, &dedicatedInfo);
+    }
+
+    GolaResourceRequirements GolaAllocator::getBufferRequirements(VkBuffer buffer) const {
+        VkBufferMemoryRequirementsInfo2 info{};
+        info.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+        info.buffer = buffer;
+
+        VkMemoryDedicatedRequirements dedicatedRequirements{};
+        dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+        VkMemoryRequirements2 memoryRequirements{};
+        memoryRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+        memoryRequirements.pNext = &dedicatedRequirements;
+        vkGetBufferMemoryRequirements2(device, &info, &memoryRequirements);
+
+        GolaResourceRequirements requirements{};
+        requirements.memory = memoryRequirements.memoryRequirements;
+        requirements.prefersDedicated = dedicatedRequirements.prefersDedicatedAllocation == VK_TRUE;
+        requirements.requiresDedicated = dedicatedRequirements.requiresDedicatedAllocation == VK_TRUE;
+        requirements.buffer = buffer;
+        return requirements;
+    }
+
+    GolaResourceRequirements GolaAllocator::getImageRequirements(VkImage image) const {
+        VkImageMemoryRequirementsInfo2 info{};
+        info.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+        info.image = image;
+
+        VkMemoryDedicatedRequirements dedicatedRequirements{};
+        dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+        VkMemoryRequirements2 memoryRequirements{};
+        memoryRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+        memoryRequirements.pNext = &dedicatedRequirements;
+        vkGetImageMemoryRequirements2(device, &info, &memoryRequirements);
+
+        GolaResourceRequirements requirements{};
+        requirements.memory = memoryRequirements.memoryRequirements;
+        requirements.prefersDedicated = dedicatedRequirements.prefersDedicatedAllocation == VK_TRUE;
+        requirements.requiresDedicated = dedicatedRequirements.requiresDedicatedAllocation == VK_TRUE;
+        requirements.image = image;
+        return requirements;
+    }
+
+    GolaAllocation GolaAllocator::allocateDedicated(VkDeviceSize size, uint32_t memoryTypeIndex,
+                                                    const VkMemoryDedicatedAllocateInfo *dedicatedInfo) {
+        Pool &pool = pools[memoryTypeIndex];
+        GolaAllocation allocation{};
+        allocation.memoryTypeIndex = memoryTypeIndex;
+        allocation.size = size;
+        allocation.memory = allocateDeviceMemory(size, memoryTypeIndex, &allocation.mapped, dedicatedInfo);
+        allocation.blockIndex = GolaAllocation::DEDICATED_BLOCK;
+        pool.dedicatedAllocationCount++;
+        pool.dedicatedBytes += size;
+        return allocation;
+    }
+
+    void GolaAllocator::free(GolaAllocation &allocation) {
+        if (!allocation.isValid()) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        Pool &pool = pools[allocation.memoryTypeIndex];
+
+        if (allocation.isDedicated()) {
+            freeDeviceMemory(allocation.memory, allocation.mapped != nullptr);
+            pool.dedicatedAllocationCount--;
+            pool.dedicatedBytes -= allocation.size;
+            allocation = {};
+            return;
+        }
+
+        auto &block = pool.blocks[allocation.blockIndex];
+        block->ranges.free(allocation.offset, allocation.size);
+        block->allocationCount--;
+
+        // 保留一个空块以免反复申请/释放; 多余的空块归还给驱动
+        if (block->allocationCount == 0) {
+            bool otherEmptyBlock = std::any_of(pool.blocks.begin(), pool.blocks.end(), [&](const auto &other) {
+                return other && other != block && other->allocationCount == 0;
+            });
+            if (otherEmptyBlock) {
+                freeDeviceMemory(block->memory, block->mapped != nullptr);
+                block.reset();
+            }
+        }
+        allocation = {};
+    }
+
+    GolaAllocatorStats GolaAllocator::getStats() const {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        GolaAllocatorStats stats{};
+        stats.memoryTypes.resize(pools.size());
+        stats.deviceMemoryAllocations = deviceMemoryAllocations;
+        stats.deviceMemoryFrees = deviceMemoryFrees;
+        stats.driverDedicatedAllocations = driverDedicatedAllocations;
+
+        for (size_t i = 0; i < pools.size(); i++) {
+            const Pool &pool = pools[i];
+            GolaMemoryTypeStats &typeStats = stats.memoryTypes[i];
+            typeStats.dedicatedAllocationCount = pool.dedicatedAllocationCount;
+            typeStats.allocationCount = pool.dedicatedAllocationCount;
+            typeStats.reservedBytes = pool.dedicatedBytes;
+            typeStats.usedBytes = pool.dedicatedBytes;
+            for (const auto &block: pool.blocks) {
+                if (!block) continue;
+                typeStats.blockCount++;
+                typeStats.allocationCount += block->allocationCount;
+                typeStats.reservedBytes += block->ranges.getCapacity();
+                typeStats.usedBytes += block->ranges.getUsedBytes();
+            }
+
+            stats.total.blockCount += typeStats.blockCount;
+            stats.total.dedicatedAllocationCount += typeStats.dedicatedAllocationCount;
+            stats.total.allocationCount += typeStats.allocationCount;
+            stats.total.reservedBytes += typeStats.reservedBytes;
+            stats.total.usedBytes += typeStats.usedBytes;
+        }
+        return stats;
+    }
+
+    VkDeviceMemory GolaAllocator::allocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void **mapped,
+                                                       const VkMemoryDedicatedAllocateInfo *dedicatedInfo) {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.pNext = dedicatedInfo;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+        VkDeviceMemory memory;
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate device memory!");
+        }
+        deviceMemoryAllocations++;
+
+        *mapped = nullptr;
+        if (isHostVisible(memoryTypeIndex)) {
+            if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS) {
+                throw std::runtime_error("failed to map device memory!");
+            }
+        }
+        return memory;
+    }
+
+    void GolaAllocator::freeDeviceMemory(VkDeviceMemory memory, bool wasMapped) {
+        if (wasMapped) {
+            vkUnmapMemory(device, memory);
+        }
+        vkFreeMemory(device, memory, nullptr);
+        deviceMemoryFrees++;
+    }
+
+    bool GolaAllocator::isHostVisible(uint32_t memoryTypeIndex) const {
+        return (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+    }
+
+    void GolaAllocator::runStressTest(GolaDevice &device) {
+        using clock = std::chrono::high_resolution_clock;
+        auto elapsedMs = [](clock::time_point start) {
+            return std::chrono::duration<float, std::chrono::milliseconds::period>(clock::now() - start).count();
+        };
+
+        constexpr uint32_t bufferCount = 100'000;
+        // 轮换阶段同时存活的 buffer 数
+        constexpr uint32_t liveCount = 4'096;
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device.getPhysicalDevice(), &properties);
+        std::print("[DEBUG] Allocator stress test ({} buffers, maxMemoryAllocationCount {})\n", bufferCount,
+                   properties.limits.maxMemoryAllocationCount);
+
+        // 256B 到 8KB 按对数均匀分布, 与小的 uniform / storage buffer 相近
+        std::mt19937 rng{12345};
+        std::uniform_int_distribution<uint32_t> sizeShift{8, 13};
+        std::uniform_int_distribution<uint32_t> sizeJitter{0, 255};
+        auto randomSize = [&] {
+            return (VkDeviceSize{1} << sizeShift(rng)) + sizeJitter(rng) * 4;
+        };
+        constexpr VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+        struct Buffer {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            GolaAllocation allocation{};
+        };
+        GolaAllocator &allocator = device.getAllocator();
+        const GolaAllocatorStats before = allocator.getStats();
+
+        // 1. 全部创建, 再按随机顺序销毁
+        std::vector<Buffer> buffers(bufferCount);
+        auto start = clock::now();
+        for (Buffer &buffer: buffers) {
+            device.createBuffer(randomSize(), usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer.buffer,
+                                buffer.allocation);
+        }
+        const float createMs = elapsedMs(start);
+        const GolaAllocatorStats peak = allocator.getStats();
+
+        std::shuffle(buffers.begin(), buffers.end(), rng);
+        start = clock::now();
+        for (Buffer &buffer: buffers) {
+            device.destroyBuffer(buffer.buffer, buffer.allocation);
+        }
+        const float destroyMs = elapsedMs(start);
+        std::print("[DEBUG]   all alive: create {:8.2f} ms, destroy {:8.2f} ms ({:.0f} ns/buffer), "
+                   "{} blocks, {:.1f} MB used of {:.1f} MB reserved\n",
+                   createMs, destroyMs, (createMs + destroyMs) * 1e6f / bufferCount,
+                   peak.total.blockCount - before.total.blockCount,
+                   static_cast<double>(peak.total.usedBytes - before.total.usedBytes) / (1024.0 * 1024.0),
+                   static_cast<double>(peak.total.reservedBytes - before.total.reservedBytes) / (1024.0 * 1024.0));
+
+        // 2. 随机替换存活集合中的一个 buffer, 模拟长时间运行的碎片化
+        buffers.resize(liveCount);
+        for (Buffer &buffer: buffers) {
+            device.createBuffer(randomSize(), usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer.buffer,
+                                buffer.allocation);
+        }
+        std::uniform_int_distribution<uint32_t> pick{0, liveCount - 1};
+        start = clock::now();
+        for (uint32_t i = 0; i < bufferCount; i++) {
+            Buffer &buffer = buffers[pick(rng)];
+            device.destroyBuffer(buffer.buffer, buffer.allocation);
+            device.createBuffer(randomSize(), usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer.buffer,
+                                buffer.allocation);
+        }
+        const float churnMs = elapsedMs(start);
+        const GolaAllocatorStats churned = allocator.getStats();
+        for (Buffer &buffer: buffers) {
+            device.destroyBuffer(buffer.buffer, buffer.allocation);
+        }
+        std::print("[DEBUG]   churn ({} live): {:8.2f} ms ({:.0f} ns/replace), {} blocks\n", liveCount, churnMs,
+                   churnMs * 1e6f / bufferCount, churned.total.blockCount - before.total.blockCount);
+
+        // 子分配之后 vkAllocateMemory 的次数应当远小于 buffer 数, 结束时分配数回到开始时的值
+        const GolaAllocatorStats after = allocator.getStats();
+        std::print("[DEBUG]   vkAllocateMemory {} / vkFreeMemory {} for {} buffers, {} driver-dedicated, "
+                   "{} allocations left over\n",
+                   after.deviceMemoryAllocations - before.deviceMemoryAllocations,
+                   after.deviceMemoryFrees - before.deviceMemoryFrees, bufferCount * 2 + liveCount,
+                   after.driverDedicatedAllocations - before.driverDedicatedAllocations,
+                   static_cast<int64_t>(after.total.allocationCount) - before.total.allocationCount);
+    }
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "gola_range_allocator.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace gola {
+    class GolaDevice;
+
+    // 一次子分配的结果. 对 HOST_VISIBLE 内存, mapped 指向持久映射后的起始地址
+    struct GolaAllocation {
+        static constexpr uint32_t DEDICATED_BLOCK = UINT32_MAX;
+
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void *mapped = nullptr;
+        uint32_t memoryTypeIndex = 0;
+        uint32_t blockIndex = DEDICATED_BLOCK;
+
+        bool isValid() const { return memory != VK_NULL_HANDLE; }
+        bool isDedicated() const { return blockIndex == DEDICATED_BLOCK; }
+    };
+
+    // vkGet*MemoryRequirements2 的结果, 包括驱动是否希望 / 要求资源使用独立分配 (VkMemoryDedicatedRequirements)
+    struct GolaResourceRequirements {
+        VkMemoryRequirements memory{};
+        bool prefersDedicated = false;
+        bool requiresDedicated = false;
+        // 独立分配时写入 VkMemoryDedicatedAllocateInfo, 两者只有一个非空
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkImage image = VK_NULL_HANDLE;
+    };
+
+    struct GolaMemoryTypeStats {
+        uint32_t blockCount = 0;
+        uint32_t dedicatedAllocationCount = 0;
+        uint32_t allocationCount = 0;
+        VkDeviceSize reservedBytes = 0;
+        VkDeviceSize usedBytes = 0;
+    };
+
+    struct GolaAllocatorStats {
+        std::vector<GolaMemoryTypeStats> memoryTypes;
+        GolaMemoryTypeStats total;
+        // 从驱动申请 VkDeviceMemory 的累计次数
+        uint64_t deviceMemoryAllocations = 0;
+        uint64_t deviceMemoryFrees = 0;
+        // 因为驱动希望或要求而独立分配的累计次数
+        uint64_t driverDedicatedAllocations = 0;
+    };
+
+    /*
+     * 显存子分配器: 每种内存类型一个池, 池由若干大块 VkDeviceMemory 组成, 块内用
+     * GolaRangeAllocator 做 best-fit 子分配. 大资源, 以及驱动希望或要求独立分配的资源
+     * (VkMemoryDedicatedRequirements) 走独立分配 (dedicated). 线程安全.
+     */
+    class GolaAllocator {
+    public:
+        enum class ResourceKind {
+            Buffer, // linear
+            Image, // optimal tiling
+        };
+
+        static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+        static constexpr VkDeviceSize DEDICATED_IMAGE_THRESHOLD = 16 * 1024 * 1024;
+
+        GolaAllocator(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize preferredBlockSize = DEFAULT_BLOCK_SIZE);
+
+        ~GolaAllocator();
+
+        GolaAllocator(const GolaAllocator &) = delete;
+
+        GolaAllocator &operator=(const GolaAllocator &) = delete;
+
+        GolaAllocation allocate(
+            const VkMemoryRequirements &requirements, uint32_t memoryTypeIndex, ResourceKind kind);
+
+        // Like allocate(), but the resource gets its own VkDeviceMemory (chained with
+        // VkMemoryDedicatedAllocateInfo) when the driver prefers or requires it.
+        GolaAllocation allocate(
+            const GolaResourceRequirements &requirements, uint32_t memoryTypeIndex, ResourceKind kind);
+
+        GolaResourceRequirements getBufferRequirements(VkBuffer buffer) const;
+
+        GolaResourceRequirements getImageRequirements(VkImage image) const;
+
+        void free(GolaAllocation &allocation);
+
+        GolaAllocatorStats getStats() const;
+
+        const VkPhysicalDeviceMemoryProperties &getMemoryProperties() const { return memoryProperties; }
+
+        // Creates and destroys 100k buffers of mixed sizes through GolaDevice::createBuffer (all alive at once,
+        // then churning with a bounded live set) and prints the timings, the vkAllocateMemory calls against
+        // maxMemoryAllocationCount and whether the allocator returned to its starting state.
+        static void runStressTest(GolaDevice &device);
+
+    private:
+        struct Block {
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            void *mapped = nullptr;
+            GolaRangeAllocator ranges;
+            uint32_t allocationCount = 0;
+        };
+
+        struct Pool {
+            VkDeviceSize blockSize = 0;
+            std::vector<std::unique_ptr<Block> > blocks;
+            uint32_t dedicatedAllocationCount = 0;
+            VkDeviceSize dedicatedBytes = 0;
+        };
+
+        GolaAllocation allocateDedicated(VkDeviceSize size, uint32_t memoryTypeIndex,
+                                         const VkMemoryDedicatedAllocateInfo *dedicatedInfo);
+
+        VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void **mapped,
+                                            const VkMemoryDedicatedAllocateInfo *dedicatedInfo = nullptr);
+
+        void freeDeviceMemory(VkDeviceMemory memory, bool wasMapped);
+
+        bool isHostVisible(uint32_t memoryTypeIndex) const;
+
+        VkDevice device;
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        // 线性资源与最优排布图像不能共享同一个 granularity 页
+        VkDeviceSize bufferImageGranularity;
+
+        std::vector<Pool> pools;
+        uint64_t deviceMemoryAllocations = 0;
+        uint64_t deviceMemoryFrees = 0;
+        uint64_t driverDedicatedAllocations = 0;
+        mutable std::mutex mutex;
+    };
+}
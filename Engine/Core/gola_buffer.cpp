@@ -0,0 +1,49 @@
+#include "gola_buffer.hpp"
+
+// std
+#include <cassert>
+#include <cstring>
+
+namespace gola {
+    VkDeviceSize GolaBuffer::getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment) {
+        if (minOffsetAlignment > 0) {
+            return (instanceSize + minOffsetAlignment - 1) & ~(minOffsetAlignment - 1);
+        }
+        return instanceSize;
+    }
+
+    GolaBuffer::GolaBuffer(
+        GolaDevice &device,
+        VkDeviceSize instanceSize,
+        uint32_t instanceCount,
+        VkBufferUsageFlags usageFlags,
+        VkMemoryPropertyFlags memoryPropertyFlags,
+        VkDeviceSize minOffsetAlignment)
+        : golaDevice{device}, instanceCount{instanceCount}, instanceSize{instanceSize} {
+        alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
+        bufferSize = alignmentSize * instanceCount;
+        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation);
+    }
+
+    GolaBuffer::~GolaBuffer() {
+        golaDevice.destroyBuffer(buffer, allocation);
+    }
+
+    void GolaBuffer::writeToBuffer(const void *data, VkDeviceSize size, VkDeviceSize offset) {
+        assert(allocation.mapped && "Cannot write to a buffer that is not host visible");
+
+        if (size == VK_WHOLE_SIZE) {
+            std::memcpy(allocation.mapped, data, static_cast<size_t>(bufferSize));
+        } else {
+            std::memcpy(static_cast<char *>(allocation.mapped) + offset, data, static_cast<size_t>(size));
+        }
+    }
+
+    void GolaBuffer::writeToIndex(const void *data, uint32_t index) {
+        writeToBuffer(data, instanceSize, index * alignmentSize);
+    }
+
+    VkDescriptorBufferInfo GolaBuffer::descriptorInfo(VkDeviceSize size, VkDeviceSize offset) const {
+        return VkDescriptorBufferInfo{buffer, offset, size};
+    }
+}
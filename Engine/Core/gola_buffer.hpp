@@ -0,0 +1,51 @@
+#pragma once
+
+#include "gola_device.hpp"
+
+namespace gola {
+    /*
+     * VkBuffer + 子分配内存的封装. HOST_VISIBLE 的缓冲区由分配器持久映射,
+     * 可以直接通过 getMappedMemory()/writeToBuffer() 写入.
+     */
+    class GolaBuffer {
+    public:
+        GolaBuffer(
+            GolaDevice &device,
+            VkDeviceSize instanceSize,
+            uint32_t instanceCount,
+            VkBufferUsageFlags usageFlags,
+            VkMemoryPropertyFlags memoryPropertyFlags,
+            VkDeviceSize minOffsetAlignment = 1);
+
+        ~GolaBuffer();
+
+        GolaBuffer(const GolaBuffer &) = delete;
+
+        GolaBuffer &operator=(const GolaBuffer &) = delete;
+
+        void writeToBuffer(const void *data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+        void writeToIndex(const void *data, uint32_t index);
+
+        VkDescriptorBufferInfo descriptorInfo(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) const;
+
+        VkBuffer getBuffer() const { return buffer; }
+        void *getMappedMemory() const { return allocation.mapped; }
+        uint32_t getInstanceCount() const { return instanceCount; }
+        VkDeviceSize getInstanceSize() const { return instanceSize; }
+        VkDeviceSize getAlignmentSize() const { return alignmentSize; }
+        VkDeviceSize getBufferSize() const { return bufferSize; }
+
+    private:
+        static VkDeviceSize getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
+
+        GolaDevice &golaDevice;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        GolaAllocation allocation{};
+
+        VkDeviceSize bufferSize;
+        uint32_t instanceCount;
+        VkDeviceSize instanceSize;
+        VkDeviceSize alignmentSize;
+    };
+}
@@ -0,0 +1,761 @@
+#include "gola_bvh.hpp"
+
+#include "gola_camera.hpp"
+#include "gola_job_system.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <print>
+#include <random>
+#include <stdexcept>
+
+namespace gola {
+    static constexpr uint32_t SAH_BIN_COUNT = 16;
+    // SAH 划分失败 (例如大量对象重叠) 时退化为中位数划分, 同时限制递归深度
+    static constexpr int MAX_SAH_DEPTH = 64;
+    static constexpr uint32_t ALL_PLANES = (1u << GolaFrustum::PLANE_COUNT) - 1;
+
+    // 射线与包围盒求交 (slab), 返回进入距离
+    static bool intersectRay(const GolaAabb &bounds, const glm::vec3 &origin, const glm::vec3 &inverseDirection,
+                             float maxDistance, float &entryDistance) {
+        glm::vec3 t1 = (bounds.min - origin) * inverseDirection;
+        glm::vec3 t2 = (bounds.max - origin) * inverseDirection;
+        glm::vec3 tNear = glm::min(t1, t2);
+        glm::vec3 tFar = glm::max(t1, t2);
+        float tEnter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+        float tExit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, maxDistance));
+        entryDistance = tEnter;
+        return tEnter <= tExit;
+    }
+
+    // 沿法线方向最远的顶点在平面外侧时, 整个包围盒都在外侧
+    static glm::vec3 positiveVertex(const GolaAabb &bounds, const glm::vec3 &normal) {
+        return glm::mix(bounds.min, bounds.max, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+    }
+
+    static glm::vec3 negativeVertex(const GolaAabb &bounds, const glm::vec3 &normal) {
+        return glm::mix(bounds.max, bounds.min, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+    }
+
+    // 逐个对象测试, 只用于基准测试中与层次剔除比较耗时
+    static bool intersectsFrustum(const GolaAabb &bounds, const GolaFrustum &frustum) {
+        for (const auto &plane: frustum.planes) {
+            glm::vec3 normal{plane};
+            if (glm::dot(normal, positiveVertex(bounds, normal)) + plane.w < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void GolaBvh::clear() {
+        nodes.clear();
+        leaves.clear();
+        root = NULL_NODE;
+        freeList = NULL_NODE;
+        leafCount = 0;
+    }
+
+    int32_t GolaBvh::allocateNode() {
+        if (freeList == NULL_NODE) {
+            nodes.emplace_back();
+            return static_cast<int32_t>(nodes.size() - 1);
+        }
+        int32_t index = freeList;
+        freeList = nodes[index].parent;
+        nodes[index] = Node{};
+        return index;
+    }
+
+    void GolaBvh::freeNode(int32_t index) {
+        nodes[index].parent = freeList;
+        nodes[index].height = -1;
+        freeList = index;
+    }
+
+    int32_t GolaBvh::findLeaf(id_t id) const {
+        auto it = leaves.find(id);
+        if (it == leaves.end()) {
+            throw std::runtime_error("failed to find BVH leaf for object id!");
+        }
+        return it->second;
+    }
+
+    // ------------------------------------------------------------------
+    // 批量构建
+
+    void GolaBvh::build(const std::vector<BuildItem> &items, bool parallel) {
+        clear();
+        if (items.empty()) {
+            return;
+        }
+
+        std::vector<BuildRef> refs(items.size());
+        for (size_t i = 0; i < items.size(); i++) {
+            refs[i] = {items[i].bounds, items[i].bounds.center(), items[i].id};
+        }
+
+        // 每个线程一棵子树: 深度 d 时最多有 2^d 个任务同时运行
+        int parallelDepth = 0;
+        if (parallel) {
+            parallelDepth = static_cast<int>(std::bit_width(GolaJobSystem::get().getThreadCount()));
+        }
+
+        leafCount = static_cast<uint32_t>(items.size());
+        nodes.resize(2 * static_cast<size_t>(leafCount) - 1);
+        buildRange(refs.data(), leafCount, 0, NULL_NODE, parallelDepth, 0);
+        root = 0;
+
+        leaves.reserve(leafCount);
+        for (int32_t i = 0; i < static_cast<int32_t>(nodes.size()); i++) {
+            if (nodes[i].isLeaf()) {
+                if (!leaves.try_emplace(nodes[i].id, i).second) {
+                    clear();
+                    throw std::runtime_error("failed to build BVH: duplicate object id!");
+                }
+            }
+        }
+    }
+
+    void GolaBvh::buildRange(BuildRef *refs, uint32_t count, int32_t nodeIndex, int32_t parent, int parallelDepth,
+                             int depth) {
+        Node &node = nodes[nodeIndex];
+        node.parent = parent;
+        if (count == 1) {
+            node.bounds = refs[0].bounds;
+            node.id = refs[0].id;
+            node.child1 = NULL_NODE;
+            node.child2 = NULL_NODE;
+            node.height = 0;
+            return;
+        }
+
+        GolaAabb bounds{};
+        GolaAabb centroidBounds{};
+        for (uint32_t i = 0; i < count; i++) {
+            bounds.expand(refs[i].bounds);
+            centroidBounds.expand(refs[i].centroid);
+        }
+
+        // 在质心分布最长的轴上划分
+        glm::vec3 extent = centroidBounds.extent();
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        const float axisMin = centroidBounds.min[axis];
+        const float axisExtent = extent[axis];
+
+        uint32_t mid = 0;
+        if (axisExtent > 0.0f && depth < MAX_SAH_DEPTH) {
+            // 1. 按质心分箱
+            std::array<uint32_t, SAH_BIN_COUNT> binCounts{};
+            std::array<GolaAabb, SAH_BIN_COUNT> binBounds{};
+            const float binScale = SAH_BIN_COUNT / axisExtent;
+            auto binOf = [&](const BuildRef &ref) {
+                auto bin = static_cast<uint32_t>((ref.centroid[axis] - axisMin) * binScale);
+                return std::min(bin, SAH_BIN_COUNT - 1);
+            };
+            for (uint32_t i = 0; i < count; i++) {
+                uint32_t bin = binOf(refs[i]);
+                binCounts[bin]++;
+                binBounds[bin].expand(refs[i].bounds);
+            }
+
+            // 2. 从右向左累积, 得到每个划分位置右侧的代价
+            std::array<float, SAH_BIN_COUNT> rightCosts{};
+            GolaAabb rightBounds{};
+            uint32_t rightCount = 0;
+            for (uint32_t bin = SAH_BIN_COUNT - 1; bin > 0; bin--) {
+                rightBounds.expand(binBounds[bin]);
+                rightCount += binCounts[bin];
+                rightCosts[bin] = rightCount * rightBounds.halfArea();
+            }
+
+            // 3. 从左向右扫描, 选择 SAH 代价最小的划分
+            GolaAabb leftBounds{};
+            uint32_t leftCount = 0;
+            float bestCost = std::numeric_limits<float>::max();
+            uint32_t bestSplit = 0;
+            for (uint32_t split = 1; split < SAH_BIN_COUNT; split++) {
+                leftBounds.expand(binBounds[split - 1]);
+                leftCount += binCounts[split - 1];
+                if (leftCount == 0 || leftCount == count) {
+                    continue;
+                }
+                float cost = leftCount * leftBounds.halfArea() + rightCosts[split];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestSplit = split;
+                }
+            }
+
+            if (bestSplit != 0) {
+                BuildRef *middle = std::partition(refs, refs + count, [&](const BuildRef &ref) {
+                    return binOf(ref) < bestSplit;
+                });
+                mid = static_cast<uint32_t>(middle - refs);
+            }
+        }
+        if (mid == 0 || mid == count) {
+            mid = count / 2;
+            std::nth_element(refs, refs + mid, refs + count, [axis](const BuildRef &a, const BuildRef &b) {
+                return a.centroid[axis] < b.centroid[axis];
+            });
+        }
+
+        const int32_t leftIndex = nodeIndex + 1;
+        const int32_t rightIndex = nodeIndex + 2 * static_cast<int32_t>(mid);
+        node.bounds = bounds;
+        node.child1 = leftIndex;
+        node.child2 = rightIndex;
+
+        if (parallelDepth > 0 && count >= PARALLEL_BUILD_THRESHOLD) {
+            GolaJobSystem &jobs = GolaJobSystem::get();
+            GolaJobCounter leftDone;
+            jobs.run([=, this] {
+                buildRange(refs, mid, leftIndex, nodeIndex, parallelDepth - 1, depth + 1);
+            }, &leftDone);
+            buildRange(refs + mid, count - mid, rightIndex, nodeIndex, parallelDepth - 1, depth + 1);
+            jobs.wait(leftDone);
+        } else {
+            buildRange(refs, mid, leftIndex, nodeIndex, 0, depth + 1);
+            buildRange(refs + mid, count - mid, rightIndex, nodeIndex, 0, depth + 1);
+        }
+        node.height = 1 + std::max(nodes[leftIndex].height, nodes[rightIndex].height);
+    }
+
+    // ------------------------------------------------------------------
+    // 增量修改
+
+    void GolaBvh::insert(id_t id, const GolaAabb &bounds) {
+        if (leaves.contains(id)) {
+            throw std::runtime_error("failed to insert BVH leaf: duplicate object id!");
+        }
+        int32_t leaf = allocateNode();
+        nodes[leaf].bounds = bounds;
+        nodes[leaf].id = id;
+        leaves.emplace(id, leaf);
+        leafCount++;
+        insertLeaf(leaf);
+    }
+
+    void GolaBvh::remove(id_t id) {
+        int32_t leaf = findLeaf(id);
+        removeLeaf(leaf);
+        freeNode(leaf);
+        leaves.erase(id);
+        leafCount--;
+    }
+
+    void GolaBvh::update(id_t id, const GolaAabb &bounds) {
+        int32_t leaf = findLeaf(id);
+        nodes[leaf].bounds = bounds;
+
+        // 还在父节点范围内: 原地 refit; 移出父节点后继续 refit 会把整条祖先链拉大, 改为重新插入
+        const int32_t parent = nodes[leaf].parent;
+        if (parent == NULL_NODE || nodes[parent].bounds.contains(bounds)) {
+            refitAncestors(parent);
+        } else {
+            removeLeaf(leaf);
+            insertLeaf(leaf);
+        }
+    }
+
+    void GolaBvh::setLeafBounds(id_t id, const GolaAabb &bounds) {
+        nodes[findLeaf(id)].bounds = bounds;
+    }
+
+    void GolaBvh::insertLeaf(int32_t leaf) {
+        if (root == NULL_NODE) {
+            root = leaf;
+            nodes[leaf].parent = NULL_NODE;
+            return;
+        }
+
+        // 1. 自顶向下贪心寻找兄弟节点: 比较 "在这里新建父节点" 与 "继续下降到某个子节点" 的 SAH 代价
+        const GolaAabb leafBounds = nodes[leaf].bounds;
+        int32_t index = root;
+        while (!nodes[index].isLeaf()) {
+            const Node &node = nodes[index];
+            float area = node.bounds.halfArea();
+            float combinedArea = GolaAabb::merge(node.bounds, leafBounds).halfArea();
+            float cost = 2.0f * combinedArea;
+            // 下降时当前节点的包围盒也会变大
+            float inheritanceCost = 2.0f * (combinedArea - area);
+
+            auto descendCost = [&](int32_t child) {
+                const Node &childNode = nodes[child];
+                float childArea = GolaAabb::merge(childNode.bounds, leafBounds).halfArea();
+                if (!childNode.isLeaf()) {
+                    childArea -= childNode.bounds.halfArea();
+                }
+                return childArea + inheritanceCost;
+            };
+            float cost1 = descendCost(node.child1);
+            float cost2 = descendCost(node.child2);
+            if (cost < cost1 && cost < cost2) {
+                break;
+            }
+            index = cost1 < cost2 ? node.child1 : node.child2;
+        }
+        const int32_t sibling = index;
+
+        // 2. 新建父节点, allocateNode 可能使引用失效, 之后只用下标访问
+        const int32_t oldParent = nodes[sibling].parent;
+        const int32_t newParent = allocateNode();
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].bounds = GolaAabb::merge(leafBounds, nodes[sibling].bounds);
+        nodes[newParent].height = nodes[sibling].height + 1;
+        nodes[newParent].child1 = sibling;
+        nodes[newParent].child2 = leaf;
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+
+        if (oldParent == NULL_NODE) {
+            root = newParent;
+        } else if (nodes[oldParent].child1 == sibling) {
+            nodes[oldParent].child1 = newParent;
+        } else {
+            nodes[oldParent].child2 = newParent;
+        }
+
+        // 3. 向上 refit
+        refitAncestors(oldParent);
+    }
+
+    void GolaBvh::removeLeaf(int32_t leaf) {
+        if (leaf == root) {
+            root = NULL_NODE;
+            return;
+        }
+
+        // 兄弟节点顶替父节点的位置
+        const int32_t parent = nodes[leaf].parent;
+        const int32_t grandParent = nodes[parent].parent;
+        const int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+        nodes[sibling].parent = grandParent;
+        freeNode(parent);
+        if (grandParent == NULL_NODE) {
+            root = sibling;
+            return;
+        }
+        if (nodes[grandParent].child1 == parent) {
+            nodes[grandParent].child1 = sibling;
+        } else {
+            nodes[grandParent].child2 = sibling;
+        }
+        refitAncestors(grandParent);
+    }
+
+    void GolaBvh::refitAncestors(int32_t index) {
+        while (index != NULL_NODE) {
+            Node &node = nodes[index];
+            node.bounds = GolaAabb::merge(nodes[node.child1].bounds, nodes[node.child2].bounds);
+            node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+            rotate(index);
+            index = nodes[index].parent;
+        }
+    }
+
+    /*
+     * 树旋转: A 的子节点为 B 和 C, 尝试把 B 与 C 的某个子节点 (F/G) 交换, 或把 C 与 B 的某个子节点 (D/E) 交换.
+     * 交换只改变被插入的那个子节点的包围盒, A 的包围盒不变, 选择使其表面积减小最多的一种.
+     *
+     *        A                 A
+     *      /   \             /   \
+     *     B     C    =>     F     C
+     *    / \   / \               / \
+     *   D   E F   G             B   G
+     */
+    void GolaBvh::rotate(int32_t indexA) {
+        Node &a = nodes[indexA];
+        if (a.height < 2) {
+            return;
+        }
+        const int32_t indexB = a.child1;
+        const int32_t indexC = a.child2;
+        Node &b = nodes[indexB];
+        Node &c = nodes[indexC];
+
+        enum class Rotation { None, BF, BG, CD, CE };
+        Rotation best = Rotation::None;
+        float bestDelta = 0.0f;
+
+        if (!c.isLeaf()) {
+            const float areaC = c.bounds.halfArea();
+            float deltaBF = GolaAabb::merge(b.bounds, nodes[c.child2].bounds).halfArea() - areaC;
+            float deltaBG = GolaAabb::merge(b.bounds, nodes[c.child1].bounds).halfArea() - areaC;
+            if (deltaBF < bestDelta) {
+                best = Rotation::BF;
+                bestDelta = deltaBF;
+            }
+            if (deltaBG < bestDelta) {
+                best = Rotation::BG;
+                bestDelta = deltaBG;
+            }
+        }
+        if (!b.isLeaf()) {
+            const float areaB = b.bounds.halfArea();
+            float deltaCD = GolaAabb::merge(c.bounds, nodes[b.child2].bounds).halfArea() - areaB;
+            float deltaCE = GolaAabb::merge(c.bounds, nodes[b.child1].bounds).halfArea() - areaB;
+            if (deltaCD < bestDelta) {
+                best = Rotation::CD;
+                bestDelta = deltaCD;
+            }
+            if (deltaCE < bestDelta) {
+                best = Rotation::CE;
+                bestDelta = deltaCE;
+            }
+        }
+
+        // swap 把 A 的子节点 outer 与 inner 的子节点 grandChild 交换, inner 剩下的子节点为 kept
+        auto swap = [&](int32_t &outerSlot, Node &inner, int32_t innerIndex, int32_t &grandChildSlot) {
+            const int32_t outer = outerSlot;
+            const int32_t grandChild = grandChildSlot;
+            const int32_t kept = inner.child1 == grandChild ? inner.child2 : inner.child1;
+
+            outerSlot = grandChild;
+            nodes[grandChild].parent = indexA;
+            grandChildSlot = outer;
+            nodes[outer].parent = innerIndex;
+
+            inner.bounds = GolaAabb::merge(nodes[outer].bounds, nodes[kept].bounds);
+            inner.height = 1 + std::max(nodes[outer].height, nodes[kept].height);
+            a.height = 1 + std::max(nodes[a.child1].height, nodes[a.child2].height);
+        };
+
+        switch (best) {
+            case Rotation::BF:
+                swap(a.child1, c, indexC, c.child1);
+                break;
+            case Rotation::BG:
+                swap(a.child1, c, indexC, c.child2);
+                break;
+            case Rotation::CD:
+                swap(a.child2, b, indexB, b.child1);
+                break;
+            case Rotation::CE:
+                swap(a.child2, b, indexB, b.child2);
+                break;
+            case Rotation::None:
+                break;
+        }
+    }
+
+    void GolaBvh::refit() {
+        if (root == NULL_NODE) {
+            return;
+        }
+
+        // 后序遍历: 子节点先于父节点更新
+        std::vector<std::pair<int32_t, bool>> stack;
+        stack.reserve(64);
+        stack.emplace_back(root, false);
+        while (!stack.empty()) {
+            auto [index, childrenDone] = stack.back();
+            stack.pop_back();
+            Node &node = nodes[index];
+            if (node.isLeaf()) {
+                continue;
+            }
+            if (!childrenDone) {
+                stack.emplace_back(index, true);
+                stack.emplace_back(node.child1, false);
+                stack.emplace_back(node.child2, false);
+                continue;
+            }
+            node.bounds = GolaAabb::merge(nodes[node.child1].bounds, nodes[node.child2].bounds);
+            node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+        }
+    }
+
+    float GolaBvh::computeSahCost() const {
+        if (root == NULL_NODE) {
+            return 0.0f;
+        }
+        float totalArea = 0.0f;
+        for (const auto &node: nodes) {
+            if (node.height > 0) {
+                totalArea += node.bounds.halfArea();
+            }
+        }
+        return totalArea / nodes[root].bounds.halfArea();
+    }
+
+    // ------------------------------------------------------------------
+    // 查询
+
+    void GolaBvh::queryFrustum(const GolaFrustum &frustum, std::vector<id_t> &out) const {
+        out.clear();
+        if (root == NULL_NODE) {
+            return;
+        }
+
+        // planeMask 记录还需要测试的平面, 节点完全位于某个平面内侧后其子树不再测试该平面
+        std::vector<std::pair<int32_t, uint32_t>> stack;
+        stack.reserve(64);
+        stack.emplace_back(root, ALL_PLANES);
+        while (!stack.empty()) {
+            auto [index, planeMask] = stack.back();
+            stack.pop_back();
+            const Node &node = nodes[index];
+
+            bool outside = false;
+            for (uint32_t mask = planeMask; mask != 0; mask &= mask - 1) {
+                const int p = std::countr_zero(mask);
+                const glm::vec4 &plane = frustum.planes[p];
+                const glm::vec3 normal{plane};
+                if (glm::dot(normal, positiveVertex(node.bounds, normal)) + plane.w < 0.0f) {
+                    outside = true;
+                    break;
+                }
+                if (glm::dot(normal, negativeVertex(node.bounds, normal)) + plane.w >= 0.0f) {
+                    planeMask &= ~(1u << p);
+                }
+            }
+            if (outside) {
+                continue;
+            }
+
+            if (node.isLeaf()) {
+                out.push_back(node.id);
+            } else {
+                stack.emplace_back(node.child2, planeMask);
+                stack.emplace_back(node.child1, planeMask);
+            }
+        }
+    }
+
+    void GolaBvh::queryAabb(const GolaAabb &bounds, std::vector<id_t> &out) const {
+        out.clear();
+        if (root == NULL_NODE) {
+            return;
+        }
+
+        std::vector<int32_t> stack;
+        stack.reserve(64);
+        stack.push_back(root);
+        while (!stack.empty()) {
+            const Node &node = nodes[stack.back()];
+            stack.pop_back();
+            if (!node.bounds.overlaps(bounds)) {
+                continue;
+            }
+            if (node.isLeaf()) {
+                out.push_back(node.id);
+            } else {
+                stack.push_back(node.child2);
+                stack.push_back(node.child1);
+            }
+        }
+    }
+
+    void GolaBvh::queryRay(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance,
+                           std::vector<RayHit> &out) const {
+        out.clear();
+        if (root == NULL_NODE) {
+            return;
+        }
+
+        const glm::vec3 inverseDirection = 1.0f / direction;
+        std::vector<int32_t> stack;
+        stack.reserve(64);
+        stack.push_back(root);
+        while (!stack.empty()) {
+            const Node &node = nodes[stack.back()];
+            stack.pop_back();
+            float distance;
+            if (!intersectRay(node.bounds, origin, inverseDirection, maxDistance, distance)) {
+                continue;
+            }
+            if (node.isLeaf()) {
+                out.push_back({node.id, distance});
+            } else {
+                stack.push_back(node.child2);
+                stack.push_back(node.child1);
+            }
+        }
+
+        std::sort(out.begin(), out.end(), [](const RayHit &a, const RayHit &b) { return a.distance < b.distance; });
+    }
+
+    bool GolaBvh::raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance,
+                          RayHit &hit) const {
+        if (root == NULL_NODE) {
+            return false;
+        }
+
+        const glm::vec3 inverseDirection = 1.0f / direction;
+        float closest = maxDistance;
+        bool found = false;
+
+        // 先访问较近的子节点, 找到命中后用它的距离裁剪更远的子树
+        std::vector<std::pair<int32_t, float>> stack;
+        stack.reserve(64);
+        float rootDistance;
+        if (!intersectRay(nodes[root].bounds, origin, inverseDirection, closest, rootDistance)) {
+            return false;
+        }
+        stack.emplace_back(root, rootDistance);
+        while (!stack.empty()) {
+            auto [index, entryDistance] = stack.back();
+            stack.pop_back();
+            if (entryDistance > closest) {
+                continue;
+            }
+            const Node &node = nodes[index];
+            if (node.isLeaf()) {
+                if (!found || entryDistance < closest) {
+                    hit = {node.id, entryDistance};
+                    closest = entryDistance;
+                    found = true;
+                }
+                continue;
+            }
+
+            float distance1, distance2;
+            bool hit1 = intersectRay(nodes[node.child1].bounds, origin, inverseDirection, closest, distance1);
+            bool hit2 = intersectRay(nodes[node.child2].bounds, origin, inverseDirection, closest, distance2);
+            if (hit1 && hit2) {
+                if (distance1 < distance2) {
+                    stack.emplace_back(node.child2, distance2);
+                    stack.emplace_back(node.child1, distance1);
+                } else {
+                    stack.emplace_back(node.child1, distance1);
+                    stack.emplace_back(node.child2, distance2);
+                }
+            } else if (hit1) {
+                stack.emplace_back(node.child1, distance1);
+            } else if (hit2) {
+                stack.emplace_back(node.child2, distance2);
+            }
+        }
+        return found;
+    }
+
+    // ------------------------------------------------------------------
+    // 基准测试
+
+    void GolaBvh::runBenchmark() {
+        using clock = std::chrono::high_resolution_clock;
+        auto elapsedMs = [](clock::time_point start) {
+            return std::chrono::duration<float, std::chrono::milliseconds::period>(clock::now() - start).count();
+        };
+
+        constexpr uint32_t objectCount = 1'000'000;
+        std::print("[DEBUG] BVH benchmark ({} objects, {} job threads)\n",
+                   objectCount, GolaJobSystem::get().getThreadCount());
+
+        // 与剔除基准测试相同的场景: 对象均匀分布在原点周围, 相机位于原点看向 +z
+        std::mt19937 rng{12345};
+        std::uniform_real_distribution<float> position{-100.0f, 100.0f};
+        std::uniform_real_distribution<float> radius{0.1f, 2.0f};
+        std::vector<BuildItem> items(objectCount);
+        for (uint32_t i = 0; i < objectCount; i++) {
+            items[i] = {i, GolaAabb::fromSphere(glm::vec3(position(rng), position(rng), position(rng)), radius(rng))};
+        }
+
+        GolaBvh bvh{};
+        for (bool parallel: {false, true}) {
+            auto start = clock::now();
+            bvh.build(items, parallel);
+            std::print("[DEBUG]   build ({}): {:8.2f} ms, height {}, SAH cost {:.1f}\n",
+                       parallel ? "parallel" : "serial", elapsedMs(start), bvh.getHeight(), bvh.computeSahCost());
+        }
+
+        // 视锥查询, 与逐个对象测试同一个 AABB 比较耗时
+        GolaCamera camera{};
+        camera.setPerspectiveProjection(glm::radians(50.f), 4.0f / 3.0f, 0.1f, 100.f);
+        camera.setViewYXZ(glm::vec3(0.0f), glm::vec3(0.0f));
+        const GolaFrustum frustum = GolaFrustum::fromMatrix(camera.getProjection() * camera.getView());
+
+        std::vector<id_t> results;
+        auto start = clock::now();
+        constexpr int frustumIterations = 10;
+        for (int i = 0; i < frustumIterations; i++) {
+            bvh.queryFrustum(frustum, results);
+        }
+        float frustumMs = elapsedMs(start) / frustumIterations;
+
+        uint32_t bruteForceVisible = 0;
+        start = clock::now();
+        for (const auto &item: items) {
+            bruteForceVisible += intersectsFrustum(item.bounds, frustum) ? 1 : 0;
+        }
+        float bruteForceMs = elapsedMs(start);
+        std::print("[DEBUG]   frustum query: {:8.3f} ms, {} visible (brute force {:.3f} ms, {} visible)\n",
+                   frustumMs, results.size(), bruteForceMs, bruteForceVisible);
+
+        // 射线查询: 随机方向的射线从原点射出
+        std::uniform_real_distribution<float> unit{-1.0f, 1.0f};
+        constexpr int rayCount = 10'000;
+        std::vector<std::pair<glm::vec3, glm::vec3>> rays(rayCount);
+        for (auto &[origin, direction]: rays) {
+            origin = glm::vec3(position(rng), position(rng), position(rng));
+            direction = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 1e-3f));
+        }
+        uint32_t rayHits = 0;
+        start = clock::now();
+        for (const auto &[origin, direction]: rays) {
+            RayHit hit{};
+            rayHits += bvh.raycast(origin, direction, 1000.0f, hit) ? 1 : 0;
+        }
+        float rayMs = elapsedMs(start);
+        std::print("[DEBUG]   raycast: {:8.3f} us/ray, {} of {} rays hit\n",
+                   rayMs * 1000.0f / rayCount, rayHits, rayCount);
+
+        // AABB 重叠查询: 边长 10 的随机盒子
+        constexpr int overlapCount = 10'000;
+        size_t overlapResults = 0;
+        start = clock::now();
+        for (int q = 0; q < overlapCount; q++) {
+            glm::vec3 center{position(rng), position(rng), position(rng)};
+            bvh.queryAabb({center - glm::vec3(5.0f), center + glm::vec3(5.0f)}, results);
+            overlapResults += results.size();
+        }
+        float overlapMs = elapsedMs(start);
+        std::print("[DEBUG]   AABB query: {:8.3f} us/query, {:.1f} results/query\n",
+                   overlapMs * 1000.0f / overlapCount, static_cast<float>(overlapResults) / overlapCount);
+
+        // 所有对象小幅移动: 只写叶子再整体 refit
+        std::uniform_real_distribution<float> jitter{-0.5f, 0.5f};
+        for (auto &item: items) {
+            glm::vec3 offset{jitter(rng), jitter(rng), jitter(rng)};
+            item.bounds = {item.bounds.min + offset, item.bounds.max + offset};
+        }
+        start = clock::now();
+        for (const auto &item: items) {
+            bvh.setLeafBounds(item.id, item.bounds);
+        }
+        bvh.refit();
+        std::print("[DEBUG]   refit (all moved): {:8.2f} ms, SAH cost {:.1f}\n", elapsedMs(start),
+                   bvh.computeSahCost());
+
+        // 10% 的对象大幅移动: 增量更新 + 旋转
+        std::uniform_int_distribution<uint32_t> pick{0, objectCount - 1};
+        constexpr uint32_t movedCount = objectCount / 10;
+        start = clock::now();
+        for (uint32_t i = 0; i < movedCount; i++) {
+            auto &item = items[pick(rng)];
+            glm::vec3 center{position(rng), position(rng), position(rng)};
+            glm::vec3 halfExtent = item.bounds.extent() * 0.5f;
+            item.bounds = {center - halfExtent, center + halfExtent};
+            bvh.update(item.id, item.bounds);
+        }
+        std::print("[DEBUG]   update ({} moved): {:8.2f} ms, height {}, SAH cost {:.1f}\n", movedCount,
+                   elapsedMs(start), bvh.getHeight(), bvh.computeSahCost());
+
+        // 删除再插入 (对象出生 / 销毁)
+        start = clock::now();
+        for (uint32_t i = 0; i < movedCount; i++) {
+            bvh.remove(items[i].id);
+        }
+        for (uint32_t i = 0; i < movedCount; i++) {
+            bvh.insert(items[i].id, items[i].bounds);
+        }
+        std::print("[DEBUG]   remove + insert ({}): {:8.2f} ms, height {}, SAH cost {:.1f}\n", movedCount,
+                   elapsedMs(start), bvh.getHeight(), bvh.computeSahCost());
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "gola_aabb.hpp"
+#include "gola_frustum.hpp"
+
+// std
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace gola {
+    /*
+     * 动态包围体层次结构 (BVH), 每个叶子对应一个对象, 按对象 id 索引.
+     * - build(): 分箱 SAH 自顶向下批量构建, 较大的子树在多个线程上并行构建
+     * - insert() / remove() / update(): 增量修改, 沿祖先链 refit 并做 SAH 树旋转, 适合移动的对象
+     * - setLeafBounds() + refit(): 大量对象同时移动时只做一次自底向上的 refit, 不改变拓扑
+     * - 查询: 视锥 (层次剔除, 完全在视锥内的子树不再测试), 射线, AABB 重叠
+     */
+    class GolaBvh {
+    public:
+        using id_t = uint32_t;
+
+        static constexpr int32_t NULL_NODE = -1;
+
+        struct BuildItem {
+            id_t id;
+            GolaAabb bounds;
+        };
+
+        // distance 是射线进入对象包围盒的距离, 需要精确结果时由调用者再与几何体求交
+        struct RayHit {
+            id_t id;
+            float distance;
+        };
+
+        GolaBvh() = default;
+
+        GolaBvh(const GolaBvh &) = delete;
+
+        GolaBvh &operator=(const GolaBvh &) = delete;
+
+        void clear();
+
+        // Replaces the whole tree with one leaf per item. Subtrees above PARALLEL_BUILD_THRESHOLD
+        // items are built as jobs on the job system when parallel is set; the result is identical.
+        void build(const std::vector<BuildItem> &items, bool parallel = true);
+
+        void insert(id_t id, const GolaAabb &bounds);
+
+        void remove(id_t id);
+
+        // 单个对象移动后调用: 仍在父节点内时沿祖先链 refit + 旋转, 否则重新插入
+        void update(id_t id, const GolaAabb &bounds);
+
+        // 只写叶子包围盒, 祖先在下一次 refit() 时更新
+        void setLeafBounds(id_t id, const GolaAabb &bounds);
+
+        void refit();
+
+        bool contains(id_t id) const { return leaves.contains(id); }
+
+        // 以下查询都会先清空 out
+        void queryFrustum(const GolaFrustum &frustum, std::vector<id_t> &out) const;
+
+        void queryAabb(const GolaAabb &bounds, std::vector<id_t> &out) const;
+
+        // 所有被射线穿过的对象, 按距离从近到远排序
+        void queryRay(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance,
+                      std::vector<RayHit> &out) const;
+
+        // Returns the closest object along the ray (by bounding box entry distance) in hit.
+        bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, RayHit &hit) const;
+
+        uint32_t getLeafCount() const { return leafCount; }
+        int32_t getHeight() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+        GolaAabb getBounds() const { return root == NULL_NODE ? GolaAabb{} : nodes[root].bounds; }
+
+        // 内部节点表面积之和 / 根节点表面积, 越小查询越快
+        float computeSahCost() const;
+
+        // Builds, refits, updates and queries a tree of 1M random objects and prints the timings. Query
+        // results are checked against brute force in Tests/gola_culling_tests.cpp.
+        static void runBenchmark();
+
+        static constexpr uint32_t PARALLEL_BUILD_THRESHOLD = 16 * 1024;
+
+    private:
+        struct Node {
+            GolaAabb bounds;
+            int32_t parent = NULL_NODE;
+            int32_t child1 = NULL_NODE;
+            int32_t child2 = NULL_NODE;
+            // 叶子为 0, 空闲节点为 -1
+            int32_t height = 0;
+            id_t id = 0;
+
+            bool isLeaf() const { return child1 == NULL_NODE; }
+        };
+
+        struct BuildRef {
+            GolaAabb bounds;
+            glm::vec3 centroid;
+            id_t id;
+        };
+
+        int32_t allocateNode();
+
+        void freeNode(int32_t index);
+
+        void insertLeaf(int32_t leaf);
+
+        void removeLeaf(int32_t leaf);
+
+        // 从 index 开始向上重新计算包围盒和高度, 每一层尝试旋转
+        void refitAncestors(int32_t index);
+
+        void rotate(int32_t index);
+
+        // count 个对象的子树恰好占用 2 * count - 1 个节点, 左右子树的节点区间可以直接算出, 并行构建无需加锁
+        void buildRange(BuildRef *refs, uint32_t count, int32_t nodeIndex, int32_t parent, int parallelDepth,
+                        int depth);
+
+        int32_t findLeaf(id_t id) const;
+
+        std::vector<Node> nodes;
+        int32_t root = NULL_NODE;
+        // 空闲节点通过 parent 串成链表
+        int32_t freeList = NULL_NODE;
+        uint32_t leafCount = 0;
+        std::unordered_map<id_t, int32_t> leaves;
+    };
+}
@@ -0,0 +1,167 @@
+#include "gola_command_recorder.hpp"
+
+#include "gola_job_system.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace gola {
+    GolaCommandRecorder::GolaCommandRecorder(GolaDevice &device)
+        : golaDevice{device},
+          threadCapacity{std::min(GolaJobSystem::get().getThreadCount(), MAX_THREADS)} {
+        createCommandPools();
+    }
+
+    GolaCommandRecorder::~GolaCommandRecorder() {
+        for (auto &pools: framePools) {
+            for (auto &pool: pools) {
+                // 销毁 pool 时一并释放其中的 command buffer
+                vkDestroyCommandPool(golaDevice.device(), pool.commandPool, nullptr);
+            }
+        }
+    }
+
+    void GolaCommandRecorder::createCommandPools() {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = golaDevice.findPhysicalQueueFamilies().graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        for (auto &pools: framePools) {
+            pools.resize(threadCapacity);
+            for (auto &pool: pools) {
+                if (vkCreateCommandPool(golaDevice.device(), &poolInfo, nullptr, &pool.commandPool) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create recording command pool!");
+                }
+            }
+        }
+    }
+
+    void GolaCommandRecorder::beginFrame(int frameIndex) {
+        assert(!isInRenderPass() && "Can't begin a recorder frame inside a render pass");
+        currentFrameIndex = frameIndex;
+        reset();
+    }
+
+    void GolaCommandRecorder::reset() {
+        for (auto &pool: framePools[currentFrameIndex]) {
+            if (pool.usedCount == 0) {
+                continue;
+            }
+            if (vkResetCommandPool(golaDevice.device(), pool.commandPool, 0) != VK_SUCCESS) {
+                throw std::runtime_error("failed to reset recording command pool!");
+            }
+            pool.usedCount = 0;
+        }
+    }
+
+    void GolaCommandRecorder::beginRenderPass(VkCommandBuffer primary, VkRenderPass renderPass,
+                                              VkFramebuffer framebuffer, VkExtent2D extent) {
+        primaryCommandBuffer = primary;
+        currentRenderPass = renderPass;
+        currentFramebuffer = framebuffer;
+        currentExtent = extent;
+    }
+
+    void GolaCommandRecorder::beginRendering(VkCommandBuffer primary, const std::vector<VkFormat> &colorFormats,
+                                             VkFormat depthFormat, VkExtent2D extent) {
+        primaryCommandBuffer = primary;
+        currentColorFormats = colorFormats;
+        currentDepthFormat = depthFormat;
+        currentExtent = extent;
+    }
+
+    void GolaCommandRecorder::endRenderPass() {
+        primaryCommandBuffer = VK_NULL_HANDLE;
+        currentRenderPass = VK_NULL_HANDLE;
+        currentFramebuffer = VK_NULL_HANDLE;
+        currentColorFormats.clear();
+        currentDepthFormat = VK_FORMAT_UNDEFINED;
+    }
+
+    VkCommandBuffer GolaCommandRecorder::beginSecondary(uint32_t chunk) {
+        ChunkPool &pool = framePools[currentFrameIndex][chunk];
+        if (pool.usedCount == pool.commandBuffers.size()) {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandPool = pool.commandPool;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer;
+            if (vkAllocateCommandBuffers(golaDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate secondary command buffer!");
+            }
+            pool.commandBuffers.push_back(commandBuffer);
+        }
+        VkCommandBuffer commandBuffer = pool.commandBuffers[pool.usedCount++];
+
+        // 动态渲染时没有 render pass, 改为继承 attachment 格式
+        const bool hasStencil = currentDepthFormat == VK_FORMAT_D16_UNORM_S8_UINT ||
+                                currentDepthFormat == VK_FORMAT_D24_UNORM_S8_UINT ||
+                                currentDepthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT;
+        VkCommandBufferInheritanceRenderingInfo renderingInfo{};
+        renderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+        renderingInfo.colorAttachmentCount = static_cast<uint32_t>(currentColorFormats.size());
+        renderingInfo.pColorAttachmentFormats = currentColorFormats.data();
+        renderingInfo.depthAttachmentFormat = currentDepthFormat;
+        renderingInfo.stencilAttachmentFormat = hasStencil ? currentDepthFormat : VK_FORMAT_UNDEFINED;
+        renderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.pNext = currentRenderPass == VK_NULL_HANDLE ? &renderingInfo : nullptr;
+        inheritanceInfo.renderPass = currentRenderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = currentFramebuffer;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT |
+                          VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to begin recording secondary command buffer!");
+        }
+
+        // 动态状态不会从 primary 继承
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(currentExtent.width);
+        viewport.height = static_cast<float>(currentExtent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        VkRect2D scissor{{0, 0}, currentExtent};
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        return commandBuffer;
+    }
+
+    uint32_t GolaCommandRecorder::record(uint32_t itemCount, uint32_t threadCount, const RecordFunction &recordChunk,
+                                         bool execute) {
+        assert(isInRenderPass() && "Secondary command buffers can only be recorded inside a render pass");
+
+        const uint32_t chunkTarget = std::max(1u, std::min({
+            threadCount, threadCapacity, (itemCount + MIN_ITEMS_PER_THREAD - 1) / MIN_ITEMS_PER_THREAD}));
+
+        // 每块用与块编号对应的 pool, 同一时间只有一个任务使用它
+        std::array<VkCommandBuffer, MAX_THREADS> commandBuffers{};
+        const uint32_t chunkCount = GolaJobSystem::get().parallelFor(
+            itemCount, chunkTarget, [&](uint32_t begin, uint32_t end, uint32_t chunk) {
+                VkCommandBuffer commandBuffer = beginSecondary(chunk);
+                recordChunk(commandBuffer, begin, end, chunk);
+                if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to record secondary command buffer!");
+                }
+                commandBuffers[chunk] = commandBuffer;
+            });
+
+        if (execute && chunkCount > 0) {
+            vkCmdExecuteCommands(primaryCommandBuffer, chunkCount, commandBuffers.data());
+        }
+        return chunkCount;
+    }
+}
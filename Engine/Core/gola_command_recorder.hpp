@@ -0,0 +1,97 @@
+#pragma once
+
+#include "gola_device.hpp"
+#include "gola_swap_chain.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace gola {
+    /*
+     * 多线程录制 render pass 内的命令: 绘制按连续的区间分块, 每块作为一个任务录制到一个 secondary command buffer,
+     * 再由 primary 按块的顺序 vkCmdExecuteCommands, 结果与单线程录制相同.
+     * 每个 frame in flight, 每个块一个 transient command pool; 帧开始时整个 pool 一次重置
+     * (该帧上一次提交的 GPU 工作已经完成), 不逐个重置 command buffer. 同一个 pool 同一时间只被一个任务使用, 不需要加锁.
+     */
+    class GolaCommandRecorder {
+    public:
+        static constexpr uint32_t MAX_THREADS = 16;
+        // 每个线程至少录制这么多项, 更少时启动线程的开销超过收益
+        static constexpr uint32_t MIN_ITEMS_PER_THREAD = 1024;
+
+        using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end,
+                                                  uint32_t chunk)>;
+
+        explicit GolaCommandRecorder(GolaDevice &device);
+
+        ~GolaCommandRecorder();
+
+        GolaCommandRecorder(const GolaCommandRecorder &) = delete;
+
+        GolaCommandRecorder &operator=(const GolaCommandRecorder &) = delete;
+
+        // 可用的录制线程数 (任务系统的线程数, 最多 MAX_THREADS)
+        uint32_t getMaxThreadCount() const { return threadCapacity; }
+
+        // Resets every pool of frameIndex. The GPU must have finished the frame's previous submission.
+        void beginFrame(int frameIndex);
+
+        // Resets the current frame's pools again, freeing everything recorded so far. Only valid while
+        // none of those command buffers has been executed by a primary (used by benchmarks).
+        void reset();
+
+        // Called after the primary began a render pass with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+        // Secondaries inherit the render pass and framebuffer and set the same full-extent viewport and scissor.
+        void beginRenderPass(VkCommandBuffer primary, VkRenderPass renderPass, VkFramebuffer framebuffer,
+                             VkExtent2D extent);
+
+        // Same for a primary that called vkCmdBeginRendering with VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT.
+        // Secondaries inherit the attachment formats instead of a render pass.
+        void beginRendering(VkCommandBuffer primary, const std::vector<VkFormat> &colorFormats, VkFormat depthFormat,
+                            VkExtent2D extent);
+
+        // 结束 beginRenderPass 或 beginRendering
+        void endRenderPass();
+
+        // 为 true 时 render pass 内只能执行 secondary command buffer, 不能直接录制命令
+        bool isInRenderPass() const { return primaryCommandBuffer != VK_NULL_HANDLE; }
+
+        // Splits [0, itemCount) into at most threadCount contiguous chunks and calls
+        // recordChunk(commandBuffer, begin, end, chunk) for each as a job (GolaJobSystem::parallelFor),
+        // then executes the secondaries in chunk order. Returns the number of chunks (<= MAX_THREADS).
+        // With execute == false the secondaries are only recorded, and freed with the pools.
+        uint32_t record(uint32_t itemCount, uint32_t threadCount, const RecordFunction &recordChunk,
+                        bool execute = true);
+
+    private:
+        struct ChunkPool {
+            VkCommandPool commandPool = VK_NULL_HANDLE;
+            // 已分配的 secondary, 重置 pool 后从头复用
+            std::vector<VkCommandBuffer> commandBuffers;
+            uint32_t usedCount = 0;
+        };
+
+        void createCommandPools();
+
+        VkCommandBuffer beginSecondary(uint32_t chunk);
+
+        GolaDevice &golaDevice;
+        uint32_t threadCapacity;
+        std::array<std::vector<ChunkPool>, GolaSwapChain::MAX_FRAMES_IN_FLIGHT> framePools;
+        int currentFrameIndex = 0;
+
+        // 当前 render pass 的继承信息
+        VkCommandBuffer primaryCommandBuffer = VK_NULL_HANDLE;
+        VkRenderPass currentRenderPass = VK_NULL_HANDLE;
+        VkFramebuffer currentFramebuffer = VK_NULL_HANDLE;
+        // 动态渲染时代替 render pass
+        std::vector<VkFormat> currentColorFormats;
+        VkFormat currentDepthFormat = VK_FORMAT_UNDEFINED;
+        VkExtent2D currentExtent{};
+    };
+}
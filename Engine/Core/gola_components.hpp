@@ -0,0 +1,120 @@
+#pragma once
+
+#include "gola_model.hpp"
+#include "vec3.hpp"
+
+#include <gtc/matrix_transform.hpp>
+
+namespace gola {
+    /*
+     * 对象的平移 / 旋转 (YXZ 欧拉角) / 缩放. 模型矩阵缓存在对象内, 只有通过 setter 修改后才重新计算;
+     * 通常由 GolaTransformSystem 每帧并行更新所有修改过的实体, mat4() 只返回缓存.
+     */
+    class Transform {
+    public:
+        const glm::vec3 &getTranslation() const { return translation; }
+        const glm::vec3 &getRotation() const { return rotation; }
+        const glm::vec3 &getScale() const { return scale; }
+
+        void setTranslation(const glm::vec3 &value) {
+            if (translation != value) {
+                translation = value;
+                markDirty();
+            }
+        }
+
+        void setRotation(const glm::vec3 &value) {
+            if (rotation != value) {
+                rotation = value;
+                markDirty();
+            }
+        }
+
+        void setScale(const glm::vec3 &value) {
+            if (scale != value) {
+                scale = value;
+                markDirty();
+            }
+        }
+
+        // 矩阵仍是脏的 (没有经过 GolaTransformSystem) 时就地计算
+        const glm::mat4 &mat4() {
+            if (matrixDirty) {
+                updateMatrix();
+            }
+            return matrix;
+        }
+
+        void updateMatrix() {
+            matrix = computeMatrix();
+            matrixDirty = false;
+        }
+
+        // 由批量计算的结果 (GolaMatrixKernel::buildModelMatrices) 填充缓存, value 必须对应当前的平移 / 旋转 / 缩放
+        void setMatrix(const glm::mat4 &value) {
+            matrix = value;
+            matrixDirty = false;
+        }
+
+        // changed 在下一次 GolaTransformSystem::update 时上报并清除, 与矩阵是否已重新计算无关
+        bool hasChanged() const { return changed; }
+        void clearChanged() { changed = false; }
+
+    private:
+        void markDirty() {
+            matrixDirty = true;
+            changed = true;
+        }
+
+        glm::mat4 computeMatrix() const {
+            const float c3 = glm::cos(rotation.z);
+            const float s3 = glm::sin(rotation.z);
+            const float c2 = glm::cos(rotation.x);
+            const float s2 = glm::sin(rotation.x);
+            const float c1 = glm::cos(rotation.y);
+            const float s1 = glm::sin(rotation.y);
+            return glm::mat4{
+          {
+              scale.x * (c1 * c3 + s1 * s2 * s3),
+              scale.x * (c2 * s3),
+              scale.x * (c1 * s2 * s3 - c3 * s1),
+              0.0f,
+          },
+          {
+              scale.y * (c3 * s1 * s2 - c1 * s3),
+              scale.y * (c2 * c3),
+              scale.y * (c1 * c3 * s2 + s1 * s3),
+              0.0f,
+          },
+          {
+              scale.z * (c2 * s1),
+              scale.z * (-s2),
+              scale.z * (c1 * c2),
+              0.0f,
+          },
+          {translation.x, translation.y, translation.z, 1.0f}};
+        }
+
+        glm::vec3 translation{};
+        glm::vec3 scale{1.0f, 1.0f, 1.0f};
+        glm::vec3 rotation{};
+
+        glm::mat4 matrix{1.0f};
+        bool matrixDirty = true;
+        // 新实体在第一次更新时也算作修改过
+        bool changed = true;
+    };
+
+    // 可绘制实体的模型, 模型本身由场景 (GolaApp) 持有, 组件里只存指针, 遍历时不触碰引用计数
+    struct ModelComponent {
+        GolaModel *model = nullptr;
+    };
+
+    struct ColorComponent {
+        glm::vec3 color{1.0f};
+    };
+
+    // 带有该组件的实体由 KeyboardMovementController 移动
+    struct KeyboardControlComponent {
+    };
+}
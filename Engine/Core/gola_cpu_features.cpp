@@ -0,0 +1,38 @@
+#include "gola_cpu_features.hpp"
+
+#if GOLA_ARCH_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace gola {
+    static GolaCpuFeatures detectCpuFeatures() {
+        GolaCpuFeatures features{};
+#if GOLA_ARCH_X86 && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+        __cpuid(info, 1);
+        features.sse2 = (info[3] & (1 << 26)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        // AVX 寄存器需要操作系统保存 (XCR0 的 XMM/YMM 位)
+        bool osSavesYmm = osxsave && (_xgetbv(0) & 0x6) == 0x6;
+        if (maxLeaf >= 7 && osSavesYmm) {
+            __cpuidex(info, 7, 0);
+            features.avx2 = (info[1] & (1 << 5)) != 0;
+            // ZMM 寄存器和掩码寄存器同样需要操作系统保存 (XCR0 的 opmask/ZMM 位)
+            features.avx512f = (info[1] & (1 << 16)) != 0 && (_xgetbv(0) & 0xE6) == 0xE6;
+        }
+#elif GOLA_ARCH_X86
+        __builtin_cpu_init();
+        features.sse2 = __builtin_cpu_supports("sse2");
+        features.avx2 = __builtin_cpu_supports("avx2");
+        features.avx512f = __builtin_cpu_supports("avx512f");
+#endif
+        return features;
+    }
+
+    const GolaCpuFeatures &GolaCpuFeatures::get() {
+        static const GolaCpuFeatures features = detectCpuFeatures();
+        return features;
+    }
+}
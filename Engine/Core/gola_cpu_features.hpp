@@ -0,0 +1,27 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GOLA_ARCH_X86 1
+#else
+#define GOLA_ARCH_X86 0
+#endif
+
+// 单个函数按指定指令集编译, 由运行时检测决定是否调用; MSVC 不需要标注即可使用 intrinsics
+#if GOLA_ARCH_X86 && (defined(__GNUC__) || defined(__clang__))
+#define GOLA_TARGET_AVX2 __attribute__((target("avx2")))
+#define GOLA_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define GOLA_TARGET_AVX2
+#define GOLA_TARGET_AVX512
+#endif
+
+namespace gola {
+    // 运行时检测的 CPU 指令集, 用于选择 SIMD 实现
+    struct GolaCpuFeatures {
+        bool sse2 = false;
+        bool avx2 = false;
+        bool avx512f = false;
+
+        static const GolaCpuFeatures &get();
+    };
+}
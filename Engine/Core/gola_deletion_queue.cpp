@@ -0,0 +1,47 @@
+#include "gola_deletion_queue.hpp"
+
+#include "gola_timeline.hpp"
+
+// std
+#include <vector>
+
+namespace gola {
+    GolaDeletionQueue::GolaDeletionQueue(GolaTimeline &timeline) : timeline{timeline} {
+    }
+
+    GolaDeletionQueue::~GolaDeletionQueue() { flush(); }
+
+    void GolaDeletionQueue::push(std::function<void()> destroy, uint32_t frames) {
+        entries.push_back({timeline.getSubmittedValue(), frameNumber + frames, std::move(destroy)});
+    }
+
+    void GolaDeletionQueue::collect() {
+        frameNumber++;
+        // 帧数条件不同的条目可能不按顺序就绪, 逐个检查. 先取出再执行, 销毁函数里可能再 push
+        std::vector<std::function<void()>> ready;
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->frame <= frameNumber && timeline.isComplete(it->timelineValue)) {
+                ready.push_back(std::move(it->destroy));
+                it = entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (auto &destroy: ready) {
+            destroy();
+        }
+    }
+
+    void GolaDeletionQueue::flush() {
+        if (entries.empty()) {
+            return;
+        }
+        timeline.wait(entries.back().timelineValue);
+        // 销毁函数里可能再 push 新的条目, 不能直接遍历
+        while (!entries.empty()) {
+            std::function<void()> destroy = std::move(entries.front().destroy);
+            entries.pop_front();
+            destroy();
+        }
+    }
+}
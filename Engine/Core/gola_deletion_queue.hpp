@@ -0,0 +1,51 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+namespace gola {
+    class GolaTimeline;
+
+    /*
+     * 延迟销毁队列: push() 记下时间线上已经提交的值, 这个值完成 (并且经过了指定的帧数) 之后才执行销毁,
+     * 正在被 GPU 使用的对象因此不需要 vkDeviceWaitIdle 就可以释放. 销毁按 push 的顺序执行. 只能在主线程使用.
+     */
+    class GolaDeletionQueue {
+    public:
+        explicit GolaDeletionQueue(GolaTimeline &timeline);
+
+        // 等待并执行所有还没执行的销毁
+        ~GolaDeletionQueue();
+
+        GolaDeletionQueue(const GolaDeletionQueue &) = delete;
+
+        GolaDeletionQueue &operator=(const GolaDeletionQueue &) = delete;
+
+        // Runs destroy once everything submitted to the timeline so far has completed and collect() has been
+        // called at least `frames` more times. The frame delay covers uses the timeline cannot see, such as a
+        // queued present still waiting on a swap chain semaphore.
+        void push(std::function<void()> destroy, uint32_t frames = 0);
+
+        // Called once per frame. Runs every destruction whose conditions are met; never blocks.
+        void collect();
+
+        // Waits for the timeline and runs every pending destruction.
+        void flush();
+
+        size_t getPendingCount() const { return entries.size(); }
+
+    private:
+        struct Entry {
+            uint64_t timelineValue;
+            // collect() 的次数达到这个值之后才能执行
+            uint64_t frame;
+            std::function<void()> destroy;
+        };
+
+        GolaTimeline &timeline;
+        std::deque<Entry> entries;
+        uint64_t frameNumber = 0;
+    };
+}
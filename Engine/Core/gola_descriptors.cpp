@@ -0,0 +1,187 @@
+#include "gola_descriptors.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace gola {
+    // *************** Descriptor Set Layout Builder *********************
+
+    GolaDescriptorSetLayout::Builder &GolaDescriptorSetLayout::Builder::addBinding(
+        uint32_t binding,
+        VkDescriptorType descriptorType,
+        VkShaderStageFlags stageFlags,
+        uint32_t count) {
+        assert(bindings.count(binding) == 0 && "Binding already in use");
+        VkDescriptorSetLayoutBinding layoutBinding{};
+        layoutBinding.binding = binding;
+        layoutBinding.descriptorType = descriptorType;
+        layoutBinding.descriptorCount = count;
+        layoutBinding.stageFlags = stageFlags;
+        bindings[binding] = layoutBinding;
+        return *this;
+    }
+
+    std::unique_ptr<GolaDescriptorSetLayout> GolaDescriptorSetLayout::Builder::build() const {
+        return std::make_unique<GolaDescriptorSetLayout>(golaDevice, bindings);
+    }
+
+    // *************** Descriptor Set Layout *********************
+
+    GolaDescriptorSetLayout::GolaDescriptorSetLayout(
+        GolaDevice &golaDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings)
+        : golaDevice{golaDevice}, bindings{bindings} {
+        std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
+        for (auto kv: bindings) {
+            setLayoutBindings.push_back(kv.second);
+        }
+
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
+        descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
+        descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
+
+        if (vkCreateDescriptorSetLayout(
+                golaDevice.device(),
+                &descriptorSetLayoutInfo,
+                nullptr,
+                &descriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor set layout!");
+        }
+    }
+
+    GolaDescriptorSetLayout::~GolaDescriptorSetLayout() {
+        vkDestroyDescriptorSetLayout(golaDevice.device(), descriptorSetLayout, nullptr);
+    }
+
+    // *************** Descriptor Pool Builder *********************
+
+    GolaDescriptorPool::Builder &GolaDescriptorPool::Builder::addPoolSize(
+        VkDescriptorType descriptorType, uint32_t count) {
+        poolSizes.push_back({descriptorType, count});
+        return *this;
+    }
+
+    GolaDescriptorPool::Builder &GolaDescriptorPool::Builder::setPoolFlags(VkDescriptorPoolCreateFlags flags) {
+        poolFlags = flags;
+        return *this;
+    }
+
+    GolaDescriptorPool::Builder &GolaDescriptorPool::Builder::setMaxSets(uint32_t count) {
+        maxSets = count;
+        return *this;
+    }
+
+    std::unique_ptr<GolaDescriptorPool> GolaDescriptorPool::Builder::build() const {
+        return std::make_unique<GolaDescriptorPool>(golaDevice, maxSets, poolFlags, poolSizes);
+    }
+
+    // *************** Descriptor Pool *********************
+
+    GolaDescriptorPool::GolaDescriptorPool(
+        GolaDevice &golaDevice,
+        uint32_t maxSets,
+        VkDescriptorPoolCreateFlags poolFlags,
+        const std::vector<VkDescriptorPoolSize> &poolSizes)
+        : golaDevice{golaDevice} {
+        VkDescriptorPoolCreateInfo descriptorPoolInfo{};
+        descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        descriptorPoolInfo.pPoolSizes = poolSizes.data();
+        descriptorPoolInfo.maxSets = maxSets;
+        descriptorPoolInfo.flags = poolFlags;
+
+        if (vkCreateDescriptorPool(golaDevice.device(), &descriptorPoolInfo, nullptr, &descriptorPool) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor pool!");
+        }
+    }
+
+    GolaDescriptorPool::~GolaDescriptorPool() {
+        vkDestroyDescriptorPool(golaDevice.device(), descriptorPool, nullptr);
+    }
+
+    bool GolaDescriptorPool::allocateDescriptor(
+        const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet &descriptor) const {
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.pSetLayouts = &descriptorSetLayout;
+        allocInfo.descriptorSetCount = 1;
+
+        return vkAllocateDescriptorSets(golaDevice.device(), &allocInfo, &descriptor) == VK_SUCCESS;
+    }
+
+    void GolaDescriptorPool::freeDescriptors(std::vector<VkDescriptorSet> &descriptors) const {
+        vkFreeDescriptorSets(
+            golaDevice.device(),
+            descriptorPool,
+            static_cast<uint32_t>(descriptors.size()),
+            descriptors.data());
+    }
+
+    void GolaDescriptorPool::resetPool() {
+        vkResetDescriptorPool(golaDevice.device(), descriptorPool, 0);
+    }
+
+    // *************** Descriptor Writer *********************
+
+    GolaDescriptorWriter::GolaDescriptorWriter(GolaDescriptorSetLayout &setLayout, GolaDescriptorPool &pool)
+        : setLayout{setLayout}, pool{pool} {
+    }
+
+    GolaDescriptorWriter &GolaDescriptorWriter::writeBuffer(uint32_t binding, VkDescriptorBufferInfo *bufferInfo) {
+        assert(setLayout.bindings.count(binding) == 1 && "Layout does not contain specified binding");
+
+        auto &bindingDescription = setLayout.bindings[binding];
+
+        assert(bindingDescription.descriptorCount == 1 &&
+            "Binding single descriptor info, but binding expects multiple");
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.descriptorType = bindingDescription.descriptorType;
+        write.dstBinding = binding;
+        write.pBufferInfo = bufferInfo;
+        write.descriptorCount = 1;
+
+        writes.push_back(write);
+        return *this;
+    }
+
+    GolaDescriptorWriter &GolaDescriptorWriter::writeImage(uint32_t binding, VkDescriptorImageInfo *imageInfo) {
+        assert(setLayout.bindings.count(binding) == 1 && "Layout does not contain specified binding");
+
+        auto &bindingDescription = setLayout.bindings[binding];
+
+        assert(bindingDescription.descriptorCount == 1 &&
+            "Binding single descriptor info, but binding expects multiple");
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.descriptorType = bindingDescription.descriptorType;
+        write.dstBinding = binding;
+        write.pImageInfo = imageInfo;
+        write.descriptorCount = 1;
+
+        writes.push_back(write);
+        return *this;
+    }
+
+    bool GolaDescriptorWriter::build(VkDescriptorSet &set) {
+        bool success = pool.allocateDescriptor(setLayout.getDescriptorSetLayout(), set);
+        if (!success) {
+            return false;
+        }
+        overwrite(set);
+        return true;
+    }
+
+    void GolaDescriptorWriter::overwrite(VkDescriptorSet &set) {
+        for (auto &write: writes) {
+            write.dstSet = set;
+        }
+        vkUpdateDescriptorSets(
+            pool.golaDevice.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "gola_device.hpp"
+
+// std
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace gola {
+    class GolaDescriptorSetLayout {
+    public:
+        class Builder {
+        public:
+            Builder(GolaDevice &golaDevice) : golaDevice{golaDevice} {
+            }
+
+            Builder &addBinding(
+                uint32_t binding,
+                VkDescriptorType descriptorType,
+                VkShaderStageFlags stageFlags,
+                uint32_t count = 1);
+
+            std::unique_ptr<GolaDescriptorSetLayout> build() const;
+
+        private:
+            GolaDevice &golaDevice;
+            std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings{};
+        };
+
+        GolaDescriptorSetLayout(
+            GolaDevice &golaDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+
+        ~GolaDescriptorSetLayout();
+
+        GolaDescriptorSetLayout(const GolaDescriptorSetLayout &) = delete;
+
+        GolaDescriptorSetLayout &operator=(const GolaDescriptorSetLayout &) = delete;
+
+        VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+
+    private:
+        GolaDevice &golaDevice;
+        VkDescriptorSetLayout descriptorSetLayout;
+        std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings;
+
+        friend class GolaDescriptorWriter;
+    };
+
+    class GolaDescriptorPool {
+    public:
+        class Builder {
+        public:
+            Builder(GolaDevice &golaDevice) : golaDevice{golaDevice} {
+            }
+
+            Builder &addPoolSize(VkDescriptorType descriptorType, uint32_t count);
+
+            Builder &setPoolFlags(VkDescriptorPoolCreateFlags flags);
+
+            Builder &setMaxSets(uint32_t count);
+
+            std::unique_ptr<GolaDescriptorPool> build() const;
+
+        private:
+            GolaDevice &golaDevice;
+            std::vector<VkDescriptorPoolSize> poolSizes{};
+            uint32_t maxSets = 1000;
+            VkDescriptorPoolCreateFlags poolFlags = 0;
+        };
+
+        GolaDescriptorPool(
+            GolaDevice &golaDevice,
+            uint32_t maxSets,
+            VkDescriptorPoolCreateFlags poolFlags,
+            const std::vector<VkDescriptorPoolSize> &poolSizes);
+
+        ~GolaDescriptorPool();
+
+        GolaDescriptorPool(const GolaDescriptorPool &) = delete;
+
+        GolaDescriptorPool &operator=(const GolaDescriptorPool &) = delete;
+
+        bool allocateDescriptor(
+            const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet &descriptor) const;
+
+        void freeDescriptors(std::vector<VkDescriptorSet> &descriptors) const;
+
+        void resetPool();
+
+    private:
+        GolaDevice &golaDevice;
+        VkDescriptorPool descriptorPool;
+
+        friend class GolaDescriptorWriter;
+    };
+
+    // 按 binding 收集写入, build() 分配新集合, overwrite() 更新已有集合
+    class GolaDescriptorWriter {
+    public:
+        GolaDescriptorWriter(GolaDescriptorSetLayout &setLayout, GolaDescriptorPool &pool);
+
+        GolaDescriptorWriter &writeBuffer(uint32_t binding, VkDescriptorBufferInfo *bufferInfo);
+
+        GolaDescriptorWriter &writeImage(uint32_t binding, VkDescriptorImageInfo *imageInfo);
+
+        bool build(VkDescriptorSet &set);
+
+        void overwrite(VkDescriptorSet &set);
+
+    private:
+        GolaDescriptorSetLayout &setLayout;
+        GolaDescriptorPool &pool;
+        std::vector<VkWriteDescriptorSet> writes;
+    };
+}
@@ -1,4 +1,10 @@
 #include "gola_device.hpp"
+#include "gola_staging_ring.hpp"
+#include "gola_deletion_queue.hpp"
+#include "gola_pipeline_cache.hpp"
+#include "gola_pipeline_registry.hpp"
+#include "gola_timeline.hpp"
+#include "gola_upload_queue.hpp"
 
 // std headers
 #include <cstring>
@@ -55,7 +61,7 @@ namespace gola {
                 .set_engine_version(1, 0, 0)
                 .request_validation_layers(enableValidationLayers)
                 .use_default_debug_messenger()
-                .require_api_version(1, 0, 0)
+                .require_api_version(1, 2, 0)
                 .build();
         if (!inst_ret) {
             throw std::runtime_error("Failed to create Vulkan instance with vk-bootstrap");
@@ -69,10 +75,15 @@ namespace gola {
             throw std::runtime_error("Failed to create window surface!");
         }
 
-        // 选择物理设备
+        // 选择物理设备; 时间线信号量在 1.2 中是必须支持的特性, 帧节奏和上传都依赖它
+        VkPhysicalDeviceVulkan12Features requiredFeatures12{};
+        requiredFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        requiredFeatures12.timelineSemaphore = VK_TRUE;
         vkb::PhysicalDeviceSelector selector{vkb_inst};
         auto phys_ret = selector
                 .set_surface(surface_)
+                .set_minimum_version(1, 2)
+                .set_required_features_12(requiredFeatures12)
                 .select();
         if (!phys_ret) {
             throw std::runtime_error("Failed to select physical device with vk-bootstrap");
@@ -81,6 +92,25 @@ namespace gola {
         physicalDevice = vkb_phys.physical_device;
         properties = vkb_phys.properties;
 
+        // 可选特性: 存在则启用, 结果记录在 features 中供渲染系统选择路径
+        VkPhysicalDeviceFeatures indirectFeatures{};
+        indirectFeatures.multiDrawIndirect = VK_TRUE;
+        indirectFeatures.drawIndirectFirstInstance = VK_TRUE;
+        features.multiDrawIndirect = vkb_phys.enable_features_if_present(indirectFeatures);
+
+        VkPhysicalDeviceVulkan12Features features12{};
+        features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        features12.drawIndirectCount = VK_TRUE;
+        features.drawIndirectCount = vkb_phys.enable_extension_features_if_present(features12);
+
+        // 动态渲染在 1.3 中是核心功能, 这里按扩展启用, 1.2 设备上同样可用
+        VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures{};
+        dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+        dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+        features.dynamicRendering =
+                vkb_phys.enable_extension_if_present("VK_KHR_dynamic_rendering") &&
+                vkb_phys.enable_extension_features_if_present(dynamicRenderingFeatures);
+
         // 创建逻辑设备和队列
         vkb::DeviceBuilder dev_builder{vkb_phys};
         auto dev_ret = dev_builder.build();
@@ -92,11 +122,53 @@ namespace gola {
         graphicsQueue_ = vkb_dev.get_queue(vkb::QueueType::graphics).value();
         presentQueue_ = vkb_dev.get_queue(vkb::QueueType::present).value();
 
+        if (features.dynamicRendering) {
+            cmdBeginRendering = reinterpret_cast<PFN_vkCmdBeginRendering>(
+                vkGetDeviceProcAddr(device_, "vkCmdBeginRenderingKHR"));
+            cmdEndRendering = reinterpret_cast<PFN_vkCmdEndRendering>(
+                vkGetDeviceProcAddr(device_, "vkCmdEndRenderingKHR"));
+            features.dynamicRendering = cmdBeginRendering != nullptr && cmdEndRendering != nullptr;
+        }
+
+        graphicsTimeline = std::make_unique<GolaTimeline>(device_, graphicsQueue_);
+        deletionQueue = std::make_unique<GolaDeletionQueue>(*graphicsTimeline);
+
+        // vk-bootstrap 默认为每个队列族创建一个队列, 专用传输族的队列可以直接获取
+        QueueFamilyIndices queueFamilies = findPhysicalQueueFamilies();
+        if (queueFamilies.transferFamilyHasValue) {
+            vkGetDeviceQueue(device_, queueFamilies.transferFamily, 0, &transferQueue_);
+            transferTimeline = std::make_unique<GolaTimeline>(device_, transferQueue_);
+        }
+
         // 创建命令池
         createCommandPool();
+
+        // 所有 buffer/image 的显存都从子分配器中获取
+        allocator = std::make_unique<GolaAllocator>(device_, physicalDevice);
+
+        // 模型等静态数据的上传通道
+        stagingRing = std::make_unique<GolaStagingRing>(*this);
+        // 资源加载的上传通道, 有专用传输队列时与渲染并行
+        uploadQueue = std::make_unique<GolaUploadQueue>(*this);
+
+        // 所有管线共用的缓存, 上次运行保存的数据在这里加载
+        pipelineCache = std::make_unique<GolaPipelineCache>(device_, properties, PIPELINE_CACHE_PATH);
+        // 相同状态的管线和相同文件的 shader module 只创建一次
+        pipelineRegistry = std::make_unique<GolaPipelineRegistry>(*this);
     }
 
     GolaDevice::~GolaDevice() {
+        // 延迟销毁的对象可能还引用分配器和其他设备级对象
+        deletionQueue.reset();
+        // 此时所有管线都已创建完毕, 保存失败只会让下次启动变慢
+        pipelineRegistry.reset();
+        pipelineCache->save();
+        pipelineCache.reset();
+        uploadQueue.reset();
+        stagingRing.reset();
+        transferTimeline.reset();
+        graphicsTimeline.reset();
+        allocator.reset();
         vkDestroyCommandPool(device_, commandPool, nullptr);
         vkDestroyDevice(device_, nullptr);
 
@@ -267,20 +339,25 @@ namespace gola {
         std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
         vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
-        int i = 0;
+        // 每种取第一个满足条件的族, 与 vk-bootstrap 选择队列的方式一致; 需要遍历所有族才能找到传输族
+        uint32_t i = 0;
         for (const auto &queueFamily: queueFamilies) {
-            if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+            if (!indices.graphicsFamilyHasValue && queueFamily.queueCount > 0 &&
+                queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
                 indices.graphicsFamily = i;
                 indices.graphicsFamilyHasValue = true;
             }
             VkBool32 presentSupport = false;
             vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-            if (queueFamily.queueCount > 0 && presentSupport) {
+            if (!indices.presentFamilyHasValue && queueFamily.queueCount > 0 && presentSupport) {
                 indices.presentFamily = i;
                 indices.presentFamilyHasValue = true;
             }
-            if (indices.isComplete()) {
-                break;
+            if (!indices.transferFamilyHasValue && queueFamily.queueCount > 0 &&
+                (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+                !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+                indices.transferFamily = i;
+                indices.transferFamilyHasValue = true;
             }
 
             i++;
@@ -349,7 +426,7 @@ namespace gola {
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer &buffer,
-        VkDeviceMemory &bufferMemory) {
+        GolaAllocation &bufferAllocation) {
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         bufferInfo.size = size;
@@ -360,19 +437,21 @@ namespace gola {
             throw std::runtime_error("failed to create vertex buffer!");
         }
 
-        VkMemoryRequirements memRequirements;
-        vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
-
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        GolaResourceRequirements requirements = allocator->getBufferRequirements(buffer);
+        bufferAllocation = allocator->allocate(
+            requirements,
+            findMemoryType(requirements.memory.memoryTypeBits, properties),
+            GolaAllocator::ResourceKind::Buffer);
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
+        if (vkBindBufferMemory(device_, buffer, bufferAllocation.memory, bufferAllocation.offset) != VK_SUCCESS) {
+            throw std::runtime_error("failed to bind buffer memory!");
         }
+    }
 
-        vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+    void GolaDevice::destroyBuffer(VkBuffer &buffer, GolaAllocation &bufferAllocation) {
+        vkDestroyBuffer(device_, buffer, nullptr);
+        buffer = VK_NULL_HANDLE;
+        allocator->free(bufferAllocation);
     }
 
     VkCommandBuffer GolaDevice::beginSingleTimeCommands() {
@@ -401,8 +480,8 @@ namespace gola {
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &commandBuffer;
 
-        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(graphicsQueue_);
+        // 只等待这次提交, 时间线的值按提交顺序递增, 之前提交的工作也已经完成
+        graphicsTimeline->wait(graphicsTimeline->submit(submitInfo));
 
         vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
     }
@@ -450,25 +529,28 @@ namespace gola {
         const VkImageCreateInfo &imageInfo,
         VkMemoryPropertyFlags properties,
         VkImage &image,
-        VkDeviceMemory &imageMemory) {
+        GolaAllocation &imageAllocation) {
         if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
             throw std::runtime_error("failed to create image!");
         }
 
-        VkMemoryRequirements memRequirements;
-        vkGetImageMemoryRequirements(device_, image, &memRequirements);
+        GolaResourceRequirements requirements = allocator->getImageRequirements(image);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        // 线性排布的图像与 buffer 一样按线性资源处理
+        auto kind = imageInfo.tiling == VK_IMAGE_TILING_LINEAR
+                        ? GolaAllocator::ResourceKind::Buffer
+                        : GolaAllocator::ResourceKind::Image;
+        imageAllocation = allocator->allocate(
+            requirements, findMemoryType(requirements.memory.memoryTypeBits, properties), kind);
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate image memory!");
-        }
-
-        if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+        if (vkBindImageMemory(device_, image, imageAllocation.memory, imageAllocation.offset) != VK_SUCCESS) {
             throw std::runtime_error("failed to bind image memory!");
         }
     }
+
+    void GolaDevice::destroyImage(VkImage &image, GolaAllocation &imageAllocation) {
+        vkDestroyImage(device_, image, nullptr);
+        image = VK_NULL_HANDLE;
+        allocator->free(imageAllocation);
+    }
 } // namespace gola
@@ -1,13 +1,22 @@
 #pragma once
 
 #include "../Window/gola_window.hpp"
+#include "gola_allocator.hpp"
 #include "VkBootstrap.h"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace gola {
+    class GolaStagingRing;
+    class GolaPipelineCache;
+    class GolaPipelineRegistry;
+    class GolaTimeline;
+    class GolaDeletionQueue;
+    class GolaUploadQueue;
+
     struct SwapChainSupportDetails {
         VkSurfaceCapabilitiesKHR capabilities;
         std::vector<VkSurfaceFormatKHR> formats;
@@ -17,11 +26,24 @@ namespace gola {
     struct QueueFamilyIndices {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        // 只支持传输的队列族 (没有 GRAPHICS 和 COMPUTE), 通常对应独立的 DMA 引擎; 不是 isComplete 的条件
+        uint32_t transferFamily;
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
+        bool transferFamilyHasValue = false;
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
     };
 
+    // 运行时检测到的可选设备能力, 不支持时相应的渲染路径会回退
+    struct GolaDeviceFeatures {
+        // 多个 indirect draw 合并为一次调用, 且 firstInstance 可以非零 (GPU 驱动渲染必需)
+        bool multiDrawIndirect = false;
+        // vkCmdDrawIndexedIndirectCount, 绘制数量由 GPU 写入的 buffer 决定
+        bool drawIndirectCount = false;
+        // VK_KHR_dynamic_rendering: 不需要 VkRenderPass 和 VkFramebuffer, 管线只依赖 attachment 格式
+        bool dynamicRendering = false;
+    };
+
     class GolaDevice {
     public:
 #ifdef NDEBUG
@@ -29,6 +51,8 @@ namespace gola {
 #else
         const bool enableValidationLayers = true;
 #endif
+        // 相对于工作目录, 与 shader 路径一致
+        static constexpr const char *PIPELINE_CACHE_PATH = "pipeline_cache.bin";
 
         GolaDevice(GolaWindow &window);
 
@@ -50,6 +74,22 @@ namespace gola {
         VkSurfaceKHR surface() { return surface_; }
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
+        // 没有专用传输族时为空
+        VkQueue transferQueue() { return transferQueue_; }
+        bool hasDedicatedTransferQueue() const { return transferQueue_ != VK_NULL_HANDLE; }
+        GolaStagingRing &getStagingRing() { return *stagingRing; }
+        GolaUploadQueue &getUploadQueue() { return *uploadQueue; }
+        GolaAllocator &getAllocator() { return *allocator; }
+        GolaPipelineCache &getPipelineCache() { return *pipelineCache; }
+        GolaPipelineRegistry &getPipelineRegistry() { return *pipelineRegistry; }
+        // 图形队列的所有提交都经过它, 提交得到的值标识这次提交的工作
+        GolaTimeline &getGraphicsTimeline() { return *graphicsTimeline; }
+        // 在图形队列已经提交的工作完成后才销毁对象, 代替 vkDeviceWaitIdle
+        GolaDeletionQueue &getDeletionQueue() { return *deletionQueue; }
+        // 只在 hasDedicatedTransferQueue() 时存在
+        GolaTimeline &getTransferTimeline() { return *transferTimeline; }
+        GolaAllocatorStats getAllocatorStats() const { return allocator->getStats(); }
+        const GolaDeviceFeatures &getFeatures() const { return features; }
 
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
 
@@ -61,17 +101,21 @@ namespace gola {
             const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
         // Buffer Helper Functions
+        // 内存来自 GolaAllocator 的子分配, 必须用 destroyBuffer 释放
         void createBuffer(
             VkDeviceSize size,
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer &buffer,
-            VkDeviceMemory &bufferMemory);
+            GolaAllocation &bufferAllocation);
+
+        void destroyBuffer(VkBuffer &buffer, GolaAllocation &bufferAllocation);
 
         VkCommandBuffer beginSingleTimeCommands();
 
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
 
+        // 同步拷贝, 会阻塞到拷贝完成; 加载资源使用 GolaUploadQueue
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 
         void copyBufferToImage(
@@ -81,7 +125,16 @@ namespace gola {
             const VkImageCreateInfo &imageInfo,
             VkMemoryPropertyFlags properties,
             VkImage &image,
-            VkDeviceMemory &imageMemory);
+            GolaAllocation &imageAllocation);
+
+        void destroyImage(VkImage &image, GolaAllocation &imageAllocation);
+
+        // vkCmdBeginRenderingKHR / vkCmdEndRenderingKHR, 只在 features.dynamicRendering 时可用
+        void beginRendering(VkCommandBuffer commandBuffer, const VkRenderingInfo &renderingInfo) {
+            cmdBeginRendering(commandBuffer, &renderingInfo);
+        }
+
+        void endRendering(VkCommandBuffer commandBuffer) { cmdEndRendering(commandBuffer); }
 
         VkPhysicalDeviceProperties properties;
 
@@ -127,8 +180,21 @@ namespace gola {
         VkSurfaceKHR surface_;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue transferQueue_ = VK_NULL_HANDLE;
+        GolaDeviceFeatures features{};
+        PFN_vkCmdBeginRendering cmdBeginRendering = nullptr;
+        PFN_vkCmdEndRendering cmdEndRendering = nullptr;
 
         const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
+        std::unique_ptr<GolaTimeline> graphicsTimeline;
+        std::unique_ptr<GolaTimeline> transferTimeline;
+        std::unique_ptr<GolaDeletionQueue> deletionQueue;
+        std::unique_ptr<GolaAllocator> allocator;
+        std::unique_ptr<GolaStagingRing> stagingRing;
+        std::unique_ptr<GolaUploadQueue> uploadQueue;
+        std::unique_ptr<GolaPipelineCache> pipelineCache;
+        std::unique_ptr<GolaPipelineRegistry> pipelineRegistry;
+
         const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
         vkb::Instance vkbInstance;
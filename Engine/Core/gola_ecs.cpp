@@ -0,0 +1,301 @@
+#include "gola_ecs.hpp"
+
+#include "gola_components.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <print>
+#include <random>
+#include <stdexcept>
+
+namespace gola {
+    std::vector<GolaWorld::ComponentInfo> &GolaWorld::componentRegistry() {
+        static std::vector<ComponentInfo> registry;
+        return registry;
+    }
+
+    uint32_t GolaWorld::registerComponent(const ComponentInfo &info) {
+        auto &registry = componentRegistry();
+        if (registry.size() >= MAX_COMPONENT_TYPES) {
+            throw std::runtime_error("failed to register component: too many component types!");
+        }
+        registry.push_back(info);
+        return static_cast<uint32_t>(registry.size() - 1);
+    }
+
+    GolaWorld::Archetype::~Archetype() {
+        const auto &registry = componentRegistry();
+        for (auto &chunk: chunks) {
+            for (size_t column = 0; column < componentIds.size(); column++) {
+                for (uint32_t row = 0; row < chunk.count; row++) {
+                    registry[componentIds[column]].destroy(chunk.data + offsets[column] + row * sizes[column]);
+                }
+            }
+            ::operator delete(chunk.data, std::align_val_t{CHUNK_ALIGNMENT});
+        }
+    }
+
+    GolaWorld::Archetype &GolaWorld::getArchetype(ComponentMask mask) {
+        auto it = archetypeByMask.find(mask);
+        if (it != archetypeByMask.end()) {
+            return *it->second;
+        }
+
+        auto archetype = std::make_unique<Archetype>();
+        archetype->mask = mask;
+        archetype->columnOf.fill(-1);
+
+        const auto &registry = componentRegistry();
+        size_t rowSize = sizeof(GolaEntity);
+        size_t alignmentSlack = 0;
+        for (uint32_t id = 0; id < MAX_COMPONENT_TYPES; id++) {
+            if (mask & (ComponentMask{1} << id)) {
+                archetype->columnOf[id] = static_cast<int32_t>(archetype->componentIds.size());
+                archetype->componentIds.push_back(id);
+                archetype->sizes.push_back(registry[id].size);
+                rowSize += registry[id].size;
+                alignmentSlack += registry[id].alignment;
+            }
+        }
+
+        // 按 chunk 大小决定每个 chunk 的行数, 每个组件数组的起始位置按各自的对齐要求对齐
+        archetype->chunkCapacity = static_cast<uint32_t>(
+            std::max<size_t>(1, (CHUNK_SIZE - std::min(CHUNK_SIZE, alignmentSlack)) / rowSize));
+        size_t offset = sizeof(GolaEntity) * archetype->chunkCapacity;
+        for (uint32_t id: archetype->componentIds) {
+            const size_t alignment = registry[id].alignment;
+            offset = (offset + alignment - 1) / alignment * alignment;
+            archetype->offsets.push_back(offset);
+            offset += registry[id].size * archetype->chunkCapacity;
+        }
+        archetype->chunkBytes = offset;
+
+        Archetype *result = archetype.get();
+        archetypes.push_back(std::move(archetype));
+        archetypeByMask.emplace(mask, result);
+        return *result;
+    }
+
+    GolaEntity GolaWorld::allocateEntity() {
+        aliveCount++;
+        if (!freeIndices.empty()) {
+            uint32_t index = freeIndices.back();
+            freeIndices.pop_back();
+            return {index, records[index].generation};
+        }
+        records.emplace_back();
+        return {static_cast<uint32_t>(records.size() - 1), 0};
+    }
+
+    std::pair<uint32_t, uint32_t> GolaWorld::allocateRow(Archetype &archetype, GolaEntity entity) {
+        // 除最后一个 chunk 外都是满的
+        if (archetype.chunks.empty() || archetype.chunks.back().count == archetype.chunkCapacity) {
+            Chunk chunk{};
+            chunk.data = static_cast<std::byte *>(
+                ::operator new(archetype.chunkBytes, std::align_val_t{CHUNK_ALIGNMENT}));
+            archetype.chunks.push_back(chunk);
+        }
+        const auto chunk = static_cast<uint32_t>(archetype.chunks.size() - 1);
+        const uint32_t row = archetype.chunks[chunk].count++;
+        archetype.entities(chunk)[row] = entity;
+        return {chunk, row};
+    }
+
+    void GolaWorld::removeRow(Archetype &archetype, uint32_t chunk, uint32_t row, bool destroyComponents) {
+        const auto &registry = componentRegistry();
+        const auto lastChunk = static_cast<uint32_t>(archetype.chunks.size() - 1);
+        const uint32_t lastRow = archetype.chunks[lastChunk].count - 1;
+
+        for (size_t column = 0; column < archetype.componentIds.size(); column++) {
+            const ComponentInfo &info = registry[archetype.componentIds[column]];
+            void *removed = archetype.column(chunk, static_cast<int32_t>(column), row);
+            if (destroyComponents) {
+                info.destroy(removed);
+            }
+            if (chunk != lastChunk || row != lastRow) {
+                void *last = archetype.column(lastChunk, static_cast<int32_t>(column), lastRow);
+                info.moveConstruct(removed, last);
+                info.destroy(last);
+            }
+        }
+
+        // 被移动过来的实体更新记录, 句柄本身不变
+        if (chunk != lastChunk || row != lastRow) {
+            GolaEntity moved = archetype.entities(lastChunk)[lastRow];
+            archetype.entities(chunk)[row] = moved;
+            records[moved.index].chunk = chunk;
+            records[moved.index].row = row;
+        }
+
+        if (--archetype.chunks[lastChunk].count == 0) {
+            ::operator delete(archetype.chunks[lastChunk].data, std::align_val_t{CHUNK_ALIGNMENT});
+            archetype.chunks.pop_back();
+        }
+    }
+
+    void GolaWorld::moveEntity(GolaEntity entity, Archetype &target) {
+        const auto &registry = componentRegistry();
+        EntityRecord &record = records[entity.index];
+        Archetype &source = *record.archetype;
+
+        auto [chunk, row] = allocateRow(target, entity);
+        for (size_t column = 0; column < source.componentIds.size(); column++) {
+            const uint32_t id = source.componentIds[column];
+            void *src = source.column(record.chunk, static_cast<int32_t>(column), record.row);
+            if (target.has(id)) {
+                registry[id].moveConstruct(target.column(chunk, target.columnOf[id], row), src);
+            }
+            registry[id].destroy(src);
+        }
+        removeRow(source, record.chunk, record.row, false);
+
+        record.archetype = &target;
+        record.chunk = chunk;
+        record.row = row;
+        structureVersion++;
+    }
+
+    void GolaWorld::destroyEntity(GolaEntity entity) {
+        if (!isAlive(entity)) {
+            return;
+        }
+        assertNotIterating();
+
+        EntityRecord &record = records[entity.index];
+        removeRow(*record.archetype, record.chunk, record.row, true);
+        record.archetype = nullptr;
+        record.generation++;
+        freeIndices.push_back(entity.index);
+        aliveCount--;
+        structureVersion++;
+    }
+
+    void GolaWorld::clear() {
+        assertNotIterating();
+        archetypeByMask.clear();
+        archetypes.clear();
+        for (uint32_t index = 0; index < records.size(); index++) {
+            if (records[index].archetype != nullptr) {
+                records[index].archetype = nullptr;
+                records[index].generation++;
+                freeIndices.push_back(index);
+            }
+        }
+        aliveCount = 0;
+        structureVersion++;
+    }
+
+    void GolaWorld::runBenchmark() {
+        using clock = std::chrono::high_resolution_clock;
+        auto elapsedMs = [](clock::time_point start) {
+            return std::chrono::duration<float, std::chrono::milliseconds::period>(clock::now() - start).count();
+        };
+
+        // 旧的对象布局: 每个对象一个结构体, 模型通过 shared_ptr 持有
+        struct LegacyGameObject {
+            uint32_t id;
+            std::shared_ptr<GolaModel> model;
+            glm::vec3 color;
+            Transform transform;
+        };
+
+        std::print("[DEBUG] ECS benchmark\n");
+        for (uint32_t entityCount: {100'000u, 1'000'000u}) {
+            const int iterations = entityCount >= 1'000'000u ? 10 : 100;
+            // 遍历只读取模型指针, 不会解引用, 不需要真正的模型
+            std::shared_ptr<GolaModel> sharedModel{};
+
+            std::vector<LegacyGameObject> legacy;
+            legacy.reserve(entityCount);
+            GolaWorld world{};
+            auto start = clock::now();
+            for (uint32_t i = 0; i < entityCount; i++) {
+                Transform transform{};
+                transform.setTranslation(glm::vec3(static_cast<float>(i % 1000), 0.0f, static_cast<float>(i / 1000)));
+                transform.updateMatrix();
+                world.createEntity(transform, ModelComponent{sharedModel.get()}, ColorComponent{glm::vec3(1.0f)});
+            }
+            float createMs = elapsedMs(start);
+            for (uint32_t i = 0; i < entityCount; i++) {
+                Transform transform{};
+                transform.setTranslation(glm::vec3(static_cast<float>(i % 1000), 0.0f, static_cast<float>(i / 1000)));
+                transform.updateMatrix();
+                legacy.push_back({i, sharedModel, glm::vec3(1.0f), transform});
+            }
+
+            // 1. 渲染路径的遍历: 读模型指针, 颜色和缓存的矩阵
+            float checksum = 0.0f;
+            uintptr_t modelChecksum = 0;
+            start = clock::now();
+            for (int iteration = 0; iteration < iterations; iteration++) {
+                for (auto &obj: legacy) {
+                    modelChecksum += reinterpret_cast<uintptr_t>(obj.model.get());
+                    checksum += obj.transform.mat4()[3].x + obj.color.x;
+                }
+            }
+            float legacyRenderMs = elapsedMs(start) / iterations;
+
+            start = clock::now();
+            for (int iteration = 0; iteration < iterations; iteration++) {
+                world.eachChunk<Transform, ModelComponent, ColorComponent>(
+                    [&](uint32_t count, const GolaEntity *, Transform *transforms, ModelComponent *models,
+                        ColorComponent *colors) {
+                        for (uint32_t i = 0; i < count; i++) {
+                            modelChecksum += reinterpret_cast<uintptr_t>(models[i].model);
+                            checksum += transforms[i].mat4()[3].x + colors[i].color.x;
+                        }
+                    });
+            }
+            float ecsRenderMs = elapsedMs(start) / iterations;
+
+            // 2. 只读一个小组件的遍历: ECS 只访问颜色数组, 旧布局要跨过整个对象
+            start = clock::now();
+            for (int iteration = 0; iteration < iterations; iteration++) {
+                for (auto &obj: legacy) {
+                    checksum += obj.color.y;
+                }
+            }
+            float legacyColorMs = elapsedMs(start) / iterations;
+
+            start = clock::now();
+            for (int iteration = 0; iteration < iterations; iteration++) {
+                world.eachChunk<ColorComponent>([&](uint32_t count, const GolaEntity *, ColorComponent *colors) {
+                    for (uint32_t i = 0; i < count; i++) {
+                        checksum += colors[i].color.y;
+                    }
+                });
+            }
+            float ecsColorMs = elapsedMs(start) / iterations;
+
+            // 3. 随机销毁一半实体, 其余句柄必须仍然有效
+            std::vector<GolaEntity> entities;
+            entities.reserve(entityCount);
+            world.each<Transform>([&](GolaEntity entity, Transform &) { entities.push_back(entity); });
+            std::mt19937 rng{12345};
+            std::shuffle(entities.begin(), entities.end(), rng);
+            const size_t half = entities.size() / 2;
+            start = clock::now();
+            for (size_t i = 0; i < half; i++) {
+                world.destroyEntity(entities[i]);
+            }
+            float destroyMs = elapsedMs(start);
+            size_t invalidHandles = 0;
+            for (size_t i = 0; i < entities.size(); i++) {
+                bool shouldBeAlive = i >= half;
+                if (world.isAlive(entities[i]) != shouldBeAlive ||
+                    (shouldBeAlive && world.getComponent<Transform>(entities[i]) == nullptr)) {
+                    invalidHandles++;
+                }
+            }
+
+            std::print("[DEBUG]   {:>8} entities: create {:8.2f} ms, destroy half {:8.2f} ms{}\n", entityCount,
+                       createMs, destroyMs, invalidHandles == 0 ? "" : "  INVALID HANDLES!");
+            std::print("[DEBUG]     transform+model+color: vector {:8.3f} ms, ECS {:8.3f} ms\n",
+                       legacyRenderMs, ecsRenderMs);
+            std::print("[DEBUG]     color only:            vector {:8.3f} ms, ECS {:8.3f} ms\n",
+                       legacyColorMs, ecsColorMs);
+            std::print("[DEBUG]     (checksum {} {})\n", checksum, modelChecksum);
+        }
+    }
+}
@@ -0,0 +1,283 @@
+#pragma once
+
+// std
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gola {
+    /*
+     * 实体句柄: index 是实体表中的槽位, generation 在实体销毁时递增.
+     * 槽位被复用后旧句柄的 generation 不再匹配, isAlive() 返回 false, 不会误指向新实体.
+     */
+    struct GolaEntity {
+        static constexpr uint32_t NULL_INDEX = 0xFFFFFFFF;
+
+        uint32_t index = NULL_INDEX;
+        uint32_t generation = 0;
+
+        bool isNull() const { return index == NULL_INDEX; }
+
+        bool operator==(const GolaEntity &) const = default;
+    };
+
+    /*
+     * 基于 archetype 的 ECS. 拥有相同组件集合的实体属于同一个 archetype, 存放在固定大小的 chunk 中,
+     * chunk 内每种组件一个连续数组 (SoA), 查询按 chunk 线性遍历.
+     * 删除实体时用 archetype 最后一行填补空位, 只有被移动的那个实体的记录需要更新, 其他句柄不受影响.
+     *
+     * 结构性修改 (创建 / 销毁实体, 增删组件) 会移动组件, 之前取得的组件指针随之失效;
+     * 遍历期间不允许结构性修改. getStructureVersion() 在每次结构性修改后递增, 缓存组件指针的系统用它判断是否需要重建.
+     */
+    class GolaWorld {
+    public:
+        using ComponentMask = uint64_t;
+
+        static constexpr uint32_t MAX_COMPONENT_TYPES = 64;
+        static constexpr size_t CHUNK_SIZE = 16 * 1024;
+        static constexpr size_t CHUNK_ALIGNMENT = 64;
+
+        GolaWorld() = default;
+
+        ~GolaWorld() = default;
+
+        GolaWorld(const GolaWorld &) = delete;
+
+        GolaWorld &operator=(const GolaWorld &) = delete;
+
+        template<typename... Ts>
+        GolaEntity createEntity(Ts... components) {
+            assertNotIterating();
+            Archetype &archetype = getArchetype(maskOf<Ts...>());
+            GolaEntity entity = allocateEntity();
+            auto [chunk, row] = allocateRow(archetype, entity);
+            records[entity.index] = {&archetype, chunk, row, entity.generation};
+            (new(columnData<Ts>(archetype, chunk, row)) Ts(std::move(components)), ...);
+            structureVersion++;
+            return entity;
+        }
+
+        void destroyEntity(GolaEntity entity);
+
+        bool isAlive(GolaEntity entity) const {
+            return entity.index < records.size() && records[entity.index].archetype != nullptr &&
+                   records[entity.index].generation == entity.generation;
+        }
+
+        // 销毁所有实体, 已有句柄全部失效
+        void clear();
+
+        // Returns nullptr when the entity is dead or does not have the component.
+        template<typename T>
+        T *getComponent(GolaEntity entity) {
+            if (!isAlive(entity)) {
+                return nullptr;
+            }
+            const EntityRecord &record = records[entity.index];
+            if (!record.archetype->has(componentId<T>())) {
+                return nullptr;
+            }
+            return columnData<T>(*record.archetype, record.chunk, record.row);
+        }
+
+        template<typename T>
+        bool hasComponent(GolaEntity entity) const {
+            return isAlive(entity) && records[entity.index].archetype->has(componentId<T>());
+        }
+
+        // 把实体移动到多出 T 的 archetype; 已经有 T 时直接赋值
+        template<typename T>
+        void addComponent(GolaEntity entity, T component) {
+            if (T *existing = getComponent<T>(entity)) {
+                *existing = std::move(component);
+                return;
+            }
+            assert(isAlive(entity) && "addComponent on a dead entity");
+            assertNotIterating();
+            Archetype &target = getArchetype(records[entity.index].archetype->mask | maskOf<T>());
+            moveEntity(entity, target);
+            const EntityRecord &record = records[entity.index];
+            new(columnData<T>(target, record.chunk, record.row)) T(std::move(component));
+        }
+
+        template<typename T>
+        void removeComponent(GolaEntity entity) {
+            if (!hasComponent<T>(entity)) {
+                return;
+            }
+            assertNotIterating();
+            moveEntity(entity, getArchetype(records[entity.index].archetype->mask & ~maskOf<T>()));
+        }
+
+        // Calls func(GolaEntity, Ts &...) for every entity that has all of Ts.
+        template<typename... Ts, typename Func>
+        void each(Func &&func) {
+            eachChunk<Ts...>([&](uint32_t count, const GolaEntity *entities, Ts *... columns) {
+                for (uint32_t row = 0; row < count; row++) {
+                    func(entities[row], columns[row]...);
+                }
+            });
+        }
+
+        // Calls func(count, const GolaEntity *, Ts *...) once per chunk: the arrays are contiguous,
+        // so the loop inside func can be vectorized.
+        template<typename... Ts, typename Func>
+        void eachChunk(Func &&func) {
+            const ComponentMask required = maskOf<Ts...>();
+            IterationScope scope{*this};
+            for (auto &archetype: archetypes) {
+                if ((archetype->mask & required) != required) {
+                    continue;
+                }
+                for (uint32_t chunk = 0; chunk < archetype->chunks.size(); chunk++) {
+                    func(archetype->chunks[chunk].count, archetype->entities(chunk),
+                         columnData<Ts>(*archetype, chunk, 0)...);
+                }
+            }
+        }
+
+        template<typename... Ts>
+        uint32_t count() const {
+            const ComponentMask required = maskOf<Ts...>();
+            uint32_t total = 0;
+            for (const auto &archetype: archetypes) {
+                if ((archetype->mask & required) == required) {
+                    total += archetype->entityCount();
+                }
+            }
+            return total;
+        }
+
+        uint32_t getEntityCount() const { return aliveCount; }
+        uint64_t getStructureVersion() const { return structureVersion; }
+        uint32_t getArchetypeCount() const { return static_cast<uint32_t>(archetypes.size()); }
+
+        // Compares query iteration against the old std::vector<GolaGameObject> layout at
+        // 100k and 1M entities, plus entity creation/destruction, and prints the timings.
+        static void runBenchmark();
+
+    private:
+        struct ComponentInfo {
+            size_t size;
+            size_t alignment;
+            // 移动构造到未初始化的内存
+            void (*moveConstruct)(void *dst, void *src);
+            void (*destroy)(void *ptr);
+        };
+
+        struct Chunk {
+            std::byte *data = nullptr;
+            uint32_t count = 0;
+        };
+
+        struct Archetype {
+            ComponentMask mask = 0;
+            std::vector<uint32_t> componentIds;
+            // chunk 内每种组件数组的起始偏移和元素大小, 实体句柄数组位于偏移 0
+            std::vector<size_t> offsets;
+            std::vector<size_t> sizes;
+            // componentId -> componentIds 中的位置, 没有该组件时为 -1
+            std::array<int32_t, MAX_COMPONENT_TYPES> columnOf{};
+            uint32_t chunkCapacity = 0;
+            size_t chunkBytes = 0;
+            std::vector<Chunk> chunks;
+
+            Archetype() = default;
+
+            ~Archetype();
+
+            Archetype(const Archetype &) = delete;
+
+            Archetype &operator=(const Archetype &) = delete;
+
+            bool has(uint32_t componentId) const { return columnOf[componentId] >= 0; }
+
+            GolaEntity *entities(uint32_t chunk) const { return reinterpret_cast<GolaEntity *>(chunks[chunk].data); }
+
+            void *column(uint32_t chunk, int32_t column, uint32_t row) const {
+                return chunks[chunk].data + offsets[column] + row * sizes[column];
+            }
+
+            uint32_t entityCount() const {
+                return chunks.empty()
+                           ? 0
+                           : static_cast<uint32_t>(chunks.size() - 1) * chunkCapacity + chunks.back().count;
+            }
+        };
+
+        struct EntityRecord {
+            Archetype *archetype = nullptr;
+            uint32_t chunk = 0;
+            uint32_t row = 0;
+            uint32_t generation = 0;
+        };
+
+        // 遍历期间置位, 用于在 debug 构建中捕获遍历时的结构性修改
+        struct IterationScope {
+            GolaWorld &world;
+
+            explicit IterationScope(GolaWorld &world) : world{world} { world.iterationDepth++; }
+            ~IterationScope() { world.iterationDepth--; }
+        };
+
+        static std::vector<ComponentInfo> &componentRegistry();
+
+        static uint32_t registerComponent(const ComponentInfo &info);
+
+        template<typename T>
+        static uint32_t componentId() {
+            static_assert(std::is_nothrow_move_constructible_v<T>, "components must be nothrow move constructible");
+            static const uint32_t id = registerComponent({
+                sizeof(T),
+                alignof(T),
+                [](void *dst, void *src) { new(dst) T(std::move(*static_cast<T *>(src))); },
+                [](void *ptr) { static_cast<T *>(ptr)->~T(); },
+            });
+            return id;
+        }
+
+        template<typename... Ts>
+        static ComponentMask maskOf() {
+            return (ComponentMask{0} | ... | (ComponentMask{1} << componentId<Ts>()));
+        }
+
+        template<typename T>
+        T *columnData(const Archetype &archetype, uint32_t chunk, uint32_t row) const {
+            return static_cast<T *>(archetype.column(chunk, archetype.columnOf[componentId<T>()], row));
+        }
+
+        void assertNotIterating() const {
+            assert(iterationDepth == 0 && "structural changes are not allowed while iterating the world");
+        }
+
+        Archetype &getArchetype(ComponentMask mask);
+
+        GolaEntity allocateEntity();
+
+        // 在 archetype 末尾追加一行 (组件内存未初始化), 返回 chunk 和行号
+        std::pair<uint32_t, uint32_t> allocateRow(Archetype &archetype, GolaEntity entity);
+
+        // 用最后一行填补 (chunk, row); destroyComponents 为 false 时该行的组件已经被移走或析构
+        void removeRow(Archetype &archetype, uint32_t chunk, uint32_t row, bool destroyComponents);
+
+        // 把实体的组件移动到 target, target 中新增的组件留给调用者构造
+        void moveEntity(GolaEntity entity, Archetype &target);
+
+        std::vector<EntityRecord> records;
+        std::vector<uint32_t> freeIndices;
+        uint32_t aliveCount = 0;
+
+        std::vector<std::unique_ptr<Archetype>> archetypes;
+        std::unordered_map<ComponentMask, Archetype *> archetypeByMask;
+
+        uint64_t structureVersion = 0;
+        int iterationDepth = 0;
+    };
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "gola_camera.hpp"
+#include "gola_components.hpp"
+#include "gola_ecs.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+
+namespace gola {
+    class GolaCommandRecorder;
+    class GolaGpuProfiler;
+
+    // 一帧内各个渲染系统共享的状态
+    struct FrameInfo {
+        int frameIndex;
+        float frameTime;
+        VkCommandBuffer commandBuffer;
+        GolaCamera &camera;
+        // render pass 以 VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS 开始时, 绘制命令通过它录制
+        GolaCommandRecorder *commandRecorder = nullptr;
+        // 为空时不计时; 作用域写入 commandBuffer, 所以只能在同一时间只录制一个 command buffer 的地方使用
+        GolaGpuProfiler *gpuProfiler = nullptr;
+    };
+
+    // 渲染系统从 GolaWorld 收集的可绘制实体; 组件指针在世界下一次结构性修改之前有效
+    struct RenderObject {
+        GolaEntity entity;
+        Transform *transform;
+        GolaModel *model;
+        glm::vec3 color;
+    };
+
+    enum class RenderMode {
+        PerObject, // 每个对象一次 draw + push constant
+        Instanced, // 每个模型一次实例化 draw, CPU 每帧写实例缓冲区
+        GpuDriven, // compute shader 生成 indirect 命令, CPU 开销与对象数无关
+    };
+
+    // 渲染系统每帧产出的统计数据, 显示在 ImGui 调试窗口中
+    struct RenderStats {
+        uint32_t objectCount = 0;
+        // 视锥剔除结果
+        uint32_t visibleCount = 0;
+        uint32_t culledCount = 0;
+        uint32_t drawCalls = 0;
+        uint64_t triangleCount = 0;
+        float cpuRecordMs = 0.0f;
+        // 并行录制 secondary command buffer 的线程数, 0 表示直接录制到 primary
+        uint32_t recordingThreads = 0;
+        RenderMode mode = RenderMode::PerObject;
+    };
+}
@@ -0,0 +1,28 @@
+#include "gola_frame_limiter.hpp"
+
+// std
+#include <thread>
+
+namespace gola {
+    void GolaFrameLimiter::wait(float frameRate) {
+        if (frameRate <= 0.0f) {
+            nextFrameTime = {};
+            return;
+        }
+
+        const auto frameDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / frameRate));
+        const auto now = std::chrono::steady_clock::now();
+        if (nextFrameTime == std::chrono::steady_clock::time_point{} || now > nextFrameTime + frameDuration) {
+            nextFrameTime = now;
+        }
+
+        if (nextFrameTime - now > SPIN_THRESHOLD) {
+            std::this_thread::sleep_for(nextFrameTime - now - SPIN_THRESHOLD);
+        }
+        while (std::chrono::steady_clock::now() < nextFrameTime) {
+            std::this_thread::yield();
+        }
+        nextFrameTime += frameDuration;
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+// std
+#include <chrono>
+
+namespace gola {
+    /*
+     * 帧率限制器: 每帧在采样输入之前调用 wait(), 把帧的开始对齐到固定间隔. 先 sleep 到截止时间前
+     * SPIN_THRESHOLD, 剩下的部分忙等, 因为 sleep_for 的唤醒通常会晚 1 ms 左右, 直接 sleep 到截止时间会让帧时间抖动.
+     * 在 GPU 限制之前截住 CPU, 输入到提交之间就不会有排队的帧.
+     */
+    class GolaFrameLimiter {
+    public:
+        static constexpr std::chrono::microseconds SPIN_THRESHOLD{2000};
+
+        // Blocks until 1/frameRate seconds after the previous frame's deadline. A frameRate of 0 disables the
+        // limiter. Falling behind by more than a frame restarts the schedule instead of catching up.
+        void wait(float frameRate);
+
+    private:
+        // 下一帧开始的时间, 未启用时为 0
+        std::chrono::steady_clock::time_point nextFrameTime{};
+    };
+}
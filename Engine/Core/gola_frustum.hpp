@@ -0,0 +1,52 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm.hpp>
+
+// std
+#include <array>
+
+namespace gola {
+    /*
+     * 视锥体的六个平面, 法线指向视锥体内部且已归一化: dot(plane.xyz, p) + plane.w >= 0 表示在内侧.
+     * 由 projection * view 提取 (Gribb-Hartmann), 深度范围为 [0, 1].
+     */
+    struct GolaFrustum {
+        enum Plane { PLANE_LEFT = 0, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_NEAR, PLANE_FAR, PLANE_COUNT };
+
+        std::array<glm::vec4, PLANE_COUNT> planes{};
+
+        static GolaFrustum fromMatrix(const glm::mat4 &projectionView) {
+            // glm 按列存储, row(i) = (m[0][i], m[1][i], m[2][i], m[3][i])
+            auto row = [&](int i) {
+                return glm::vec4(projectionView[0][i], projectionView[1][i], projectionView[2][i], projectionView[3][i]);
+            };
+            const glm::vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+            GolaFrustum frustum{};
+            frustum.planes[PLANE_LEFT] = r3 + r0;
+            frustum.planes[PLANE_RIGHT] = r3 - r0;
+            frustum.planes[PLANE_BOTTOM] = r3 + r1;
+            frustum.planes[PLANE_TOP] = r3 - r1;
+            // 0 <= z_clip, 而不是 OpenGL 的 -w <= z_clip
+            frustum.planes[PLANE_NEAR] = r2;
+            frustum.planes[PLANE_FAR] = r3 - r2;
+
+            for (auto &plane: frustum.planes) {
+                plane /= glm::length(glm::vec3(plane));
+            }
+            return frustum;
+        }
+
+        bool intersectsSphere(const glm::vec3 &center, float radius) const {
+            for (const auto &plane: planes) {
+                if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+}
@@ -0,0 +1,248 @@
+#include "gola_frustum_culler.hpp"
+
+#include "gola_camera.hpp"
+#include "gola_cpu_features.hpp"
+#include "gola_job_system.hpp"
+
+#if GOLA_ARCH_X86
+#include <immintrin.h>
+#endif
+
+// std
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <limits>
+#include <print>
+#include <random>
+
+namespace gola {
+    // 补齐项: 任何平面测试都会失败
+    static constexpr float PADDING_RADIUS = -std::numeric_limits<float>::infinity();
+
+    GolaFrustumCuller::GolaFrustumCuller() {
+        const auto &cpu = GolaCpuFeatures::get();
+        implementation = cpu.avx2 ? Implementation::Avx2 : cpu.sse2 ? Implementation::Sse2 : Implementation::Scalar;
+    }
+
+    void GolaFrustumCuller::resize(uint32_t newCount) {
+        count = newCount;
+        size_t paddedCount = (static_cast<size_t>(count) + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+        centerX.assign(paddedCount, 0.0f);
+        centerY.assign(paddedCount, 0.0f);
+        centerZ.assign(paddedCount, 0.0f);
+        radii.assign(paddedCount, PADDING_RADIUS);
+    }
+
+    uint32_t GolaFrustumCuller::cull(const GolaFrustum &frustum, std::vector<uint32_t> &visibleIndices) const {
+        return cull(frustum, visibleIndices, implementation);
+    }
+
+    uint32_t GolaFrustumCuller::cull(
+        const GolaFrustum &frustum, std::vector<uint32_t> &visibleIndices, Implementation impl) const {
+        // 先按最坏情况分配, SIMD 版本一次最多写出一整组
+        const auto paddedCount = static_cast<uint32_t>(centerX.size());
+        visibleIndices.resize(paddedCount);
+        uint32_t *out = visibleIndices.data();
+
+        GolaJobSystem &jobs = GolaJobSystem::get();
+        const uint32_t chunkCount = std::min(jobs.getThreadCount(), count / PARALLEL_THRESHOLD + 1);
+        uint32_t visibleCount = 0;
+        if (chunkCount <= 1) {
+            visibleCount = cullRange(frustum, 0, paddedCount, out, impl);
+        } else {
+            // 每块把结果写在自己区间的开头 (可见数不会超过区间长度), 再按块的顺序紧凑, 结果仍然升序
+            std::vector<std::pair<uint32_t, uint32_t>> chunkResults(chunkCount);
+            const uint32_t usedChunks = jobs.parallelFor(
+                paddedCount, chunkCount, [&](uint32_t begin, uint32_t end, uint32_t chunk) {
+                    chunkResults[chunk] = {begin, cullRange(frustum, begin, end, out + begin, impl)};
+                }, SIMD_WIDTH);
+            for (uint32_t chunk = 0; chunk < usedChunks; chunk++) {
+                auto [begin, chunkVisible] = chunkResults[chunk];
+                if (begin != visibleCount) {
+                    std::copy(out + begin, out + begin + chunkVisible, out + visibleCount);
+                }
+                visibleCount += chunkVisible;
+            }
+        }
+        visibleIndices.resize(visibleCount);
+        return visibleCount;
+    }
+
+    uint32_t GolaFrustumCuller::cullRange(const GolaFrustum &frustum, uint32_t begin, uint32_t end, uint32_t *out,
+                                          Implementation impl) const {
+        switch (impl) {
+            case Implementation::Avx2:
+                return cullAvx2(frustum, begin, end, out);
+            case Implementation::Sse2:
+                return cullSse2(frustum, begin, end, out);
+            case Implementation::Scalar:
+                break;
+        }
+        return cullScalar(frustum, begin, end, out);
+    }
+
+    const char *GolaFrustumCuller::getImplementationName(Implementation impl) {
+        switch (impl) {
+            case Implementation::Avx2:
+                return "AVX2";
+            case Implementation::Sse2:
+                return "SSE2";
+            case Implementation::Scalar:
+                return "scalar";
+        }
+        return "unknown";
+    }
+
+    // 标量参考实现: SIMD 版本按相同的运算顺序计算, 结果逐位一致
+    uint32_t GolaFrustumCuller::cullScalar(const GolaFrustum &frustum, uint32_t begin, uint32_t end,
+                                           uint32_t *out) const {
+        uint32_t visibleCount = 0;
+        end = std::min(end, count);
+        for (uint32_t i = begin; i < end; i++) {
+            bool visible = true;
+            for (const auto &plane: frustum.planes) {
+                float distance = plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w;
+                if (!(distance + radii[i] >= 0.0f)) {
+                    visible = false;
+                    break;
+                }
+            }
+            if (visible) {
+                out[visibleCount++] = i;
+            }
+        }
+        return visibleCount;
+    }
+
+#if GOLA_ARCH_X86
+    uint32_t GolaFrustumCuller::cullSse2(const GolaFrustum &frustum, uint32_t begin, uint32_t end,
+                                         uint32_t *out) const {
+        __m128 planeX[GolaFrustum::PLANE_COUNT], planeY[GolaFrustum::PLANE_COUNT];
+        __m128 planeZ[GolaFrustum::PLANE_COUNT], planeW[GolaFrustum::PLANE_COUNT];
+        for (int p = 0; p < GolaFrustum::PLANE_COUNT; p++) {
+            planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+            planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+            planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+            planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+        }
+        const __m128 zero = _mm_setzero_ps();
+
+        uint32_t visibleCount = 0;
+        for (uint32_t i = begin; i < end; i += 4) {
+            __m128 x = _mm_loadu_ps(&centerX[i]);
+            __m128 y = _mm_loadu_ps(&centerY[i]);
+            __m128 z = _mm_loadu_ps(&centerZ[i]);
+            __m128 r = _mm_loadu_ps(&radii[i]);
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < GolaFrustum::PLANE_COUNT; p++) {
+                __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+                               _mm_mul_ps(planeZ[p], z)),
+                    planeW[p]);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, r), zero));
+            }
+
+            // 把可见位逐个写出, 补齐项总是不可见
+            int mask = _mm_movemask_ps(inside);
+            while (mask != 0) {
+                int lane = std::countr_zero(static_cast<unsigned>(mask));
+                out[visibleCount++] = i + lane;
+                mask &= mask - 1;
+            }
+        }
+        return visibleCount;
+    }
+
+    GOLA_TARGET_AVX2 uint32_t GolaFrustumCuller::cullAvx2(const GolaFrustum &frustum, uint32_t begin, uint32_t end,
+                                                          uint32_t *out) const {
+        __m256 planeX[GolaFrustum::PLANE_COUNT], planeY[GolaFrustum::PLANE_COUNT];
+        __m256 planeZ[GolaFrustum::PLANE_COUNT], planeW[GolaFrustum::PLANE_COUNT];
+        for (int p = 0; p < GolaFrustum::PLANE_COUNT; p++) {
+            planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+            planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+            planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+            planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+        }
+        const __m256 zero = _mm256_setzero_ps();
+
+        uint32_t visibleCount = 0;
+        for (uint32_t i = begin; i < end; i += 8) {
+            __m256 x = _mm256_loadu_ps(&centerX[i]);
+            __m256 y = _mm256_loadu_ps(&centerY[i]);
+            __m256 z = _mm256_loadu_ps(&centerZ[i]);
+            __m256 r = _mm256_loadu_ps(&radii[i]);
+
+            // 不用 FMA: 保持与标量参考实现相同的舍入
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < GolaFrustum::PLANE_COUNT; p++) {
+                __m256 distance = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], x), _mm256_mul_ps(planeY[p], y)),
+                                  _mm256_mul_ps(planeZ[p], z)),
+                    planeW[p]);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, r), zero, _CMP_GE_OQ));
+            }
+
+            int mask = _mm256_movemask_ps(inside);
+            while (mask != 0) {
+                int lane = std::countr_zero(static_cast<unsigned>(mask));
+                out[visibleCount++] = i + lane;
+                mask &= mask - 1;
+            }
+        }
+        return visibleCount;
+    }
+#else
+    uint32_t GolaFrustumCuller::cullSse2(const GolaFrustum &frustum, uint32_t begin, uint32_t end,
+                                         uint32_t *out) const {
+        return cullScalar(frustum, begin, end, out);
+    }
+
+    uint32_t GolaFrustumCuller::cullAvx2(const GolaFrustum &frustum, uint32_t begin, uint32_t end,
+                                         uint32_t *out) const {
+        return cullScalar(frustum, begin, end, out);
+    }
+#endif
+
+    void GolaFrustumCuller::runBenchmark() {
+        const auto &cpu = GolaCpuFeatures::get();
+        std::print("[DEBUG] Frustum culling benchmark (sse2: {}, avx2: {})\n", cpu.sse2, cpu.avx2);
+
+        // 相机位于原点看向 +z, 对象均匀分布在相机周围
+        GolaCamera camera{};
+        camera.setPerspectiveProjection(glm::radians(50.f), 4.0f / 3.0f, 0.1f, 100.f);
+        camera.setViewYXZ(glm::vec3(0.0f), glm::vec3(0.0f));
+        const GolaFrustum frustum = GolaFrustum::fromMatrix(camera.getProjection() * camera.getView());
+
+        std::mt19937 rng{12345};
+        std::uniform_real_distribution<float> position{-100.0f, 100.0f};
+        std::uniform_real_distribution<float> radius{0.1f, 2.0f};
+
+        for (uint32_t objectCount: {10'000u, 100'000u, 1'000'000u}) {
+            GolaFrustumCuller culler{};
+            culler.resize(objectCount);
+            for (uint32_t i = 0; i < objectCount; i++) {
+                culler.setSphere(i, glm::vec3(position(rng), position(rng), position(rng)), radius(rng));
+            }
+
+            std::vector<Implementation> implementations{Implementation::Scalar};
+            if (cpu.sse2) implementations.push_back(Implementation::Sse2);
+            if (cpu.avx2) implementations.push_back(Implementation::Avx2);
+
+            std::vector<uint32_t> visible;
+            for (Implementation impl: implementations) {
+                const int iterations = objectCount >= 1'000'000u ? 10 : 100;
+                auto start = std::chrono::high_resolution_clock::now();
+                for (int i = 0; i < iterations; i++) {
+                    culler.cull(frustum, visible, impl);
+                }
+                float ms = std::chrono::duration<float, std::chrono::milliseconds::period>(
+                               std::chrono::high_resolution_clock::now() - start).count() / iterations;
+
+                std::print("[DEBUG]   {:>8} objects, {:>6}: {:8.3f} ms, {} visible\n",
+                           objectCount, getImplementationName(impl), ms, visible.size());
+            }
+        }
+    }
+}
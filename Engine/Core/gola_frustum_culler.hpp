@@ -0,0 +1,85 @@
+#pragma once
+
+#include "gola_frustum.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace gola {
+    /*
+     * CPU 视锥剔除: 世界空间包围球按 SoA 存放 (x/y/z/radius 各一个数组), 每次迭代用 AVX2 测试
+     * 8 个对象 (SSE2 时 4 个) 与六个平面, 输出可见对象的紧凑索引列表.
+     * 数组尾部补齐到 SIMD 宽度, 补齐项的半径为负无穷大, 总会被剔除.
+     * 对象较多时按 SIMD 宽度对齐分块, 在任务系统上并行剔除, 再按块的顺序合并结果.
+     */
+    class GolaFrustumCuller {
+    public:
+        enum class Implementation {
+            Scalar,
+            Sse2,
+            Avx2,
+        };
+
+        static constexpr uint32_t SIMD_WIDTH = 8;
+        // 少于这个数量时在调用线程上剔除
+        static constexpr uint32_t PARALLEL_THRESHOLD = 64 * 1024;
+
+        GolaFrustumCuller();
+
+        void resize(uint32_t count);
+
+        void setSphere(uint32_t index, const glm::vec3 &center, float radius) {
+            centerX[index] = center.x;
+            centerY[index] = center.y;
+            centerZ[index] = center.z;
+            radii[index] = radius;
+        }
+
+        // Writes the indices of the spheres that intersect the frustum to visibleIndices
+        // (in ascending order) and returns how many there are.
+        uint32_t cull(const GolaFrustum &frustum, std::vector<uint32_t> &visibleIndices) const;
+
+        // 指定实现, 用于基准测试和测试中与标量版本对比
+        uint32_t cull(const GolaFrustum &frustum, std::vector<uint32_t> &visibleIndices,
+                      Implementation implementation) const;
+
+        uint32_t getCount() const { return count; }
+        Implementation getImplementation() const { return implementation; }
+
+        static const char *getImplementationName(Implementation implementation);
+
+        // Culls random spheres at 10k/100k/1M objects with every available implementation and prints the
+        // timings. The SIMD results are checked against the scalar reference in Tests/gola_culling_tests.cpp.
+        static void runBenchmark();
+
+    private:
+        // 剔除 [begin, end) 并把可见对象的下标写到 out, begin 是 SIMD_WIDTH 的倍数, end 不超过补齐后的数量
+        uint32_t cullRange(const GolaFrustum &frustum, uint32_t begin, uint32_t end, uint32_t *out,
+                           Implementation implementation) const;
+
+        uint32_t cullScalar(const GolaFrustum &frustum, uint32_t begin, uint32_t end, uint32_t *out) const;
+
+        uint32_t cullSse2(const GolaFrustum &frustum, uint32_t begin, uint32_t end, uint32_t *out) const;
+
+        uint32_t cullAvx2(const GolaFrustum &frustum, uint32_t begin, uint32_t end, uint32_t *out) const;
+
+        uint32_t count = 0;
+        std::vector<float> centerX;
+        std::vector<float> centerY;
+        std::vector<float> centerZ;
+        std::vector<float> radii;
+
+        Implementation implementation;
+    };
+
+    // 把模型空间包围球变换到世界空间: 半径按最大的轴向缩放放大, 与 build_draws.comp 一致
+    inline glm::vec4 transformBoundingSphere(const glm::mat4 &transform, const glm::vec4 &sphere) {
+        glm::vec3 center = glm::vec3(transform * glm::vec4(glm::vec3(sphere), 1.0f));
+        float scaleSquared = glm::max(
+            glm::max(glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+                     glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1]))),
+            glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2])));
+        return glm::vec4(center, sphere.w * glm::sqrt(scaleSquared));
+    }
+}
@@ -0,0 +1,183 @@
+#include "gola_gpu_profiler.hpp"
+
+#include "gola_device.hpp"
+
+// std
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+
+namespace gola {
+    static constexpr uint32_t QUERIES_PER_SLOT = GolaGpuProfiler::MAX_SCOPES_PER_FRAME * 2;
+    // 占满查询的作用域, 结束时不写时间戳
+    static constexpr uint32_t DROPPED_SCOPE = std::numeric_limits<uint32_t>::max();
+
+    GolaGpuProfiler::Scope::Scope(GolaGpuProfiler *profiler, VkCommandBuffer commandBuffer, const char *name)
+        : profiler{profiler}, commandBuffer{commandBuffer} {
+        if (profiler != nullptr) {
+            profiler->beginScope(commandBuffer, name);
+        }
+    }
+
+    GolaGpuProfiler::Scope::~Scope() {
+        if (profiler != nullptr) {
+            profiler->endScope(commandBuffer);
+        }
+    }
+
+    GolaGpuProfiler::GolaGpuProfiler(GolaDevice &device) : device{device} {
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+        const uint32_t validBits = queueFamilies[device.findPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+        supported = validBits > 0 && device.properties.limits.timestampPeriod > 0.0f;
+        if (!supported) {
+            return;
+        }
+        timestampPeriod = device.properties.limits.timestampPeriod;
+        timestampMask = validBits >= 64 ? std::numeric_limits<uint64_t>::max() : (uint64_t{1} << validBits) - 1;
+
+        VkQueryPoolCreateInfo queryPoolInfo{};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = QUERIES_PER_SLOT * GolaSwapChain::MAX_FRAMES_IN_FLIGHT;
+        if (vkCreateQueryPool(device.device(), &queryPoolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create profiler query pool!");
+        }
+        timestamps.resize(QUERIES_PER_SLOT);
+    }
+
+    GolaGpuProfiler::~GolaGpuProfiler() {
+        if (queryPool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(device.device(), queryPool, nullptr);
+        }
+    }
+
+    void GolaGpuProfiler::beginFrame(VkCommandBuffer commandBuffer, int frameIndex) {
+        if (!supported) {
+            return;
+        }
+        currentSlot = &frameSlots[frameIndex];
+        currentFirstQuery = static_cast<uint32_t>(frameIndex) * QUERIES_PER_SLOT;
+        if (!currentSlot->scopes.empty()) {
+            readBack(*currentSlot, currentFirstQuery);
+        }
+
+        currentSlot->frameNumber = frameNumber++;
+        currentSlot->scopes.clear();
+        openScopes.clear();
+        vkCmdResetQueryPool(commandBuffer, queryPool, currentFirstQuery, QUERIES_PER_SLOT);
+        beginScope(commandBuffer, "frame");
+    }
+
+    void GolaGpuProfiler::endFrame(VkCommandBuffer commandBuffer) {
+        if (!supported) {
+            return;
+        }
+        while (!openScopes.empty()) {
+            endScope(commandBuffer);
+        }
+        currentSlot = nullptr;
+    }
+
+    void GolaGpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char *name) {
+        if (currentSlot == nullptr) {
+            return;
+        }
+        if (currentSlot->scopes.size() == MAX_SCOPES_PER_FRAME) {
+            openScopes.push_back(DROPPED_SCOPE);
+            return;
+        }
+        const auto query = static_cast<uint32_t>(currentSlot->scopes.size()) * 2;
+        openScopes.push_back(static_cast<uint32_t>(currentSlot->scopes.size()));
+        currentSlot->scopes.push_back({name, static_cast<uint32_t>(openScopes.size() - 1), query});
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, currentFirstQuery + query);
+    }
+
+    void GolaGpuProfiler::endScope(VkCommandBuffer commandBuffer) {
+        if (currentSlot == nullptr || openScopes.empty()) {
+            return;
+        }
+        const uint32_t scope = openScopes.back();
+        openScopes.pop_back();
+        if (scope != DROPPED_SCOPE) {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool,
+                                currentFirstQuery + currentSlot->scopes[scope].query + 1);
+        }
+    }
+
+    void GolaGpuProfiler::readBack(FrameSlot &slot, uint32_t firstQuery) {
+        // frame in flight 减少后不再使用的 slot, 重新启用时里面是很久以前的一帧
+        if (!history.empty() && slot.frameNumber < history.back().frameNumber) {
+            return;
+        }
+        const auto queryCount = static_cast<uint32_t>(slot.scopes.size()) * 2;
+        // 不带 WAIT_BIT: slot 的时间线值已经等待过, 仍未就绪 (例如那一帧没有提交) 时丢弃这一帧
+        if (vkGetQueryPoolResults(device.device(), queryPool, firstQuery, queryCount,
+                                  queryCount * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t),
+                                  VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+            return;
+        }
+
+        const double msPerTick = static_cast<double>(timestampPeriod) / 1e6;
+        const uint64_t frameStart = timestamps[0] & timestampMask;
+        GolaGpuFrameTiming frame{};
+        frame.frameNumber = slot.frameNumber;
+        frame.gpuTimeMs = static_cast<double>(frameStart) * msPerTick;
+        frame.scopes.reserve(slot.scopes.size());
+        for (const PendingScope &scope: slot.scopes) {
+            // 有效位之外的部分是未定义的, 减法在有效位内回绕
+            const uint64_t begin = (timestamps[scope.query] - frameStart) & timestampMask;
+            const uint64_t end = (timestamps[scope.query + 1] - timestamps[scope.query]) & timestampMask;
+            frame.scopes.push_back({scope.name, scope.depth, static_cast<float>(begin * msPerTick),
+                                    static_cast<float>(end * msPerTick)});
+        }
+
+        history.push_back(std::move(frame));
+        if (history.size() > HISTORY_FRAMES) {
+            history.pop_front();
+        }
+    }
+
+    static void writeJsonString(std::ofstream &file, const char *text) {
+        file << '"';
+        for (const char *c = text; *c != '\0'; c++) {
+            if (*c == '"' || *c == '\\') {
+                file << '\\' << *c;
+            } else if (static_cast<unsigned char>(*c) < 0x20) {
+                file << ' ';
+            } else {
+                file << *c;
+            }
+        }
+        file << '"';
+    }
+
+    bool GolaGpuProfiler::exportJson(const std::string &path) const {
+        std::ofstream file{path, std::ios::trunc};
+        if (!file.is_open()) {
+            return false;
+        }
+
+        // Chrome trace 的时间单位是微秒; 每帧按 GPU 时钟放在时间轴上, 嵌套关系由时间区间推出
+        const double origin = history.empty() ? 0.0 : history.front().gpuTimeMs;
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (const GolaGpuFrameTiming &frame: history) {
+            for (const GolaGpuScopeTiming &scope: frame.scopes) {
+                file << (first ? "\n" : ",\n") << "{\"name\":";
+                writeJsonString(file, scope.name);
+                file << ",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":"
+                        << (frame.gpuTimeMs - origin + scope.startMs) * 1000.0
+                        << ",\"dur\":" << scope.durationMs * 1000.0
+                        << ",\"args\":{\"frame\":" << frame.frameNumber << ",\"depth\":" << scope.depth << "}}";
+                first = false;
+            }
+        }
+        file << "\n]}\n";
+        return file.good();
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "gola_swap_chain.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace gola {
+    class GolaDevice;
+
+    // 一个作用域在 GPU 上的耗时, startMs 相对于帧的开始
+    struct GolaGpuScopeTiming {
+        const char *name;
+        uint32_t depth;
+        float startMs;
+        float durationMs;
+    };
+
+    // scopes[0] 是整帧, 其余按开始的顺序排列
+    struct GolaGpuFrameTiming {
+        uint64_t frameNumber;
+        // 帧开始时 GPU 时钟的读数, 只用于排列导出的帧
+        double gpuTimeMs;
+        std::vector<GolaGpuScopeTiming> scopes;
+    };
+
+    /*
+     * GPU 计时: 每个作用域在开始和结束时各写一个时间戳 (vkCmdWriteTimestamp), 作用域可以嵌套.
+     * 查询池按 frame slot 分段, 一帧在 beginFrame() 中读回这个 slot 上一次的结果, 此时 GolaRenderer 已经等待过
+     * 它的时间线值, 所以读回从不阻塞; 结果因此滞后 framesInFlight 帧. 只能在录制主线程上使用, 作用域的开始和结束
+     * 必须写入同一个 command buffer (或按执行顺序排列的 command buffer), 不能写在
+     * VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS 的 render pass 里的 primary 中.
+     */
+    class GolaGpuProfiler {
+    public:
+        static constexpr uint32_t MAX_SCOPES_PER_FRAME = 64;
+        // 保留的帧数, 用于滚动图表和导出
+        static constexpr uint32_t HISTORY_FRAMES = 240;
+        static constexpr const char *EXPORT_PATH = "gpu_profile.json";
+
+        // 作用域的 RAII 包装, profiler 为空时什么也不做
+        class Scope {
+        public:
+            Scope(GolaGpuProfiler *profiler, VkCommandBuffer commandBuffer, const char *name);
+
+            ~Scope();
+
+            Scope(const Scope &) = delete;
+
+            Scope &operator=(const Scope &) = delete;
+
+        private:
+            GolaGpuProfiler *profiler;
+            VkCommandBuffer commandBuffer;
+        };
+
+        explicit GolaGpuProfiler(GolaDevice &device);
+
+        ~GolaGpuProfiler();
+
+        GolaGpuProfiler(const GolaGpuProfiler &) = delete;
+
+        GolaGpuProfiler &operator=(const GolaGpuProfiler &) = delete;
+
+        // 图形队列不支持时间戳时为 false, 其余函数都不写入命令
+        bool isSupported() const { return supported; }
+
+        // Reads back the previous results of frameIndex, resets its queries and opens the frame scope. Called
+        // right after vkBeginCommandBuffer, once the GPU has finished the slot's previous submission.
+        void beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+
+        // 关闭所有未结束的作用域和整帧, 在 vkEndCommandBuffer 之前调用
+        void endFrame(VkCommandBuffer commandBuffer);
+
+        // name must outlive the profiler's history (string literals and render graph pass names do). Scopes
+        // beyond MAX_SCOPES_PER_FRAME are dropped.
+        void beginScope(VkCommandBuffer commandBuffer, const char *name);
+
+        void endScope(VkCommandBuffer commandBuffer);
+
+        // 最近读回的帧在最后
+        const std::deque<GolaGpuFrameTiming> &getHistory() const { return history; }
+
+        // Writes the history as Chrome trace events (chrome://tracing, Perfetto) and returns false if the file
+        // cannot be opened.
+        bool exportJson(const std::string &path) const;
+
+    private:
+        struct PendingScope {
+            const char *name;
+            uint32_t depth;
+            // 在 slot 内的查询下标, 结束查询紧跟其后
+            uint32_t query;
+        };
+
+        struct FrameSlot {
+            uint64_t frameNumber = 0;
+            std::vector<PendingScope> scopes;
+        };
+
+        void readBack(FrameSlot &slot, uint32_t firstQuery);
+
+        GolaDevice &device;
+        bool supported = false;
+        // 每个 tick 的纳秒数
+        float timestampPeriod = 0.0f;
+        uint64_t timestampMask = 0;
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+
+        std::array<FrameSlot, GolaSwapChain::MAX_FRAMES_IN_FLIGHT> frameSlots;
+        FrameSlot *currentSlot = nullptr;
+        uint32_t currentFirstQuery = 0;
+        // 还没结束的作用域在 currentSlot->scopes 中的下标
+        std::vector<uint32_t> openScopes;
+        uint64_t frameNumber = 0;
+        std::vector<uint64_t> timestamps;
+        std::deque<GolaGpuFrameTiming> history;
+    };
+}
@@ -0,0 +1,448 @@
+#include "gola_gpu_scene.hpp"
+
+#include "gola_deletion_queue.hpp"
+#include "gola_frustum.hpp"
+#include "gola_staging_ring.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace gola {
+    GolaGpuScene::GolaGpuScene(GolaDevice &device) : golaDevice{device} {
+        createDescriptors();
+        createBuildPipeline();
+        createBuffers(1024, 64);
+
+        for (auto &readbackBuffer: drawCountReadbackBuffers) {
+            readbackBuffer = std::make_unique<GolaBuffer>(
+                golaDevice,
+                sizeof(uint32_t),
+                INDEX_LIST_COUNT,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            std::memset(readbackBuffer->getMappedMemory(), 0, readbackBuffer->getBufferSize());
+        }
+    }
+
+    GolaGpuScene::~GolaGpuScene() {
+        vkDestroyPipelineLayout(golaDevice.device(), buildPipelineLayout, nullptr);
+    }
+
+    void GolaGpuScene::createDescriptors() {
+        setLayout = GolaDescriptorSetLayout::Builder(golaDevice)
+                .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                            VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT)
+                .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                .build();
+        allocateDescriptorSets();
+    }
+
+    void GolaGpuScene::allocateDescriptorSets() {
+        descriptorPool = GolaDescriptorPool::Builder(golaDevice)
+                .setMaxSets(GolaSwapChain::MAX_FRAMES_IN_FLIGHT)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * GolaSwapChain::MAX_FRAMES_IN_FLIGHT)
+                .build();
+
+        for (auto &set: descriptorSets) {
+            if (!descriptorPool->allocateDescriptor(setLayout->getDescriptorSetLayout(), set)) {
+                throw std::runtime_error("failed to allocate gpu scene descriptor set!");
+            }
+        }
+    }
+
+    void GolaGpuScene::createBuildPipeline() {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(BuildPushConstants);
+
+        VkDescriptorSetLayout descriptorSetLayout = setLayout->getDescriptorSetLayout();
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(golaDevice.device(), &pipelineLayoutInfo, nullptr, &buildPipelineLayout) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+
+        buildPipeline = std::make_unique<GolaComputePipeline>(
+            golaDevice, GOLA_SHADER_DIR "/build_draws.comp.spv", buildPipelineLayout);
+    }
+
+    void GolaGpuScene::createBuffers(uint32_t newObjectCapacity, uint32_t newMeshCapacity) {
+        objectCapacity = newObjectCapacity;
+        meshCapacity = newMeshCapacity;
+
+        objectBuffer = std::make_unique<GolaBuffer>(
+            golaDevice,
+            sizeof(ObjectData),
+            objectCapacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        meshBuffer = std::make_unique<GolaBuffer>(
+            golaDevice,
+            sizeof(MeshData),
+            meshCapacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        for (int i = 0; i < GolaSwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+            // 每个索引类型一段, 每段最多 objectCapacity 条命令
+            drawCommandBuffers[i] = std::make_unique<GolaBuffer>(
+                golaDevice,
+                sizeof(VkDrawIndexedIndirectCommand),
+                objectCapacity * INDEX_LIST_COUNT,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            drawCountBuffers[i] = std::make_unique<GolaBuffer>(
+                golaDevice,
+                sizeof(uint32_t),
+                INDEX_LIST_COUNT,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        }
+
+        writeDescriptorSets();
+    }
+
+    void GolaGpuScene::retireBuffers() {
+        struct Retired {
+            std::unique_ptr<GolaDescriptorPool> descriptorPool;
+            std::unique_ptr<GolaBuffer> objectBuffer;
+            std::unique_ptr<GolaBuffer> meshBuffer;
+            std::array<std::unique_ptr<GolaBuffer>, GolaSwapChain::MAX_FRAMES_IN_FLIGHT> drawCommandBuffers;
+            std::array<std::unique_ptr<GolaBuffer>, GolaSwapChain::MAX_FRAMES_IN_FLIGHT> drawCountBuffers;
+        };
+        // std::function 要求可拷贝, 用 shared_ptr 持有
+        auto retired = std::make_shared<Retired>();
+        retired->descriptorPool = std::move(descriptorPool);
+        retired->objectBuffer = std::move(objectBuffer);
+        retired->meshBuffer = std::move(meshBuffer);
+        retired->drawCommandBuffers = std::move(drawCommandBuffers);
+        retired->drawCountBuffers = std::move(drawCountBuffers);
+        golaDevice.getDeletionQueue().push([retired]() mutable { retired.reset(); });
+    }
+
+    void GolaGpuScene::writeDescriptorSets() {
+        for (int i = 0; i < GolaSwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+            auto objectInfo = objectBuffer->descriptorInfo();
+            auto meshInfo = meshBuffer->descriptorInfo();
+            auto commandInfo = drawCommandBuffers[i]->descriptorInfo();
+            auto countInfo = drawCountBuffers[i]->descriptorInfo();
+            GolaDescriptorWriter(*setLayout, *descriptorPool)
+                    .writeBuffer(0, &objectInfo)
+                    .writeBuffer(1, &meshInfo)
+                    .writeBuffer(2, &commandInfo)
+                    .writeBuffer(3, &countInfo)
+                    .overwrite(descriptorSets[i]);
+        }
+    }
+
+    void GolaGpuScene::update(const std::vector<RenderObject> &renderObjects) {
+        if (!dirty && renderObjects.size() == objectCount) {
+            return;
+        }
+        dirty = false;
+
+        objects.clear();
+        meshes.clear();
+        meshLookup.clear();
+        listObjectCounts = {};
+        triangleCount = 0;
+        arena = nullptr;
+
+        objects.reserve(renderObjects.size());
+        for (auto &obj: renderObjects) {
+            const GolaModel *model = obj.model;
+            // indirect draw 只绑定一次几何缓冲区, 所有模型必须来自同一个 arena
+            assert((arena == nullptr || arena == &model->getArena()) && "GPU-driven models must share one mesh arena");
+            arena = &model->getArena();
+
+            auto [it, inserted] = meshLookup.try_emplace(model, static_cast<uint32_t>(meshes.size()));
+            if (inserted) {
+                const auto &range = model->getMeshRange();
+                MeshData mesh{};
+                mesh.firstIndex = range.firstIndex;
+                // 非索引网格的 indexCount 为 0, compute shader 会跳过它们
+                mesh.indexCount = range.indexCount;
+                mesh.vertexOffset = static_cast<int32_t>(range.firstVertex);
+                mesh.indexList = range.indexType == VK_INDEX_TYPE_UINT32 ? INDEX_LIST_UINT32 : INDEX_LIST_UINT16;
+                mesh.boundingSphere = model->getBoundingSphere();
+                meshes.push_back(mesh);
+            }
+            const MeshData &mesh = meshes[it->second];
+            if (mesh.indexCount > 0) {
+                listObjectCounts[mesh.indexList]++;
+                triangleCount += mesh.indexCount / 3;
+            }
+
+            ObjectData object{};
+            object.transform = obj.transform->mat4();
+            object.color = glm::vec4(obj.color, 1.0f);
+            object.meshIndex = it->second;
+            objects.push_back(object);
+        }
+        objectCount = static_cast<uint32_t>(objects.size());
+
+        if (objectCount > objectCapacity || meshes.size() > meshCapacity) {
+            uint32_t newObjectCapacity = objectCapacity;
+            while (newObjectCapacity < objectCount) {
+                newObjectCapacity *= 2;
+            }
+            uint32_t newMeshCapacity = meshCapacity;
+            while (newMeshCapacity < meshes.size()) {
+                newMeshCapacity *= 2;
+            }
+            // 旧缓冲区和描述符集可能仍被在途的帧使用, 交给删除队列, 新的描述符集从新的池中分配
+            retireBuffers();
+            allocateDescriptorSets();
+            createBuffers(newObjectCapacity, newMeshCapacity);
+        }
+
+        // 拷贝由暂存环在本帧提交前执行, 并且排在之前所有帧的读取之后
+        auto &stagingRing = golaDevice.getStagingRing();
+        if (!objects.empty()) {
+            stagingRing.upload(objectBuffer->getBuffer(), objects.data(), sizeof(ObjectData) * objects.size());
+        }
+        if (!meshes.empty()) {
+            stagingRing.upload(meshBuffer->getBuffer(), meshes.data(), sizeof(MeshData) * meshes.size());
+        }
+    }
+
+    void GolaGpuScene::updateObjects(
+        const std::vector<RenderObject> &renderObjects, const std::vector<uint32_t> &changedIndices) {
+        if (dirty || renderObjects.size() != objectCount || changedIndices.empty()) {
+            return;
+        }
+
+        for (uint32_t index: changedIndices) {
+            objects[index].transform = renderObjects[index].transform->mat4();
+        }
+
+        auto &stagingRing = golaDevice.getStagingRing();
+        // 修改的对象较多时拷贝区间太碎, 直接上传整个数组
+        if (changedIndices.size() * 4 >= objectCount) {
+            stagingRing.upload(objectBuffer->getBuffer(), objects.data(), sizeof(ObjectData) * objects.size());
+            return;
+        }
+
+        size_t runBegin = 0;
+        while (runBegin < changedIndices.size()) {
+            size_t runEnd = runBegin + 1;
+            while (runEnd < changedIndices.size() && changedIndices[runEnd] == changedIndices[runEnd - 1] + 1) {
+                runEnd++;
+            }
+            const uint32_t first = changedIndices[runBegin];
+            const auto count = static_cast<uint32_t>(runEnd - runBegin);
+            stagingRing.upload(
+                objectBuffer->getBuffer(), &objects[first], sizeof(ObjectData) * count, sizeof(ObjectData) * first);
+            runBegin = runEnd;
+        }
+    }
+
+    bool GolaGpuScene::usesDrawCount(uint32_t listCount) const {
+        return golaDevice.getFeatures().drawIndirectCount &&
+               listCount <= golaDevice.properties.limits.maxDrawIndirectCount;
+    }
+
+    void GolaGpuScene::readBackCullingResults(int frameIndex) {
+        // beginFrame 已经等待过这一帧的时间线值, 回读缓冲区里是 framesInFlight 帧之前的结果
+        auto *counts = static_cast<const uint32_t *>(drawCountReadbackBuffers[frameIndex]->getMappedMemory());
+        visibleCount = 0;
+        for (uint32_t list = 0; list < INDEX_LIST_COUNT; list++) {
+            visibleCount += counts[list];
+        }
+        culledCount = readbackObjectCounts[frameIndex] - std::min(visibleCount, readbackObjectCounts[frameIndex]);
+    }
+
+    void GolaGpuScene::recordDrawListBuild(FrameInfo &frameInfo) {
+        readBackCullingResults(frameInfo.frameIndex);
+
+        if (objectCount == 0) {
+            std::memset(drawCountReadbackBuffers[frameInfo.frameIndex]->getMappedMemory(), 0,
+                        drawCountReadbackBuffers[frameInfo.frameIndex]->getBufferSize());
+            readbackObjectCounts[frameInfo.frameIndex] = 0;
+            return;
+        }
+
+        VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+        GolaBuffer &commandListBuffer = *drawCommandBuffers[frameInfo.frameIndex];
+        GolaBuffer &countBuffer = *drawCountBuffers[frameInfo.frameIndex];
+        GolaBuffer &readbackBuffer = *drawCountReadbackBuffers[frameInfo.frameIndex];
+
+        vkCmdFillBuffer(commandBuffer, countBuffer.getBuffer(), 0, countBuffer.getBufferSize(), 0);
+
+        // 不使用 countBuffer 的列表会绘制到上限, 被剔除对象留下的空位必须是 indexCount = 0 的空命令
+        bool needsClearedCommands = false;
+        for (uint32_t list = 0; list < INDEX_LIST_COUNT; list++) {
+            needsClearedCommands |= listObjectCounts[list] > 0 && !usesDrawCount(listObjectCounts[list]);
+        }
+        if (needsClearedCommands) {
+            vkCmdFillBuffer(commandBuffer, commandListBuffer.getBuffer(), 0, commandListBuffer.getBufferSize(), 0);
+        }
+
+        VkMemoryBarrier clearBarrier{};
+        clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1,
+            &clearBarrier,
+            0,
+            nullptr,
+            0,
+            nullptr);
+
+        buildPipeline->bind(commandBuffer);
+        vkCmdBindDescriptorSets(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            buildPipelineLayout,
+            0,
+            1,
+            &descriptorSets[frameInfo.frameIndex],
+            0,
+            nullptr);
+
+        const auto projectionView = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+        const GolaFrustum frustum = GolaFrustum::fromMatrix(projectionView);
+
+        BuildPushConstants push{};
+        for (int i = 0; i < GolaFrustum::PLANE_COUNT; i++) {
+            push.frustumPlanes[i] = frustum.planes[i];
+        }
+        push.objectCount = objectCount;
+        push.listCapacity = objectCapacity;
+        push.cullingEnabled = cullingEnabled ? 1 : 0;
+        vkCmdPushConstants(
+            commandBuffer,
+            buildPipelineLayout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(BuildPushConstants),
+            &push);
+
+        vkCmdDispatch(commandBuffer, (objectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+        // 只同步回读拷贝; indirect 读取由渲染图在绘制 pass 之前同步
+        VkMemoryBarrier buildBarrier{};
+        buildBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        buildBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        buildBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            1,
+            &buildBarrier,
+            0,
+            nullptr,
+            0,
+            nullptr);
+
+        // 把可见数量拷贝到 HOST_VISIBLE 缓冲区, 供调试窗口显示
+        VkBufferCopy region{};
+        region.size = countBuffer.getBufferSize();
+        vkCmdCopyBuffer(commandBuffer, countBuffer.getBuffer(), readbackBuffer.getBuffer(), 1, &region);
+
+        VkMemoryBarrier readbackBarrier{};
+        readbackBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        readbackBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        readbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_HOST_BIT,
+            0,
+            1,
+            &readbackBarrier,
+            0,
+            nullptr,
+            0,
+            nullptr);
+        readbackObjectCounts[frameInfo.frameIndex] = objectCount;
+    }
+
+    uint32_t GolaGpuScene::draw(FrameInfo &frameInfo, VkPipelineLayout pipelineLayout) {
+        if (objectCount == 0 || arena == nullptr) {
+            return 0;
+        }
+
+        VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+        vkCmdBindDescriptorSets(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineLayout,
+            0,
+            1,
+            &descriptorSets[frameInfo.frameIndex],
+            0,
+            nullptr);
+
+        VkBuffer vertexBuffers[] = {arena->getVertexBuffer()};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+
+        const uint32_t maxDrawCount = golaDevice.properties.limits.maxDrawIndirectCount;
+        const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+        VkBuffer commandBufferHandle = drawCommandBuffers[frameInfo.frameIndex]->getBuffer();
+        VkBuffer countBufferHandle = drawCountBuffers[frameInfo.frameIndex]->getBuffer();
+
+        uint32_t drawCalls = 0;
+        for (uint32_t list = 0; list < INDEX_LIST_COUNT; list++) {
+            uint32_t listCount = listObjectCounts[list];
+            if (listCount == 0) {
+                continue;
+            }
+
+            vkCmdBindIndexBuffer(
+                commandBuffer,
+                arena->getIndexBuffer(),
+                0,
+                list == INDEX_LIST_UINT32 ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16);
+
+            VkDeviceSize listOffset = static_cast<VkDeviceSize>(list) * objectCapacity * stride;
+            if (usesDrawCount(listCount)) {
+                // 实际数量由 compute shader 写入 countBuffer, listCount 只是上限
+                vkCmdDrawIndexedIndirectCount(
+                    commandBuffer,
+                    commandBufferHandle,
+                    listOffset,
+                    countBufferHandle,
+                    list * sizeof(uint32_t),
+                    listCount,
+                    stride);
+                drawCalls++;
+            } else {
+                // 回退: 不读取计数, 按上限分批绘制, 被剔除的空位是空命令
+                for (uint32_t first = 0; first < listCount; first += maxDrawCount) {
+                    uint32_t count = std::min(maxDrawCount, listCount - first);
+                    vkCmdDrawIndexedIndirect(
+                        commandBuffer,
+                        commandBufferHandle,
+                        listOffset + static_cast<VkDeviceSize>(first) * stride,
+                        count,
+                        stride);
+                    drawCalls++;
+                }
+            }
+        }
+        return drawCalls;
+    }
+}
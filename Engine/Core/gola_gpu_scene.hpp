@@ -0,0 +1,153 @@
+#pragma once
+
+#include "gola_buffer.hpp"
+#include "gola_descriptors.hpp"
+#include "gola_device.hpp"
+#include "gola_frame_info.hpp"
+#include "gola_pipeline.hpp"
+#include "gola_swap_chain.hpp"
+
+// std
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace gola {
+    /*
+     * GPU 驱动渲染的场景数据: 对象变换与网格区间存放在 SSBO 中, 每帧由 compute shader
+     * (build_draws.comp) 对包围球做视锥剔除, 把可见对象压缩成 VkDrawIndexedIndirectCommand
+     * 列表和绘制数量, 图形管线再用 indirect draw 消费. 场景不变时 CPU 每帧只录制固定数量的命令,
+     * 与对象数无关.
+     */
+    class GolaGpuScene {
+    public:
+        // 与 build_draws.comp / gpu_driven.vert 中的 std430 布局一致
+        struct ObjectData {
+            glm::mat4 transform{1.0f};
+            glm::vec4 color{};
+            uint32_t meshIndex = 0;
+            uint32_t padding[3]{};
+        };
+
+        struct MeshData {
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+            int32_t vertexOffset = 0;
+            uint32_t indexList = 0;
+            // 模型空间包围球, 见 GolaModel::getBoundingSphere
+            glm::vec4 boundingSphere{0.0f};
+        };
+
+        // 同一次 indirect draw 只能使用一种索引类型, 命令按索引类型分成两段
+        enum IndexList : uint32_t {
+            INDEX_LIST_UINT16 = 0,
+            INDEX_LIST_UINT32 = 1,
+            INDEX_LIST_COUNT = 2,
+        };
+
+        static constexpr uint32_t WORKGROUP_SIZE = 64;
+
+        GolaGpuScene(GolaDevice &device);
+
+        ~GolaGpuScene();
+
+        GolaGpuScene(const GolaGpuScene &) = delete;
+
+        GolaGpuScene &operator=(const GolaGpuScene &) = delete;
+
+        // 对象被增删或修改后调用, 下一次 update() 重新上传整个场景
+        void markDirty() { dirty = true; }
+
+        // Re-uploads object and mesh data through the staging ring when the scene changed.
+        // Must be called before recordDrawListBuild() in the same frame.
+        void update(const std::vector<RenderObject> &renderObjects);
+
+        // Re-uploads only the transforms of the given objects (ascending indices), coalescing
+        // neighbouring indices into one copy. Ignored while a full re-upload is pending.
+        void updateObjects(const std::vector<RenderObject> &renderObjects, const std::vector<uint32_t> &changedIndices);
+
+        // Records the compute pass that culls the objects against the camera frustum and writes
+        // this frame's indirect commands. Must be recorded outside of a render pass. The barrier that makes
+        // the commands and counts visible to DRAW_INDIRECT is left to the caller (the render graph).
+        void recordDrawListBuild(FrameInfo &frameInfo);
+
+        // Binds the scene geometry and descriptor set (set 0) and records the indirect draws.
+        // Returns the number of draw commands recorded on the CPU.
+        uint32_t draw(FrameInfo &frameInfo, VkPipelineLayout pipelineLayout);
+
+        void setCullingEnabled(bool enabled) { cullingEnabled = enabled; }
+
+        VkDescriptorSetLayout getDescriptorSetLayout() const { return setLayout->getDescriptorSetLayout(); }
+        // 由 recordDrawListBuild 在 transfer 和 compute 阶段写入, draw() 作为 indirect 参数读取
+        VkBuffer getDrawCommandBuffer(int frameIndex) const { return drawCommandBuffers[frameIndex]->getBuffer(); }
+        VkBuffer getDrawCountBuffer(int frameIndex) const { return drawCountBuffers[frameIndex]->getBuffer(); }
+        uint32_t getObjectCount() const { return objectCount; }
+        // 未剔除时的三角形总数
+        uint64_t getTriangleCount() const { return triangleCount; }
+
+        // 剔除结果通过回读得到, 滞后 framesInFlight 帧 (GolaPresentSettings)
+        uint32_t getVisibleCount() const { return visibleCount; }
+        uint32_t getCulledCount() const { return culledCount; }
+
+    private:
+        struct BuildPushConstants {
+            glm::vec4 frustumPlanes[6];
+            uint32_t objectCount;
+            uint32_t listCapacity;
+            uint32_t cullingEnabled;
+        };
+
+        // 该列表是否通过 countBuffer 决定绘制数量; 否则绘制整个列表, 未写入的命令必须清零
+        bool usesDrawCount(uint32_t listCount) const;
+
+        void readBackCullingResults(int frameIndex);
+
+        void createDescriptors();
+
+        void allocateDescriptorSets();
+
+        void createBuildPipeline();
+
+        void createBuffers(uint32_t newObjectCapacity, uint32_t newMeshCapacity);
+
+        // 把缓冲区和描述符池交给删除队列, 在途的帧完成后再销毁
+        void retireBuffers();
+
+        void writeDescriptorSets();
+
+        GolaDevice &golaDevice;
+
+        std::unique_ptr<GolaDescriptorSetLayout> setLayout;
+        std::unique_ptr<GolaDescriptorPool> descriptorPool;
+        std::array<VkDescriptorSet, GolaSwapChain::MAX_FRAMES_IN_FLIGHT> descriptorSets{};
+
+        VkPipelineLayout buildPipelineLayout = VK_NULL_HANDLE;
+        std::unique_ptr<GolaComputePipeline> buildPipeline;
+
+        // 对象和网格数据只在场景变化时更新, 所有帧共享; 命令和计数每帧一份
+        std::unique_ptr<GolaBuffer> objectBuffer;
+        std::unique_ptr<GolaBuffer> meshBuffer;
+        std::array<std::unique_ptr<GolaBuffer>, GolaSwapChain::MAX_FRAMES_IN_FLIGHT> drawCommandBuffers;
+        std::array<std::unique_ptr<GolaBuffer>, GolaSwapChain::MAX_FRAMES_IN_FLIGHT> drawCountBuffers;
+        // 绘制数量的 HOST_VISIBLE 副本, 该帧的时间线值等待后才读取
+        std::array<std::unique_ptr<GolaBuffer>, GolaSwapChain::MAX_FRAMES_IN_FLIGHT> drawCountReadbackBuffers;
+        std::array<uint32_t, GolaSwapChain::MAX_FRAMES_IN_FLIGHT> readbackObjectCounts{};
+        uint32_t objectCapacity = 0;
+        uint32_t meshCapacity = 0;
+
+        // CPU 侧的暂存数据, 重复使用避免每次上传都重新分配
+        std::vector<ObjectData> objects;
+        std::vector<MeshData> meshes;
+        std::unordered_map<const GolaModel *, uint32_t> meshLookup;
+
+        GolaMeshArena *arena = nullptr;
+        uint32_t objectCount = 0;
+        std::array<uint32_t, INDEX_LIST_COUNT> listObjectCounts{};
+        uint64_t triangleCount = 0;
+        uint32_t visibleCount = 0;
+        uint32_t culledCount = 0;
+        bool cullingEnabled = true;
+        bool dirty = true;
+    };
+}
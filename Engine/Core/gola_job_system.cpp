@@ -0,0 +1,386 @@
+#include "gola_job_system.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <print>
+
+namespace gola {
+    struct GolaJob {
+        GolaJobSystem::JobFunction function;
+        GolaJobCounter *counter;
+    };
+
+    // 当前线程在 queues 中的下标, 不属于调度器的线程为 -1
+    static thread_local int32_t currentThreadIndex = -1;
+    // 选择窃取目标的随机数状态 (xorshift)
+    static thread_local uint32_t stealRandomState = 0;
+
+    // 空闲的工作线程先让出这么多次时间片再睡眠, 避免频繁地睡眠和唤醒
+    static constexpr uint32_t IDLE_SPIN_ROUNDS = 64;
+
+    GolaJobSystem &GolaJobSystem::get() {
+        static GolaJobSystem instance;
+        return instance;
+    }
+
+    GolaJobSystem::GolaJobSystem() : mainThreadId{std::this_thread::get_id()} {
+        const uint32_t workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        for (uint32_t i = 0; i <= workerCount; i++) {
+            queues.push_back(std::make_unique<GolaWorkStealingDeque<GolaJob *>>());
+        }
+        currentThreadIndex = 0;
+        stealRandomState = 0x9E3779B9u;
+
+        workers.reserve(workerCount);
+        for (uint32_t i = 1; i <= workerCount; i++) {
+            workers.emplace_back(&GolaJobSystem::workerLoop, this, i);
+        }
+    }
+
+    GolaJobSystem::~GolaJobSystem() {
+        stopping.store(true, std::memory_order_seq_cst);
+        wakeEpoch.fetch_add(1, std::memory_order_seq_cst);
+        wakeEpoch.notify_all();
+        for (auto &worker: workers) {
+            worker.join();
+        }
+
+        // 没有人再等待的任务直接丢弃
+        for (auto &queue: queues) {
+            GolaJob *job;
+            while (queue->pop(job)) {
+                delete job;
+            }
+        }
+        for (GolaJob *job: injectedJobs) {
+            delete job;
+        }
+        for (GolaJob *job: mainThreadJobs) {
+            delete job;
+        }
+        for (GolaJob *job: workerJobs) {
+            delete job;
+        }
+    }
+
+    void GolaJobSystem::run(JobFunction function, GolaJobCounter *counter) {
+        if (counter) {
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        submit(new GolaJob{std::move(function), counter});
+    }
+
+    void GolaJobSystem::runAfter(GolaJobCounter &dependency, JobFunction function, GolaJobCounter *counter) {
+        if (counter) {
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        auto *job = new GolaJob{std::move(function), counter};
+        {
+            std::lock_guard lock(dependency.mutex);
+            if (dependency.pending.load(std::memory_order_acquire) != 0) {
+                dependency.continuations.push_back(job);
+                return;
+            }
+        }
+        submit(job);
+    }
+
+    void GolaJobSystem::runOnMainThread(JobFunction function, GolaJobCounter *counter) {
+        if (counter) {
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::lock_guard lock(mainThreadMutex);
+        mainThreadJobs.push_back(new GolaJob{std::move(function), counter});
+        hasMainThreadJobs.store(true, std::memory_order_release);
+    }
+
+    void GolaJobSystem::runOnWorker(JobFunction function, GolaJobCounter *counter) {
+        if (workers.empty()) {
+            run(std::move(function), counter);
+            return;
+        }
+        if (counter) {
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        {
+            std::lock_guard lock(workerMutex);
+            workerJobs.push_back(new GolaJob{std::move(function), counter});
+            hasWorkerJobs.store(true, std::memory_order_release);
+        }
+        wakeWorker();
+    }
+
+    void GolaJobSystem::submit(GolaJob *job) {
+        const int32_t index = currentThreadIndex;
+        if (index >= 0) {
+            queues[index]->push(job);
+        } else {
+            std::lock_guard lock(injectedMutex);
+            injectedJobs.push_back(job);
+            hasInjectedJobs.store(true, std::memory_order_release);
+        }
+        wakeWorker();
+    }
+
+    void GolaJobSystem::wakeWorker() {
+        // 工作线程在睡眠前读取 wakeEpoch 并再找一次任务, 这里递增之后不会错过唤醒
+        wakeEpoch.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepingWorkers.load(std::memory_order_seq_cst) > 0) {
+            wakeEpoch.notify_one();
+        }
+    }
+
+    GolaJob *GolaJobSystem::findJob() {
+        const int32_t index = currentThreadIndex;
+        GolaJob *job = nullptr;
+        if (index >= 0 && queues[index]->pop(job)) {
+            return job;
+        }
+
+        if (index == 0 && hasMainThreadJobs.load(std::memory_order_acquire)) {
+            std::lock_guard lock(mainThreadMutex);
+            if (!mainThreadJobs.empty()) {
+                job = mainThreadJobs.front();
+                mainThreadJobs.pop_front();
+                hasMainThreadJobs.store(!mainThreadJobs.empty(), std::memory_order_release);
+                return job;
+            }
+        }
+
+        // 从随机的队列开始窃取, 避免所有线程争抢同一个队列
+        uint32_t &state = stealRandomState;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        const auto queueCount = static_cast<uint32_t>(queues.size());
+        const uint32_t start = state % queueCount;
+        for (uint32_t i = 0; i < queueCount; i++) {
+            const uint32_t victim = (start + i) % queueCount;
+            if (static_cast<int32_t>(victim) != index && queues[victim]->steal(job)) {
+                return job;
+            }
+        }
+
+        if (hasInjectedJobs.load(std::memory_order_acquire)) {
+            std::lock_guard lock(injectedMutex);
+            if (!injectedJobs.empty()) {
+                job = injectedJobs.front();
+                injectedJobs.pop_front();
+                hasInjectedJobs.store(!injectedJobs.empty(), std::memory_order_release);
+                return job;
+            }
+        }
+
+        if (index > 0 && hasWorkerJobs.load(std::memory_order_acquire)) {
+            std::lock_guard lock(workerMutex);
+            if (!workerJobs.empty()) {
+                job = workerJobs.front();
+                workerJobs.pop_front();
+                hasWorkerJobs.store(!workerJobs.empty(), std::memory_order_release);
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    bool GolaJobSystem::runOneJob() {
+        GolaJob *job = findJob();
+        if (job == nullptr) {
+            return false;
+        }
+        execute(job);
+        return true;
+    }
+
+    void GolaJobSystem::execute(GolaJob *job) {
+        job->function();
+        GolaJobCounter *counter = job->counter;
+        delete job;
+        if (counter) {
+            finish(counter);
+        }
+    }
+
+    void GolaJobSystem::finish(GolaJobCounter *counter) {
+        // 不是最后一个任务时只递减, 之后不再访问 counter (等待者可能已经返回并销毁了它)
+        uint32_t value = counter->pending.load(std::memory_order_relaxed);
+        while (value > 1) {
+            if (counter->pending.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel,
+                                                       std::memory_order_relaxed)) {
+                return;
+            }
+        }
+
+        // 最后一个任务在锁内归零并取出后续任务; wait() 返回前会获取同一个锁
+        std::vector<GolaJob *> continuations;
+        {
+            std::lock_guard lock(counter->mutex);
+            if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                continuations.swap(counter->continuations);
+            }
+        }
+        for (GolaJob *job: continuations) {
+            submit(job);
+        }
+    }
+
+    void GolaJobSystem::wait(GolaJobCounter &counter) {
+        while (counter.pending.load(std::memory_order_acquire) != 0) {
+            if (!runOneJob()) {
+                std::this_thread::yield();
+            }
+        }
+        std::lock_guard lock(counter.mutex);
+    }
+
+    void GolaJobSystem::pumpMainThreadJobs() {
+        assert(isMainThread() && "Main thread jobs can only run on the main thread");
+        while (hasMainThreadJobs.load(std::memory_order_acquire)) {
+            GolaJob *job = nullptr;
+            {
+                std::lock_guard lock(mainThreadMutex);
+                if (mainThreadJobs.empty()) {
+                    break;
+                }
+                job = mainThreadJobs.front();
+                mainThreadJobs.pop_front();
+                hasMainThreadJobs.store(!mainThreadJobs.empty(), std::memory_order_release);
+            }
+            execute(job);
+        }
+    }
+
+    uint32_t GolaJobSystem::parallelFor(uint32_t count, uint32_t chunkCount, const RangeFunction &function,
+                                        uint32_t alignment) {
+        if (count == 0) {
+            return 0;
+        }
+        chunkCount = std::clamp(chunkCount, 1u, count);
+        uint32_t chunkSize = (count + chunkCount - 1) / chunkCount;
+        chunkSize = (chunkSize + alignment - 1) / alignment * alignment;
+        // 对齐之后可能需要更少的块
+        chunkCount = (count + chunkSize - 1) / chunkSize;
+        if (chunkCount == 1) {
+            function(0, count, 0);
+            return 1;
+        }
+
+        // 第一个异常在所有块完成之后重新抛出
+        std::exception_ptr error;
+        std::mutex errorMutex;
+        auto runChunk = [&](uint32_t chunk) {
+            try {
+                const uint32_t begin = chunk * chunkSize;
+                function(begin, std::min(count, begin + chunkSize), chunk);
+            } catch (...) {
+                std::lock_guard lock(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        };
+
+        GolaJobCounter counter;
+        for (uint32_t chunk = chunkCount - 1; chunk > 0; chunk--) {
+            run([&runChunk, chunk] { runChunk(chunk); }, &counter);
+        }
+        runChunk(0);
+        wait(counter);
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return chunkCount;
+    }
+
+    void GolaJobSystem::workerLoop(uint32_t threadIndex) {
+        currentThreadIndex = static_cast<int32_t>(threadIndex);
+        stealRandomState = 0x9E3779B9u * (threadIndex + 1);
+
+        uint32_t idleRounds = 0;
+        while (!stopping.load(std::memory_order_acquire)) {
+            if (runOneJob()) {
+                idleRounds = 0;
+                continue;
+            }
+            if (++idleRounds < IDLE_SPIN_ROUNDS) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // 先登记为睡眠, 再读取 epoch 并最后找一次任务
+            sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+            const uint32_t epoch = wakeEpoch.load(std::memory_order_seq_cst);
+            if (GolaJob *job = findJob()) {
+                sleepingWorkers.fetch_sub(1, std::memory_order_seq_cst);
+                execute(job);
+                idleRounds = 0;
+                continue;
+            }
+            if (!stopping.load(std::memory_order_acquire)) {
+                wakeEpoch.wait(epoch, std::memory_order_seq_cst);
+            }
+            sleepingWorkers.fetch_sub(1, std::memory_order_seq_cst);
+            idleRounds = 0;
+        }
+    }
+
+    void GolaJobSystem::runBenchmark() {
+        using clock = std::chrono::high_resolution_clock;
+        auto elapsedMs = [](clock::time_point start) {
+            return std::chrono::duration<float, std::chrono::milliseconds::period>(clock::now() - start).count();
+        };
+
+        GolaJobSystem &jobs = get();
+        const uint32_t threadCount = jobs.getThreadCount();
+        std::print("[DEBUG] Job system benchmark ({} threads)\n", threadCount);
+
+        // 正确性由 Tests/gola_job_system_tests.cpp 覆盖, 这里只测量性能
+        // 1. 单个任务的开销: 提交并执行空任务
+        {
+            constexpr uint32_t jobCount = 100'000;
+            GolaJobCounter counter;
+            auto start = clock::now();
+            for (uint32_t i = 0; i < jobCount; i++) {
+                jobs.run([] {}, &counter);
+            }
+            jobs.wait(counter);
+            float ms = elapsedMs(start);
+            std::print("[DEBUG]   {} empty jobs: {:8.3f} ms ({:.0f} ns/job)\n", jobCount, ms,
+                       ms * 1e6f / jobCount);
+        }
+
+        // 2. 计算密集的 parallel_for, 块数从 1 到线程数
+        {
+            constexpr uint32_t count = 4'000'000;
+            std::vector<float> output(count);
+            float singleThreadMs = 0.0f;
+            for (uint32_t chunks = 1;; chunks = std::min(chunks * 2, threadCount)) {
+                float bestMs = std::numeric_limits<float>::max();
+                for (int iteration = 0; iteration < 3; iteration++) {
+                    auto start = clock::now();
+                    jobs.parallelFor(count, chunks, [&](uint32_t begin, uint32_t end, uint32_t) {
+                        for (uint32_t i = begin; i < end; i++) {
+                            float x = static_cast<float>(i) * 0.001f;
+                            output[i] = std::sqrt(x) * std::sin(x) + std::cos(x * 0.5f);
+                        }
+                    });
+                    bestMs = std::min(bestMs, elapsedMs(start));
+                }
+                if (chunks == 1) {
+                    singleThreadMs = bestMs;
+                }
+                std::print("[DEBUG]   parallel_for {} items, {:2} threads: {:8.3f} ms, {:5.2f}x\n", count, chunks,
+                           bestMs, singleThreadMs / bestMs);
+                if (chunks == threadCount) {
+                    break;
+                }
+            }
+            std::print("[DEBUG]   (checksum {})\n", output[count / 3]);
+        }
+    }
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gola {
+    /*
+     * Chase-Lev 工作窃取双端队列 (Lê et al. 2013 的 C11 版本): 所有者线程在 bottom 端 push/pop,
+     * 其他线程在 top 端 steal. 数组满时扩容为两倍, 旧数组保留到队列销毁, 因为窃取者可能还在读取.
+     * 用 seq_cst 操作代替独立的内存屏障, 这样 ThreadSanitizer 能正确理解同步关系.
+     */
+    template<typename T>
+    class GolaWorkStealingDeque {
+    public:
+        explicit GolaWorkStealingDeque(int64_t capacity = 1024) {
+            assert((capacity & (capacity - 1)) == 0 && "Deque capacity must be a power of two");
+            retiredArrays.push_back(std::make_unique<Array>(capacity));
+            array.store(retiredArrays.back().get(), std::memory_order_relaxed);
+        }
+
+        GolaWorkStealingDeque(const GolaWorkStealingDeque &) = delete;
+
+        GolaWorkStealingDeque &operator=(const GolaWorkStealingDeque &) = delete;
+
+        // 只能由所有者线程调用
+        void push(T item) {
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            int64_t t = top.load(std::memory_order_acquire);
+            Array *a = array.load(std::memory_order_relaxed);
+            if (b - t > a->capacity - 1) {
+                a = grow(a, t, b);
+            }
+            a->put(b, item);
+            bottom.store(b + 1, std::memory_order_release);
+        }
+
+        // 只能由所有者线程调用, 队列为空时返回 false
+        bool pop(T &item) {
+            int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+            Array *a = array.load(std::memory_order_relaxed);
+            bottom.store(b, std::memory_order_seq_cst);
+            int64_t t = top.load(std::memory_order_seq_cst);
+            if (t > b) {
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+            item = a->get(b);
+            if (t == b) {
+                // 最后一个元素, 与窃取者竞争
+                bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                       std::memory_order_relaxed);
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        // 任意线程调用, 队列为空或竞争失败时返回 false
+        bool steal(T &item) {
+            int64_t t = top.load(std::memory_order_seq_cst);
+            int64_t b = bottom.load(std::memory_order_seq_cst);
+            if (t >= b) {
+                return false;
+            }
+            Array *a = array.load(std::memory_order_acquire);
+            item = a->get(t);
+            return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+
+        bool empty() const {
+            return top.load(std::memory_order_relaxed) >= bottom.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Array {
+            explicit Array(int64_t size) : capacity{size}, mask{size - 1}, items{new std::atomic<T>[size]} {
+            }
+
+            T get(int64_t index) const { return items[index & mask].load(std::memory_order_relaxed); }
+            void put(int64_t index, T item) { items[index & mask].store(item, std::memory_order_relaxed); }
+
+            int64_t capacity;
+            int64_t mask;
+            std::unique_ptr<std::atomic<T>[]> items;
+        };
+
+        Array *grow(Array *old, int64_t t, int64_t b) {
+            retiredArrays.push_back(std::make_unique<Array>(old->capacity * 2));
+            Array *a = retiredArrays.back().get();
+            for (int64_t i = t; i < b; i++) {
+                a->put(i, old->get(i));
+            }
+            array.store(a, std::memory_order_release);
+            return a;
+        }
+
+        // top 和 bottom 分别由窃取者和所有者频繁修改, 放在不同的缓存行
+        alignas(64) std::atomic<int64_t> top{0};
+        alignas(64) std::atomic<int64_t> bottom{0};
+        std::atomic<Array *> array{nullptr};
+        // 只由所有者线程修改, 包括当前数组
+        std::vector<std::unique_ptr<Array>> retiredArrays;
+    };
+
+    struct GolaJob;
+
+    // 一组任务的计数器: 提交时加一, 任务完成时减一, 归零后释放等待它的后续任务.
+    // 计数器在 GolaJobSystem::wait() 返回之前不能销毁.
+    class GolaJobCounter {
+    public:
+        GolaJobCounter() = default;
+
+        ~GolaJobCounter() { assert(isDone() && "Job counter destroyed while jobs are pending"); }
+
+        GolaJobCounter(const GolaJobCounter &) = delete;
+
+        GolaJobCounter &operator=(const GolaJobCounter &) = delete;
+
+        bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class GolaJobSystem;
+
+        std::atomic<uint32_t> pending{0};
+        // 保护 continuations, 归零也在锁内进行
+        std::mutex mutex;
+        std::vector<GolaJob *> continuations;
+    };
+
+    /*
+     * 工作窃取任务调度器. 每个工作线程 (以及主线程) 有一个 Chase-Lev 队列: 新任务放入当前线程的队列,
+     * 空闲线程从其他队列随机窃取. wait() 在等待期间执行其他任务, 因此任务内部可以继续提交并等待子任务.
+     * runOnMainThread() 的任务只在主线程上执行 (GLFW 等只能在主线程调用的 API), 由 wait() 或
+     * pumpMainThreadJobs() 执行. 进程内只有一个实例, 第一次调用 get() 的线程被视为主线程.
+     */
+    class GolaJobSystem {
+    public:
+        using JobFunction = std::function<void()>;
+        using RangeFunction = std::function<void(uint32_t begin, uint32_t end, uint32_t chunk)>;
+
+        static GolaJobSystem &get();
+
+        ~GolaJobSystem();
+
+        GolaJobSystem(const GolaJobSystem &) = delete;
+
+        GolaJobSystem &operator=(const GolaJobSystem &) = delete;
+
+        // 工作线程数加上主线程
+        uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()) + 1; }
+
+        bool isMainThread() const { return std::this_thread::get_id() == mainThreadId; }
+
+        // Schedules function on any thread. If counter is given it is incremented now and decremented
+        // when the job finishes. Exceptions escaping a job terminate the process, as with std::thread.
+        void run(JobFunction function, GolaJobCounter *counter = nullptr);
+
+        // Like run(), but the job only starts once dependency has reached zero.
+        void runAfter(GolaJobCounter &dependency, JobFunction function, GolaJobCounter *counter = nullptr);
+
+        // The job only runs on the main thread, inside wait() or pumpMainThreadJobs().
+        void runOnMainThread(JobFunction function, GolaJobCounter *counter = nullptr);
+
+        // The job only runs on a worker thread, never inside the main thread's wait(), so long jobs (pipeline
+        // compilation) cannot stall a frame. Without worker threads it behaves like run().
+        void runOnWorker(JobFunction function, GolaJobCounter *counter = nullptr);
+
+        // Blocks until counter reaches zero, executing other jobs in the meantime.
+        void wait(GolaJobCounter &counter);
+
+        // 执行所有排队的主线程任务, 只能在主线程调用
+        void pumpMainThreadJobs();
+
+        // Splits [0, count) into at most chunkCount contiguous ranges and calls function(begin, end, chunk) for
+        // each as a job (chunk 0 on the calling thread), then waits for all of them and rethrows the first
+        // exception. Every range starts at a multiple of alignment. Returns the number of chunks used.
+        uint32_t parallelFor(uint32_t count, uint32_t chunkCount, const RangeFunction &function,
+                             uint32_t alignment = 1);
+
+        // Prints the job overhead and the parallel_for speedup from 1 to N threads.
+        static void runBenchmark();
+
+    private:
+        GolaJobSystem();
+
+        void submit(GolaJob *job);
+
+        // 提交任务之后唤醒一个睡眠的工作线程
+        void wakeWorker();
+
+        // 取一个任务并执行, 没有任务时返回 false
+        bool runOneJob();
+
+        GolaJob *findJob();
+
+        void execute(GolaJob *job);
+
+        void finish(GolaJobCounter *counter);
+
+        void workerLoop(uint32_t threadIndex);
+
+        std::thread::id mainThreadId;
+        std::vector<std::thread> workers;
+        // 下标 0 是主线程, 之后是各个工作线程
+        std::vector<std::unique_ptr<GolaWorkStealingDeque<GolaJob *>>> queues;
+
+        // 不属于调度器的线程提交的任务
+        std::mutex injectedMutex;
+        std::deque<GolaJob *> injectedJobs;
+        std::atomic<bool> hasInjectedJobs{false};
+
+        std::mutex mainThreadMutex;
+        std::deque<GolaJob *> mainThreadJobs;
+        std::atomic<bool> hasMainThreadJobs{false};
+
+        // runOnWorker() 的任务, 只有工作线程会取
+        std::mutex workerMutex;
+        std::deque<GolaJob *> workerJobs;
+        std::atomic<bool> hasWorkerJobs{false};
+
+        // 每次提交任务加一, 空闲的工作线程在上面等待
+        std::atomic<uint32_t> wakeEpoch{0};
+        std::atomic<uint32_t> sleepingWorkers{0};
+        std::atomic<bool> stopping{false};
+    };
+}
@@ -0,0 +1,516 @@
+#include "gola_matrix_kernel.hpp"
+
+#include "gola_camera.hpp"
+#include "gola_cpu_features.hpp"
+
+#if GOLA_ARCH_X86
+#include <immintrin.h>
+#endif
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <print>
+#include <random>
+
+namespace gola {
+    GolaMatrixKernel::GolaMatrixKernel() {
+        const auto &cpu = GolaCpuFeatures::get();
+        implementation = cpu.avx512f ? Implementation::Avx512 : cpu.avx2 ? Implementation::Avx2 : Implementation::Scalar;
+    }
+
+    void GolaMatrixKernel::resize(uint32_t newCount) {
+        count = newCount;
+        // 补齐项的缩放为 0, 只参与计算, 不会被写出
+        size_t paddedCount = (static_cast<size_t>(count) + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+        for (auto *array: {&translationX, &translationY, &translationZ, &rotationX, &rotationY, &rotationZ,
+                           &scaleX, &scaleY, &scaleZ}) {
+            array->resize(paddedCount);
+            std::fill(array->begin() + count, array->end(), 0.0f);
+        }
+    }
+
+    void GolaMatrixKernel::buildModelMatrices(uint32_t begin, uint32_t end, glm::mat4 *out) const {
+        buildModelMatrices(begin, end, out, implementation);
+    }
+
+    void GolaMatrixKernel::buildModelMatrices(
+        uint32_t begin, uint32_t end, glm::mat4 *out, Implementation impl) const {
+        assert((begin % SIMD_WIDTH == 0 || begin == end) && end <= count);
+        switch (impl) {
+            case Implementation::Avx512:
+                buildAvx512(begin, end, out);
+                break;
+            case Implementation::Avx2:
+                buildAvx2(begin, end, out);
+                break;
+            case Implementation::Scalar:
+                buildScalar(begin, end, out);
+                break;
+        }
+    }
+
+    void GolaMatrixKernel::writeInstances(const glm::mat4 &projectionView, const RenderObject *objects,
+                                          const uint32_t *indices, uint32_t instanceCount, void *out,
+                                          size_t stride) const {
+        writeInstances(projectionView, objects, indices, instanceCount, out, stride, implementation);
+    }
+
+    void GolaMatrixKernel::writeInstances(const glm::mat4 &projectionView, const RenderObject *objects,
+                                          const uint32_t *indices, uint32_t instanceCount, void *out,
+                                          size_t stride, Implementation impl) const {
+        auto *bytes = static_cast<std::byte *>(out);
+        switch (impl) {
+            case Implementation::Avx512:
+                writeInstancesAvx512(projectionView, objects, indices, instanceCount, bytes, stride);
+                break;
+            case Implementation::Avx2:
+                writeInstancesAvx2(projectionView, objects, indices, instanceCount, bytes, stride);
+                break;
+            case Implementation::Scalar:
+                writeInstancesScalar(projectionView, objects, indices, instanceCount, bytes, stride);
+                break;
+        }
+    }
+
+    const char *GolaMatrixKernel::getImplementationName(Implementation impl) {
+        switch (impl) {
+            case Implementation::Scalar:
+                return "scalar";
+            case Implementation::Avx2:
+                return "AVX2";
+            case Implementation::Avx512:
+                return "AVX-512";
+        }
+        return "unknown";
+    }
+
+    void GolaMatrixKernel::buildScalar(uint32_t begin, uint32_t end, glm::mat4 *out) const {
+        for (uint32_t i = begin; i < end; i++) {
+            // 与 Transform::mat4 相同
+            const float c3 = glm::cos(rotationZ[i]);
+            const float s3 = glm::sin(rotationZ[i]);
+            const float c2 = glm::cos(rotationX[i]);
+            const float s2 = glm::sin(rotationX[i]);
+            const float c1 = glm::cos(rotationY[i]);
+            const float s1 = glm::sin(rotationY[i]);
+            out[i] = glm::mat4{
+                {scaleX[i] * (c1 * c3 + s1 * s2 * s3), scaleX[i] * (c2 * s3), scaleX[i] * (c1 * s2 * s3 - c3 * s1), 0.0f},
+                {scaleY[i] * (c3 * s1 * s2 - c1 * s3), scaleY[i] * (c2 * c3), scaleY[i] * (c1 * c3 * s2 + s1 * s3), 0.0f},
+                {scaleZ[i] * (c2 * s1), scaleZ[i] * (-s2), scaleZ[i] * (c1 * c2), 0.0f},
+                {translationX[i], translationY[i], translationZ[i], 1.0f}};
+        }
+    }
+
+    void GolaMatrixKernel::writeInstancesScalar(const glm::mat4 &projectionView, const RenderObject *objects,
+                                                const uint32_t *indices, uint32_t instanceCount, std::byte *out,
+                                                size_t stride) {
+        for (uint32_t i = 0; i < instanceCount; i++) {
+            const RenderObject &obj = objects[indices[i]];
+            auto *dst = reinterpret_cast<glm::mat4 *>(out + i * stride);
+            *dst = projectionView * obj.transform->mat4();
+            *reinterpret_cast<glm::vec4 *>(dst + 1) = glm::vec4(obj.color, 1.0f);
+        }
+    }
+
+#if GOLA_ARCH_X86
+    // Cephes 的 sinf / cosf: 按 pi/4 分三段做范围缩减, 再用最小最大多项式逼近, 误差约 1 ulp (|x| < 8192)
+    namespace {
+        constexpr float FOUR_OVER_PI = 1.27323954473516f;
+        constexpr float DP1 = 0.78515625f;
+        constexpr float DP2 = 2.4187564849853515625e-4f;
+        constexpr float DP3 = 3.77489497744594108e-8f;
+        constexpr float COS_C0 = 2.443315711809948e-5f;
+        constexpr float COS_C1 = -1.388731625493765e-3f;
+        constexpr float COS_C2 = 4.166664568298827e-2f;
+        constexpr float SIN_C0 = -1.9515295891e-4f;
+        constexpr float SIN_C1 = 8.3321608736e-3f;
+        constexpr float SIN_C2 = -1.6666654611e-1f;
+    }
+
+    GOLA_TARGET_AVX2 static inline void sinCosAvx2(__m256 x, __m256 &sinOut, __m256 &cosOut) {
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        const __m256 xSign = _mm256_and_ps(x, signMask);
+        x = _mm256_andnot_ps(signMask, x);
+
+        // j = 距离最近的偶数个 pi/4, 决定象限
+        __m256i j = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(FOUR_OVER_PI)));
+        j = _mm256_and_si256(_mm256_add_epi32(j, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+        const __m256 y = _mm256_cvtepi32_ps(j);
+
+        const __m256 sinFlip = _mm256_castsi256_ps(
+            _mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29));
+        const __m256 cosFlip = _mm256_castsi256_ps(_mm256_slli_epi32(
+            _mm256_andnot_si256(_mm256_sub_epi32(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+        // 第 0, 3 象限用 sin 多项式求 sin, 第 1, 2 象限交换
+        const __m256 useSinPoly = _mm256_castsi256_ps(
+            _mm256_cmpeq_epi32(_mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+
+        x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(DP1)));
+        x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(DP2)));
+        x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(DP3)));
+        const __m256 z = _mm256_mul_ps(x, x);
+
+        __m256 cosPoly = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(COS_C0), z), _mm256_set1_ps(COS_C1));
+        cosPoly = _mm256_add_ps(_mm256_mul_ps(cosPoly, z), _mm256_set1_ps(COS_C2));
+        cosPoly = _mm256_mul_ps(_mm256_mul_ps(cosPoly, z), z);
+        cosPoly = _mm256_sub_ps(cosPoly, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+        cosPoly = _mm256_add_ps(cosPoly, _mm256_set1_ps(1.0f));
+
+        __m256 sinPoly = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SIN_C0), z), _mm256_set1_ps(SIN_C1));
+        sinPoly = _mm256_add_ps(_mm256_mul_ps(sinPoly, z), _mm256_set1_ps(SIN_C2));
+        sinPoly = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(sinPoly, z), x), x);
+
+        sinOut = _mm256_blendv_ps(cosPoly, sinPoly, useSinPoly);
+        cosOut = _mm256_blendv_ps(sinPoly, cosPoly, useSinPoly);
+        sinOut = _mm256_xor_ps(sinOut, _mm256_xor_ps(xSign, sinFlip));
+        cosOut = _mm256_xor_ps(cosOut, cosFlip);
+    }
+
+    GOLA_TARGET_AVX2 static inline void transpose8x8(__m256 *rows) {
+        const __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+        const __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+        const __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+        const __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+        const __m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+        const __m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+        const __m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+        const __m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+        const __m256 u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+        rows[0] = _mm256_permute2f128_ps(u0, u4, 0x20);
+        rows[1] = _mm256_permute2f128_ps(u1, u5, 0x20);
+        rows[2] = _mm256_permute2f128_ps(u2, u6, 0x20);
+        rows[3] = _mm256_permute2f128_ps(u3, u7, 0x20);
+        rows[4] = _mm256_permute2f128_ps(u0, u4, 0x31);
+        rows[5] = _mm256_permute2f128_ps(u1, u5, 0x31);
+        rows[6] = _mm256_permute2f128_ps(u2, u6, 0x31);
+        rows[7] = _mm256_permute2f128_ps(u3, u7, 0x31);
+    }
+
+    // elements 是模型矩阵的 16 个元素 (列主序), 每个 lane 一个对象; 转置后每个矩阵的 64 字节连续写出.
+    // 只写前 laneCount 个矩阵.
+    GOLA_TARGET_AVX2 static inline void storeMatricesAvx2(const __m256 *elements, glm::mat4 *out, uint32_t laneCount) {
+        __m256 low[8], high[8];
+        for (int e = 0; e < 8; e++) {
+            low[e] = elements[e];
+            high[e] = elements[8 + e];
+        }
+        transpose8x8(low);
+        transpose8x8(high);
+        for (uint32_t lane = 0; lane < laneCount; lane++) {
+            auto *dst = reinterpret_cast<float *>(out + lane);
+            _mm256_storeu_ps(dst, low[lane]);
+            _mm256_storeu_ps(dst + 8, high[lane]);
+        }
+    }
+
+    GOLA_TARGET_AVX2 void GolaMatrixKernel::buildAvx2(uint32_t begin, uint32_t end, glm::mat4 *out) const {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+
+        // 不用 FMA: 只要求 AVX2, 与 GolaFrustumCuller 一致
+        for (uint32_t i = begin; i < end; i += 8) {
+            __m256 s1, c1, s2, c2, s3, c3;
+            sinCosAvx2(_mm256_loadu_ps(&rotationY[i]), s1, c1);
+            sinCosAvx2(_mm256_loadu_ps(&rotationX[i]), s2, c2);
+            sinCosAvx2(_mm256_loadu_ps(&rotationZ[i]), s3, c3);
+            const __m256 sx = _mm256_loadu_ps(&scaleX[i]);
+            const __m256 sy = _mm256_loadu_ps(&scaleY[i]);
+            const __m256 sz = _mm256_loadu_ps(&scaleZ[i]);
+            const __m256 s1s2 = _mm256_mul_ps(s1, s2);
+            const __m256 c1s2 = _mm256_mul_ps(c1, s2);
+
+            __m256 elements[16];
+            elements[0] = _mm256_mul_ps(sx, _mm256_add_ps(_mm256_mul_ps(c1, c3), _mm256_mul_ps(s1s2, s3)));
+            elements[1] = _mm256_mul_ps(sx, _mm256_mul_ps(c2, s3));
+            elements[2] = _mm256_mul_ps(sx, _mm256_sub_ps(_mm256_mul_ps(c1s2, s3), _mm256_mul_ps(c3, s1)));
+            elements[3] = zero;
+            elements[4] = _mm256_mul_ps(sy, _mm256_sub_ps(_mm256_mul_ps(c3, s1s2), _mm256_mul_ps(c1, s3)));
+            elements[5] = _mm256_mul_ps(sy, _mm256_mul_ps(c2, c3));
+            elements[6] = _mm256_mul_ps(sy, _mm256_add_ps(_mm256_mul_ps(c1s2, c3), _mm256_mul_ps(s1, s3)));
+            elements[7] = zero;
+            elements[8] = _mm256_mul_ps(sz, _mm256_mul_ps(c2, s1));
+            elements[9] = _mm256_sub_ps(zero, _mm256_mul_ps(sz, s2));
+            elements[10] = _mm256_mul_ps(sz, _mm256_mul_ps(c1, c2));
+            elements[11] = zero;
+            elements[12] = _mm256_loadu_ps(&translationX[i]);
+            elements[13] = _mm256_loadu_ps(&translationY[i]);
+            elements[14] = _mm256_loadu_ps(&translationZ[i]);
+            elements[15] = one;
+
+            storeMatricesAvx2(elements, out + i, std::min(8u, end - i));
+        }
+    }
+
+    GOLA_TARGET_AVX2 void GolaMatrixKernel::writeInstancesAvx2(
+        const glm::mat4 &projectionView, const RenderObject *objects, const uint32_t *indices,
+        uint32_t instanceCount, std::byte *out, size_t stride) {
+        // 每个寄存器放两列: 结果的第 j 列 = sum_k projectionView[k] * model[j][k]
+        const auto *pv = reinterpret_cast<const float *>(&projectionView);
+        const __m256 pv0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(pv));
+        const __m256 pv1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(pv + 4));
+        const __m256 pv2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(pv + 8));
+        const __m256 pv3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(pv + 12));
+
+        for (uint32_t i = 0; i < instanceCount; i++) {
+            const RenderObject &obj = objects[indices[i]];
+            const auto *model = reinterpret_cast<const float *>(&obj.transform->mat4());
+            auto *dst = reinterpret_cast<float *>(out + i * stride);
+            for (int half = 0; half < 2; half++) {
+                const __m256 columns = _mm256_loadu_ps(model + 8 * half);
+                // 与 glm 的 mat4 * mat4 相同的运算顺序, 结果逐位一致
+                __m256 result = _mm256_mul_ps(pv0, _mm256_shuffle_ps(columns, columns, 0x00));
+                result = _mm256_add_ps(result, _mm256_mul_ps(pv1, _mm256_shuffle_ps(columns, columns, 0x55)));
+                result = _mm256_add_ps(result, _mm256_mul_ps(pv2, _mm256_shuffle_ps(columns, columns, 0xAA)));
+                result = _mm256_add_ps(result, _mm256_mul_ps(pv3, _mm256_shuffle_ps(columns, columns, 0xFF)));
+                _mm256_storeu_ps(dst + 8 * half, result);
+            }
+            _mm_storeu_ps(dst + 16, _mm_setr_ps(obj.color.r, obj.color.g, obj.color.b, 1.0f));
+        }
+    }
+
+    GOLA_TARGET_AVX512 static inline __m512 xorPs512(__m512 a, __m512i b) {
+        // _mm512_xor_ps 需要 AVX512DQ, 这里只要求 AVX512F
+        return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), b));
+    }
+
+    GOLA_TARGET_AVX512 static inline void sinCosAvx512(__m512 x, __m512 &sinOut, __m512 &cosOut) {
+        const __m512i signMask = _mm512_set1_epi32(static_cast<int>(0x80000000u));
+        const __m512i xSign = _mm512_and_si512(_mm512_castps_si512(x), signMask);
+        x = _mm512_castsi512_ps(_mm512_andnot_si512(signMask, _mm512_castps_si512(x)));
+
+        __m512i j = _mm512_cvttps_epi32(_mm512_mul_ps(x, _mm512_set1_ps(FOUR_OVER_PI)));
+        j = _mm512_and_si512(_mm512_add_epi32(j, _mm512_set1_epi32(1)), _mm512_set1_epi32(~1));
+        const __m512 y = _mm512_cvtepi32_ps(j);
+
+        const __m512i sinFlip = _mm512_slli_epi32(_mm512_and_si512(j, _mm512_set1_epi32(4)), 29);
+        const __m512i cosFlip = _mm512_slli_epi32(
+            _mm512_andnot_si512(_mm512_sub_epi32(j, _mm512_set1_epi32(2)), _mm512_set1_epi32(4)), 29);
+        const __mmask16 useSinPoly = _mm512_cmpeq_epi32_mask(
+            _mm512_and_si512(j, _mm512_set1_epi32(2)), _mm512_setzero_si512());
+
+        x = _mm512_fnmadd_ps(y, _mm512_set1_ps(DP1), x);
+        x = _mm512_fnmadd_ps(y, _mm512_set1_ps(DP2), x);
+        x = _mm512_fnmadd_ps(y, _mm512_set1_ps(DP3), x);
+        const __m512 z = _mm512_mul_ps(x, x);
+
+        __m512 cosPoly = _mm512_fmadd_ps(_mm512_set1_ps(COS_C0), z, _mm512_set1_ps(COS_C1));
+        cosPoly = _mm512_fmadd_ps(cosPoly, z, _mm512_set1_ps(COS_C2));
+        cosPoly = _mm512_mul_ps(_mm512_mul_ps(cosPoly, z), z);
+        cosPoly = _mm512_fnmadd_ps(z, _mm512_set1_ps(0.5f), cosPoly);
+        cosPoly = _mm512_add_ps(cosPoly, _mm512_set1_ps(1.0f));
+
+        __m512 sinPoly = _mm512_fmadd_ps(_mm512_set1_ps(SIN_C0), z, _mm512_set1_ps(SIN_C1));
+        sinPoly = _mm512_fmadd_ps(sinPoly, z, _mm512_set1_ps(SIN_C2));
+        sinPoly = _mm512_fmadd_ps(_mm512_mul_ps(sinPoly, z), x, x);
+
+        sinOut = xorPs512(_mm512_mask_blend_ps(useSinPoly, cosPoly, sinPoly), _mm512_xor_si512(xSign, sinFlip));
+        cosOut = xorPs512(_mm512_mask_blend_ps(useSinPoly, sinPoly, cosPoly), cosFlip);
+    }
+
+    GOLA_TARGET_AVX512 void GolaMatrixKernel::buildAvx512(uint32_t begin, uint32_t end, glm::mat4 *out) const {
+        const __m512 zero = _mm512_setzero_ps();
+        const __m512 one = _mm512_set1_ps(1.0f);
+
+        for (uint32_t i = begin; i < end; i += 16) {
+            __m512 s1, c1, s2, c2, s3, c3;
+            sinCosAvx512(_mm512_loadu_ps(&rotationY[i]), s1, c1);
+            sinCosAvx512(_mm512_loadu_ps(&rotationX[i]), s2, c2);
+            sinCosAvx512(_mm512_loadu_ps(&rotationZ[i]), s3, c3);
+            const __m512 sx = _mm512_loadu_ps(&scaleX[i]);
+            const __m512 sy = _mm512_loadu_ps(&scaleY[i]);
+            const __m512 sz = _mm512_loadu_ps(&scaleZ[i]);
+            const __m512 s1s2 = _mm512_mul_ps(s1, s2);
+            const __m512 c1s2 = _mm512_mul_ps(c1, s2);
+
+            __m512 elements[16];
+            elements[0] = _mm512_mul_ps(sx, _mm512_fmadd_ps(c1, c3, _mm512_mul_ps(s1s2, s3)));
+            elements[1] = _mm512_mul_ps(sx, _mm512_mul_ps(c2, s3));
+            elements[2] = _mm512_mul_ps(sx, _mm512_fmsub_ps(c1s2, s3, _mm512_mul_ps(c3, s1)));
+            elements[3] = zero;
+            elements[4] = _mm512_mul_ps(sy, _mm512_fmsub_ps(c3, s1s2, _mm512_mul_ps(c1, s3)));
+            elements[5] = _mm512_mul_ps(sy, _mm512_mul_ps(c2, c3));
+            elements[6] = _mm512_mul_ps(sy, _mm512_fmadd_ps(c1s2, c3, _mm512_mul_ps(s1, s3)));
+            elements[7] = zero;
+            elements[8] = _mm512_mul_ps(sz, _mm512_mul_ps(c2, s1));
+            elements[9] = _mm512_sub_ps(zero, _mm512_mul_ps(sz, s2));
+            elements[10] = _mm512_mul_ps(sz, _mm512_mul_ps(c1, c2));
+            elements[11] = zero;
+            elements[12] = _mm512_loadu_ps(&translationX[i]);
+            elements[13] = _mm512_loadu_ps(&translationY[i]);
+            elements[14] = _mm512_loadu_ps(&translationZ[i]);
+            elements[15] = one;
+
+            // 转置和写出按 8 个矩阵一组复用 AVX2 版本
+            __m256 lowHalf[16], highHalf[16];
+            for (int e = 0; e < 16; e++) {
+                lowHalf[e] = _mm512_castps512_ps256(elements[e]);
+                highHalf[e] = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(elements[e]), 1));
+            }
+            const uint32_t laneCount = std::min(16u, end - i);
+            storeMatricesAvx2(lowHalf, out + i, std::min(8u, laneCount));
+            if (laneCount > 8) {
+                storeMatricesAvx2(highHalf, out + i + 8, laneCount - 8);
+            }
+        }
+    }
+
+    GOLA_TARGET_AVX512 void GolaMatrixKernel::writeInstancesAvx512(
+        const glm::mat4 &projectionView, const RenderObject *objects, const uint32_t *indices,
+        uint32_t instanceCount, std::byte *out, size_t stride) {
+        // 整个矩阵放在一个寄存器里, 每个 128 位 lane 是一列; 使用 FMA, 与 glm 的结果只在舍入上有差别
+        const auto *pv = reinterpret_cast<const float *>(&projectionView);
+        const __m512 pv0 = _mm512_broadcast_f32x4(_mm_loadu_ps(pv));
+        const __m512 pv1 = _mm512_broadcast_f32x4(_mm_loadu_ps(pv + 4));
+        const __m512 pv2 = _mm512_broadcast_f32x4(_mm_loadu_ps(pv + 8));
+        const __m512 pv3 = _mm512_broadcast_f32x4(_mm_loadu_ps(pv + 12));
+
+        for (uint32_t i = 0; i < instanceCount; i++) {
+            const RenderObject &obj = objects[indices[i]];
+            const __m512 columns = _mm512_loadu_ps(&obj.transform->mat4());
+            __m512 result = _mm512_mul_ps(pv0, _mm512_permute_ps(columns, 0x00));
+            result = _mm512_fmadd_ps(pv1, _mm512_permute_ps(columns, 0x55), result);
+            result = _mm512_fmadd_ps(pv2, _mm512_permute_ps(columns, 0xAA), result);
+            result = _mm512_fmadd_ps(pv3, _mm512_permute_ps(columns, 0xFF), result);
+
+            auto *dst = reinterpret_cast<float *>(out + i * stride);
+            _mm512_storeu_ps(dst, result);
+            _mm_storeu_ps(dst + 16, _mm_setr_ps(obj.color.r, obj.color.g, obj.color.b, 1.0f));
+        }
+    }
+#else
+    void GolaMatrixKernel::buildAvx2(uint32_t begin, uint32_t end, glm::mat4 *out) const {
+        buildScalar(begin, end, out);
+    }
+
+    void GolaMatrixKernel::buildAvx512(uint32_t begin, uint32_t end, glm::mat4 *out) const {
+        buildScalar(begin, end, out);
+    }
+
+    void GolaMatrixKernel::writeInstancesAvx2(const glm::mat4 &projectionView, const RenderObject *objects,
+                                              const uint32_t *indices, uint32_t instanceCount, std::byte *out,
+                                              size_t stride) {
+        writeInstancesScalar(projectionView, objects, indices, instanceCount, out, stride);
+    }
+
+    void GolaMatrixKernel::writeInstancesAvx512(const glm::mat4 &projectionView, const RenderObject *objects,
+                                                const uint32_t *indices, uint32_t instanceCount, std::byte *out,
+                                                size_t stride) {
+        writeInstancesScalar(projectionView, objects, indices, instanceCount, out, stride);
+    }
+#endif
+
+    void GolaMatrixKernel::runBenchmark() {
+        const auto &cpu = GolaCpuFeatures::get();
+        std::print("[DEBUG] Matrix kernel benchmark (avx2: {}, avx512f: {})\n", cpu.avx2, cpu.avx512f);
+
+        using clock = std::chrono::high_resolution_clock;
+        auto elapsedMs = [](clock::time_point start) {
+            return std::chrono::duration<float, std::chrono::milliseconds::period>(clock::now() - start).count();
+        };
+
+        GolaCamera camera{};
+        camera.setPerspectiveProjection(glm::radians(50.f), 4.0f / 3.0f, 0.1f, 100.f);
+        camera.setViewYXZ(glm::vec3(1.0f, -2.0f, -5.0f), glm::vec3(0.2f, 0.3f, 0.0f));
+        const glm::mat4 projectionView = camera.getProjection() * camera.getView();
+
+        std::mt19937 rng{12345};
+        std::uniform_real_distribution<float> position{-100.0f, 100.0f};
+        // 包含较大的角度, 覆盖 sin/cos 的范围缩减
+        std::uniform_real_distribution<float> angle{-50.0f, 50.0f};
+        std::uniform_real_distribution<float> scale{0.1f, 2.0f};
+
+        // 与 InstanceData 相同的布局
+        struct Instance {
+            glm::mat4 transform;
+            glm::vec4 color;
+        };
+        static_assert(sizeof(Instance) == INSTANCE_FLOATS * sizeof(float));
+
+        std::vector<Implementation> implementations{Implementation::Scalar};
+        if (cpu.avx2) implementations.push_back(Implementation::Avx2);
+        if (cpu.avx512f) implementations.push_back(Implementation::Avx512);
+
+        for (uint32_t objectCount: {10'000u, 100'000u, 1'000'000u}) {
+            const int iterations = objectCount >= 1'000'000u ? 10 : 100;
+
+            std::vector<Transform> transforms(objectCount);
+            std::vector<RenderObject> objects(objectCount);
+            for (uint32_t i = 0; i < objectCount; i++) {
+                transforms[i].setTranslation(glm::vec3(position(rng), position(rng), position(rng)));
+                transforms[i].setRotation(glm::vec3(angle(rng), angle(rng), angle(rng)));
+                transforms[i].setScale(glm::vec3(scale(rng), scale(rng), scale(rng)));
+                objects[i] = {GolaEntity{i, 0}, &transforms[i], nullptr, glm::vec3(0.5f)};
+            }
+            // 渲染路径按可见对象的下标收集, 这里用所有对象
+            std::vector<uint32_t> indices(objectCount);
+            for (uint32_t i = 0; i < objectCount; i++) {
+                indices[i] = i;
+            }
+
+            // 1. 模型矩阵: Transform::updateMatrix 逐个计算 vs 批量构建
+            auto start = clock::now();
+            for (int iteration = 0; iteration < iterations; iteration++) {
+                for (auto &transform: transforms) {
+                    transform.updateMatrix();
+                }
+            }
+            float updateMatrixMs = elapsedMs(start) / iterations;
+
+            GolaMatrixKernel kernel{};
+            start = clock::now();
+            for (int iteration = 0; iteration < iterations; iteration++) {
+                kernel.resize(objectCount);
+                for (uint32_t i = 0; i < objectCount; i++) {
+                    kernel.setTransform(i, transforms[i]);
+                }
+            }
+            float gatherMs = elapsedMs(start) / iterations;
+
+            std::print("[DEBUG]   {:>8} objects, model matrices: Transform::updateMatrix {:8.3f} ms, SoA gather {:8.3f} ms\n",
+                       objectCount, updateMatrixMs, gatherMs);
+
+            std::vector<glm::mat4> matrices(objectCount);
+            for (Implementation impl: implementations) {
+                start = clock::now();
+                for (int iteration = 0; iteration < iterations; iteration++) {
+                    kernel.buildModelMatrices(0, objectCount, matrices.data(), impl);
+                }
+                float ms = elapsedMs(start) / iterations;
+                std::print("[DEBUG]     {:>8}: {:8.3f} ms\n", getImplementationName(impl), ms);
+            }
+
+            // 2. projectionView * model 写入实例数据: 原来的逐对象 glm 乘法 vs 批量版本
+            std::vector<Instance> expected(objectCount);
+            start = clock::now();
+            for (int iteration = 0; iteration < iterations; iteration++) {
+                for (uint32_t i = 0; i < objectCount; i++) {
+                    expected[i].transform = projectionView * objects[indices[i]].transform->mat4();
+                    expected[i].color = glm::vec4(objects[indices[i]].color, 1.0f);
+                }
+            }
+            float glmMs = elapsedMs(start) / iterations;
+            std::print("[DEBUG]   {:>8} objects, projectionView * model: glm loop {:8.3f} ms\n", objectCount, glmMs);
+
+            std::vector<Instance> instances(objectCount);
+            for (Implementation impl: implementations) {
+                start = clock::now();
+                for (int iteration = 0; iteration < iterations; iteration++) {
+                    kernel.writeInstances(projectionView, objects.data(), indices.data(), objectCount,
+                                          instances.data(), sizeof(Instance), impl);
+                }
+                float ms = elapsedMs(start) / iterations;
+                std::print("[DEBUG]     {:>8}: {:8.3f} ms\n", getImplementationName(impl), ms);
+            }
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "gola_components.hpp"
+#include "gola_frame_info.hpp"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gola {
+    /*
+     * 批量矩阵计算, 运行时选择 AVX-512 / AVX2 / 标量实现:
+     * - buildModelMatrices(): 平移 / 旋转 / 缩放按 SoA 存放, 每次迭代在寄存器中为 8 个 (AVX-512 时 16 个) 对象
+     *   构建模型矩阵 (与 Transform::mat4 相同的 YXZ 欧拉角, sin/cos 用多项式逼近), 转置后写出.
+     *   GolaTransformSystem 用它更新修改过的实体的缓存矩阵.
+     * - writeInstances(): projectionView * 缓存的模型矩阵, 按下标收集对象, 结果和颜色按 stride 直接写入输出
+     *   (通常是映射的实例缓冲区). 每个对象的输出为 16 个 float 的列主序矩阵加 4 个 float 的颜色 (alpha 为 1),
+     *   与 InstanceData 和 push constant 的布局一致.
+     */
+    class GolaMatrixKernel {
+    public:
+        enum class Implementation {
+            Scalar,
+            Avx2,
+            Avx512,
+        };
+
+        static constexpr uint32_t SIMD_WIDTH = 16;
+        // writeInstances() 每个对象输出的 float 数: 矩阵 + 颜色
+        static constexpr uint32_t INSTANCE_FLOATS = 20;
+
+        GolaMatrixKernel();
+
+        void resize(uint32_t count);
+
+        void setTransform(uint32_t index, const Transform &transform) {
+            const glm::vec3 &translation = transform.getTranslation();
+            const glm::vec3 &rotation = transform.getRotation();
+            const glm::vec3 &scale = transform.getScale();
+            translationX[index] = translation.x;
+            translationY[index] = translation.y;
+            translationZ[index] = translation.z;
+            rotationX[index] = rotation.x;
+            rotationY[index] = rotation.y;
+            rotationZ[index] = rotation.z;
+            scaleX[index] = scale.x;
+            scaleY[index] = scale.y;
+            scaleZ[index] = scale.z;
+        }
+
+        // Writes the model matrices of the transforms [begin, end) to out[begin, end). begin must be a
+        // multiple of SIMD_WIDTH, so that threads building disjoint ranges never read each other's inputs.
+        void buildModelMatrices(uint32_t begin, uint32_t end, glm::mat4 *out) const;
+
+        void buildModelMatrices(uint32_t begin, uint32_t end, glm::mat4 *out, Implementation implementation) const;
+
+        // For each i < count writes projectionView * objects[indices[i]].transform->mat4() followed by the
+        // object's color to out + i * stride (stride >= INSTANCE_FLOATS * sizeof(float)).
+        void writeInstances(const glm::mat4 &projectionView, const RenderObject *objects, const uint32_t *indices,
+                            uint32_t count, void *out, size_t stride) const;
+
+        void writeInstances(const glm::mat4 &projectionView, const RenderObject *objects, const uint32_t *indices,
+                            uint32_t count, void *out, size_t stride, Implementation implementation) const;
+
+        uint32_t getCount() const { return count; }
+        Implementation getImplementation() const { return implementation; }
+
+        static const char *getImplementationName(Implementation implementation);
+
+        // Runs both kernels on 10k/100k/1M random transforms with every available implementation and prints
+        // the timings. Results are checked against Transform::mat4 in Tests/gola_matrix_kernel_tests.cpp.
+        static void runBenchmark();
+
+    private:
+        void buildScalar(uint32_t begin, uint32_t end, glm::mat4 *out) const;
+
+        void buildAvx2(uint32_t begin, uint32_t end, glm::mat4 *out) const;
+
+        void buildAvx512(uint32_t begin, uint32_t end, glm::mat4 *out) const;
+
+        static void writeInstancesScalar(const glm::mat4 &projectionView, const RenderObject *objects,
+                                         const uint32_t *indices, uint32_t count, std::byte *out, size_t stride);
+
+        static void writeInstancesAvx2(const glm::mat4 &projectionView, const RenderObject *objects,
+                                       const uint32_t *indices, uint32_t count, std::byte *out, size_t stride);
+
+        static void writeInstancesAvx512(const glm::mat4 &projectionView, const RenderObject *objects,
+                                         const uint32_t *indices, uint32_t count, std::byte *out, size_t stride);
+
+        uint32_t count = 0;
+        std::vector<float> translationX, translationY, translationZ;
+        std::vector<float> rotationX, rotationY, rotationZ;
+        std::vector<float> scaleX, scaleY, scaleZ;
+
+        Implementation implementation;
+    };
+}
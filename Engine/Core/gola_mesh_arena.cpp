@@ -0,0 +1,117 @@
+#include "gola_mesh_arena.hpp"
+#include "gola_staging_ring.hpp"
+
+// std
+#include <stdexcept>
+
+namespace gola {
+    static constexpr VkDeviceSize INDEX_UNIT_SIZE = sizeof(uint16_t);
+
+    GolaMeshArena::GolaMeshArena(
+        GolaDevice &device, uint32_t vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity)
+        : device{device}, vertexStride{vertexStride}, vertexRanges{vertexCapacity}, indexRanges{indexCapacity} {
+        device.createBuffer(
+            static_cast<VkDeviceSize>(vertexCapacity) * vertexStride,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            vertexBuffer,
+            vertexAllocation);
+
+        device.createBuffer(
+            static_cast<VkDeviceSize>(indexCapacity) * INDEX_UNIT_SIZE,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            indexBuffer,
+            indexAllocation);
+    }
+
+    GolaMeshArena::~GolaMeshArena() {
+        device.destroyBuffer(indexBuffer, indexAllocation);
+        device.destroyBuffer(vertexBuffer, vertexAllocation);
+    }
+
+    GolaMeshArena::MeshRange GolaMeshArena::allocate(
+        const void *vertexData, uint32_t vertexCount, const void *indexData, uint32_t indexCount,
+        VkIndexType indexType) {
+        MeshRange range{};
+        range.vertexCount = vertexCount;
+        range.indexCount = indexCount;
+        range.indexType = indexType;
+
+        uint64_t firstVertex = vertexRanges.allocate(vertexCount);
+        if (firstVertex == GolaRangeAllocator::INVALID_OFFSET) {
+            throw std::runtime_error("mesh arena is out of vertex space!");
+        }
+        range.firstVertex = static_cast<uint32_t>(firstVertex);
+
+        if (indexCount > 0) {
+            // 32 位索引按两个单位对齐, 这样 firstIndex 在两种索引类型下都是整数
+            uint32_t units = indexUnits(indexType);
+            uint64_t firstUnit = indexRanges.allocate(static_cast<uint64_t>(indexCount) * units, units);
+            if (firstUnit == GolaRangeAllocator::INVALID_OFFSET) {
+                vertexRanges.free(firstVertex, vertexCount);
+                throw std::runtime_error("mesh arena is out of index space!");
+            }
+            range.firstIndex = static_cast<uint32_t>(firstUnit / units);
+        }
+
+        auto &stagingRing = device.getStagingRing();
+        stagingRing.upload(
+            vertexBuffer,
+            vertexData,
+            static_cast<VkDeviceSize>(vertexCount) * vertexStride,
+            static_cast<VkDeviceSize>(range.firstVertex) * vertexStride);
+        if (indexCount > 0) {
+            VkDeviceSize indexSize = indexUnits(indexType) * INDEX_UNIT_SIZE;
+            stagingRing.upload(
+                indexBuffer,
+                indexData,
+                indexCount * indexSize,
+                range.firstIndex * indexSize);
+        }
+
+        meshCount++;
+        return range;
+    }
+
+    void GolaMeshArena::free(const MeshRange &range) {
+        // 暂存环在每批拷贝之前都有一个执行屏障, 复用这段区间的上传不会覆盖仍在被读取的数据
+        vertexRanges.free(range.firstVertex, range.vertexCount);
+        if (range.isIndexed()) {
+            uint32_t units = indexUnits(range.indexType);
+            indexRanges.free(static_cast<uint64_t>(range.firstIndex) * units,
+                             static_cast<uint64_t>(range.indexCount) * units);
+        }
+        meshCount--;
+    }
+
+    void GolaMeshArena::bind(VkCommandBuffer commandBuffer, const MeshRange &range, BindState &state) const {
+        if (state.arena != this) {
+            VkBuffer buffers[] = {vertexBuffer};
+            VkDeviceSize offsets[] = {0};
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+            state.arena = this;
+            state.indexType = VK_INDEX_TYPE_MAX_ENUM;
+        }
+
+        if (range.isIndexed() && state.indexType != range.indexType) {
+            vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, range.indexType);
+            state.indexType = range.indexType;
+        }
+    }
+
+    void GolaMeshArena::draw(
+        VkCommandBuffer commandBuffer, const MeshRange &range, uint32_t instanceCount, uint32_t firstInstance) const {
+        if (range.isIndexed()) {
+            vkCmdDrawIndexed(
+                commandBuffer,
+                range.indexCount,
+                instanceCount,
+                range.firstIndex,
+                static_cast<int32_t>(range.firstVertex),
+                firstInstance);
+        } else {
+            vkCmdDraw(commandBuffer, range.vertexCount, instanceCount, range.firstVertex, firstInstance);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "gola_device.hpp"
+#include "gola_range_allocator.hpp"
+
+namespace gola {
+    /*
+     * 全局几何缓冲区: 所有网格都是同一个顶点缓冲区和同一个索引缓冲区中的子区间,
+     * 通过 firstVertex/firstIndex 寻址. 整个场景每帧只需绑定一次几何数据.
+     * 释放的区间立即回到空闲列表, 不需要重建整个缓冲区.
+     */
+    class GolaMeshArena {
+    public:
+        // 以顶点个数计
+        static constexpr uint32_t DEFAULT_VERTEX_CAPACITY = 1u << 20;
+        // 以 16 位索引为单位计, 32 位索引占两个单位
+        static constexpr uint32_t DEFAULT_INDEX_CAPACITY = 1u << 22;
+
+        struct MeshRange {
+            uint32_t firstVertex = 0;
+            uint32_t vertexCount = 0;
+            // 以 indexType 为单位, 相对于索引缓冲区起点
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+            VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+
+            bool isIndexed() const { return indexCount > 0; }
+        };
+
+        // 记录命令缓冲上当前绑定的几何状态, 避免重复绑定
+        struct BindState {
+            const GolaMeshArena *arena = nullptr;
+            VkIndexType indexType = VK_INDEX_TYPE_MAX_ENUM;
+        };
+
+        GolaMeshArena(
+            GolaDevice &device,
+            uint32_t vertexStride,
+            uint32_t vertexCapacity = DEFAULT_VERTEX_CAPACITY,
+            uint32_t indexCapacity = DEFAULT_INDEX_CAPACITY);
+
+        ~GolaMeshArena();
+
+        GolaMeshArena(const GolaMeshArena &) = delete;
+
+        GolaMeshArena &operator=(const GolaMeshArena &) = delete;
+
+        // Copies the data into the arena through the device staging ring.
+        // indexData holds indexCount values of indexType (may be null when indexCount == 0).
+        MeshRange allocate(
+            const void *vertexData, uint32_t vertexCount, const void *indexData, uint32_t indexCount,
+            VkIndexType indexType);
+
+        void free(const MeshRange &range);
+
+        // Binds the shared vertex buffer and, for indexed meshes, the index buffer with the
+        // mesh's index type. Does nothing if `state` says they are already bound.
+        void bind(VkCommandBuffer commandBuffer, const MeshRange &range, BindState &state) const;
+
+        void draw(VkCommandBuffer commandBuffer, const MeshRange &range, uint32_t instanceCount = 1,
+                  uint32_t firstInstance = 0) const;
+
+        VkBuffer getVertexBuffer() const { return vertexBuffer; }
+        VkBuffer getIndexBuffer() const { return indexBuffer; }
+        uint32_t getVertexStride() const { return vertexStride; }
+        uint32_t getMeshCount() const { return meshCount; }
+        uint64_t getUsedVertices() const { return vertexRanges.getUsedBytes(); }
+        uint64_t getUsedIndexUnits() const { return indexRanges.getUsedBytes(); }
+
+    private:
+        static uint32_t indexUnits(VkIndexType indexType) { return indexType == VK_INDEX_TYPE_UINT32 ? 2 : 1; }
+
+        GolaDevice &device;
+        uint32_t vertexStride;
+
+        VkBuffer vertexBuffer = VK_NULL_HANDLE;
+        GolaAllocation vertexAllocation{};
+        VkBuffer indexBuffer = VK_NULL_HANDLE;
+        GolaAllocation indexAllocation{};
+
+        GolaRangeAllocator vertexRanges;
+        GolaRangeAllocator indexRanges;
+        uint32_t meshCount = 0;
+    };
+}
@@ -3,47 +3,119 @@
 #include <stdexcept>
 #include <cassert>
 #include <cstring>
+#include <limits>
 #include <ostream>
+#include <unordered_map>
+
+namespace std {
+    template<>
+    struct hash<gola::GolaModel::Vertex> {
+        size_t operator()(const gola::GolaModel::Vertex &vertex) const {
+            // 按位哈希: 只有完全相同的顶点才会被合并
+            const float values[] = {
+                vertex.position.x, vertex.position.y, vertex.position.z,
+                vertex.color.x, vertex.color.y, vertex.color.z
+            };
+            size_t seed = 0;
+            for (float value: values) {
+                uint32_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                seed ^= std::hash<uint32_t>{}(bits) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            }
+            return seed;
+        }
+    };
+}
 
 namespace gola {
-    GolaModel::GolaModel(GolaDevice &device, const std::vector<Vertex> &vertices)
-        : device{device} {
-        createVertexBuffer(vertices);
+    GolaModel::GolaModel(GolaMeshArena &arena, const Builder &builder)
+        : arena{arena} {
+        auto vertexCount = static_cast<uint32_t>(builder.vertices.size());
+        auto indexCount = static_cast<uint32_t>(builder.indices.size());
+        assert(vertexCount >= 3 && "Vertex count must be greater than 2");
+        assert(arena.getVertexStride() == sizeof(Vertex) && "Mesh arena stride does not match GolaModel::Vertex");
+
+        // 顶点数不超过 65536 时使用 16 位索引
+        if (indexCount > 0 && vertexCount <= static_cast<uint32_t>(std::numeric_limits<uint16_t>::max()) + 1) {
+            std::vector<uint16_t> indices16(builder.indices.begin(), builder.indices.end());
+            meshRange = arena.allocate(
+                builder.vertices.data(), vertexCount, indices16.data(), indexCount, VK_INDEX_TYPE_UINT16);
+        } else {
+            meshRange = arena.allocate(
+                builder.vertices.data(), vertexCount, builder.indices.data(), indexCount, VK_INDEX_TYPE_UINT32);
+        }
+        computeBoundingSphere(builder.vertices);
+        printMemorySavings(builder.sourceVertexCount);
     }
 
     GolaModel::~GolaModel() {
-        vkDestroyBuffer(device.device(), vertexBuffer, nullptr);
-        vkFreeMemory(device.device(), vertexBufferMemory, nullptr);
+        arena.free(meshRange);
     }
 
-    void GolaModel::createVertexBuffer(const std::vector<Vertex> &vertices) {
-        vertexCount = static_cast<uint32_t>(vertices.size());
+    void GolaModel::Builder::addTriangles(const std::vector<Vertex> &triangleVertices) {
+        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+        uniqueVertices.reserve(vertices.size() + triangleVertices.size());
+        for (uint32_t i = 0; i < vertices.size(); i++) {
+            uniqueVertices.emplace(vertices[i], i);
+        }
 
-        assert(vertexCount >= 3 && "Vertex count must be greater than 2");
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-        std::print("[DEBUG] {} vertices, vertex buffer size: {}\n", vertexCount, bufferSize);
-
-        device.createBuffer(
-            bufferSize,
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            vertexBuffer,
-            vertexBufferMemory);
-
-        void *data;
-        vkMapMemory(device.device(), vertexBufferMemory, 0, bufferSize, 0, &data);
-        memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
-        vkUnmapMemory(device.device(), vertexBufferMemory);
+        indices.reserve(indices.size() + triangleVertices.size());
+        for (const auto &vertex: triangleVertices) {
+            auto [it, inserted] = uniqueVertices.emplace(vertex, static_cast<uint32_t>(vertices.size()));
+            if (inserted) {
+                vertices.push_back(vertex);
+            }
+            indices.push_back(it->second);
+        }
+        sourceVertexCount += static_cast<uint32_t>(triangleVertices.size());
+    }
+
+    void GolaModel::computeBoundingSphere(const std::vector<Vertex> &vertices) {
+        // 以 AABB 中心为球心, 比最小包围球略大, 但只需两次遍历
+        glm::vec3 minPosition = vertices[0].position;
+        glm::vec3 maxPosition = vertices[0].position;
+        for (const auto &vertex: vertices) {
+            minPosition = glm::min(minPosition, vertex.position);
+            maxPosition = glm::max(maxPosition, vertex.position);
+        }
+        glm::vec3 center = (minPosition + maxPosition) * 0.5f;
+
+        float radiusSquared = 0.0f;
+        for (const auto &vertex: vertices) {
+            glm::vec3 offset = vertex.position - center;
+            radiusSquared = glm::max(radiusSquared, glm::dot(offset, offset));
+        }
+        boundingSphere = glm::vec4(center, glm::sqrt(radiusSquared));
+    }
+
+    void GolaModel::printMemorySavings(uint32_t sourceVertexCount) const {
+        uint32_t vertexCount = meshRange.vertexCount;
+        uint32_t indexCount = meshRange.indexCount;
+        bool hasIndexBuffer = meshRange.isIndexed();
+        VkIndexType indexType = meshRange.indexType;
+        VkDeviceSize vertexBytes = sizeof(Vertex) * vertexCount;
+        VkDeviceSize indexBytes = static_cast<VkDeviceSize>(indexCount) *
+                                  (indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t));
+        // Builder 直接填写 vertices/indices 时没有去重前的数量, 按展开后的数量计算
+        if (sourceVertexCount == 0) {
+            sourceVertexCount = hasIndexBuffer ? indexCount : vertexCount;
+        }
+        VkDeviceSize sourceBytes = sizeof(Vertex) * static_cast<VkDeviceSize>(sourceVertexCount);
+        long long savedBytes = static_cast<long long>(sourceBytes) - static_cast<long long>(vertexBytes + indexBytes);
+
+        std::print("[DEBUG] {} -> {} vertices ({} saved), {} x {}-bit indices, vertex data: {} bytes, "
+                   "index data: {} bytes, saved {} of {} bytes\n",
+                   sourceVertexCount, vertexCount, static_cast<long long>(sourceVertexCount) - vertexCount,
+                   indexCount, indexType == VK_INDEX_TYPE_UINT16 ? 16 : 32,
+                   vertexBytes, indexBytes, savedBytes, sourceBytes);
     }
 
-    void GolaModel::bind(VkCommandBuffer commandBuffer) {
-        VkBuffer buffers[] = {vertexBuffer};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+    void GolaModel::bind(VkCommandBuffer commandBuffer, GolaMeshArena::BindState &bindState) {
+        arena.bind(commandBuffer, meshRange, bindState);
     }
 
-    void GolaModel::draw(VkCommandBuffer commandBuffer) {
-        vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+    void GolaModel::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance) {
+        arena.draw(commandBuffer, meshRange, instanceCount, firstInstance);
     }
 
     // Static methods to get vertex input binding and attribute descriptions
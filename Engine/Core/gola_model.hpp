@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gola_device.hpp"
+#include "gola_mesh_arena.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -16,23 +17,49 @@ namespace gola {
 
 			static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
 			static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+
+			bool operator==(const Vertex& other) const {
+				return position == other.position && color == other.color;
+			}
+		};
+
+		// 导入时对顶点去重并生成索引
+		struct Builder {
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			// 去重前的顶点数, 用于统计节省量
+			uint32_t sourceVertexCount = 0;
+
+			// Append a non-indexed triangle list, merging bit-identical vertices.
+			void addTriangles(const std::vector<Vertex>& triangleVertices);
 		};
 
-		GolaModel(GolaDevice& device, const std::vector<Vertex>& vertices);
+		// 几何数据存放在 arena 的共享缓冲区中, 模型只持有其中的区间
+		GolaModel(GolaMeshArena& arena, const Builder& builder);
 		~GolaModel();
 
 		GolaModel(const GolaModel&) = delete;
 		GolaModel& operator=(const GolaModel&) = delete;
 
-		void bind(VkCommandBuffer commandBuffer);
-		void draw(VkCommandBuffer commandBuffer);
+		// 与同一命令缓冲上的其他模型共享 bindState, 同一 arena 只绑定一次
+		void bind(VkCommandBuffer commandBuffer, GolaMeshArena::BindState& bindState);
+		void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+
+		const GolaMeshArena::MeshRange& getMeshRange() const { return meshRange; }
+		GolaMeshArena& getArena() const { return arena; }
+		// 模型空间包围球: xyz 为球心, w 为半径
+		const glm::vec4& getBoundingSphere() const { return boundingSphere; }
+		uint32_t getTriangleCount() const {
+			return (meshRange.isIndexed() ? meshRange.indexCount : meshRange.vertexCount) / 3;
+		}
 
 	private:
-		void createVertexBuffer(const std::vector<Vertex>& vertices);
+		void printMemorySavings(uint32_t sourceVertexCount) const;
+
+		void computeBoundingSphere(const std::vector<Vertex>& vertices);
 
-		GolaDevice& device;
-		VkBuffer vertexBuffer;
-		VkDeviceMemory vertexBufferMemory;
-		uint32_t vertexCount;
+		GolaMeshArena& arena;
+		GolaMeshArena::MeshRange meshRange{};
+		glm::vec4 boundingSphere{0.0f};
 	};
-}
\ No newline at end of file
+}
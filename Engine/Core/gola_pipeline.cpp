@@ -1,23 +1,65 @@
 #include "gola_pipeline.hpp"
 #include "gola_model.hpp"
+#include "gola_pipeline_cache.hpp"
+#include "gola_pipeline_registry.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <stdexcept>
 #include <iostream>
 #include <assert.h>
 
 namespace gola {
+    VkSpecializationInfo GolaSpecializationConstants::getInfo() const {
+        VkSpecializationInfo info{};
+        info.mapEntryCount = static_cast<uint32_t>(entries.size());
+        info.pMapEntries = entries.data();
+        info.dataSize = data.size() * sizeof(uint32_t);
+        info.pData = data.data();
+        return info;
+    }
+
+    void GolaSpecializationConstants::setBits(uint32_t constantId, uint32_t bits) {
+        auto it = std::lower_bound(entries.begin(), entries.end(), constantId,
+                                   [](const VkSpecializationMapEntry &entry, uint32_t id) {
+                                       return entry.constantID < id;
+                                   });
+        const auto index = static_cast<size_t>(it - entries.begin());
+        if (it != entries.end() && it->constantID == constantId) {
+            data[index] = bits;
+            return;
+        }
+        // 数据与条目顺序一致, 插入位置之后的偏移都要后移
+        entries.insert(it, {constantId, 0, sizeof(uint32_t)});
+        data.insert(data.begin() + static_cast<std::ptrdiff_t>(index), bits);
+        for (size_t i = index; i < entries.size(); i++) {
+            entries[i].offset = static_cast<uint32_t>(i * sizeof(uint32_t));
+        }
+    }
+
     GolaPipeline::GolaPipeline(
         GolaDevice &device,
         const std::string &vertexShaderPath,
         const std::string &fragmentShaderPath,
-        const PipelineConfigInfo &configInfo) : golaDevice(device) {
-        createGraphicsPipeline(vertexShaderPath, fragmentShaderPath, configInfo);
+        const PipelineConfigInfo &configInfo)
+        : GolaPipeline(device,
+                       device.getPipelineRegistry().getShaderModule(vertexShaderPath),
+                       device.getPipelineRegistry().getShaderModule(fragmentShaderPath),
+                       configInfo) {
+    }
+
+    GolaPipeline::GolaPipeline(
+        GolaDevice &device,
+        std::shared_ptr<GolaShaderModule> vertexShader,
+        std::shared_ptr<GolaShaderModule> fragmentShader,
+        const PipelineConfigInfo &configInfo)
+        : golaDevice(device),
+          vertexShaderModule(std::move(vertexShader)),
+          fragmentShaderModule(std::move(fragmentShader)) {
+        createGraphicsPipeline(configInfo);
     }
 
     GolaPipeline::~GolaPipeline() {
-        vkDestroyShaderModule(golaDevice.device(), vertexShaderModule, nullptr);
-        vkDestroyShaderModule(golaDevice.device(), fragmentShaderModule, nullptr);
         vkDestroyPipeline(golaDevice.device(), graphicsPipeline, nullptr);
     }
 
@@ -36,38 +78,53 @@ namespace gola {
         return buffer;
     }
 
-    void GolaPipeline::createGraphicsPipeline(const std::string &vertexShaderPath,
-                                              const std::string &fragmentShaderPath,
-                                              const PipelineConfigInfo &configInfo) {
-        // Load shaders and create graphics pipeline
+    static bool hasStencilComponent(VkFormat format) {
+        return format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT ||
+               format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+    }
+
+    void GolaRenderTarget::apply(PipelineConfigInfo &configInfo) const {
+        configInfo.renderPass = renderPass;
+        if (renderPass == VK_NULL_HANDLE) {
+            configInfo.colorAttachmentFormats = {colorFormat};
+            configInfo.depthAttachmentFormat = depthFormat;
+        }
+    }
+
+    void GolaPipeline::createGraphicsPipeline(const PipelineConfigInfo &configInfo) {
+        // Create graphics pipeline from the shared shader modules
         assert(
             configInfo.pipelineLayout != VK_NULL_HANDLE &&
             "Cannot create graphics pipeline: no pipeline layout provided");
-        assert(configInfo.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline: no render pass provided");
+        assert(
+            (configInfo.renderPass != VK_NULL_HANDLE || !configInfo.colorAttachmentFormats.empty() ||
+             configInfo.depthAttachmentFormat != VK_FORMAT_UNDEFINED) &&
+            "Cannot create graphics pipeline: no render pass or attachment formats provided");
 
-        auto vertexShaderCode = readFile(vertexShaderPath);
-        auto fragmentShaderCode = readFile(fragmentShaderPath);
-        createShaderModule(vertexShaderCode, vertexShaderModule);
-        createShaderModule(fragmentShaderCode, fragmentShaderModule);
+        // 没有特化常量时不传特化信息
+        const VkSpecializationInfo vertexSpecialization = configInfo.vertexSpecialization.getInfo();
+        const VkSpecializationInfo fragmentSpecialization = configInfo.fragmentSpecialization.getInfo();
 
         VkPipelineShaderStageCreateInfo shaderStages[2]{};
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-        shaderStages[0].module = vertexShaderModule;
+        shaderStages[0].module = vertexShaderModule->getHandle();
         shaderStages[0].pName = "main";
         shaderStages[0].flags = 0;
         shaderStages[0].pNext = nullptr;
-        shaderStages[0].pSpecializationInfo = nullptr;
+        shaderStages[0].pSpecializationInfo =
+                configInfo.vertexSpecialization.empty() ? nullptr : &vertexSpecialization;
         shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-        shaderStages[1].module = fragmentShaderModule;
+        shaderStages[1].module = fragmentShaderModule->getHandle();
         shaderStages[1].pName = "main";
         shaderStages[1].flags = 0;
         shaderStages[1].pNext = nullptr;
-        shaderStages[1].pSpecializationInfo = nullptr;
+        shaderStages[1].pSpecializationInfo =
+                configInfo.fragmentSpecialization.empty() ? nullptr : &fragmentSpecialization;
 
-        auto bindingDescription = GolaModel::Vertex::getBindingDescriptions();
-        auto attributeDescriptions = GolaModel::Vertex::getAttributeDescriptions();
+        auto &bindingDescription = configInfo.bindingDescriptions;
+        auto &attributeDescriptions = configInfo.attributeDescriptions;
 
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -76,8 +133,19 @@ namespace gola {
         vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
         vertexInputInfo.pVertexBindingDescriptions = bindingDescription.data();
 
+        // 没有 render pass 时用动态渲染, 由 attachment 格式决定兼容性
+        VkPipelineRenderingCreateInfo renderingInfo{};
+        renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+        renderingInfo.colorAttachmentCount = static_cast<uint32_t>(configInfo.colorAttachmentFormats.size());
+        renderingInfo.pColorAttachmentFormats = configInfo.colorAttachmentFormats.data();
+        renderingInfo.depthAttachmentFormat = configInfo.depthAttachmentFormat;
+        renderingInfo.stencilAttachmentFormat = hasStencilComponent(configInfo.depthAttachmentFormat)
+                                                    ? configInfo.depthAttachmentFormat
+                                                    : VK_FORMAT_UNDEFINED;
+
         VkGraphicsPipelineCreateInfo pipelineInfo{};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.pNext = configInfo.renderPass == VK_NULL_HANDLE ? &renderingInfo : nullptr;
         pipelineInfo.stageCount = 2;
         pipelineInfo.pStages = shaderStages;
         pipelineInfo.pVertexInputState = &vertexInputInfo;
@@ -95,23 +163,15 @@ namespace gola {
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
         pipelineInfo.basePipelineIndex = -1;
 
-        if (vkCreateGraphicsPipelines(golaDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline)
+        VkPipelineCache pipelineCache = configInfo.pipelineCache != VK_NULL_HANDLE
+                                            ? configInfo.pipelineCache
+                                            : golaDevice.getPipelineCache().getHandle();
+        if (vkCreateGraphicsPipelines(golaDevice.device(), pipelineCache, 1, &pipelineInfo, nullptr, &graphicsPipeline)
             != VK_SUCCESS) {
             throw std::runtime_error("Failed to create graphics pipeline");
         }
     }
 
-    void GolaPipeline::createShaderModule(const std::vector<char> &code, VkShaderModule &shaderModule) {
-        VkShaderModuleCreateInfo createInfo{};
-        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = code.size();
-        createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
-
-        if (vkCreateShaderModule(golaDevice.device(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create shader module");
-        }
-    }
-
     void GolaPipeline::bind(VkCommandBuffer commandBuffer) {
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
     }
@@ -175,5 +235,40 @@ namespace gola {
         configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
         configInfo.dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
         configInfo.dynamicStateInfo.flags = 0;
+
+        configInfo.bindingDescriptions = GolaModel::Vertex::getBindingDescriptions();
+        configInfo.attributeDescriptions = GolaModel::Vertex::getAttributeDescriptions();
+    }
+
+    GolaComputePipeline::GolaComputePipeline(
+        GolaDevice &device,
+        const std::string &computeShaderPath,
+        VkPipelineLayout pipelineLayout) : golaDevice(device) {
+        assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline: no pipeline layout provided");
+
+        computeShaderModule = golaDevice.getPipelineRegistry().getShaderModule(computeShaderPath);
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = computeShaderModule->getHandle();
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+        pipelineInfo.basePipelineIndex = -1;
+
+        if (vkCreateComputePipelines(golaDevice.device(), golaDevice.getPipelineCache().getHandle(), 1, &pipelineInfo,
+                                     nullptr, &computePipeline) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create compute pipeline");
+        }
+    }
+
+    GolaComputePipeline::~GolaComputePipeline() {
+        vkDestroyPipeline(golaDevice.device(), computePipeline, nullptr);
+    }
+
+    void GolaComputePipeline::bind(VkCommandBuffer commandBuffer) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
     }
 }
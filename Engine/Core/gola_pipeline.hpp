@@ -1,9 +1,53 @@
 #pragma once
 #include "gola_device.hpp"
+#include <bit>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+// .spv 所在的目录. CMake 找到 glslc 时定义为构建目录中的 shaders, 否则使用 compile.bat 在源码树中的输出
+#ifndef GOLA_SHADER_DIR
+#define GOLA_SHADER_DIR "Engine/shaders"
+#endif
+
 namespace gola {
+	class GolaShaderModule;
+
+	// 一个 shader 阶段的特化常量, 对应 GLSL 中的 layout (constant_id = N) const.
+	// 所有支持的类型都是 32 位, bool 按 VkBool32 保存; 常量按 constant_id 排序, 相同的集合总是得到相同的字节
+	class GolaSpecializationConstants {
+	public:
+		template<typename T>
+		void set(uint32_t constantId, T value) {
+			static_assert(
+				std::is_same_v<T, bool> || std::is_same_v<T, int32_t> ||
+				std::is_same_v<T, uint32_t> || std::is_same_v<T, float>,
+				"specialization constants must be bool, int32_t, uint32_t or float");
+			if constexpr (std::is_same_v<T, bool>) {
+				setBits(constantId, value ? VK_TRUE : VK_FALSE);
+			} else {
+				setBits(constantId, std::bit_cast<uint32_t>(value));
+			}
+		}
+
+		bool empty() const { return entries.empty(); }
+
+		const std::vector<VkSpecializationMapEntry>& getEntries() const { return entries; }
+
+		const std::vector<uint32_t>& getData() const { return data; }
+
+		// 指向本对象的数组, 修改或销毁之后失效
+		VkSpecializationInfo getInfo() const;
+
+	private:
+		void setBits(uint32_t constantId, uint32_t bits);
+
+		std::vector<VkSpecializationMapEntry> entries;
+		std::vector<uint32_t> data;
+	};
+
 	struct PipelineConfigInfo {
 		PipelineConfigInfo(const PipelineConfigInfo&) = delete;
 		PipelineConfigInfo() = default;
@@ -23,16 +67,42 @@ namespace gola {
 		VkPipelineLayout pipelineLayout = nullptr;
 		VkRenderPass renderPass = nullptr;
 		uint32_t subpass = 0;
+		// renderPass 为空时管线用于动态渲染, 只需要 attachment 格式; 带模板的深度格式同时作为模板格式
+		std::vector<VkFormat> colorAttachmentFormats{};
+		VkFormat depthAttachmentFormat = VK_FORMAT_UNDEFINED;
+		// 没有设置的常量使用 shader 中的默认值
+		GolaSpecializationConstants vertexSpecialization;
+		GolaSpecializationConstants fragmentSpecialization;
+		// 为空时使用设备的全局缓存
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE;
 	};
 
+	// 管线的渲染目标: 有 renderPass 时按 render pass 创建管线, 否则按动态渲染的 attachment 格式创建.
+	// 动态渲染时交换链重建不会改变它, 已经创建的管线和 ImGui 都不需要重建
+	struct GolaRenderTarget {
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+		VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+
+		void apply(PipelineConfigInfo& configInfo) const;
+	};
+
+	// 总是新建一个管线; 需要共享相同状态的管线时使用 GolaPipelineRegistry::getGraphicsPipeline
 	class GolaPipeline {
 	public:
+		// shader module 从设备的 GolaPipelineRegistry 获取, 与其他管线共享
 		GolaPipeline(
 			GolaDevice& device,
 			const std::string& vertexShaderPath,
 			const std::string& fragmentShaderPath,
 			const PipelineConfigInfo& configInfo);
 
+		GolaPipeline(
+			GolaDevice& device,
+			std::shared_ptr<GolaShaderModule> vertexShader,
+			std::shared_ptr<GolaShaderModule> fragmentShader,
+			const PipelineConfigInfo& configInfo);
+
 		~GolaPipeline();
 
 		GolaPipeline(const GolaPipeline&) = delete;
@@ -42,18 +112,35 @@ namespace gola {
 
 		static void defaultPipelineConfigInfo(PipelineConfigInfo &configInfo);
 
-	private:
 		static std::vector<char> readFile(const std::string& filepath);
 
-		void createGraphicsPipeline(const std::string& vertexShaderPath,
-			const std::string& fragmentShaderPath,
-			const PipelineConfigInfo& configInfo);
-
-		void createShaderModule(const std::vector<char>& code, VkShaderModule& shaderModule);
+	private:
+		void createGraphicsPipeline(const PipelineConfigInfo& configInfo);
 
 		GolaDevice& golaDevice;
 		VkPipeline graphicsPipeline;
-		VkShaderModule vertexShaderModule;
-		VkShaderModule fragmentShaderModule;
+		std::shared_ptr<GolaShaderModule> vertexShaderModule;
+		std::shared_ptr<GolaShaderModule> fragmentShaderModule;
+	};
+
+	// 计算管线: 单个 compute shader + 外部提供的 pipeline layout
+	class GolaComputePipeline {
+	public:
+		GolaComputePipeline(
+			GolaDevice& device,
+			const std::string& computeShaderPath,
+			VkPipelineLayout pipelineLayout);
+
+		~GolaComputePipeline();
+
+		GolaComputePipeline(const GolaComputePipeline&) = delete;
+		GolaComputePipeline& operator=(const GolaComputePipeline&) = delete;
+
+		void bind(VkCommandBuffer commandBuffer);
+
+	private:
+		GolaDevice& golaDevice;
+		VkPipeline computePipeline;
+		std::shared_ptr<GolaShaderModule> computeShaderModule;
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,248 @@
+#include "gola_pipeline_cache.hpp"
+
+#include "gola_device.hpp"
+#include "gola_pipeline.hpp"
+
+// std
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <print>
+#include <stdexcept>
+#include <system_error>
+
+namespace gola {
+    static uint64_t checksum(const char *data, size_t size) {
+        // FNV-1a, 只用于发现截断或损坏的文件
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    GolaPipelineCache::GolaPipelineCache(VkDevice device, const VkPhysicalDeviceProperties &properties,
+                                         std::string path)
+        : device{device}, properties{properties}, path{std::move(path)} {
+        std::vector<char> file;
+        std::ifstream input(this->path, std::ios::ate | std::ios::binary);
+        if (input.is_open()) {
+            file.resize(static_cast<size_t>(input.tellg()));
+            input.seekg(0);
+            input.read(file.data(), static_cast<std::streamsize>(file.size()));
+            if (!input) {
+                file.clear();
+            }
+        }
+
+        // 文件不存在时是正常的冷启动, 只有文件无效时才提示
+        const char *initialData = nullptr;
+        if (!file.empty()) {
+            const std::string error = validate(file);
+            if (error.empty()) {
+                initialData = file.data() + sizeof(FileHeader);
+                loadedSize = file.size() - sizeof(FileHeader);
+            } else {
+                std::print("[DEBUG] Ignoring pipeline cache {}: {}\n", this->path, error);
+            }
+        }
+
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = loadedSize;
+        cacheInfo.pInitialData = initialData;
+        if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline cache!");
+        }
+    }
+
+    GolaPipelineCache::~GolaPipelineCache() {
+        vkDestroyPipelineCache(device, pipelineCache, nullptr);
+    }
+
+    std::string GolaPipelineCache::validate(const std::vector<char> &file) const {
+        FileHeader header{};
+        if (file.size() < sizeof(FileHeader)) {
+            return "file is truncated";
+        }
+        std::memcpy(&header, file.data(), sizeof(FileHeader));
+        if (header.magic != FILE_MAGIC || header.version != FILE_VERSION) {
+            return "unknown file format";
+        }
+        if (header.vendorID != properties.vendorID || header.deviceID != properties.deviceID ||
+            header.driverVersion != properties.driverVersion ||
+            std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+            return "written by a different device or driver";
+        }
+        const char *data = file.data() + sizeof(FileHeader);
+        const size_t dataSize = file.size() - sizeof(FileHeader);
+        if (header.dataSize != dataSize || header.checksum != checksum(data, dataSize)) {
+            return "file is corrupted";
+        }
+
+        // 驱动数据自带的头也要与设备一致, 防止文件头和数据来自不同的设备
+        VkPipelineCacheHeaderVersionOne driverHeader{};
+        if (dataSize < sizeof(driverHeader)) {
+            return "driver data is truncated";
+        }
+        std::memcpy(&driverHeader, data, sizeof(driverHeader));
+        if (driverHeader.headerSize < sizeof(driverHeader) || driverHeader.headerSize > dataSize ||
+            driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+            driverHeader.vendorID != properties.vendorID || driverHeader.deviceID != properties.deviceID ||
+            std::memcmp(driverHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+            return "driver data does not match the device";
+        }
+        return {};
+    }
+
+    bool GolaPipelineCache::save() const {
+        size_t dataSize = 0;
+        if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr) != VK_SUCCESS) {
+            std::print("[DEBUG] Failed to save pipeline cache {}: could not query the cache size\n", path);
+            return false;
+        }
+        std::vector<char> file(sizeof(FileHeader) + dataSize);
+        char *data = file.data() + sizeof(FileHeader);
+        if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, data) != VK_SUCCESS) {
+            std::print("[DEBUG] Failed to save pipeline cache {}: could not read the cache data\n", path);
+            return false;
+        }
+        file.resize(sizeof(FileHeader) + dataSize);
+
+        FileHeader header{};
+        header.magic = FILE_MAGIC;
+        header.version = FILE_VERSION;
+        header.vendorID = properties.vendorID;
+        header.deviceID = properties.deviceID;
+        header.driverVersion = properties.driverVersion;
+        std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+        header.dataSize = dataSize;
+        header.checksum = checksum(file.data() + sizeof(FileHeader), dataSize);
+        std::memcpy(file.data(), &header, sizeof(FileHeader));
+
+        // 先完整写入临时文件, 再用 rename 替换, 旧文件要么保持不变要么被完整的新文件取代
+        const std::string tempPath = path + ".tmp";
+        {
+            std::ofstream output(tempPath, std::ios::binary | std::ios::trunc);
+            output.write(file.data(), static_cast<std::streamsize>(file.size()));
+            output.close();
+            if (!output) {
+                std::print("[DEBUG] Failed to save pipeline cache {}: could not write {}\n", path, tempPath);
+                std::error_code ignored;
+                std::filesystem::remove(tempPath, ignored);
+                return false;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(tempPath, path, error);
+        if (error) {
+            std::print("[DEBUG] Failed to save pipeline cache {}: {}\n", path, error.message());
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+        return true;
+    }
+
+    void GolaPipelineCache::runBenchmark(GolaDevice &device, const GolaRenderTarget &renderTarget) {
+        static constexpr const char *BENCHMARK_PATH = "pipeline_cache_benchmark.bin";
+
+        // 与 simple shader 兼容的 layout, push constant 使用规范保证的最小上限
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = 128;
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        VkPipelineLayout pipelineLayout;
+        if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+
+        // 渲染状态的组合, 每种都是驱动需要单独编译的管线
+        static constexpr VkCullModeFlags CULL_MODES[] = {
+            VK_CULL_MODE_NONE, VK_CULL_MODE_BACK_BIT, VK_CULL_MODE_FRONT_BIT};
+        static constexpr VkCompareOp DEPTH_COMPARE_OPS[] = {
+            VK_COMPARE_OP_LESS, VK_COMPARE_OP_LESS_OR_EQUAL, VK_COMPARE_OP_GREATER, VK_COMPARE_OP_ALWAYS};
+        static constexpr VkPrimitiveTopology TOPOLOGIES[] = {
+            VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP, VK_PRIMITIVE_TOPOLOGY_LINE_LIST};
+        static constexpr bool BLEND_MODES[] = {false, true};
+
+        auto createPipelines = [&](VkPipelineCache cache) {
+            std::vector<std::unique_ptr<GolaPipeline>> pipelines;
+            const auto startTime = std::chrono::high_resolution_clock::now();
+            for (VkCullModeFlags cullMode: CULL_MODES) {
+                for (VkCompareOp compareOp: DEPTH_COMPARE_OPS) {
+                    for (VkPrimitiveTopology topology: TOPOLOGIES) {
+                        for (bool blend: BLEND_MODES) {
+                            PipelineConfigInfo pipelineConfig{};
+                            GolaPipeline::defaultPipelineConfigInfo(pipelineConfig);
+                            pipelineConfig.rasterizationInfo.cullMode = cullMode;
+                            pipelineConfig.depthStencilInfo.depthCompareOp = compareOp;
+                            pipelineConfig.inputAssemblyInfo.topology = topology;
+                            if (blend) {
+                                pipelineConfig.colorBlendAttachment.blendEnable = VK_TRUE;
+                                pipelineConfig.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+                                pipelineConfig.colorBlendAttachment.dstColorBlendFactor =
+                                        VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+                                pipelineConfig.colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+                                pipelineConfig.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+                                pipelineConfig.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+                                pipelineConfig.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+                            }
+                            renderTarget.apply(pipelineConfig);
+                            pipelineConfig.pipelineLayout = pipelineLayout;
+                            pipelineConfig.pipelineCache = cache;
+                            pipelines.push_back(std::make_unique<GolaPipeline>(
+                                device,
+                                GOLA_SHADER_DIR "/simple_shader.vert.spv",
+                                GOLA_SHADER_DIR "/simple_shader.frag.spv",
+                                pipelineConfig));
+                        }
+                    }
+                }
+            }
+            const float elapsedMs = std::chrono::duration<float, std::chrono::milliseconds::period>(
+                std::chrono::high_resolution_clock::now() - startTime).count();
+            return std::make_pair(pipelines.size(), elapsedMs);
+        };
+
+        float coldMs = 0.0f;
+        float warmMs = 0.0f;
+        size_t pipelineCount = 0;
+        size_t loadedSize = 0;
+        bool saved = false;
+        {
+            // 冷启动: 空缓存, 创建后写入文件
+            std::error_code ignored;
+            std::filesystem::remove(BENCHMARK_PATH, ignored);
+            GolaPipelineCache coldCache{device.device(), device.properties, BENCHMARK_PATH};
+            std::tie(pipelineCount, coldMs) = createPipelines(coldCache.getHandle());
+            saved = coldCache.save();
+        }
+        if (saved) {
+            // 热启动: 经过与引擎启动相同的校验从文件加载
+            GolaPipelineCache warmCache{device.device(), device.properties, BENCHMARK_PATH};
+            loadedSize = warmCache.getLoadedSize();
+            warmMs = createPipelines(warmCache.getHandle()).second;
+        }
+        std::error_code ignored;
+        std::filesystem::remove(BENCHMARK_PATH, ignored);
+        vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+
+        std::print("[DEBUG] Pipeline cache benchmark ({} pipelines)\n", pipelineCount);
+        std::print("[DEBUG]   cold (empty cache): {:.2f} ms\n", coldMs);
+        if (!saved) {
+            std::print("[DEBUG]   warm: skipped, the cache could not be saved\n");
+            return;
+        }
+        std::print("[DEBUG]   warm ({} bytes loaded): {:.2f} ms, {:.1f}x faster\n", loadedSize, warmMs,
+                   warmMs > 0.0f ? coldMs / warmMs : 0.0f);
+        std::print("[DEBUG]   (the driver's own shader cache can already make the cold run fast)\n");
+    }
+}
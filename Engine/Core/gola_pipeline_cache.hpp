@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gola {
+    class GolaDevice;
+    struct GolaRenderTarget;
+
+    /*
+     * 整个引擎共用的 VkPipelineCache, 启动时从磁盘加载, 退出时写回.
+     * 文件以 FileHeader 开头, 记录写入它的设备和驱动 (vendorID, deviceID, driverVersion, pipelineCacheUUID)
+     * 以及数据的长度和校验和; 任何一项不匹配都丢弃文件, 从空缓存开始, 不把可能损坏的数据交给驱动.
+     */
+    class GolaPipelineCache {
+    public:
+        // Loads path when it was written by the same device and driver, otherwise starts empty.
+        GolaPipelineCache(VkDevice device, const VkPhysicalDeviceProperties &properties, std::string path);
+
+        // 只销毁缓存, 不会保存
+        ~GolaPipelineCache();
+
+        GolaPipelineCache(const GolaPipelineCache &) = delete;
+
+        GolaPipelineCache &operator=(const GolaPipelineCache &) = delete;
+
+        VkPipelineCache getHandle() const { return pipelineCache; }
+
+        // 启动时加载的驱动数据大小, 0 表示冷启动
+        size_t getLoadedSize() const { return loadedSize; }
+
+        // Writes the cache to a temporary file next to the path and renames it over the old file, so a crash
+        // while saving never leaves a truncated cache behind. Returns false (and keeps the old file) on failure.
+        bool save() const;
+
+        // Creates a set of pipeline variants with an empty cache and again with a cache loaded from the saved
+        // file, and prints both times (the driver's own shader cache may still make the cold run faster).
+        static void runBenchmark(GolaDevice &device, const GolaRenderTarget &renderTarget);
+
+    private:
+        static constexpr uint32_t FILE_MAGIC = 0x43504C47; // "GLPC"
+        static constexpr uint32_t FILE_VERSION = 1;
+
+        struct FileHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t vendorID;
+            uint32_t deviceID;
+            uint32_t driverVersion;
+            uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+            uint64_t dataSize;
+            uint64_t checksum;
+        };
+
+        // 校验文件头和驱动数据头, 不匹配时返回原因, 匹配时返回空字符串
+        std::string validate(const std::vector<char> &file) const;
+
+        VkDevice device;
+        VkPhysicalDeviceProperties properties;
+        std::string path;
+        VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+        size_t loadedSize = 0;
+    };
+}
@@ -0,0 +1,257 @@
+#include "gola_pipeline_compiler.hpp"
+
+#include "gola_pipeline_registry.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <exception>
+#include <print>
+#include <stdexcept>
+
+namespace gola {
+    GolaPipelineCompiler::GolaPipelineCompiler(GolaDevice &device)
+        : golaDevice{device},
+          jobSystem{GolaJobSystem::get()},
+          useWorkers{jobSystem.getThreadCount() > 1},
+          maxConcurrentJobs{std::max(1u, (jobSystem.getThreadCount() - 1) / 2)} {
+    }
+
+    GolaPipelineCompiler::~GolaPipelineCompiler() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+            for (auto &state: queue) {
+                state->error = "pipeline compiler was destroyed";
+                state->status.store(GolaPipelineStatus::Failed, std::memory_order_release);
+                failedCount.fetch_add(1, std::memory_order_relaxed);
+                pendingCount.fetch_sub(1, std::memory_order_relaxed);
+            }
+            queue.clear();
+        }
+        jobSystem.wait(jobCounter);
+
+        if (benchmark) {
+            benchmark->handles.clear();
+            vkDestroyPipelineLayout(golaDevice.device(), benchmark->pipelineLayout, nullptr);
+        }
+    }
+
+    GolaPipelineHandle GolaPipelineCompiler::request(std::string vertexShaderPath, std::string fragmentShaderPath,
+                                                     ConfigureFunction configure) {
+        auto state = std::make_shared<GolaPipelineHandle::State>();
+        state->vertexShaderPath = std::move(vertexShaderPath);
+        state->fragmentShaderPath = std::move(fragmentShaderPath);
+        state->configure = std::move(configure);
+        pendingCount.fetch_add(1, std::memory_order_relaxed);
+
+        bool startJob = false;
+        {
+            std::lock_guard lock(mutex);
+            assert(!stopping && "Pipeline requested while the compiler is being destroyed");
+            queue.push_back(state);
+            // 正在运行的任务会在编译完成后继续取队列中的请求
+            if (useWorkers && activeJobs < maxConcurrentJobs) {
+                activeJobs++;
+                startJob = true;
+            }
+        }
+        if (startJob) {
+            jobSystem.runOnWorker([this] { compileNext(); }, &jobCounter);
+        }
+        return GolaPipelineHandle{std::move(state)};
+    }
+
+    void GolaPipelineCompiler::compileNext() {
+        compileQueued();
+        {
+            std::lock_guard lock(mutex);
+            if (queue.empty()) {
+                activeJobs--;
+                return;
+            }
+        }
+        jobSystem.runOnWorker([this] { compileNext(); }, &jobCounter);
+    }
+
+    bool GolaPipelineCompiler::compileQueued() {
+        StatePointer state;
+        {
+            std::lock_guard lock(mutex);
+            if (queue.empty()) {
+                return false;
+            }
+            state = std::move(queue.front());
+            queue.pop_front();
+        }
+        compile(*state);
+        // 句柄已经全部释放时管线在这里销毁
+        state.reset();
+        return true;
+    }
+
+    void GolaPipelineCompiler::compile(GolaPipelineHandle::State &state) {
+        const auto startTime = std::chrono::high_resolution_clock::now();
+        try {
+            PipelineConfigInfo configInfo{};
+            GolaPipeline::defaultPipelineConfigInfo(configInfo);
+            if (state.configure) {
+                state.configure(configInfo);
+            }
+            state.pipeline = golaDevice.getPipelineRegistry().getGraphicsPipeline(
+                state.vertexShaderPath, state.fragmentShaderPath, configInfo);
+            compiledCount.fetch_add(1, std::memory_order_relaxed);
+            state.status.store(GolaPipelineStatus::Ready, std::memory_order_release);
+        } catch (const std::exception &e) {
+            // 异常不能离开任务, 记录在句柄中由使用方决定如何回退
+            std::print("[DEBUG] Failed to compile pipeline {} + {}: {}\n", state.vertexShaderPath,
+                       state.fragmentShaderPath, e.what());
+            state.error = e.what();
+            failedCount.fetch_add(1, std::memory_order_relaxed);
+            state.status.store(GolaPipelineStatus::Failed, std::memory_order_release);
+        }
+        compileMicroseconds.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - startTime).count(), std::memory_order_relaxed);
+        pendingCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void GolaPipelineCompiler::waitIdle() {
+        if (!useWorkers) {
+            while (compileQueued()) {
+            }
+            return;
+        }
+        // 队列不为空时至少有一个任务在计数中, 计数归零说明所有请求都已处理
+        jobSystem.wait(jobCounter);
+    }
+
+    void GolaPipelineCompiler::endFrame(float frameTime) {
+        if (!useWorkers) {
+            compileQueued();
+        }
+        if (frameTime > HITCH_FRAME_TIME) {
+            hitchFrames++;
+        }
+        if (fallbackFrameRecorded) {
+            fallbackFrames++;
+            fallbackFrameRecorded = false;
+        }
+
+        if (!benchmark) {
+            return;
+        }
+        benchmark->frameCount++;
+        benchmark->elapsedTime += frameTime;
+        benchmark->maxFrameTime = std::max(benchmark->maxFrameTime, frameTime);
+        if (frameTime > HITCH_FRAME_TIME) {
+            benchmark->hitchFrames++;
+        }
+        const bool done = std::none_of(benchmark->handles.begin(), benchmark->handles.end(), [](auto &handle) {
+            return handle.getStatus() == GolaPipelineStatus::Pending;
+        });
+        if (done) {
+            finishBenchmark();
+        }
+    }
+
+    GolaPipelineCompilerStats GolaPipelineCompiler::getStats() const {
+        GolaPipelineCompilerStats stats{};
+        stats.pendingCount = pendingCount.load(std::memory_order_relaxed);
+        stats.compiledCount = compiledCount.load(std::memory_order_relaxed);
+        stats.failedCount = failedCount.load(std::memory_order_relaxed);
+        stats.compileMs = static_cast<float>(compileMicroseconds.load(std::memory_order_relaxed)) / 1000.0f;
+        stats.fallbackFrames = fallbackFrames;
+        stats.hitchFrames = hitchFrames;
+        return stats;
+    }
+
+    void GolaPipelineCompiler::startBenchmark(const GolaRenderTarget &renderTarget) {
+        if (benchmark) {
+            std::print("[DEBUG] Async pipeline benchmark is already running\n");
+            return;
+        }
+        benchmark = std::make_unique<Benchmark>();
+        benchmark->startCompileMicroseconds = compileMicroseconds.load(std::memory_order_relaxed);
+
+        // 与 simple shader 兼容的 layout, push constant 使用规范保证的最小上限
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = 128;
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(golaDevice.device(), &pipelineLayoutInfo, nullptr, &benchmark->pipelineLayout) !=
+            VK_SUCCESS) {
+            benchmark.reset();
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+
+        // 每个下标对应一种渲染状态组合, depth bias 保证 500 个变体互不相同
+        static constexpr VkCullModeFlags CULL_MODES[] = {
+            VK_CULL_MODE_NONE, VK_CULL_MODE_BACK_BIT, VK_CULL_MODE_FRONT_BIT};
+        static constexpr VkCompareOp DEPTH_COMPARE_OPS[] = {
+            VK_COMPARE_OP_LESS, VK_COMPARE_OP_LESS_OR_EQUAL, VK_COMPARE_OP_GREATER, VK_COMPARE_OP_ALWAYS};
+        static constexpr VkPrimitiveTopology TOPOLOGIES[] = {
+            VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP, VK_PRIMITIVE_TOPOLOGY_LINE_LIST};
+
+        const VkPipelineLayout pipelineLayout = benchmark->pipelineLayout;
+        benchmark->handles.reserve(BENCHMARK_PIPELINE_COUNT);
+        for (uint32_t i = 0; i < BENCHMARK_PIPELINE_COUNT; i++) {
+            benchmark->handles.push_back(request(
+                GOLA_SHADER_DIR "/simple_shader.vert.spv",
+                GOLA_SHADER_DIR "/simple_shader.frag.spv",
+                [=](PipelineConfigInfo &configInfo) {
+                    configInfo.rasterizationInfo.cullMode = CULL_MODES[i % 3];
+                    configInfo.depthStencilInfo.depthCompareOp = DEPTH_COMPARE_OPS[i / 3 % 4];
+                    configInfo.inputAssemblyInfo.topology = TOPOLOGIES[i / 12 % 3];
+                    if (i / 36 % 2 == 1) {
+                        configInfo.colorBlendAttachment.blendEnable = VK_TRUE;
+                        configInfo.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+                        configInfo.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+                        configInfo.colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+                        configInfo.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+                        configInfo.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+                        configInfo.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+                    }
+                    configInfo.rasterizationInfo.depthBiasEnable = VK_TRUE;
+                    configInfo.rasterizationInfo.depthBiasConstantFactor = static_cast<float>(i / 72);
+                    renderTarget.apply(configInfo);
+                    configInfo.pipelineLayout = pipelineLayout;
+                }));
+        }
+        if (useWorkers) {
+            std::print("[DEBUG] Async pipeline benchmark: requested {} pipelines on {} compile jobs\n",
+                       BENCHMARK_PIPELINE_COUNT, maxConcurrentJobs);
+        } else {
+            std::print("[DEBUG] Async pipeline benchmark: requested {} pipelines, no worker threads, "
+                       "compiling one per frame\n", BENCHMARK_PIPELINE_COUNT);
+        }
+    }
+
+    void GolaPipelineCompiler::finishBenchmark() {
+        const auto failed = static_cast<uint32_t>(std::count_if(
+            benchmark->handles.begin(), benchmark->handles.end(), [](auto &handle) {
+                return handle.getStatus() == GolaPipelineStatus::Failed;
+            }));
+        const float compileMs = static_cast<float>(
+            compileMicroseconds.load(std::memory_order_relaxed) - benchmark->startCompileMicroseconds) / 1000.0f;
+        const float averageMs = benchmark->elapsedTime * 1000.0f / static_cast<float>(benchmark->frameCount);
+
+        std::print("[DEBUG] Async pipeline benchmark ({} pipelines, {} failed)\n", benchmark->handles.size(), failed);
+        std::print("[DEBUG]   loaded in {:.1f} ms over {} frames\n", benchmark->elapsedTime * 1000.0f,
+                   benchmark->frameCount);
+        std::print("[DEBUG]   frame time: {:.2f} ms average, {:.2f} ms max, {} frames over {:.1f} ms: {}\n",
+                   averageMs, benchmark->maxFrameTime * 1000.0f, benchmark->hitchFrames, HITCH_FRAME_TIME * 1000.0f,
+                   benchmark->hitchFrames == 0 ? "PASS" : "FAIL");
+        std::print("[DEBUG]   synchronous compilation would have blocked the main thread for {:.1f} ms\n", compileMs);
+
+        // 这些管线从未被录制, 可以立即销毁
+        benchmark->handles.clear();
+        vkDestroyPipelineLayout(golaDevice.device(), benchmark->pipelineLayout, nullptr);
+        benchmark.reset();
+    }
+}
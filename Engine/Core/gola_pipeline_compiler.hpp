@@ -0,0 +1,169 @@
+#pragma once
+
+#include "gola_device.hpp"
+#include "gola_job_system.hpp"
+#include "gola_pipeline.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace gola {
+    enum class GolaPipelineStatus {
+        Pending,
+        Ready,
+        Failed,
+    };
+
+    // 后台编译的管线, 编译完成之前 get() 返回 nullptr, 调用方需要跳过绘制或使用回退管线.
+    // 相同状态的请求共享同一个管线 (GolaPipelineRegistry), 最后一个引用释放时销毁, 需要保证 GPU 已经不再使用它.
+    class GolaPipelineHandle {
+    public:
+        GolaPipelineHandle() = default;
+
+        bool isValid() const { return state != nullptr; }
+
+        GolaPipelineStatus getStatus() const { return state->status.load(std::memory_order_acquire); }
+
+        bool isReady() const { return state && getStatus() == GolaPipelineStatus::Ready; }
+
+        GolaPipeline *get() const { return isReady() ? state->pipeline.get() : nullptr; }
+
+        // 只在 Failed 时有效
+        const std::string &getError() const { return state->error; }
+
+    private:
+        friend class GolaPipelineCompiler;
+
+        struct State {
+            std::string vertexShaderPath;
+            std::string fragmentShaderPath;
+            std::function<void(PipelineConfigInfo &)> configure;
+            // 编译线程写入后以 release 发布 status, 之后只读
+            std::shared_ptr<GolaPipeline> pipeline;
+            std::string error;
+            std::atomic<GolaPipelineStatus> status{GolaPipelineStatus::Pending};
+        };
+
+        explicit GolaPipelineHandle(std::shared_ptr<State> state) : state{std::move(state)} {
+        }
+
+        std::shared_ptr<State> state;
+    };
+
+    struct GolaPipelineCompilerStats {
+        uint32_t pendingCount = 0;
+        uint32_t compiledCount = 0;
+        uint32_t failedCount = 0;
+        // 编译线程上的累计耗时, 即同步编译时主线程会被阻塞的时间
+        float compileMs = 0.0f;
+        // 因为管线还没编译完而使用回退管线的帧, 以及超过 HITCH_FRAME_TIME 的帧
+        uint32_t fallbackFrames = 0;
+        uint32_t hitchFrames = 0;
+    };
+
+    /*
+     * 在任务系统的工作线程上编译图形管线, 通过设备的 GolaPipelineRegistry 创建, 已经存在的相同管线直接复用,
+     * 所有编译共用设备的 VkPipelineCache (缓存本身是线程安全的).
+     * 请求按提交顺序排队, 同时最多 maxConcurrentJobs 个编译任务, 给每帧的 parallelFor 留出工作线程.
+     * 每个任务只编译一个管线, 通过 GolaJobSystem::runOnWorker 提交, 主线程在 wait() 中不会执行到编译任务.
+     * 没有工作线程时 (单核机器) 改为每帧在 endFrame() 中编译一个.
+     */
+    class GolaPipelineCompiler {
+    public:
+        using ConfigureFunction = std::function<void(PipelineConfigInfo &)>;
+
+        // 60 Hz 的目标帧时间, 超过它 1.5 倍 (错过一次垂直同步) 的帧记为卡顿
+        static constexpr float TARGET_FRAME_TIME = 1.0f / 60.0f;
+        static constexpr float HITCH_FRAME_TIME = TARGET_FRAME_TIME * 1.5f;
+        static constexpr uint32_t BENCHMARK_PIPELINE_COUNT = 500;
+
+        explicit GolaPipelineCompiler(GolaDevice &device);
+
+        // 丢弃还没开始的请求 (状态为 Failed), 并等待正在编译的管线
+        ~GolaPipelineCompiler();
+
+        GolaPipelineCompiler(const GolaPipelineCompiler &) = delete;
+
+        GolaPipelineCompiler &operator=(const GolaPipelineCompiler &) = delete;
+
+        // Queues a graphics pipeline. configure runs on a worker thread after GolaPipeline::defaultPipelineConfigInfo
+        // and must only fill the config from values it captured by copy; the layout and render pass it references
+        // must stay alive until the handle is no longer pending (see waitIdle()).
+        GolaPipelineHandle request(std::string vertexShaderPath, std::string fragmentShaderPath,
+                                   ConfigureFunction configure);
+
+        // Blocks until every queued request has been compiled. Called before destroying layouts or render
+        // passes that pending requests reference.
+        void waitIdle();
+
+        // 本帧因为管线未就绪而使用了回退管线
+        void recordFallback() { fallbackFrameRecorded = true; }
+
+        // Called once per frame on the main thread with the previous frame's duration. Counts hitches and
+        // fallback frames, and finishes a running benchmark once all of its pipelines are compiled.
+        // Without worker threads this is where queued pipelines are compiled, one per frame.
+        void endFrame(float frameTime);
+
+        GolaPipelineCompilerStats getStats() const;
+
+        // Requests BENCHMARK_PIPELINE_COUNT pipeline variants for renderTarget while the app keeps rendering.
+        // When all are compiled, prints the frame times during loading against HITCH_FRAME_TIME and the
+        // compile time a synchronous load would have blocked the main thread for.
+        void startBenchmark(const GolaRenderTarget &renderTarget);
+
+    private:
+        using StatePointer = std::shared_ptr<GolaPipelineHandle::State>;
+
+        // 从队列取出一个请求并编译, 队列不为空时提交下一个任务
+        void compileNext();
+
+        // 在调用线程上编译队列中的下一个请求, 队列为空时返回 false
+        bool compileQueued();
+
+        void compile(GolaPipelineHandle::State &state);
+
+        void finishBenchmark();
+
+        GolaDevice &golaDevice;
+        GolaJobSystem &jobSystem;
+        // 为 false 时任务系统没有工作线程, 请求只在 endFrame() 和 waitIdle() 中编译
+        bool useWorkers;
+        uint32_t maxConcurrentJobs;
+
+        // 保护 queue 和 activeJobs
+        std::mutex mutex;
+        std::deque<StatePointer> queue;
+        uint32_t activeJobs = 0;
+        bool stopping = false;
+        GolaJobCounter jobCounter;
+
+        std::atomic<uint32_t> pendingCount{0};
+        std::atomic<uint32_t> compiledCount{0};
+        std::atomic<uint32_t> failedCount{0};
+        // 微秒, 由各个编译线程累加
+        std::atomic<uint64_t> compileMicroseconds{0};
+        uint32_t fallbackFrames = 0;
+        uint32_t hitchFrames = 0;
+        bool fallbackFrameRecorded = false;
+
+        struct Benchmark {
+            VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+            std::vector<GolaPipelineHandle> handles;
+            uint64_t startCompileMicroseconds = 0;
+            float elapsedTime = 0.0f;
+            float maxFrameTime = 0.0f;
+            uint32_t frameCount = 0;
+            uint32_t hitchFrames = 0;
+        };
+        std::unique_ptr<Benchmark> benchmark;
+    };
+}
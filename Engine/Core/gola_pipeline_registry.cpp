@@ -0,0 +1,276 @@
+#include "gola_pipeline_registry.hpp"
+
+#include "gola_device.hpp"
+#include "gola_pipeline.hpp"
+
+// std
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace gola {
+    // FNV-1a, 对同样的内容在每次运行中都得到同样的值
+    static uint64_t hashBytes(const void *data, size_t size) {
+        const auto *bytes = static_cast<const uint8_t *>(data);
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // 只用于没有填充字节和指针的 Vulkan 结构体和标量
+    template<typename T>
+    static void appendKey(std::vector<uint8_t> &key, const T &value) {
+        static_assert(std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>);
+        const auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+        key.insert(key.end(), bytes, bytes + sizeof(T));
+    }
+
+    template<typename T>
+    static void appendKey(std::vector<uint8_t> &key, const T *values, uint32_t count) {
+        appendKey(key, count);
+        for (uint32_t i = 0; values != nullptr && i < count; i++) {
+            appendKey(key, values[i]);
+        }
+    }
+
+    // 句柄在 32 位平台上是整数, 在 64 位平台上是指针
+    template<typename Handle>
+    static uint64_t handleBits(Handle handle) {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &handle, sizeof(Handle));
+        return bits;
+    }
+
+    GolaShaderModule::GolaShaderModule(VkDevice device, const std::vector<char> &code)
+        : device{device}, codeHash{hashBytes(code.data(), code.size())} {
+        VkShaderModuleCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        createInfo.codeSize = code.size();
+        createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+        if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create shader module");
+        }
+    }
+
+    GolaShaderModule::~GolaShaderModule() {
+        vkDestroyShaderModule(device, shaderModule, nullptr);
+    }
+
+    GolaPipelineRegistry::GolaPipelineRegistry(GolaDevice &device) : golaDevice{device} {
+    }
+
+    std::shared_ptr<GolaShaderModule> GolaPipelineRegistry::getShaderModule(const std::string &path) {
+        std::lock_guard lock(mutex);
+        std::weak_ptr<GolaShaderModule> &entry = shaderModules[path];
+        if (auto shaderModule = entry.lock()) {
+            shaderModuleHits.fetch_add(1, std::memory_order_relaxed);
+            return shaderModule;
+        }
+        // 读取和创建都很快, 在锁内进行, 避免同一个文件被加载两次
+        shaderModuleMisses.fetch_add(1, std::memory_order_relaxed);
+        auto shaderModule = std::make_shared<GolaShaderModule>(golaDevice.device(), GolaPipeline::readFile(path));
+        entry = shaderModule;
+        return shaderModule;
+    }
+
+    // 按 Vulkan 的 render pass 兼容性规则: 只比较每个引用指向的 attachment 的格式和采样数, 不比较 load/store 操作和布局
+    static void appendAttachmentReferences(std::vector<uint8_t> &key, const VkRenderPassCreateInfo &createInfo,
+                                           const VkAttachmentReference *references, uint32_t count) {
+        appendKey(key, references != nullptr ? count : 0u);
+        for (uint32_t i = 0; references != nullptr && i < count; i++) {
+            const uint32_t attachment = references[i].attachment;
+            if (attachment == VK_ATTACHMENT_UNUSED) {
+                appendKey(key, VK_FORMAT_UNDEFINED);
+                appendKey(key, VkSampleCountFlagBits{});
+            } else {
+                appendKey(key, createInfo.pAttachments[attachment].format);
+                appendKey(key, createInfo.pAttachments[attachment].samples);
+            }
+        }
+    }
+
+    static std::vector<uint8_t> makeRenderPassKey(const VkRenderPassCreateInfo &createInfo) {
+        std::vector<uint8_t> key;
+        appendKey(key, createInfo.subpassCount);
+        for (uint32_t i = 0; i < createInfo.subpassCount; i++) {
+            const VkSubpassDescription &subpass = createInfo.pSubpasses[i];
+            appendAttachmentReferences(key, createInfo, subpass.pInputAttachments, subpass.inputAttachmentCount);
+            appendAttachmentReferences(key, createInfo, subpass.pColorAttachments, subpass.colorAttachmentCount);
+            appendAttachmentReferences(key, createInfo, subpass.pResolveAttachments, subpass.colorAttachmentCount);
+            appendAttachmentReferences(key, createInfo, subpass.pDepthStencilAttachment, 1);
+        }
+        return key;
+    }
+
+    void GolaPipelineRegistry::registerRenderPass(VkRenderPass renderPass, const VkRenderPassCreateInfo &createInfo) {
+        std::vector<uint8_t> key = makeRenderPassKey(createInfo);
+        std::lock_guard lock(mutex);
+        renderPasses[handleBits(renderPass)] = std::move(key);
+    }
+
+    void GolaPipelineRegistry::unregisterRenderPass(VkRenderPass renderPass) {
+        std::lock_guard lock(mutex);
+        renderPasses.erase(handleBits(renderPass));
+    }
+
+    static void appendSpecializationKey(std::vector<uint8_t> &key, const GolaSpecializationConstants &constants) {
+        const auto &entries = constants.getEntries();
+        const auto &data = constants.getData();
+        appendKey(key, entries.data(), static_cast<uint32_t>(entries.size()));
+        appendKey(key, data.data(), static_cast<uint32_t>(data.size()));
+    }
+
+    std::vector<uint8_t> GolaPipelineRegistry::makePipelineKey(const GolaShaderModule &vertexShader,
+                                                               const GolaShaderModule &fragmentShader,
+                                                               const PipelineConfigInfo &configInfo) {
+        std::vector<uint8_t> key;
+        key.reserve(512);
+        appendKey(key, vertexShader.getCodeHash());
+        appendKey(key, fragmentShader.getCodeHash());
+        // 特化常量不同的管线是不同的编译结果
+        appendSpecializationKey(key, configInfo.vertexSpecialization);
+        appendSpecializationKey(key, configInfo.fragmentSpecialization);
+
+        appendKey(key, configInfo.bindingDescriptions.data(),
+                  static_cast<uint32_t>(configInfo.bindingDescriptions.size()));
+        appendKey(key, configInfo.attributeDescriptions.data(),
+                  static_cast<uint32_t>(configInfo.attributeDescriptions.size()));
+
+        const auto &inputAssembly = configInfo.inputAssemblyInfo;
+        appendKey(key, inputAssembly.topology);
+        appendKey(key, inputAssembly.primitiveRestartEnable);
+
+        const auto &viewport = configInfo.viewportInfo;
+        appendKey(key, viewport.pViewports, viewport.viewportCount);
+        appendKey(key, viewport.pScissors, viewport.scissorCount);
+
+        const auto &rasterization = configInfo.rasterizationInfo;
+        appendKey(key, rasterization.depthClampEnable);
+        appendKey(key, rasterization.rasterizerDiscardEnable);
+        appendKey(key, rasterization.polygonMode);
+        appendKey(key, rasterization.cullMode);
+        appendKey(key, rasterization.frontFace);
+        appendKey(key, rasterization.depthBiasEnable);
+        appendKey(key, rasterization.depthBiasConstantFactor);
+        appendKey(key, rasterization.depthBiasClamp);
+        appendKey(key, rasterization.depthBiasSlopeFactor);
+        appendKey(key, rasterization.lineWidth);
+
+        const auto &multisample = configInfo.multisampleInfo;
+        appendKey(key, multisample.rasterizationSamples);
+        appendKey(key, multisample.sampleShadingEnable);
+        appendKey(key, multisample.minSampleShading);
+        appendKey(key, multisample.pSampleMask, (static_cast<uint32_t>(multisample.rasterizationSamples) + 31) / 32);
+        appendKey(key, multisample.alphaToCoverageEnable);
+        appendKey(key, multisample.alphaToOneEnable);
+
+        const auto &depthStencil = configInfo.depthStencilInfo;
+        appendKey(key, depthStencil.depthTestEnable);
+        appendKey(key, depthStencil.depthWriteEnable);
+        appendKey(key, depthStencil.depthCompareOp);
+        appendKey(key, depthStencil.depthBoundsTestEnable);
+        appendKey(key, depthStencil.stencilTestEnable);
+        appendKey(key, depthStencil.front);
+        appendKey(key, depthStencil.back);
+        appendKey(key, depthStencil.minDepthBounds);
+        appendKey(key, depthStencil.maxDepthBounds);
+
+        const auto &colorBlend = configInfo.colorBlendInfo;
+        appendKey(key, colorBlend.logicOpEnable);
+        appendKey(key, colorBlend.logicOp);
+        appendKey(key, colorBlend.pAttachments, colorBlend.attachmentCount);
+        appendKey(key, colorBlend.blendConstants);
+
+        const auto &dynamicState = configInfo.dynamicStateInfo;
+        appendKey(key, dynamicState.pDynamicStates, dynamicState.dynamicStateCount);
+
+        appendKey(key, handleBits(configInfo.pipelineLayout));
+        // 兼容的 render pass 可以共用同一个管线; 没有注册的 render pass 只能按句柄区分
+        const bool hasRenderPass = configInfo.renderPass != VK_NULL_HANDLE;
+        appendKey(key, hasRenderPass);
+        if (hasRenderPass) {
+            std::lock_guard lock(mutex);
+            auto it = renderPasses.find(handleBits(configInfo.renderPass));
+            const bool registered = it != renderPasses.end();
+            appendKey(key, registered);
+            if (registered) {
+                key.insert(key.end(), it->second.begin(), it->second.end());
+            } else {
+                appendKey(key, handleBits(configInfo.renderPass));
+            }
+        }
+        appendKey(key, configInfo.subpass);
+        appendKey(key, configInfo.colorAttachmentFormats.data(),
+                  static_cast<uint32_t>(configInfo.colorAttachmentFormats.size()));
+        appendKey(key, configInfo.depthAttachmentFormat);
+        return key;
+    }
+
+    std::shared_ptr<GolaPipeline> GolaPipelineRegistry::getGraphicsPipeline(const std::string &vertexShaderPath,
+                                                                            const std::string &fragmentShaderPath,
+                                                                            const PipelineConfigInfo &configInfo) {
+        auto vertexShader = getShaderModule(vertexShaderPath);
+        auto fragmentShader = getShaderModule(fragmentShaderPath);
+        std::vector<uint8_t> key = makePipelineKey(*vertexShader, *fragmentShader, configInfo);
+        const uint64_t hash = hashBytes(key.data(), key.size());
+
+        std::shared_ptr<PipelineEntry> entry;
+        {
+            std::lock_guard lock(mutex);
+            std::shared_ptr<PipelineEntry> &slot = pipelines[hash];
+            if (!slot) {
+                slot = std::make_shared<PipelineEntry>();
+                slot->key = key;
+            }
+            entry = slot;
+        }
+
+        std::lock_guard entryLock(entry->mutex);
+        if (entry->key != key) {
+            // 64 位哈希冲突: 键不同的管线不能共享, 单独创建且不登记
+            pipelineMisses.fetch_add(1, std::memory_order_relaxed);
+            return std::make_shared<GolaPipeline>(golaDevice, std::move(vertexShader), std::move(fragmentShader),
+                                                  configInfo);
+        }
+        if (auto pipeline = entry->pipeline.lock()) {
+            pipelineHits.fetch_add(1, std::memory_order_relaxed);
+            return pipeline;
+        }
+        pipelineMisses.fetch_add(1, std::memory_order_relaxed);
+        auto pipeline = std::make_shared<GolaPipeline>(golaDevice, std::move(vertexShader),
+                                                       std::move(fragmentShader), configInfo);
+        entry->pipeline = pipeline;
+        return pipeline;
+    }
+
+    GolaPipelineRegistryStats GolaPipelineRegistry::getStats() {
+        GolaPipelineRegistryStats stats{};
+        stats.pipelineHits = pipelineHits.load(std::memory_order_relaxed);
+        stats.pipelineMisses = pipelineMisses.load(std::memory_order_relaxed);
+        stats.shaderModuleHits = shaderModuleHits.load(std::memory_order_relaxed);
+        stats.shaderModuleMisses = shaderModuleMisses.load(std::memory_order_relaxed);
+
+        std::lock_guard lock(mutex);
+        // 顺便清理已经没有引用的条目; 正在创建的条目由调用方持有, 不会被清理
+        for (auto it = shaderModules.begin(); it != shaderModules.end();) {
+            if (it->second.expired()) {
+                it = shaderModules.erase(it);
+            } else {
+                stats.shaderModuleCount++;
+                ++it;
+            }
+        }
+        for (auto it = pipelines.begin(); it != pipelines.end();) {
+            if (it->second.use_count() == 1 && it->second->pipeline.expired()) {
+                it = pipelines.erase(it);
+            } else {
+                stats.pipelineCount++;
+                ++it;
+            }
+        }
+        return stats;
+    }
+}
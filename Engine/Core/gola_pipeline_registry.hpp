@@ -0,0 +1,111 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gola {
+    class GolaDevice;
+    class GolaPipeline;
+    struct PipelineConfigInfo;
+
+    // 从 SPIR-V 文件创建的 shader module, 由使用它的管线共享, 最后一个引用释放时销毁.
+    // 管线创建完成后就不再需要 module, 因此销毁时不用等待 GPU.
+    class GolaShaderModule {
+    public:
+        GolaShaderModule(VkDevice device, const std::vector<char> &code);
+
+        ~GolaShaderModule();
+
+        GolaShaderModule(const GolaShaderModule &) = delete;
+
+        GolaShaderModule &operator=(const GolaShaderModule &) = delete;
+
+        VkShaderModule getHandle() const { return shaderModule; }
+
+        // SPIR-V 内容的哈希, 作为管线键中 shader 的身份
+        uint64_t getCodeHash() const { return codeHash; }
+
+    private:
+        VkDevice device;
+        VkShaderModule shaderModule = VK_NULL_HANDLE;
+        uint64_t codeHash;
+    };
+
+    struct GolaPipelineRegistryStats {
+        uint64_t pipelineHits = 0;
+        uint64_t pipelineMisses = 0;
+        uint64_t shaderModuleHits = 0;
+        uint64_t shaderModuleMisses = 0;
+        // 当前还有引用的管线和 shader module
+        uint32_t pipelineCount = 0;
+        uint32_t shaderModuleCount = 0;
+    };
+
+    /*
+     * 设备级的管线注册表: 图形管线按状态键去重, shader module 按路径去重. 两者都只保存 weak_ptr,
+     * 对象的生命周期由使用方的 shared_ptr 决定. 状态键是 PipelineConfigInfo 中所有影响编译结果的字段
+     * (不含指针本身) 和特化常量, 加上两个 shader 的内容哈希, pipeline layout, render pass 的兼容性数据, subpass 和动态渲染的
+     * attachment 格式; 以键的 64 位哈希查找,
+     * 再比较完整的键, 哈希冲突时直接创建不共享的管线. 所有函数都可以在任意线程调用.
+     */
+    class GolaPipelineRegistry {
+    public:
+        explicit GolaPipelineRegistry(GolaDevice &device);
+
+        GolaPipelineRegistry(const GolaPipelineRegistry &) = delete;
+
+        GolaPipelineRegistry &operator=(const GolaPipelineRegistry &) = delete;
+
+        // 已经加载的 module 直接返回, 否则读取 SPIR-V 文件并创建
+        std::shared_ptr<GolaShaderModule> getShaderModule(const std::string &path);
+
+        // Returns the pipeline with the same shaders and state if one is still alive, otherwise creates it.
+        // Identical requests from several threads compile the pipeline once; the others wait for it.
+        std::shared_ptr<GolaPipeline> getGraphicsPipeline(const std::string &vertexShaderPath,
+                                                          const std::string &fragmentShaderPath,
+                                                          const PipelineConfigInfo &configInfo);
+
+        // Records the compatibility data of renderPass (attachment formats and sample counts, subpass references),
+        // which pipeline keys use instead of the handle: the driver may hand a destroyed render pass's handle to an
+        // incompatible one. Call right after vkCreateRenderPass and unregisterRenderPass before destroying it.
+        void registerRenderPass(VkRenderPass renderPass, const VkRenderPassCreateInfo &createInfo);
+
+        void unregisterRenderPass(VkRenderPass renderPass);
+
+        GolaPipelineRegistryStats getStats();
+
+    private:
+        struct PipelineEntry {
+            // 创建期间持有, 同一个键的其他请求在这里等待
+            std::mutex mutex;
+            std::vector<uint8_t> key;
+            std::weak_ptr<GolaPipeline> pipeline;
+        };
+
+        std::vector<uint8_t> makePipelineKey(const GolaShaderModule &vertexShader,
+                                             const GolaShaderModule &fragmentShader,
+                                             const PipelineConfigInfo &configInfo);
+
+        GolaDevice &golaDevice;
+
+        // 保护三个表; 管线的创建在 PipelineEntry::mutex 内进行, 不阻塞其他键
+        std::mutex mutex;
+        std::unordered_map<std::string, std::weak_ptr<GolaShaderModule>> shaderModules;
+        std::unordered_map<uint64_t, std::shared_ptr<PipelineEntry>> pipelines;
+        // 按句柄的位索引的 render pass 兼容性数据
+        std::unordered_map<uint64_t, std::vector<uint8_t>> renderPasses;
+
+        std::atomic<uint64_t> pipelineHits{0};
+        std::atomic<uint64_t> pipelineMisses{0};
+        std::atomic<uint64_t> shaderModuleHits{0};
+        std::atomic<uint64_t> shaderModuleMisses{0};
+    };
+}
@@ -0,0 +1,95 @@
+#include "gola_range_allocator.hpp"
+
+#include <cassert>
+#include <iterator>
+
+namespace gola {
+    GolaRangeAllocator::GolaRangeAllocator(uint64_t capacity) {
+        reset(capacity);
+    }
+
+    void GolaRangeAllocator::reset(uint64_t newCapacity) {
+        capacity = newCapacity;
+        usedBytes = 0;
+        freeByOffset.clear();
+        freeBySize.clear();
+        if (capacity > 0) {
+            insertFreeRange(0, capacity);
+        }
+    }
+
+    uint64_t GolaRangeAllocator::allocate(uint64_t size, uint64_t alignment) {
+        assert(size > 0 && "Cannot allocate an empty range");
+        assert((alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+
+        // 从不小于 size 的最小空闲区间开始找, 第一个放得下对齐后数据的就是 best-fit
+        for (auto it = freeBySize.lower_bound(size); it != freeBySize.end(); ++it) {
+            uint64_t rangeOffset = it->second;
+            uint64_t rangeSize = it->first;
+            uint64_t alignedOffset = (rangeOffset + alignment - 1) & ~(alignment - 1);
+            uint64_t padding = alignedOffset - rangeOffset;
+            if (padding + size > rangeSize) {
+                continue;
+            }
+
+            eraseFreeRange(freeByOffset.find(rangeOffset));
+            if (padding > 0) {
+                insertFreeRange(rangeOffset, padding);
+            }
+            uint64_t tail = rangeSize - padding - size;
+            if (tail > 0) {
+                insertFreeRange(alignedOffset + size, tail);
+            }
+
+            usedBytes += size;
+            return alignedOffset;
+        }
+        return INVALID_OFFSET;
+    }
+
+    void GolaRangeAllocator::free(uint64_t offset, uint64_t size) {
+        assert(offset + size <= capacity && "Freed range is out of bounds");
+        usedBytes -= size;
+
+        // 与后一个空闲区间合并
+        auto next = freeByOffset.lower_bound(offset);
+        if (next != freeByOffset.end() && next->first == offset + size) {
+            size += next->second;
+            eraseFreeRange(next);
+        }
+
+        // 与前一个空闲区间合并
+        auto nextAfterErase = freeByOffset.lower_bound(offset);
+        if (nextAfterErase != freeByOffset.begin()) {
+            auto prev = std::prev(nextAfterErase);
+            assert(prev->first + prev->second <= offset && "Double free in GolaRangeAllocator");
+            if (prev->first + prev->second == offset) {
+                offset = prev->first;
+                size += prev->second;
+                eraseFreeRange(prev);
+            }
+        }
+
+        insertFreeRange(offset, size);
+    }
+
+    uint64_t GolaRangeAllocator::getLargestFreeRange() const {
+        return freeBySize.empty() ? 0 : freeBySize.rbegin()->first;
+    }
+
+    void GolaRangeAllocator::insertFreeRange(uint64_t offset, uint64_t size) {
+        freeByOffset.emplace(offset, size);
+        freeBySize.emplace(size, offset);
+    }
+
+    void GolaRangeAllocator::eraseFreeRange(std::map<uint64_t, uint64_t>::iterator it) {
+        auto [first, last] = freeBySize.equal_range(it->second);
+        for (auto sizeIt = first; sizeIt != last; ++sizeIt) {
+            if (sizeIt->second == it->first) {
+                freeBySize.erase(sizeIt);
+                break;
+            }
+        }
+        freeByOffset.erase(it);
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+namespace gola {
+    /*
+     * 区间分配器: 在 [0, capacity) 上做 best-fit 分配, 释放时与相邻空闲区间合并.
+     * 只管理偏移量, 不持有任何 Vulkan 对象; 显存块和几何缓冲区都基于它做子分配.
+     */
+    class GolaRangeAllocator {
+    public:
+        static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+
+        explicit GolaRangeAllocator(uint64_t capacity = 0);
+
+        // Returns the aligned offset of the new range, or INVALID_OFFSET if nothing fits.
+        // `alignment` must be a power of two.
+        uint64_t allocate(uint64_t size, uint64_t alignment = 1);
+
+        void free(uint64_t offset, uint64_t size);
+
+        void reset(uint64_t newCapacity);
+
+        uint64_t getCapacity() const { return capacity; }
+        uint64_t getUsedBytes() const { return usedBytes; }
+        uint64_t getLargestFreeRange() const;
+        size_t getFreeRangeCount() const { return freeByOffset.size(); }
+        bool isEmpty() const { return usedBytes == 0; }
+
+    private:
+        void insertFreeRange(uint64_t offset, uint64_t size);
+
+        void eraseFreeRange(std::map<uint64_t, uint64_t>::iterator it);
+
+        uint64_t capacity = 0;
+        uint64_t usedBytes = 0;
+
+        // offset -> size, 用于合并相邻区间
+        std::map<uint64_t, uint64_t> freeByOffset;
+        // size -> offset, 用于 best-fit 查找
+        std::multimap<uint64_t, uint64_t> freeBySize;
+    };
+}
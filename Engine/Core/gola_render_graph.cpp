@@ -0,0 +1,1090 @@
+#include "gola_render_graph.hpp"
+
+#include "gola_command_recorder.hpp"
+#include "gola_deletion_queue.hpp"
+#include "gola_gpu_profiler.hpp"
+#include "gola_pipeline_registry.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <numeric>
+#include <print>
+#include <stdexcept>
+
+namespace gola {
+    static constexpr VkAccessFlags WRITE_ACCESS_MASK =
+            VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT |
+            VK_ACCESS_MEMORY_WRITE_BIT;
+
+    static bool isDepthFormat(VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_D16_UNORM:
+            case VK_FORMAT_X8_D24_UNORM_PACK32:
+            case VK_FORMAT_D32_SFLOAT:
+            case VK_FORMAT_D16_UNORM_S8_UINT:
+            case VK_FORMAT_D24_UNORM_S8_UINT:
+            case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    static bool hasStencilComponent(VkFormat format) {
+        return format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT ||
+               format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+    }
+
+    // 屏障需要覆盖全部 aspect, 视图只能有一个 (采样深度时只能用 DEPTH)
+    static VkImageAspectFlags barrierAspect(VkFormat format) {
+        if (!isDepthFormat(format)) {
+            return VK_IMAGE_ASPECT_COLOR_BIT;
+        }
+        return hasStencilComponent(format)
+                   ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT
+                   : VK_IMAGE_ASPECT_DEPTH_BIT;
+    }
+
+    static VkImageAspectFlags viewAspect(VkFormat format) {
+        return isDepthFormat(format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+
+    // FNV-1a, 按 64 位字混合
+    static void hashCombine(uint64_t &hash, uint64_t value) {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    }
+
+    GolaRenderGraphResource GolaRenderGraph::PassBuilder::createImage(const char *name,
+                                                                     const GolaRenderGraphImageDesc &desc) {
+        assert(desc.format != VK_FORMAT_UNDEFINED && desc.extent.width > 0 && desc.extent.height > 0 &&
+            "Transient images need a format and an extent");
+        ResourceDecl resource{name, true, false};
+        resource.desc = desc;
+        resource.aspect = barrierAspect(desc.format);
+        return {graph.addResource(resource)};
+    }
+
+    void GolaRenderGraph::PassBuilder::addUse(const ResourceUse &use) {
+        assert(use.resource < graph.resources.size() && "Unknown render graph resource");
+        assert(use.stage != 0 && "Resource use needs a pipeline stage");
+        PassDecl &pass = graph.passes[passIndex];
+        for (const ResourceUse &other: pass.uses) {
+            assert(other.resource != use.resource && "A pass can only use a resource once");
+            (void) other;
+        }
+        assert(graph.resources[use.resource].isImage == (use.kind != UseKind::Buffer) && "Resource kind mismatch");
+        pass.uses.push_back(use);
+    }
+
+    void GolaRenderGraph::PassBuilder::writeColor(GolaRenderGraphResource image, const VkClearColorValue *clearValue) {
+        assert(graph.passes[passIndex].type == PassType::Graphics && "Attachments need a graphics pass");
+        ResourceUse use{};
+        use.resource = image.index;
+        use.kind = UseKind::ColorAttachment;
+        use.stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        use.access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | (clearValue ? 0 : VK_ACCESS_COLOR_ATTACHMENT_READ_BIT);
+        use.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        use.reads = clearValue == nullptr;
+        use.writes = true;
+        use.discards = clearValue != nullptr;
+        if (clearValue) {
+            use.clearValue.color = *clearValue;
+        }
+        addUse(use);
+    }
+
+    void GolaRenderGraph::PassBuilder::writeDepth(GolaRenderGraphResource image,
+                                                  const VkClearDepthStencilValue *clearValue) {
+        assert(graph.passes[passIndex].type == PassType::Graphics && "Attachments need a graphics pass");
+        ResourceUse use{};
+        use.resource = image.index;
+        use.kind = UseKind::DepthAttachment;
+        use.stage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        // 深度测试总会读取
+        use.access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        use.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        use.reads = clearValue == nullptr;
+        use.writes = true;
+        use.discards = clearValue != nullptr;
+        if (clearValue) {
+            use.clearValue.depthStencil = *clearValue;
+        }
+        addUse(use);
+    }
+
+    void GolaRenderGraph::PassBuilder::readImage(GolaRenderGraphResource image, VkPipelineStageFlags stage) {
+        ResourceUse use{};
+        use.resource = image.index;
+        use.kind = UseKind::SampledImage;
+        use.stage = stage;
+        use.access = VK_ACCESS_SHADER_READ_BIT;
+        use.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        use.reads = true;
+        addUse(use);
+    }
+
+    void GolaRenderGraph::PassBuilder::readBuffer(GolaRenderGraphResource buffer, VkPipelineStageFlags stage,
+                                                  VkAccessFlags access) {
+        ResourceUse use{};
+        use.resource = buffer.index;
+        use.kind = UseKind::Buffer;
+        use.stage = stage;
+        use.access = access;
+        use.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        use.reads = true;
+        addUse(use);
+    }
+
+    void GolaRenderGraph::PassBuilder::writeBuffer(GolaRenderGraphResource buffer, VkPipelineStageFlags stage,
+                                                   VkAccessFlags access) {
+        // 不知道是否覆盖了整个缓冲区, 之前的写入不会因此被剔除
+        ResourceUse use{};
+        use.resource = buffer.index;
+        use.kind = UseKind::Buffer;
+        use.stage = stage;
+        use.access = access;
+        use.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        use.writes = true;
+        addUse(use);
+    }
+
+    void GolaRenderGraph::PassBuilder::setSideEffect() {
+        graph.passes[passIndex].sideEffect = true;
+    }
+
+    void GolaRenderGraph::PassBuilder::useSecondaryCommandBuffers(bool enabled) {
+        graph.passes[passIndex].secondaryCommandBuffers = enabled;
+    }
+
+    GolaRenderGraph::GolaRenderGraph(GolaDevice &device)
+        : GolaRenderGraph{device, device.getFeatures().dynamicRendering} {
+    }
+
+    GolaRenderGraph::GolaRenderGraph(GolaDevice &device, bool dynamicRendering)
+        : golaDevice{device}, dynamicRendering{dynamicRendering} {
+        assert((!dynamicRendering || device.getFeatures().dynamicRendering) &&
+            "Dynamic rendering is not supported by the device");
+    }
+
+    GolaRenderGraph::~GolaRenderGraph() { clearCache(); }
+
+    void GolaRenderGraph::reset() {
+        resources.clear();
+        passes.clear();
+        current = nullptr;
+        frameNumber++;
+    }
+
+    uint32_t GolaRenderGraph::addResource(const ResourceDecl &resource) {
+        resources.push_back(resource);
+        return static_cast<uint32_t>(resources.size() - 1);
+    }
+
+    GolaRenderGraphResource GolaRenderGraph::importImage(const char *name, VkImage image, VkImageView view,
+                                                         const GolaRenderGraphImageDesc &desc,
+                                                         VkImageLayout initialLayout,
+                                                         VkPipelineStageFlags initialStage,
+                                                         VkImageLayout finalLayout) {
+        ResourceDecl resource{name, true, true};
+        resource.desc = desc;
+        resource.aspect = barrierAspect(desc.format);
+        resource.image = image;
+        resource.view = view;
+        resource.initialLayout = initialLayout;
+        resource.initialStage = initialStage;
+        resource.finalLayout = finalLayout;
+        return {addResource(resource)};
+    }
+
+    GolaRenderGraphResource GolaRenderGraph::importBuffer(const char *name, VkBuffer buffer) {
+        ResourceDecl resource{name, false, true};
+        resource.buffer = buffer;
+        return {addResource(resource)};
+    }
+
+    void GolaRenderGraph::markOutput(GolaRenderGraphResource resource) {
+        assert(resource.index < resources.size() && "Unknown render graph resource");
+        resources[resource.index].output = true;
+    }
+
+    void GolaRenderGraph::addPass(const char *name, PassType type, const SetupFunction &setup,
+                                  ExecuteFunction execute) {
+        passes.push_back(PassDecl{name, type, {}, false, false, std::move(execute)});
+        PassBuilder builder{*this, static_cast<uint32_t>(passes.size() - 1)};
+        setup(builder);
+        assert((type != PassType::Graphics || std::ranges::any_of(passes.back().uses, [](const ResourceUse &use) {
+                   return use.kind == UseKind::ColorAttachment || use.kind == UseKind::DepthAttachment;
+               })) && "A graphics pass must write an attachment");
+    }
+
+    uint64_t GolaRenderGraph::hashTopology() const {
+        uint64_t hash = 14695981039346656037ull;
+        hashCombine(hash, resources.size());
+        for (const ResourceDecl &resource: resources) {
+            hashCombine(hash, (resource.isImage ? 1u : 0u) | (resource.imported ? 2u : 0u) |
+                              (resource.output ? 4u : 0u));
+            hashCombine(hash, resource.desc.format);
+            hashCombine(hash, (static_cast<uint64_t>(resource.desc.extent.width) << 32) | resource.desc.extent.height);
+            hashCombine(hash, resource.desc.usage);
+            hashCombine(hash, resource.initialLayout);
+            hashCombine(hash, resource.initialStage);
+            hashCombine(hash, resource.finalLayout);
+        }
+        hashCombine(hash, passes.size());
+        for (const PassDecl &pass: passes) {
+            hashCombine(hash, static_cast<uint64_t>(pass.type) | (pass.sideEffect ? 0x100u : 0u));
+            hashCombine(hash, pass.uses.size());
+            for (const ResourceUse &use: pass.uses) {
+                hashCombine(hash, use.resource);
+                hashCombine(hash, static_cast<uint64_t>(use.kind) | (use.reads ? 0x100u : 0u) |
+                                  (use.writes ? 0x200u : 0u) | (use.discards ? 0x400u : 0u));
+                hashCombine(hash, (static_cast<uint64_t>(use.stage) << 32) | use.access);
+            }
+        }
+        return hash;
+    }
+
+    void GolaRenderGraph::compile() {
+        const uint64_t topologyHash = hashTopology();
+        if (current && current->topologyHash == topologyHash) {
+            return;
+        }
+        for (auto &graph: cache) {
+            if (graph->topologyHash == topologyHash) {
+                current = graph.get();
+                current->lastUsedFrame = frameNumber;
+                stats = current->stats;
+                stats.cached = true;
+                return;
+            }
+        }
+
+        // reset() 在等待了这个 frame slot 上一帧的时间线值之后调用, frame in flight 不超过 MAX_FRAMES_IN_FLIGHT, 更早使用的编译结果 GPU 已经用完
+        if (cache.size() >= MAX_CACHED_GRAPHS) {
+            auto oldest = cache.end();
+            for (auto it = cache.begin(); it != cache.end(); ++it) {
+                if ((*it)->lastUsedFrame + GolaSwapChain::MAX_FRAMES_IN_FLIGHT <= frameNumber &&
+                    (oldest == cache.end() || (*it)->lastUsedFrame < (*oldest)->lastUsedFrame)) {
+                    oldest = it;
+                }
+            }
+            if (oldest != cache.end()) {
+                destroy(golaDevice, **oldest);
+                cache.erase(oldest);
+            }
+        }
+
+        cache.push_back(build(topologyHash));
+        current = cache.back().get();
+        current->lastUsedFrame = frameNumber;
+        stats = current->stats;
+    }
+
+    std::unique_ptr<GolaRenderGraph::CompiledGraph> GolaRenderGraph::build(uint64_t topologyHash) {
+        auto graph = std::make_unique<CompiledGraph>();
+        graph->topologyHash = topologyHash;
+        for (uint32_t pass: cullPasses()) {
+            graph->passes.emplace_back().pass = pass;
+        }
+        graph->stats.passCount = static_cast<uint32_t>(graph->passes.size());
+        graph->stats.culledPassCount = static_cast<uint32_t>(passes.size() - graph->passes.size());
+
+        try {
+            createTransients(*graph);
+            planPasses(*graph);
+            for (uint32_t i = 0; i < graph->passes.size(); i++) {
+                if (passes[graph->passes[i].pass].type == PassType::Graphics) {
+                    describeAttachments(graph->passes[i]);
+                    // 动态渲染直接在 vkCmdBeginRendering 中给出 attachment, 不需要 render pass 和 framebuffer
+                    if (!dynamicRendering) {
+                        createRenderPass(*graph, i);
+                    }
+                }
+            }
+        } catch (...) {
+            destroy(golaDevice, *graph);
+            throw;
+        }
+        return graph;
+    }
+
+    std::vector<uint32_t> GolaRenderGraph::cullPasses() const {
+        // 从后往前做活跃性分析: 写入了之后还需要的资源 (或者有副作用) 的 pass 保留, 它读取的资源变为需要;
+        // 清除写入的资源在它之前的内容不再需要
+        std::vector<bool> needed(resources.size());
+        for (size_t i = 0; i < resources.size(); i++) {
+            needed[i] = resources[i].output;
+        }
+
+        std::vector<uint32_t> kept;
+        for (size_t p = passes.size(); p-- > 0;) {
+            const PassDecl &pass = passes[p];
+            bool keep = pass.sideEffect;
+            for (const ResourceUse &use: pass.uses) {
+                keep |= use.writes && needed[use.resource];
+            }
+            if (!keep) {
+                continue;
+            }
+            kept.push_back(static_cast<uint32_t>(p));
+            for (const ResourceUse &use: pass.uses) {
+                if (use.discards) {
+                    needed[use.resource] = false;
+                }
+            }
+            for (const ResourceUse &use: pass.uses) {
+                if (use.reads) {
+                    needed[use.resource] = true;
+                }
+            }
+        }
+        std::ranges::reverse(kept);
+        return kept;
+    }
+
+    void GolaRenderGraph::createTransients(CompiledGraph &graph) {
+        VkDevice device = golaDevice.device();
+
+        // 生命周期是第一次和最后一次使用它的 pass (编译后的下标), usage 由所有用法合并
+        std::vector<uint32_t> firstUse(resources.size(), UINT32_MAX);
+        std::vector<uint32_t> lastUse(resources.size(), 0);
+        std::vector<VkImageUsageFlags> usages(resources.size(), 0);
+        for (uint32_t i = 0; i < graph.passes.size(); i++) {
+            for (const ResourceUse &use: passes[graph.passes[i].pass].uses) {
+                firstUse[use.resource] = std::min(firstUse[use.resource], i);
+                lastUse[use.resource] = std::max(lastUse[use.resource], i);
+                switch (use.kind) {
+                    case UseKind::ColorAttachment:
+                        usages[use.resource] |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+                        break;
+                    case UseKind::DepthAttachment:
+                        usages[use.resource] |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+                        break;
+                    case UseKind::SampledImage:
+                        usages[use.resource] |= VK_IMAGE_USAGE_SAMPLED_BIT;
+                        break;
+                    case UseKind::Buffer:
+                        break;
+                }
+            }
+        }
+
+        graph.transientIndices.assign(resources.size(), -1);
+        for (uint32_t r = 0; r < resources.size(); r++) {
+            const ResourceDecl &resource = resources[r];
+            if (!resource.isImage || resource.imported || firstUse[r] == UINT32_MAX) {
+                continue;
+            }
+
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.format = resource.desc.format;
+            imageInfo.extent = {resource.desc.extent.width, resource.desc.extent.height, 1};
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.usage = usages[r] | resource.desc.usage;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            graph.transientIndices[r] = static_cast<int32_t>(graph.transients.size());
+            TransientImage &transient = graph.transients.emplace_back();
+            transient.resource = r;
+            for (VkImage &image: transient.images) {
+                if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create render graph image!");
+                }
+            }
+            vkGetImageMemoryRequirements(device, transient.images[0], &transient.requirements);
+        }
+
+        // 贪心装箱: 从大到小, 放进第一块内存类型相同且已有图像的生命周期都不与它重叠的内存
+        std::vector<uint32_t> order(graph.transients.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::ranges::stable_sort(order, [&](uint32_t a, uint32_t b) {
+            return graph.transients[a].requirements.size > graph.transients[b].requirements.size;
+        });
+
+        std::vector<std::vector<uint32_t>> blockOccupants;
+        for (uint32_t t: order) {
+            TransientImage &transient = graph.transients[t];
+            const uint32_t first = firstUse[transient.resource];
+            const uint32_t last = lastUse[transient.resource];
+
+            uint32_t block = 0;
+            for (; block < graph.blocks.size(); block++) {
+                if (graph.blocks[block].requirements.memoryTypeBits != transient.requirements.memoryTypeBits) {
+                    continue;
+                }
+                bool overlaps = false;
+                for (uint32_t other: blockOccupants[block]) {
+                    const uint32_t resource = graph.transients[other].resource;
+                    overlaps |= first <= lastUse[resource] && firstUse[resource] <= last;
+                }
+                if (!overlaps) {
+                    break;
+                }
+            }
+            if (block == graph.blocks.size()) {
+                graph.blocks.emplace_back().requirements = transient.requirements;
+                blockOccupants.emplace_back();
+            }
+
+            VkMemoryRequirements &requirements = graph.blocks[block].requirements;
+            requirements.size = std::max(requirements.size, transient.requirements.size);
+            requirements.alignment = std::max(requirements.alignment, transient.requirements.alignment);
+            blockOccupants[block].push_back(t);
+            transient.block = block;
+        }
+
+        for (MemoryBlock &block: graph.blocks) {
+            const uint32_t memoryType =
+                    golaDevice.findMemoryType(block.requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            for (GolaAllocation &allocation: block.allocations) {
+                allocation = golaDevice.getAllocator().allocate(block.requirements, memoryType,
+                                                                GolaAllocator::ResourceKind::Image);
+            }
+            graph.stats.transientMemoryBytes += block.requirements.size;
+        }
+
+        for (TransientImage &transient: graph.transients) {
+            const ResourceDecl &resource = resources[transient.resource];
+            const MemoryBlock &block = graph.blocks[transient.block];
+            for (uint32_t frame = 0; frame < GolaSwapChain::MAX_FRAMES_IN_FLIGHT; frame++) {
+                if (vkBindImageMemory(device, transient.images[frame], block.allocations[frame].memory,
+                                      block.allocations[frame].offset) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to bind render graph image memory!");
+                }
+
+                VkImageViewCreateInfo viewInfo{};
+                viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+                viewInfo.image = transient.images[frame];
+                viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                viewInfo.format = resource.desc.format;
+                viewInfo.subresourceRange.aspectMask = viewAspect(resource.desc.format);
+                viewInfo.subresourceRange.baseMipLevel = 0;
+                viewInfo.subresourceRange.levelCount = 1;
+                viewInfo.subresourceRange.baseArrayLayer = 0;
+                viewInfo.subresourceRange.layerCount = 1;
+                if (vkCreateImageView(device, &viewInfo, nullptr, &transient.views[frame]) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create render graph image view!");
+                }
+            }
+            graph.stats.unaliasedMemoryBytes += transient.requirements.size;
+        }
+        graph.stats.transientImageCount = static_cast<uint32_t>(graph.transients.size());
+    }
+
+    void GolaRenderGraph::planPasses(CompiledGraph &graph) const {
+        // 每个资源当前的布局, 最后一次写入, 以及之后已经对哪些阶段可见
+        struct ResourceState {
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            VkPipelineStageFlags writeStage = 0;
+            VkAccessFlags writeAccess = 0;
+            VkPipelineStageFlags readStages = 0;
+            VkPipelineStageFlags visibleStages = 0;
+            VkAccessFlags visibleAccess = 0;
+            bool hasContents = false;
+            bool used = false;
+        };
+
+        std::vector<ResourceState> states(resources.size());
+        std::vector<uint32_t> lastUse(resources.size(), 0);
+        for (uint32_t r = 0; r < resources.size(); r++) {
+            const ResourceDecl &resource = resources[r];
+            if (resource.imported) {
+                states[r].layout = resource.initialLayout;
+                states[r].writeStage = resource.initialStage;
+                states[r].hasContents = !resource.isImage || resource.initialLayout != VK_IMAGE_LAYOUT_UNDEFINED;
+            }
+        }
+        for (uint32_t i = 0; i < graph.passes.size(); i++) {
+            for (const ResourceUse &use: passes[graph.passes[i].pass].uses) {
+                lastUse[use.resource] = i;
+            }
+        }
+        // 每块内存上一个使用它的临时图像
+        std::vector<uint32_t> blockOccupants(graph.blocks.size(), UINT32_MAX);
+
+        auto addImageBarrier = [](BarrierBatch &batch, uint32_t resource, VkImageLayout oldLayout,
+                                  VkImageLayout newLayout, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+                                  VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+            batch.imageBarriers.push_back({resource, oldLayout, newLayout, srcAccess, dstAccess});
+            batch.srcStage |= srcStage != 0 ? srcStage : VkPipelineStageFlags{VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT};
+            batch.dstStage |= dstStage;
+        };
+
+        for (uint32_t i = 0; i < graph.passes.size(); i++) {
+            CompiledPass &compiled = graph.passes[i];
+            const PassDecl &pass = passes[compiled.pass];
+            BarrierBatch &batch = compiled.barriers;
+
+            for (const ResourceUse &use: pass.uses) {
+                const ResourceDecl &resource = resources[use.resource];
+                ResourceState &state = states[use.resource];
+                const int32_t transient = graph.transientIndices[use.resource];
+                bool transitioned = false;
+
+                if (transient >= 0 && !state.used) {
+                    // 第一次使用临时图像: 内容未定义, 但要等同一块内存上的前一个图像用完
+                    const uint32_t block = graph.transients[transient].block;
+                    VkPipelineStageFlags srcStage = 0;
+                    VkAccessFlags srcAccess = 0;
+                    if (blockOccupants[block] != UINT32_MAX) {
+                        const ResourceState &previous = states[blockOccupants[block]];
+                        srcStage = previous.writeStage | previous.readStages;
+                        srcAccess = previous.writeAccess;
+                    }
+                    blockOccupants[block] = use.resource;
+                    addImageBarrier(batch, use.resource, VK_IMAGE_LAYOUT_UNDEFINED, use.layout, srcStage, srcAccess,
+                                    use.stage, use.access);
+                    transitioned = true;
+                } else if (resource.isImage && use.layout != state.layout) {
+                    // 清除写入时不保留之前的内容, 可以从 UNDEFINED 转换
+                    const VkImageLayout oldLayout = use.discards || !state.hasContents
+                                                        ? VK_IMAGE_LAYOUT_UNDEFINED
+                                                        : state.layout;
+                    addImageBarrier(batch, use.resource, oldLayout, use.layout, state.writeStage | state.readStages,
+                                    state.writeAccess, use.stage, use.access);
+                    transitioned = true;
+                } else if (use.writes) {
+                    // WAR 只需要执行依赖, WAW 还要让之前的写入可见
+                    if (state.readStages != 0) {
+                        batch.srcStage |= state.readStages;
+                        batch.dstStage |= use.stage;
+                    } else if (state.writeStage != 0) {
+                        batch.srcStage |= state.writeStage;
+                        batch.dstStage |= use.stage;
+                        if (state.writeAccess != 0) {
+                            batch.hasMemoryBarrier = true;
+                            batch.memorySrcAccess |= state.writeAccess;
+                            batch.memoryDstAccess |= use.access;
+                        }
+                    }
+                } else if (state.writeStage != 0 &&
+                           ((use.stage & ~state.visibleStages) != 0 || (use.access & ~state.visibleAccess) != 0)) {
+                    // RAW; 之前的读取已经等待过这次写入时 (读后读) 不需要屏障
+                    batch.srcStage |= state.writeStage;
+                    batch.dstStage |= use.stage;
+                    if (state.writeAccess != 0) {
+                        batch.hasMemoryBarrier = true;
+                        batch.memorySrcAccess |= state.writeAccess;
+                        batch.memoryDstAccess |= use.access;
+                    }
+                }
+
+                if (use.kind == UseKind::ColorAttachment || use.kind == UseKind::DepthAttachment) {
+                    // 之后还会被使用, 或者是导入资源 (帧结束后仍然可见) 时才需要保存
+                    const bool keepContents = resource.imported || resource.output || lastUse[use.resource] > i;
+                    compiled.attachmentUses.push_back(static_cast<uint32_t>(&use - pass.uses.data()));
+                    compiled.loadOps.push_back(use.discards
+                                                   ? VK_ATTACHMENT_LOAD_OP_CLEAR
+                                                   : state.hasContents
+                                                   ? VK_ATTACHMENT_LOAD_OP_LOAD
+                                                   : VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+                    compiled.storeOps.push_back(keepContents
+                                                    ? VK_ATTACHMENT_STORE_OP_STORE
+                                                    : VK_ATTACHMENT_STORE_OP_DONT_CARE);
+                }
+
+                state.used = true;
+                state.layout = use.layout;
+                if (use.writes) {
+                    state.writeStage = use.stage;
+                    state.writeAccess = use.access & WRITE_ACCESS_MASK;
+                    state.readStages = 0;
+                    state.visibleStages = 0;
+                    state.visibleAccess = 0;
+                    state.hasContents = true;
+                } else if (transitioned) {
+                    // 布局转换相当于一次写入, 它只对本次使用的阶段可见
+                    state.writeStage = use.stage;
+                    state.writeAccess = 0;
+                    state.readStages = use.stage;
+                    state.visibleStages = use.stage;
+                    state.visibleAccess = use.access;
+                } else {
+                    state.readStages |= use.stage;
+                    state.visibleStages |= use.stage;
+                    state.visibleAccess |= use.access;
+                }
+            }
+
+            // depth 必须是最后一个 attachment
+            for (size_t k = 0; k < compiled.attachmentUses.size(); k++) {
+                if (pass.uses[compiled.attachmentUses[k]].kind == UseKind::DepthAttachment) {
+                    std::rotate(compiled.attachmentUses.begin() + k, compiled.attachmentUses.begin() + k + 1,
+                                compiled.attachmentUses.end());
+                    std::rotate(compiled.loadOps.begin() + k, compiled.loadOps.begin() + k + 1, compiled.loadOps.end());
+                    std::rotate(compiled.storeOps.begin() + k, compiled.storeOps.begin() + k + 1,
+                                compiled.storeOps.end());
+                    break;
+                }
+            }
+        }
+
+        for (uint32_t r = 0; r < resources.size(); r++) {
+            const ResourceDecl &resource = resources[r];
+            const ResourceState &state = states[r];
+            if (!resource.imported || !resource.isImage || resource.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED ||
+                resource.finalLayout == state.layout) {
+                continue;
+            }
+            addImageBarrier(graph.finalBarriers, r, state.layout, resource.finalLayout,
+                            state.writeStage | state.readStages, state.writeAccess,
+                            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+        }
+
+        for (const CompiledPass &compiled: graph.passes) {
+            if (!compiled.barriers.empty()) {
+                graph.stats.pipelineBarrierCount++;
+                graph.stats.barrierCount += static_cast<uint32_t>(compiled.barriers.imageBarriers.size()) +
+                        (compiled.barriers.hasMemoryBarrier ? 1 : 0);
+            }
+        }
+        if (!graph.finalBarriers.empty()) {
+            graph.stats.pipelineBarrierCount++;
+            graph.stats.barrierCount += static_cast<uint32_t>(graph.finalBarriers.imageBarriers.size());
+        }
+    }
+
+    void GolaRenderGraph::describeAttachments(CompiledPass &compiled) const {
+        const PassDecl &pass = passes[compiled.pass];
+        for (uint32_t k = 0; k < compiled.attachmentUses.size(); k++) {
+            const ResourceUse &use = pass.uses[compiled.attachmentUses[k]];
+            const ResourceDecl &resource = resources[use.resource];
+            assert((k == 0 || (resource.desc.extent.width == compiled.extent.width &&
+                               resource.desc.extent.height == compiled.extent.height)) &&
+                "All attachments of a pass must have the same extent");
+            compiled.extent = resource.desc.extent;
+            if (use.kind == UseKind::DepthAttachment) {
+                assert(compiled.depthFormat == VK_FORMAT_UNDEFINED && "A pass can only have one depth attachment");
+                compiled.depthFormat = resource.desc.format;
+            } else {
+                compiled.colorFormats.push_back(resource.desc.format);
+            }
+        }
+    }
+
+    void GolaRenderGraph::createRenderPass(CompiledGraph &graph, uint32_t compiledIndex) {
+        CompiledPass &compiled = graph.passes[compiledIndex];
+        const PassDecl &pass = passes[compiled.pass];
+
+        std::vector<VkAttachmentDescription> attachments;
+        std::vector<VkAttachmentReference> colorReferences;
+        VkAttachmentReference depthReference{};
+        bool hasDepth = false;
+
+        for (uint32_t k = 0; k < compiled.attachmentUses.size(); k++) {
+            const ResourceUse &use = pass.uses[compiled.attachmentUses[k]];
+            const ResourceDecl &resource = resources[use.resource];
+
+            VkAttachmentDescription attachment{};
+            attachment.format = resource.desc.format;
+            attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            attachment.loadOp = compiled.loadOps[k];
+            attachment.storeOp = compiled.storeOps[k];
+            const bool stencil = hasStencilComponent(resource.desc.format);
+            attachment.stencilLoadOp = stencil ? attachment.loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.stencilStoreOp = stencil ? attachment.storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            // 布局转换由图的屏障完成
+            attachment.initialLayout = use.layout;
+            attachment.finalLayout = use.layout;
+            attachments.push_back(attachment);
+
+            if (use.kind == UseKind::DepthAttachment) {
+                depthReference = {k, use.layout};
+                hasDepth = true;
+            } else {
+                colorReferences.push_back({k, use.layout});
+            }
+        }
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
+        subpass.pColorAttachments = colorReferences.data();
+        subpass.pDepthStencilAttachment = hasDepth ? &depthReference : nullptr;
+
+        VkRenderPassCreateInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        renderPassInfo.pAttachments = attachments.data();
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+
+        if (vkCreateRenderPass(golaDevice.device(), &renderPassInfo, nullptr, &compiled.renderPass) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create render graph render pass!");
+        }
+        golaDevice.getPipelineRegistry().registerRenderPass(compiled.renderPass, renderPassInfo);
+    }
+
+    VkFramebuffer GolaRenderGraph::getFramebuffer(CompiledPass &compiled) {
+        const PassDecl &pass = passes[compiled.pass];
+        std::vector<VkImageView> views;
+        views.reserve(compiled.attachmentUses.size());
+        for (uint32_t use: compiled.attachmentUses) {
+            views.push_back(getImageView({pass.uses[use].resource}));
+        }
+
+        auto it = compiled.framebuffers.find(views);
+        if (it != compiled.framebuffers.end()) {
+            return it->second;
+        }
+
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = compiled.renderPass;
+        framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+        framebufferInfo.pAttachments = views.data();
+        framebufferInfo.width = compiled.extent.width;
+        framebufferInfo.height = compiled.extent.height;
+        framebufferInfo.layers = 1;
+
+        VkFramebuffer framebuffer;
+        if (vkCreateFramebuffer(golaDevice.device(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create render graph framebuffer!");
+        }
+        compiled.framebuffers.emplace(std::move(views), framebuffer);
+        return framebuffer;
+    }
+
+    void GolaRenderGraph::beginRendering(VkCommandBuffer commandBuffer, const CompiledPass &compiled,
+                                         bool secondary) const {
+        const PassDecl &pass = passes[compiled.pass];
+        std::vector<VkRenderingAttachmentInfo> colorAttachments;
+        VkRenderingAttachmentInfo depthAttachment{};
+        for (uint32_t k = 0; k < compiled.attachmentUses.size(); k++) {
+            const ResourceUse &use = pass.uses[compiled.attachmentUses[k]];
+            VkRenderingAttachmentInfo attachment{};
+            attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+            attachment.imageView = getImageView({use.resource});
+            attachment.imageLayout = use.layout;
+            attachment.loadOp = compiled.loadOps[k];
+            attachment.storeOp = compiled.storeOps[k];
+            attachment.clearValue = use.clearValue;
+            if (use.kind == UseKind::DepthAttachment) {
+                depthAttachment = attachment;
+            } else {
+                colorAttachments.push_back(attachment);
+            }
+        }
+
+        const bool hasDepth = compiled.depthFormat != VK_FORMAT_UNDEFINED;
+        VkRenderingInfo renderingInfo{};
+        renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+        renderingInfo.flags = secondary ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+        renderingInfo.renderArea = {{0, 0}, compiled.extent};
+        renderingInfo.layerCount = 1;
+        renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorAttachments.size());
+        renderingInfo.pColorAttachments = colorAttachments.data();
+        renderingInfo.pDepthAttachment = hasDepth ? &depthAttachment : nullptr;
+        // 与 render pass 路径一致, 模板使用与深度相同的 load/store op
+        renderingInfo.pStencilAttachment =
+                hasDepth && hasStencilComponent(compiled.depthFormat) ? &depthAttachment : nullptr;
+        golaDevice.beginRendering(commandBuffer, renderingInfo);
+    }
+
+    void GolaRenderGraph::recordBarriers(VkCommandBuffer commandBuffer, const BarrierBatch &batch) const {
+        if (batch.empty()) {
+            return;
+        }
+
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        imageBarriers.reserve(batch.imageBarriers.size());
+        for (const Barrier &barrier: batch.imageBarriers) {
+            VkImageMemoryBarrier imageBarrier{};
+            imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            imageBarrier.srcAccessMask = barrier.srcAccess;
+            imageBarrier.dstAccessMask = barrier.dstAccess;
+            imageBarrier.oldLayout = barrier.oldLayout;
+            imageBarrier.newLayout = barrier.newLayout;
+            imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.image = getImage({barrier.resource});
+            imageBarrier.subresourceRange.aspectMask = resources[barrier.resource].aspect;
+            imageBarrier.subresourceRange.baseMipLevel = 0;
+            imageBarrier.subresourceRange.levelCount = 1;
+            imageBarrier.subresourceRange.baseArrayLayer = 0;
+            imageBarrier.subresourceRange.layerCount = 1;
+            imageBarriers.push_back(imageBarrier);
+        }
+
+        VkMemoryBarrier memoryBarrier{};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = batch.memorySrcAccess;
+        memoryBarrier.dstAccessMask = batch.memoryDstAccess;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            batch.srcStage,
+            batch.dstStage,
+            0,
+            batch.hasMemoryBarrier ? 1 : 0,
+            batch.hasMemoryBarrier ? &memoryBarrier : nullptr,
+            0,
+            nullptr,
+            static_cast<uint32_t>(imageBarriers.size()),
+            imageBarriers.data());
+    }
+
+    void GolaRenderGraph::execute(VkCommandBuffer commandBuffer, int frameIndex, GolaCommandRecorder *recorder,
+                                  GolaGpuProfiler *profiler) {
+        compile();
+        executingFrameIndex = frameIndex;
+
+        std::vector<VkClearValue> clearValues;
+        for (CompiledPass &compiled: current->passes) {
+            PassDecl &pass = passes[compiled.pass];
+            // 作用域在 render pass 之外写入, 包含 pass 之前的屏障等待
+            GolaGpuProfiler::Scope scope{profiler, commandBuffer, pass.name};
+            recordBarriers(commandBuffer, compiled.barriers);
+
+            PassContext context{commandBuffer, *this};
+            if (pass.type == PassType::Compute) {
+                pass.execute(context);
+                continue;
+            }
+
+            const bool secondary = pass.secondaryCommandBuffers && recorder != nullptr;
+            if (dynamicRendering) {
+                beginRendering(commandBuffer, compiled, secondary);
+                if (secondary) {
+                    recorder->beginRendering(commandBuffer, compiled.colorFormats, compiled.depthFormat,
+                                             compiled.extent);
+                }
+            } else {
+                clearValues.clear();
+                for (uint32_t use: compiled.attachmentUses) {
+                    clearValues.push_back(pass.uses[use].clearValue);
+                }
+
+                VkRenderPassBeginInfo renderPassInfo{};
+                renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+                renderPassInfo.renderPass = compiled.renderPass;
+                renderPassInfo.framebuffer = getFramebuffer(compiled);
+                renderPassInfo.renderArea.offset = {0, 0};
+                renderPassInfo.renderArea.extent = compiled.extent;
+                renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+                renderPassInfo.pClearValues = clearValues.data();
+
+                vkCmdBeginRenderPass(commandBuffer, &renderPassInfo,
+                                     secondary
+                                         ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                                         : VK_SUBPASS_CONTENTS_INLINE);
+                if (secondary) {
+                    recorder->beginRenderPass(commandBuffer, compiled.renderPass, renderPassInfo.framebuffer,
+                                              compiled.extent);
+                }
+            }
+            // viewport 和 scissor 由每个 secondary 自己设置
+            if (!secondary) {
+                VkViewport viewport{};
+                viewport.x = 0.0f;
+                viewport.y = 0.0f;
+                viewport.width = static_cast<float>(compiled.extent.width);
+                viewport.height = static_cast<float>(compiled.extent.height);
+                viewport.minDepth = 0.0f;
+                viewport.maxDepth = 1.0f;
+                VkRect2D scissor{{0, 0}, compiled.extent};
+                vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+                vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+            }
+
+            context.renderPass = compiled.renderPass;
+            context.extent = compiled.extent;
+            pass.execute(context);
+
+            if (secondary) {
+                recorder->endRenderPass();
+            }
+            if (dynamicRendering) {
+                golaDevice.endRendering(commandBuffer);
+            } else {
+                vkCmdEndRenderPass(commandBuffer);
+            }
+        }
+        recordBarriers(commandBuffer, current->finalBarriers);
+    }
+
+    VkImage GolaRenderGraph::getImage(GolaRenderGraphResource image) const {
+        const ResourceDecl &resource = resources[image.index];
+        if (resource.imported) {
+            return resource.image;
+        }
+        assert(current && current->transientIndices[image.index] >= 0 && "Image is not used by any executed pass");
+        return current->transients[current->transientIndices[image.index]].images[executingFrameIndex];
+    }
+
+    VkImageView GolaRenderGraph::getImageView(GolaRenderGraphResource image) const {
+        const ResourceDecl &resource = resources[image.index];
+        if (resource.imported) {
+            return resource.view;
+        }
+        assert(current && current->transientIndices[image.index] >= 0 && "Image is not used by any executed pass");
+        return current->transients[current->transientIndices[image.index]].views[executingFrameIndex];
+    }
+
+    VkBuffer GolaRenderGraph::getBuffer(GolaRenderGraphResource buffer) const {
+        assert(!resources[buffer.index].isImage && "Resource is not a buffer");
+        return resources[buffer.index].buffer;
+    }
+
+    void GolaRenderGraph::destroy(GolaDevice &golaDevice, CompiledGraph &graph) {
+        VkDevice device = golaDevice.device();
+        for (CompiledPass &compiled: graph.passes) {
+            for (auto &[views, framebuffer]: compiled.framebuffers) {
+                vkDestroyFramebuffer(device, framebuffer, nullptr);
+            }
+            compiled.framebuffers.clear();
+            if (compiled.renderPass != VK_NULL_HANDLE) {
+                golaDevice.getPipelineRegistry().unregisterRenderPass(compiled.renderPass);
+                vkDestroyRenderPass(device, compiled.renderPass, nullptr);
+                compiled.renderPass = VK_NULL_HANDLE;
+            }
+        }
+        for (TransientImage &transient: graph.transients) {
+            for (uint32_t frame = 0; frame < GolaSwapChain::MAX_FRAMES_IN_FLIGHT; frame++) {
+                if (transient.views[frame] != VK_NULL_HANDLE) {
+                    vkDestroyImageView(device, transient.views[frame], nullptr);
+                }
+                if (transient.images[frame] != VK_NULL_HANDLE) {
+                    vkDestroyImage(device, transient.images[frame], nullptr);
+                }
+            }
+        }
+        graph.transients.clear();
+        for (MemoryBlock &block: graph.blocks) {
+            for (GolaAllocation &allocation: block.allocations) {
+                if (allocation.isValid()) {
+                    golaDevice.getAllocator().free(allocation);
+                }
+            }
+        }
+        graph.blocks.clear();
+    }
+
+    void GolaRenderGraph::clearCache() {
+        // 正在执行的帧可能还在使用这些 framebuffer 和临时图像, 等它们完成后再销毁
+        for (auto &graph: cache) {
+            std::shared_ptr<CompiledGraph> retired = std::move(graph);
+            golaDevice.getDeletionQueue().push([&device = golaDevice, retired] { destroy(device, *retired); });
+        }
+        cache.clear();
+        current = nullptr;
+    }
+
+    void GolaRenderGraph::runBenchmark(GolaDevice &device) {
+        GolaRenderGraph graph{device};
+
+        const VkFormat depthFormat = device.findSupportedFormat(
+            {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+        const VkExtent2D extent{1920, 1080};
+        const VkClearColorValue clearColor{{0.0f, 0.0f, 0.0f, 0.0f}};
+        const VkClearDepthStencilValue clearDepth{1.0f, 0};
+        constexpr VkPipelineStageFlags FRAGMENT = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        constexpr uint32_t BLOOM_LEVELS = 4;
+        auto noop = [](PassContext &) {
+        };
+
+        // 延迟着色的一帧: G-buffer, SSAO, 光照, bloom 降采样链, 一个输出没人读的调试 pass, tonemap, FXAA 到交换链
+        auto declareFrame = [&] {
+            graph.reset();
+            GolaRenderGraphResource backbuffer = graph.importImage(
+                "backbuffer", VK_NULL_HANDLE, VK_NULL_HANDLE, {VK_FORMAT_B8G8R8A8_SRGB, extent},
+                VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+            graph.markOutput(backbuffer);
+
+            GolaRenderGraphResource albedo, normal, depth, ao, hdr, ldr, debug;
+            std::array<GolaRenderGraphResource, BLOOM_LEVELS> bloom;
+            graph.addPass("gbuffer", PassType::Graphics, [&](PassBuilder &builder) {
+                albedo = builder.createImage("albedo", {VK_FORMAT_R8G8B8A8_UNORM, extent});
+                normal = builder.createImage("normal", {VK_FORMAT_R16G16B16A16_SFLOAT, extent});
+                depth = builder.createImage("depth", {depthFormat, extent});
+                builder.writeColor(albedo, &clearColor);
+                builder.writeColor(normal, &clearColor);
+                builder.writeDepth(depth, &clearDepth);
+            }, noop);
+            graph.addPass("ssao", PassType::Graphics, [&](PassBuilder &builder) {
+                ao = builder.createImage("ao", {VK_FORMAT_R8_UNORM, extent});
+                builder.readImage(normal, FRAGMENT);
+                builder.readImage(depth, FRAGMENT);
+                builder.writeColor(ao, &clearColor);
+            }, noop);
+            graph.addPass("lighting", PassType::Graphics, [&](PassBuilder &builder) {
+                hdr = builder.createImage("hdr", {VK_FORMAT_R16G16B16A16_SFLOAT, extent});
+                builder.readImage(albedo, FRAGMENT);
+                builder.readImage(normal, FRAGMENT);
+                builder.readImage(depth, FRAGMENT);
+                builder.readImage(ao, FRAGMENT);
+                builder.writeColor(hdr, &clearColor);
+            }, noop);
+            for (uint32_t level = 0; level < BLOOM_LEVELS; level++) {
+                graph.addPass("bloom", PassType::Graphics, [&](PassBuilder &builder) {
+                    const VkExtent2D levelExtent{extent.width >> (level + 1), extent.height >> (level + 1)};
+                    bloom[level] = builder.createImage("bloom", {VK_FORMAT_R16G16B16A16_SFLOAT, levelExtent});
+                    builder.readImage(level == 0 ? hdr : bloom[level - 1], FRAGMENT);
+                    builder.writeColor(bloom[level], &clearColor);
+                }, noop);
+            }
+            graph.addPass("debug overlay", PassType::Graphics, [&](PassBuilder &builder) {
+                debug = builder.createImage("debug", {VK_FORMAT_R8G8B8A8_UNORM, extent});
+                builder.readImage(depth, FRAGMENT);
+                builder.writeColor(debug, &clearColor);
+            }, noop);
+            graph.addPass("tonemap", PassType::Graphics, [&](PassBuilder &builder) {
+                ldr = builder.createImage("ldr", {VK_FORMAT_R8G8B8A8_UNORM, extent});
+                builder.readImage(hdr, FRAGMENT);
+                builder.readImage(bloom[BLOOM_LEVELS - 1], FRAGMENT);
+                builder.writeColor(ldr, &clearColor);
+            }, noop);
+            graph.addPass("fxaa", PassType::Graphics, [&](PassBuilder &builder) {
+                builder.readImage(ldr, FRAGMENT);
+                builder.writeColor(backbuffer, &clearColor);
+            }, noop);
+        };
+
+        declareFrame();
+        auto startTime = std::chrono::high_resolution_clock::now();
+        graph.compile();
+        const float coldMs = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - startTime).count();
+        const GolaRenderGraphStats stats = graph.getStats();
+
+        // 不合并时每次资源使用一个屏障, 每个 pass 前一次 vkCmdPipelineBarrier
+        uint32_t naiveBarrierCount = 0;
+        for (const CompiledPass &compiled: graph.current->passes) {
+            naiveBarrierCount += static_cast<uint32_t>(graph.passes[compiled.pass].uses.size());
+        }
+
+        constexpr int FRAME_COUNT = 1000;
+        bool allCached = true;
+        startTime = std::chrono::high_resolution_clock::now();
+        for (int frame = 0; frame < FRAME_COUNT; frame++) {
+            declareFrame();
+            graph.compile();
+            allCached &= graph.getStats().cached;
+        }
+        const float cachedMs = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - startTime).count() / FRAME_COUNT;
+
+        std::print("[DEBUG] Render graph benchmark ({} passes declared)\n", stats.passCount + stats.culledPassCount);
+        std::print("[DEBUG]   passes: {} executed, {} culled\n", stats.passCount, stats.culledPassCount);
+        std::print("[DEBUG]   barriers: {} in {} vkCmdPipelineBarrier calls (naive: {} in {} calls)\n",
+                   stats.barrierCount, stats.pipelineBarrierCount, naiveBarrierCount, naiveBarrierCount);
+        std::print("[DEBUG]   transient memory: {:.1f} MiB aliased, {:.1f} MiB without aliasing ({} images)\n",
+                   static_cast<double>(stats.transientMemoryBytes) / (1024.0 * 1024.0),
+                   static_cast<double>(stats.unaliasedMemoryBytes) / (1024.0 * 1024.0), stats.transientImageCount);
+        std::print("[DEBUG]   compile: {:.3f} ms cold, {:.4f} ms declare + cached compile{}\n", coldMs, cachedMs,
+                   allCached ? "" : " (cache missed!)");
+    }
+}
@@ -0,0 +1,328 @@
+#pragma once
+
+#include "gola_allocator.hpp"
+#include "gola_device.hpp"
+#include "gola_swap_chain.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace gola {
+    class GolaCommandRecorder;
+    class GolaGpuProfiler;
+
+    // 渲染图中资源的句柄, 只在声明它的那一帧有效
+    struct GolaRenderGraphResource {
+        static constexpr uint32_t INVALID = UINT32_MAX;
+
+        uint32_t index = INVALID;
+
+        bool isValid() const { return index != INVALID; }
+    };
+
+    struct GolaRenderGraphImageDesc {
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent{};
+        // pass 的声明会自动加上对应的 usage, 这里只填额外需要的
+        VkImageUsageFlags usage = 0;
+    };
+
+    // 最近一次 compile() 的结果, 显示在 ImGui 调试窗口中
+    struct GolaRenderGraphStats {
+        uint32_t passCount = 0;
+        uint32_t culledPassCount = 0;
+        // 合并后的 vkCmdPipelineBarrier 次数和其中的屏障数 (图像屏障 + 全局内存屏障)
+        uint32_t pipelineBarrierCount = 0;
+        uint32_t barrierCount = 0;
+        uint32_t transientImageCount = 0;
+        // 每个 frame in flight 的临时图像内存, 以及不做别名时需要的内存
+        VkDeviceSize transientMemoryBytes = 0;
+        VkDeviceSize unaliasedMemoryBytes = 0;
+        // 拓扑与缓存中的某次编译相同, 直接复用
+        bool cached = false;
+    };
+
+    /*
+     * 每帧重新声明的渲染图: pass 声明读写的资源, compile() 剔除对输出没有贡献的 pass, 按声明顺序为每个 pass
+     * 合并出一次 vkCmdPipelineBarrier (布局转换, RAW/WAR/WAW), 为 graphics pass 创建 render pass 和 framebuffer
+     * (设备支持动态渲染时改用 vkCmdBeginRendering, 两者都不创建), 并把生命周期不重叠的临时图像放在同一块内存上. 编译结果按拓扑 (pass, 资源描述和用法, 不含句柄) 的哈希缓存,
+     * 拓扑不变时每帧只需要重新解析导入资源的句柄.
+     *
+     * render pass 的 initialLayout 等于 finalLayout, 所有布局转换都由图发出的屏障完成. attachment 格式与
+     * 交换链 render pass 相同时两者兼容, 用交换链 render pass 创建的管线可以直接使用; 动态渲染时管线
+     * 只需要相同的 attachment 格式 (GolaRenderer::getSwapChainRenderTarget).
+     */
+    class GolaRenderGraph {
+        struct ResourceUse;
+
+    public:
+        // 超过这个数量后不再缓存新的拓扑, 最久未使用且 GPU 已经用完的编译结果会被释放
+        static constexpr uint32_t MAX_CACHED_GRAPHS = 8;
+
+        enum class PassType {
+            Graphics, // 在图创建的 render pass 内执行, 至少写一个 attachment
+            Compute, // render pass 之外的 compute / transfer 命令
+        };
+
+        struct PassContext {
+            VkCommandBuffer commandBuffer;
+            GolaRenderGraph &graph;
+            // 只对 graphics pass 有效, 动态渲染时为空
+            VkRenderPass renderPass = VK_NULL_HANDLE;
+            VkExtent2D extent{};
+        };
+
+        class PassBuilder {
+        public:
+            // 由图管理内存的图像, 只在本帧内有效, 内容不会保留到下一帧
+            GolaRenderGraphResource createImage(const char *name, const GolaRenderGraphImageDesc &desc);
+
+            // Color attachment. With a clear value the previous contents are discarded, otherwise they are loaded.
+            void writeColor(GolaRenderGraphResource image, const VkClearColorValue *clearValue = nullptr);
+
+            void writeDepth(GolaRenderGraphResource image, const VkClearDepthStencilValue *clearValue = nullptr);
+
+            // 在 stage 中作为 sampled image 读取
+            void readImage(GolaRenderGraphResource image, VkPipelineStageFlags stage);
+
+            void readBuffer(GolaRenderGraphResource buffer, VkPipelineStageFlags stage, VkAccessFlags access);
+
+            void writeBuffer(GolaRenderGraphResource buffer, VkPipelineStageFlags stage, VkAccessFlags access);
+
+            // pass 有图之外可见的效果 (例如回读到 CPU), 不会被剔除
+            void setSideEffect();
+
+            // graphics pass 以 VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS 开始, 命令通过 GolaCommandRecorder 录制
+            void useSecondaryCommandBuffers(bool enabled);
+
+        private:
+            friend class GolaRenderGraph;
+
+            PassBuilder(GolaRenderGraph &graph, uint32_t passIndex) : graph{graph}, passIndex{passIndex} {
+            }
+
+            void addUse(const ResourceUse &use);
+
+            GolaRenderGraph &graph;
+            uint32_t passIndex;
+        };
+
+        using SetupFunction = std::function<void(PassBuilder &)>;
+        using ExecuteFunction = std::function<void(PassContext &)>;
+
+        // 设备支持时使用动态渲染
+        explicit GolaRenderGraph(GolaDevice &device);
+
+        GolaRenderGraph(GolaDevice &device, bool dynamicRendering);
+
+        ~GolaRenderGraph();
+
+        GolaRenderGraph(const GolaRenderGraph &) = delete;
+
+        GolaRenderGraph &operator=(const GolaRenderGraph &) = delete;
+
+        // Clears the passes and resources declared for the previous frame. Must be called once per frame after
+        // the timeline value of the frame that last used this frame slot was waited on (GolaRenderer::beginFrame).
+        void reset();
+
+        // External image, e.g. the swap chain image. It is in initialLayout when the frame starts (written by
+        // initialStage, for example a semaphore wait stage) and is transitioned to finalLayout at the end.
+        GolaRenderGraphResource importImage(const char *name, VkImage image, VkImageView view,
+                                            const GolaRenderGraphImageDesc &desc, VkImageLayout initialLayout,
+                                            VkPipelineStageFlags initialStage, VkImageLayout finalLayout);
+
+        // 外部缓冲区, 帧开始时没有未完成的写入
+        GolaRenderGraphResource importBuffer(const char *name, VkBuffer buffer);
+
+        // 帧的输出 (例如交换链图像): 最终写入它的 pass 及其依赖不会被剔除
+        void markOutput(GolaRenderGraphResource resource);
+
+        // setup is called immediately to declare the pass's resources; execute is called by execute() in
+        // declaration order, unless the pass was culled. name must outlive the frame (a string literal).
+        void addPass(const char *name, PassType type, const SetupFunction &setup, ExecuteFunction execute);
+
+        // Builds or reuses the compiled graph for the declared topology. Called by execute().
+        void compile();
+
+        // Records every surviving pass into commandBuffer (outside of a render pass). recorder is only
+        // needed by passes that use secondary command buffers. With a profiler every pass is a GPU scope
+        // named after it.
+        void execute(VkCommandBuffer commandBuffer, int frameIndex, GolaCommandRecorder *recorder,
+                     GolaGpuProfiler *profiler = nullptr);
+
+        // Drops every compiled graph. Their framebuffers and transient images are handed to the device deletion
+        // queue and destroyed once the frames already submitted have completed. Called whenever imported image
+        // views are about to be destroyed (swap chain recreation).
+        void clearCache();
+
+        // 只能在 pass 的 execute 回调中调用
+        VkImage getImage(GolaRenderGraphResource image) const;
+
+        VkImageView getImageView(GolaRenderGraphResource image) const;
+
+        VkBuffer getBuffer(GolaRenderGraphResource buffer) const;
+
+        const GolaRenderGraphImageDesc &getImageDesc(GolaRenderGraphResource image) const {
+            return resources[image.index].desc;
+        }
+
+        const GolaRenderGraphStats &getStats() const { return stats; }
+
+        // Compiles a synthetic deferred-shading frame and prints culled passes, the merged barriers against one
+        // barrier per resource use, transient memory with and without aliasing, and the cold vs cached compile time.
+        static void runBenchmark(GolaDevice &device);
+
+    private:
+        enum class UseKind {
+            ColorAttachment,
+            DepthAttachment,
+            SampledImage,
+            Buffer,
+        };
+
+        struct ResourceUse {
+            uint32_t resource;
+            UseKind kind;
+            VkPipelineStageFlags stage;
+            VkAccessFlags access;
+            VkImageLayout layout;
+            bool reads;
+            bool writes;
+            // 写入前不需要之前的内容 (带清除值的 attachment)
+            bool discards;
+            VkClearValue clearValue{};
+        };
+
+        struct ResourceDecl {
+            const char *name;
+            bool isImage;
+            bool imported;
+            bool output = false;
+            GolaRenderGraphImageDesc desc{};
+            VkImageAspectFlags aspect = 0;
+            VkImage image = VK_NULL_HANDLE;
+            VkImageView view = VK_NULL_HANDLE;
+            VkBuffer buffer = VK_NULL_HANDLE;
+            VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            VkPipelineStageFlags initialStage = 0;
+            VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        };
+
+        struct PassDecl {
+            const char *name;
+            PassType type;
+            std::vector<ResourceUse> uses;
+            bool sideEffect = false;
+            bool secondaryCommandBuffers = false;
+            ExecuteFunction execute;
+        };
+
+        struct Barrier {
+            uint32_t resource;
+            VkImageLayout oldLayout;
+            VkImageLayout newLayout;
+            VkAccessFlags srcAccess;
+            VkAccessFlags dstAccess;
+        };
+
+        // 一次 vkCmdPipelineBarrier: 所有图像屏障加上一个覆盖缓冲区和同布局图像的全局内存屏障
+        struct BarrierBatch {
+            VkPipelineStageFlags srcStage = 0;
+            VkPipelineStageFlags dstStage = 0;
+            VkAccessFlags memorySrcAccess = 0;
+            VkAccessFlags memoryDstAccess = 0;
+            bool hasMemoryBarrier = false;
+            std::vector<Barrier> imageBarriers;
+
+            bool empty() const { return srcStage == 0 && dstStage == 0; }
+        };
+
+        struct CompiledPass {
+            uint32_t pass;
+            BarrierBatch barriers;
+            // graphics pass: attachment 依次为各个 color, 最后是 depth, 记录的是 PassDecl::uses 的下标
+            VkRenderPass renderPass = VK_NULL_HANDLE;
+            std::vector<uint32_t> attachmentUses;
+            std::vector<VkAttachmentLoadOp> loadOps;
+            std::vector<VkAttachmentStoreOp> storeOps;
+            VkExtent2D extent{};
+            std::vector<VkFormat> colorFormats;
+            VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+            // 只在 render pass 模式下使用
+            std::map<std::vector<VkImageView>, VkFramebuffer> framebuffers;
+        };
+
+        struct TransientImage {
+            uint32_t resource;
+            uint32_t block;
+            VkMemoryRequirements requirements{};
+            std::array<VkImage, GolaSwapChain::MAX_FRAMES_IN_FLIGHT> images{};
+            std::array<VkImageView, GolaSwapChain::MAX_FRAMES_IN_FLIGHT> views{};
+        };
+
+        // 若干生命周期不重叠的临时图像共用的内存, 每个 frame in flight 一份
+        struct MemoryBlock {
+            VkMemoryRequirements requirements{};
+            std::array<GolaAllocation, GolaSwapChain::MAX_FRAMES_IN_FLIGHT> allocations{};
+        };
+
+        struct CompiledGraph {
+            uint64_t topologyHash = 0;
+            uint64_t lastUsedFrame = 0;
+            std::vector<CompiledPass> passes;
+            // pass 全部执行后, 把导入图像转换到 finalLayout
+            BarrierBatch finalBarriers;
+            std::vector<TransientImage> transients;
+            // 按资源下标查找 transients, 不是临时图像时为 -1
+            std::vector<int32_t> transientIndices;
+            std::vector<MemoryBlock> blocks;
+            GolaRenderGraphStats stats{};
+        };
+
+        uint32_t addResource(const ResourceDecl &resource);
+
+        uint64_t hashTopology() const;
+
+        std::unique_ptr<CompiledGraph> build(uint64_t topologyHash);
+
+        std::vector<uint32_t> cullPasses() const;
+
+        // 计算每个 pass 之前的屏障, 以及 attachment 的 load/store op
+        void planPasses(CompiledGraph &graph) const;
+
+        void createTransients(CompiledGraph &graph);
+
+        // graphics pass 的 extent 和 attachment 格式
+        void describeAttachments(CompiledPass &compiled) const;
+
+        void createRenderPass(CompiledGraph &graph, uint32_t compiledIndex);
+
+        void beginRendering(VkCommandBuffer commandBuffer, const CompiledPass &compiled, bool secondary) const;
+
+        VkFramebuffer getFramebuffer(CompiledPass &pass);
+
+        void recordBarriers(VkCommandBuffer commandBuffer, const BarrierBatch &batch) const;
+
+        static void destroy(GolaDevice &golaDevice, CompiledGraph &graph);
+
+        GolaDevice &golaDevice;
+        bool dynamicRendering;
+
+        // 当前帧的声明
+        std::vector<ResourceDecl> resources;
+        std::vector<PassDecl> passes;
+
+        std::vector<std::unique_ptr<CompiledGraph>> cache;
+        CompiledGraph *current = nullptr;
+        uint64_t frameNumber = 0;
+        int executingFrameIndex = 0;
+        GolaRenderGraphStats stats{};
+    };
+}
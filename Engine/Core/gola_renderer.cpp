@@ -1,12 +1,20 @@
 #include "gola_renderer.hpp"
+#include "gola_deletion_queue.hpp"
+#include "gola_pipeline_compiler.hpp"
+#include "gola_staging_ring.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
+#include <print>
 #include <stdexcept>
+#include <string>
 
 namespace gola {
     GolaRenderer::GolaRenderer(GolaWindow &window, GolaDevice &device)
-        : golaWindow{window}, golaDevice{device} {
+        : golaWindow{window}, golaDevice{device}, dynamicRendering{device.getFeatures().dynamicRendering},
+          commandRecorder{device}, renderGraph{device, dynamicRendering}, gpuProfiler{device} {
         recreateSwapChain();
         createCommandBuffers();
     }
@@ -19,46 +27,89 @@ namespace gola {
             extent = golaWindow.getExtent();
             glfwWaitEvents();
         }
-        vkDeviceWaitIdle(golaDevice.device());
+        rebuildSwapChain(extent, dynamicRendering);
+    }
+
+    void GolaRenderer::rebuildSwapChain(VkExtent2D extent, bool useDynamicRendering) {
+        // 缓存的 framebuffer 和临时图像引用了旧交换链的 image view 和尺寸, 交给延迟销毁队列
+        renderGraph.clearCache();
+        swapChainRecreations++;
 
         if (golaSwapChain == nullptr) {
-            golaSwapChain = std::make_unique<GolaSwapChain>(golaDevice, extent);
+            golaSwapChain = std::make_unique<GolaSwapChain>(golaDevice, extent, appliedSettings, useDynamicRendering);
         } else {
             std::shared_ptr<GolaSwapChain> oldSwapChain = std::move(golaSwapChain);
-            golaSwapChain = std::make_unique<GolaSwapChain>(golaDevice, extent, oldSwapChain);
+            golaSwapChain = std::make_unique<GolaSwapChain>(golaDevice, extent, oldSwapChain, appliedSettings,
+                                                            useDynamicRendering);
 
             if (!oldSwapChain->compareSwapFormats(*golaSwapChain.get())) {
                 throw std::runtime_error("Swap chain image(or depth) format has changed!");
             }
+            // 旧交换链的图像, view, framebuffer 和信号量可能还被在途的帧和 present 使用. 时间线看不到 present,
+            // 所以再多等 MAX_FRAMES_IN_FLIGHT 帧: 那时新交换链上的帧已经完成, 之前排队的 present 也已经执行
+            golaDevice.getDeletionQueue().push([retired = std::move(oldSwapChain)]() mutable { retired.reset(); },
+                                               GolaSwapChain::MAX_FRAMES_IN_FLIGHT);
         }
     }
 
     void GolaRenderer::createCommandBuffers() {
         commandBuffers.resize(GolaSwapChain::MAX_FRAMES_IN_FLIGHT);
 
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = golaDevice.getCommandPool();
-        allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = golaDevice.findPhysicalQueueFamilies().graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        for (size_t i = 0; i < commandBuffers.size(); i++) {
+            if (vkCreateCommandPool(golaDevice.device(), &poolInfo, nullptr, &commandPools[i]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create frame command pool!");
+            }
+
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = commandPools[i];
+            allocInfo.commandBufferCount = 1;
 
-        if (vkAllocateCommandBuffers(golaDevice.device(), &allocInfo, commandBuffers.data()) !=
-            VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate command buffers!");
+            if (vkAllocateCommandBuffers(golaDevice.device(), &allocInfo, &commandBuffers[i]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate command buffers!");
+            }
         }
     }
 
     void GolaRenderer::freeCommandBuffers() {
-        vkFreeCommandBuffers(
-            golaDevice.device(),
-            golaDevice.getCommandPool(),
-            static_cast<uint32_t>(commandBuffers.size()),
-            commandBuffers.data());
+        // 销毁 pool 时一并释放其中的 command buffer
+        for (auto &commandPool: commandPools) {
+            if (commandPool != VK_NULL_HANDLE) {
+                vkDestroyCommandPool(golaDevice.device(), commandPool, nullptr);
+                commandPool = VK_NULL_HANDLE;
+            }
+        }
         commandBuffers.clear();
     }
 
+    void GolaRenderer::waitForNextFrame() {
+        assert(!isFrameStarted && "Can't call waitForNextFrame while a frame is in progress");
+        const GolaPresentSettings &requested =
+            presentBenchmark ? presentBenchmark->configurations[presentBenchmark->current] : presentSettings;
+        if (requested.presentMode != appliedSettings.presentMode ||
+            requested.framesInFlight != appliedSettings.framesInFlight) {
+            appliedSettings = requested;
+            recreateSwapChain();
+        }
+        appliedSettings.frameRateLimit = requested.frameRateLimit;
+
+        frameLimiter.wait(appliedSettings.frameRateLimit);
+        inputTime = std::chrono::steady_clock::now();
+    }
+
     VkCommandBuffer GolaRenderer::beginFrame() {
         assert(!isFrameStarted && "Can't call beginFrame while already in progress");
+        if (resizeStorm) {
+            updateResizeStorm();
+        }
+        // 也在获取失败的帧里执行, 连续重建时旧交换链不会堆积
+        golaDevice.getDeletionQueue().collect();
 
         auto result = golaSwapChain->acquireNextImage(&currentImageIndex);
         if (result == VK_ERROR_OUT_OF_DATE_KHR) {
@@ -71,24 +122,40 @@ namespace gola {
         }
 
         isFrameStarted = true;
+        currentFrameIndex = static_cast<int>(golaSwapChain->getFrameIndex());
+
+        // acquireNextImage 已经等待了这一帧上一次提交的时间线值, 整个 pool 可以直接重置
+        if (vkResetCommandPool(golaDevice.device(), commandPools[currentFrameIndex], 0) != VK_SUCCESS) {
+            throw std::runtime_error("failed to reset frame command pool!");
+        }
+        commandRecorder.beginFrame(currentFrameIndex);
+        renderGraph.reset();
 
         auto commandBuffer = getCurrentCommandBuffer();
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
         if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
             throw std::runtime_error("failed to begin recording command buffer!");
         }
+        gpuProfiler.beginFrame(commandBuffer, currentFrameIndex);
         return commandBuffer;
     }
 
     void GolaRenderer::endFrame() {
         assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
         auto commandBuffer = getCurrentCommandBuffer();
+        gpuProfiler.endFrame(commandBuffer);
         if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
             throw std::runtime_error("failed to record command buffer!");
         }
 
+        // 本帧内新建的模型必须在绘制命令之前提交上传
+        golaDevice.getStagingRing().flush();
+
+        const float latencyMs = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::steady_clock::now() - inputTime).count();
         auto result = golaSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
             golaWindow.wasWindowResized()) {
@@ -99,11 +166,49 @@ namespace gola {
         }
 
         isFrameStarted = false;
-        currentFrameIndex = (currentFrameIndex + 1) % GolaSwapChain::MAX_FRAMES_IN_FLIGHT;
+        recordPresentLatency(latencyMs);
     }
 
-    void GolaRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+    void GolaRenderer::recordPresentLatency(float latencyMs) {
+        const auto now = std::chrono::steady_clock::now();
+        const float frameMs = lastSubmitTime == std::chrono::steady_clock::time_point{}
+                                  ? 0.0f
+                                  : std::chrono::duration<float, std::chrono::milliseconds::period>(
+                                      now - lastSubmitTime).count();
+        lastSubmitTime = now;
+
+        latencyFrames++;
+        latencyTotalMs += latencyMs;
+        latencyMaxMs = std::max(latencyMaxMs, latencyMs);
+        frameTotalMs += frameMs;
+        if (latencyFrames == LATENCY_WINDOW_FRAMES) {
+            presentStats.presentMode = golaSwapChain->getPresentMode();
+            presentStats.framesInFlight = golaSwapChain->getFramesInFlight();
+            presentStats.averageLatencyMs = latencyTotalMs / static_cast<float>(latencyFrames);
+            presentStats.maxLatencyMs = latencyMaxMs;
+            presentStats.averageFrameMs = frameTotalMs / static_cast<float>(latencyFrames);
+            latencyFrames = 0;
+            latencyTotalMs = 0.0f;
+            latencyMaxMs = 0.0f;
+            frameTotalMs = 0.0f;
+        }
+
+        if (presentBenchmark) {
+            updatePresentBenchmark(latencyMs, frameMs);
+        }
+    }
+
+    GolaRenderTarget GolaRenderer::getSwapChainRenderTarget() const {
+        GolaRenderTarget renderTarget{};
+        renderTarget.renderPass = golaSwapChain->getRenderPass();
+        renderTarget.colorFormat = golaSwapChain->getSwapChainImageFormat();
+        renderTarget.depthFormat = golaSwapChain->getDepthFormat();
+        return renderTarget;
+    }
+
+    void GolaRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
         assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress");
+        assert(!golaSwapChain->isDynamicRendering() && "The swap chain has no render pass with dynamic rendering");
         assert(
             commandBuffer == getCurrentCommandBuffer() &&
             "Can't begin render pass on command buffer from a different frame");
@@ -122,7 +227,13 @@ namespace gola {
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+        if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS) {
+            // viewport 和 scissor 由每个 secondary 自己设置
+            commandRecorder.beginRenderPass(commandBuffer, renderPassInfo.renderPass, renderPassInfo.framebuffer,
+                                            renderPassInfo.renderArea.extent);
+            return;
+        }
 
         VkViewport viewport{};
         viewport.x = 0.0f;
@@ -141,6 +252,204 @@ namespace gola {
         assert(
             commandBuffer == getCurrentCommandBuffer() &&
             "Can't end render pass on command buffer from a different frame");
+        if (commandRecorder.isInRenderPass()) {
+            commandRecorder.endRenderPass();
+        }
         vkCmdEndRenderPass(commandBuffer);
     }
+
+    GolaRenderGraphResource GolaRenderer::importSwapChainImage() {
+        assert(isFrameStarted && "Can't import the swap chain image if frame is not in progress");
+        GolaRenderGraphImageDesc desc{};
+        desc.format = golaSwapChain->getSwapChainImageFormat();
+        desc.extent = golaSwapChain->getSwapChainExtent();
+        // 在 submitCommandBuffers 等待 imageAvailable 信号量的阶段之后才能写入
+        GolaRenderGraphResource image = renderGraph.importImage(
+            "swap chain", golaSwapChain->getImage(static_cast<int>(currentImageIndex)),
+            golaSwapChain->getImageView(static_cast<int>(currentImageIndex)), desc, VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+        renderGraph.markOutput(image);
+        return image;
+    }
+
+    void GolaRenderer::executeRenderGraph(VkCommandBuffer commandBuffer) {
+        assert(isFrameStarted && "Can't execute the render graph if frame is not in progress");
+        assert(
+            commandBuffer == getCurrentCommandBuffer() &&
+            "Can't execute the render graph on command buffer from a different frame");
+        renderGraph.execute(commandBuffer, currentFrameIndex, &commandRecorder, &gpuProfiler);
+    }
+
+    void GolaRenderer::runResizeBenchmark() {
+        assert(!isFrameStarted && "Can't run the resize benchmark while a frame is in progress");
+        static constexpr int ITERATIONS = 20;
+        const VkExtent2D extent = golaSwapChain->getSwapChainExtent();
+
+        // 每次: 重建交换链, 再像重建后的第一帧一样编译场景 pass (交换链图像 + 临时深度图)
+        auto measure = [&](bool useDynamicRendering) {
+            GolaRenderGraph graph{golaDevice, useDynamicRendering};
+            float totalMs = 0.0f;
+            float maxMs = 0.0f;
+            for (int i = 0; i < ITERATIONS; i++) {
+                const auto startTime = std::chrono::high_resolution_clock::now();
+                rebuildSwapChain(extent, useDynamicRendering);
+                graph.clearCache();
+                graph.reset();
+
+                GolaRenderGraphImageDesc colorDesc{};
+                colorDesc.format = golaSwapChain->getSwapChainImageFormat();
+                colorDesc.extent = extent;
+                GolaRenderGraphResource color = graph.importImage(
+                    "swap chain", golaSwapChain->getImage(0), golaSwapChain->getImageView(0), colorDesc,
+                    VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                    VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+                graph.markOutput(color);
+                graph.addPass("scene", GolaRenderGraph::PassType::Graphics,
+                              [&](GolaRenderGraph::PassBuilder &builder) {
+                                  const VkClearColorValue clearColor{{0.01f, 0.01f, 0.01f, 1.0f}};
+                                  const VkClearDepthStencilValue clearDepth{1.0f, 0};
+                                  builder.writeColor(color, &clearColor);
+                                  builder.writeDepth(
+                                      builder.createImage("depth", {golaSwapChain->getDepthFormat(), extent}),
+                                      &clearDepth);
+                              },
+                              [](GolaRenderGraph::PassContext &) {
+                              });
+                graph.compile();
+
+                const float elapsedMs = std::chrono::duration<float, std::chrono::milliseconds::period>(
+                    std::chrono::high_resolution_clock::now() - startTime).count();
+                totalMs += elapsedMs;
+                maxMs = std::max(maxMs, elapsedMs);
+            }
+            return std::make_pair(totalMs / ITERATIONS, maxMs);
+        };
+
+        const size_t imageCount = golaSwapChain->imageCount();
+        const auto [renderPassMs, renderPassMaxMs] = measure(false);
+        std::print("[DEBUG] Resize benchmark ({} recreations at {}x{}, {} swap chain images)\n", ITERATIONS,
+                   extent.width, extent.height, imageCount);
+        std::print("[DEBUG]   render pass + {} depth images and framebuffers: avg {:.3f} ms, max {:.3f} ms\n",
+                   imageCount, renderPassMs, renderPassMaxMs);
+        if (golaDevice.getFeatures().dynamicRendering) {
+            const auto [dynamicMs, dynamicMaxMs] = measure(true);
+            std::print("[DEBUG]   dynamic rendering: avg {:.3f} ms, max {:.3f} ms, {:.1f}x faster\n", dynamicMs,
+                       dynamicMaxMs, dynamicMs > 0.0f ? renderPassMs / dynamicMs : 0.0f);
+        } else {
+            std::print("[DEBUG]   dynamic rendering: not supported by the device\n");
+        }
+        std::print("[DEBUG]   (pipelines and ImGui are not recreated in either mode)\n");
+
+        rebuildSwapChain(extent, dynamicRendering);
+    }
+
+    void GolaRenderer::startResizeStorm() {
+        if (resizeStorm) {
+            std::print("[DEBUG] Resize storm is already running\n");
+            return;
+        }
+        resizeStorm = std::make_unique<ResizeStorm>();
+        // 窗口尺寸以屏幕坐标计, 高 DPI 下与 framebuffer 的像素尺寸不同
+        glfwGetWindowSize(golaWindow.getGLFWwindow(), &resizeStorm->windowWidth, &resizeStorm->windowHeight);
+        resizeStorm->startRecreations = swapChainRecreations;
+        resizeStorm->lastFrameTime = std::chrono::steady_clock::now();
+    }
+
+    void GolaRenderer::updateResizeStorm() {
+        ResizeStorm &storm = *resizeStorm;
+        const auto now = std::chrono::steady_clock::now();
+        const float frameMs = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            now - storm.lastFrameTime).count();
+        storm.lastFrameTime = now;
+        // 第一帧的时间里还没有发生过调整
+        if (storm.frameCount++ > 0) {
+            storm.totalMs += frameMs;
+            storm.maxFrameMs = std::max(storm.maxFrameMs, frameMs);
+            if (frameMs > GolaPipelineCompiler::HITCH_FRAME_TIME * 1000.0f) {
+                storm.hitchFrames++;
+            }
+        }
+
+        if (storm.frameCount <= RESIZE_STORM_FRAMES) {
+            // 在原尺寸和 3/4 尺寸之间交替, 每帧都让窗口系统发出一次调整
+            const bool shrink = storm.frameCount % 2 == 1;
+            glfwSetWindowSize(golaWindow.getGLFWwindow(), shrink ? storm.windowWidth * 3 / 4 : storm.windowWidth,
+                              shrink ? storm.windowHeight * 3 / 4 : storm.windowHeight);
+            return;
+        }
+
+        glfwSetWindowSize(golaWindow.getGLFWwindow(), storm.windowWidth, storm.windowHeight);
+        const uint32_t measuredFrames = storm.frameCount - 1;
+        std::print("[DEBUG] Resize storm ({} frames, {} swap chain recreations)\n", measuredFrames,
+                   swapChainRecreations - storm.startRecreations);
+        std::print("[DEBUG]   frame time: {:.2f} ms average, {:.2f} ms worst, {} frames over {:.1f} ms: {}\n",
+                   measuredFrames > 0 ? storm.totalMs / static_cast<float>(measuredFrames) : 0.0f, storm.maxFrameMs,
+                   storm.hitchFrames, GolaPipelineCompiler::HITCH_FRAME_TIME * 1000.0f,
+                   storm.hitchFrames == 0 ? "PASS" : "FAIL");
+        std::print("[DEBUG]   {} objects waiting for deferred destruction\n",
+                   golaDevice.getDeletionQueue().getPendingCount());
+        resizeStorm.reset();
+    }
+
+    void GolaRenderer::startPresentBenchmark() {
+        if (presentBenchmark) {
+            std::print("[DEBUG] Present benchmark is already running\n");
+            return;
+        }
+        presentBenchmark = std::make_unique<PresentBenchmark>();
+        const std::vector<VkPresentModeKHR> supportedModes = golaDevice.getSwapChainSupport().presentModes;
+        for (VkPresentModeKHR mode: {VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+                                     VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR}) {
+            if (std::find(supportedModes.begin(), supportedModes.end(), mode) == supportedModes.end()) {
+                continue;
+            }
+            for (uint32_t framesInFlight = 1; framesInFlight <= GolaSwapChain::MAX_FRAMES_IN_FLIGHT;
+                 framesInFlight++) {
+                presentBenchmark->configurations.push_back({mode, framesInFlight, 0.0f});
+            }
+            // 不等待垂直同步的模式加上帧率限制, 对比 CPU 先于 GPU 限速时的延迟
+            if (mode == VK_PRESENT_MODE_MAILBOX_KHR || mode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
+                presentBenchmark->configurations.push_back({mode, 1, 60.0f});
+            }
+        }
+        std::print("[DEBUG] Present benchmark ({} configurations, {} frames each)\n",
+                   presentBenchmark->configurations.size(), PRESENT_BENCHMARK_FRAMES);
+    }
+
+    void GolaRenderer::updatePresentBenchmark(float latencyMs, float frameMs) {
+        PresentBenchmark &benchmark = *presentBenchmark;
+        // 本帧可能还是用上一个配置提交的, 交换链切换之后才开始计数
+        const GolaPresentSettings &configuration = benchmark.configurations[benchmark.current];
+        if (appliedSettings != configuration) {
+            return;
+        }
+        if (benchmark.frameCount++ >= PRESENT_BENCHMARK_WARMUP_FRAMES) {
+            benchmark.totalLatencyMs += latencyMs;
+            benchmark.maxLatencyMs = std::max(benchmark.maxLatencyMs, latencyMs);
+            benchmark.totalFrameMs += frameMs;
+        }
+        if (benchmark.frameCount < PRESENT_BENCHMARK_WARMUP_FRAMES + PRESENT_BENCHMARK_FRAMES) {
+            return;
+        }
+
+        const float frames = static_cast<float>(PRESENT_BENCHMARK_FRAMES);
+        std::print("[DEBUG]   {:<12} {} in flight, {:<8}: input->submit avg {:6.2f} ms, max {:6.2f} ms, "
+                   "frame {:6.2f} ms\n",
+                   GolaSwapChain::getPresentModeName(golaSwapChain->getPresentMode()),
+                   golaSwapChain->getFramesInFlight(),
+                   configuration.frameRateLimit > 0.0f
+                       ? std::to_string(static_cast<int>(configuration.frameRateLimit)) + " fps"
+                       : std::string{"no limit"},
+                   benchmark.totalLatencyMs / frames, benchmark.maxLatencyMs, benchmark.totalFrameMs / frames);
+
+        benchmark.current++;
+        benchmark.frameCount = 0;
+        benchmark.totalLatencyMs = 0.0f;
+        benchmark.maxLatencyMs = 0.0f;
+        benchmark.totalFrameMs = 0.0f;
+        if (benchmark.current == benchmark.configurations.size()) {
+            // 下一次 waitForNextFrame 恢复 presentSettings
+            presentBenchmark.reset();
+        }
+    }
 }
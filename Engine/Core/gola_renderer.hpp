@@ -1,17 +1,30 @@
 #pragma once
 
+#include "gola_command_recorder.hpp"
 #include "gola_device.hpp"
+#include "gola_frame_limiter.hpp"
+#include "gola_gpu_profiler.hpp"
+#include "gola_pipeline.hpp"
+#include "gola_render_graph.hpp"
 #include "gola_swap_chain.hpp"
 #include "../Window/gola_window.hpp"
 
 // std
+#include <array>
 #include <cassert>
+#include <chrono>
 #include <memory>
 #include <vector>
 
 namespace gola {
     class GolaRenderer {
     public:
+        static constexpr uint32_t RESIZE_STORM_FRAMES = 120;
+        static constexpr uint32_t LATENCY_WINDOW_FRAMES = 60;
+        // 基准测试中每种配置先丢弃的帧数 (重建后的队列需要填满) 和测量的帧数
+        static constexpr uint32_t PRESENT_BENCHMARK_WARMUP_FRAMES = 30;
+        static constexpr uint32_t PRESENT_BENCHMARK_FRAMES = 180;
+
         GolaRenderer(GolaWindow &window, GolaDevice &device);
 
         ~GolaRenderer();
@@ -20,10 +33,18 @@ namespace gola {
 
         GolaRenderer &operator=(const GolaRenderer &) = delete;
 
-        VkRenderPass getSwapChainRenderPass() const { return golaSwapChain->getRenderPass(); }
+        // 交换链图像的渲染目标, 管线和 ImGui 按它创建. 动态渲染时只有格式, 否则是交换链的 render pass
+        // (重建时被新交换链接管), 两种情况下交换链重建后都保持有效
+        GolaRenderTarget getSwapChainRenderTarget() const;
+        bool isDynamicRendering() const { return dynamicRendering; }
         GolaSwapChain &getSwapChain() { return *golaSwapChain; }
         float getAspectRatio() const { return golaSwapChain->extentAspectRatio(); }
         bool isFrameInProgress() const { return isFrameStarted; }
+        GolaCommandRecorder &getCommandRecorder() { return commandRecorder; }
+        // 每帧在 beginFrame 中重置, 本帧的 pass 声明完之后调用 executeRenderGraph
+        GolaRenderGraph &getRenderGraph() { return renderGraph; }
+        // 每帧的命令都在 "frame" 作用域里, executeRenderGraph 给每个 pass 一个作用域
+        GolaGpuProfiler &getGpuProfiler() { return gpuProfiler; }
 
         VkCommandBuffer getCurrentCommandBuffer() const {
             assert(isFrameStarted && "Cannot get command buffer when frame not in progress");
@@ -35,14 +56,48 @@ namespace gola {
             return currentFrameIndex;
         }
 
+        // Stores the presentation policy to use from the next waitForNextFrame(). Changing the present mode or
+        // the frames in flight recreates the swap chain; ignored while the present benchmark is running.
+        void setPresentSettings(const GolaPresentSettings &settings) { presentSettings = settings; }
+        const GolaPresentSettings &getPresentSettings() const { return presentSettings; }
+        const GolaPresentStats &getPresentStats() const { return presentStats; }
+
+        // Called once per frame before polling input: applies pending present settings, waits for the frame
+        // limiter and starts the input-to-submit latency measurement of the next frame.
+        void waitForNextFrame();
+
         VkCommandBuffer beginFrame();
 
         void endFrame();
 
-        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // 只在 render pass 模式下可用. contents 为 VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS 时, render pass 内的命令必须通过
+        // getCommandRecorder() 录制到 secondary command buffer
+        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer,
+                                      VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+        // 把本帧获取的交换链图像导入渲染图并标记为输出, 执行完后转换为 PRESENT_SRC_KHR
+        GolaRenderGraphResource importSwapChainImage();
+
+        // 录制渲染图中所有未被剔除的 pass, 代替 begin/endSwapChainRenderPass
+        void executeRenderGraph(VkCommandBuffer commandBuffer);
+
+        // Recreates the swap chain (at the current extent) and compiles the scene pass of a fresh render graph
+        // several times, first with a render pass and framebuffers, then with dynamic rendering if supported,
+        // and prints the latency of each. Must be called between frames; the swap chain is left in the
+        // renderer's own mode.
+        void runResizeBenchmark();
+
+        // Resizes the window every frame for RESIZE_STORM_FRAMES frames while the app keeps rendering, then
+        // restores its size and prints the worst frame time and the number of swap chain recreations.
+        void startResizeStorm();
+
+        // Renders PRESENT_BENCHMARK_FRAMES frames with every supported present mode and 1 to
+        // MAX_FRAMES_IN_FLIGHT frames in flight, plus the non-FIFO modes with a 60 fps limit, while the app keeps
+        // rendering. Prints the input-to-submit latency and frame time of each, then restores the settings.
+        void startPresentBenchmark();
+
     private:
         void createCommandBuffers();
 
@@ -50,13 +105,65 @@ namespace gola {
 
         void recreateSwapChain();
 
+        // 用 extent 新建交换链, 旧交换链作为 oldSwapchain, 不等待 GPU; 旧交换链交给延迟销毁队列
+        void rebuildSwapChain(VkExtent2D extent, bool useDynamicRendering);
+
+        // 每帧在 beginFrame 开始时调用, 记录上一帧的时间并调整窗口尺寸
+        void updateResizeStorm();
+
+        // 在 endFrame 提交之后调用, latencyMs 是本帧的输入到提交延迟
+        void recordPresentLatency(float latencyMs);
+
+        void updatePresentBenchmark(float latencyMs, float frameMs);
+
         GolaWindow &golaWindow;
         GolaDevice &golaDevice;
+        bool dynamicRendering;
         std::unique_ptr<GolaSwapChain> golaSwapChain;
+        // 每个 frame in flight 一个 transient pool, 帧开始时整体重置
+        std::array<VkCommandPool, GolaSwapChain::MAX_FRAMES_IN_FLIGHT> commandPools{};
         std::vector<VkCommandBuffer> commandBuffers;
+        GolaCommandRecorder commandRecorder;
+        GolaRenderGraph renderGraph;
+        GolaGpuProfiler gpuProfiler;
 
         uint32_t currentImageIndex;
         int currentFrameIndex{0};
         bool isFrameStarted{false};
+        uint32_t swapChainRecreations = 0;
+
+        // 请求的设置, 以及当前交换链实际使用的设置
+        GolaPresentSettings presentSettings{};
+        GolaPresentSettings appliedSettings{};
+        GolaFrameLimiter frameLimiter;
+        std::chrono::steady_clock::time_point inputTime{};
+        std::chrono::steady_clock::time_point lastSubmitTime{};
+        GolaPresentStats presentStats{};
+        uint32_t latencyFrames = 0;
+        float latencyTotalMs = 0.0f;
+        float latencyMaxMs = 0.0f;
+        float frameTotalMs = 0.0f;
+
+        struct ResizeStorm {
+            int windowWidth = 0;
+            int windowHeight = 0;
+            uint32_t startRecreations = 0;
+            std::chrono::steady_clock::time_point lastFrameTime;
+            uint32_t frameCount = 0;
+            uint32_t hitchFrames = 0;
+            float totalMs = 0.0f;
+            float maxFrameMs = 0.0f;
+        };
+        std::unique_ptr<ResizeStorm> resizeStorm;
+
+        struct PresentBenchmark {
+            std::vector<GolaPresentSettings> configurations;
+            size_t current = 0;
+            uint32_t frameCount = 0;
+            float totalLatencyMs = 0.0f;
+            float maxLatencyMs = 0.0f;
+            float totalFrameMs = 0.0f;
+        };
+        std::unique_ptr<PresentBenchmark> presentBenchmark;
     };
 } // namespace gola
@@ -0,0 +1,213 @@
+#include "gola_staging_ring.hpp"
+
+#include "gola_device.hpp"
+#include "gola_timeline.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace gola {
+    GolaStagingRing::GolaStagingRing(GolaDevice &device, VkDeviceSize capacity)
+        : device{device}, capacity{capacity} {
+        createStagingBuffer();
+        createCommandPool();
+    }
+
+    GolaStagingRing::~GolaStagingRing() {
+        waitIdle();
+
+        vkDestroyCommandPool(device.device(), commandPool, nullptr);
+
+        device.destroyBuffer(stagingBuffer, stagingAllocation);
+    }
+
+    void GolaStagingRing::createStagingBuffer() {
+        device.createBuffer(
+            capacity,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            stagingBuffer,
+            stagingAllocation);
+
+        // 子分配器对 HOST_VISIBLE 内存做了持久映射
+        mapped = static_cast<char *>(stagingAllocation.mapped);
+    }
+
+    void GolaStagingRing::createCommandPool() {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = device.findPhysicalQueueFamilies().graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create staging command pool!");
+        }
+    }
+
+    void GolaStagingRing::upload(VkBuffer dstBuffer, const void *data, VkDeviceSize size, VkDeviceSize dstOffset) {
+        auto src = static_cast<const char *>(data);
+
+        // 大于整个环的数据按容量切块, 每块单独占用一次环
+        while (size > 0) {
+            VkDeviceSize chunk = std::min(size, capacity);
+            VkDeviceSize offset = reserve(chunk);
+
+            std::memcpy(mapped + offset, src, static_cast<size_t>(chunk));
+
+            VkBufferCopy region{};
+            region.srcOffset = offset;
+            region.dstOffset = dstOffset;
+            region.size = chunk;
+            pendingCopies.push_back({dstBuffer, region});
+
+            src += chunk;
+            dstOffset += chunk;
+            size -= chunk;
+        }
+    }
+
+    VkDeviceSize GolaStagingRing::reserve(VkDeviceSize size) {
+        VkDeviceSize offset = (head + UPLOAD_ALIGNMENT - 1) & ~(UPLOAD_ALIGNMENT - 1);
+
+        // 剩余的连续空间不够: 先提交当前批次, 再从头开始 (每个批次在环内都是连续的)
+        if (offset + size > capacity) {
+            flush();
+            offset = 0;
+            head = 0;
+            batchBegin = 0;
+        }
+
+        // 等待仍占用目标区域的旧批次完成
+        retireCompletedBatches();
+        auto overlapsInFlight = [&]() {
+            return std::any_of(inFlightBatches.begin(), inFlightBatches.end(), [&](const InFlightBatch &batch) {
+                return offset < batch.end && batch.begin < offset + size;
+            });
+        };
+        while (overlapsInFlight()) {
+            retireOldestBatch();
+        }
+
+        head = offset + size;
+        return offset;
+    }
+
+    void GolaStagingRing::flush() {
+        if (pendingCopies.empty()) {
+            batchBegin = head;
+            return;
+        }
+
+        VkCommandBuffer commandBuffer = acquireCommandBuffer();
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+        // 目标区间可能刚被释放又被复用 (例如 mesh arena), 拷贝前等待之前提交的所有读取完成
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            0,
+            nullptr);
+
+        // 相邻且目标相同的拷贝合并成一次 vkCmdCopyBuffer
+        std::vector<VkBufferCopy> regions;
+        size_t i = 0;
+        while (i < pendingCopies.size()) {
+            VkBuffer dstBuffer = pendingCopies[i].dstBuffer;
+            regions.clear();
+            while (i < pendingCopies.size() && pendingCopies[i].dstBuffer == dstBuffer) {
+                regions.push_back(pendingCopies[i].region);
+                i++;
+            }
+            vkCmdCopyBuffer(
+                commandBuffer,
+                stagingBuffer,
+                dstBuffer,
+                static_cast<uint32_t>(regions.size()),
+                regions.data());
+        }
+
+        // Make the copies visible to every later consumer on this queue.
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            1,
+            &barrier,
+            0,
+            nullptr,
+            0,
+            nullptr);
+
+        vkEndCommandBuffer(commandBuffer);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        const uint64_t timelineValue = device.getGraphicsTimeline().submit(submitInfo);
+
+        inFlightBatches.push_back({timelineValue, commandBuffer, batchBegin, head});
+        pendingCopies.clear();
+        batchBegin = head;
+    }
+
+    void GolaStagingRing::waitIdle() {
+        flush();
+        while (!inFlightBatches.empty()) {
+            retireOldestBatch();
+        }
+    }
+
+    void GolaStagingRing::retireOldestBatch() {
+        InFlightBatch batch = inFlightBatches.front();
+        inFlightBatches.pop_front();
+
+        device.getGraphicsTimeline().wait(batch.timelineValue);
+        freeCommandBuffers.push_back(batch.commandBuffer);
+    }
+
+    void GolaStagingRing::retireCompletedBatches() {
+        while (!inFlightBatches.empty() &&
+               device.getGraphicsTimeline().isComplete(inFlightBatches.front().timelineValue)) {
+            retireOldestBatch();
+        }
+    }
+
+    VkCommandBuffer GolaStagingRing::acquireCommandBuffer() {
+        if (!freeCommandBuffers.empty()) {
+            VkCommandBuffer commandBuffer = freeCommandBuffers.back();
+            freeCommandBuffers.pop_back();
+            vkResetCommandBuffer(commandBuffer, 0);
+            return commandBuffer;
+        }
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = commandPool;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(device.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate staging command buffer!");
+        }
+        return commandBuffer;
+    }
+}
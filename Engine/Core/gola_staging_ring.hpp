@@ -0,0 +1,89 @@
+#pragma once
+
+#include "gola_allocator.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <deque>
+#include <vector>
+
+namespace gola {
+    class GolaDevice;
+
+    /*
+     * 持久映射的暂存环形缓冲区 (persistently mapped staging ring)
+     * upload() 只做 memcpy 并记录一次拷贝, flush() 把所有待处理的拷贝录制进一个命令缓冲一次提交,
+     * 不等待队列空闲; 只有当环绕回来的空间仍被 GPU 使用时才会等待对应批次在图形队列时间线上的值.
+     */
+    class GolaStagingRing {
+    public:
+        static constexpr VkDeviceSize DEFAULT_CAPACITY = 32 * 1024 * 1024;
+        static constexpr VkDeviceSize UPLOAD_ALIGNMENT = 16;
+
+        GolaStagingRing(GolaDevice &device, VkDeviceSize capacity = DEFAULT_CAPACITY);
+
+        ~GolaStagingRing();
+
+        GolaStagingRing(const GolaStagingRing &) = delete;
+
+        GolaStagingRing &operator=(const GolaStagingRing &) = delete;
+
+        // Queue a copy of `size` bytes from `data` into dstBuffer at dstOffset.
+        // The data is copied into the ring immediately, so the caller may free it on return.
+        void upload(VkBuffer dstBuffer, const void *data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+
+        // Submit every pending copy in a single batch. Does not wait for completion:
+        // later submissions on the same queue are ordered after the copies by a barrier.
+        void flush();
+
+        // Block until every submitted batch has finished on the GPU.
+        void waitIdle();
+
+        bool hasPendingUploads() const { return !pendingCopies.empty(); }
+        VkDeviceSize getCapacity() const { return capacity; }
+
+    private:
+        struct PendingCopy {
+            VkBuffer dstBuffer;
+            VkBufferCopy region;
+        };
+
+        struct InFlightBatch {
+            // GolaDevice::getGraphicsTimeline() 上的值
+            uint64_t timelineValue;
+            VkCommandBuffer commandBuffer;
+            VkDeviceSize begin;
+            VkDeviceSize end;
+        };
+
+        void createStagingBuffer();
+
+        void createCommandPool();
+
+        VkDeviceSize reserve(VkDeviceSize size);
+
+        void retireOldestBatch();
+
+        void retireCompletedBatches();
+
+        VkCommandBuffer acquireCommandBuffer();
+
+        GolaDevice &device;
+        VkDeviceSize capacity;
+
+        VkBuffer stagingBuffer = VK_NULL_HANDLE;
+        GolaAllocation stagingAllocation{};
+        char *mapped = nullptr;
+
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+
+        // [batchBegin, head) is the region written since the last flush
+        VkDeviceSize head = 0;
+        VkDeviceSize batchBegin = 0;
+        std::vector<PendingCopy> pendingCopies;
+
+        std::deque<InFlightBatch> inFlightBatches;
+        std::vector<VkCommandBuffer> freeCommandBuffers;
+    };
+}
@@ -1,5 +1,9 @@
 #include "gola_swap_chain.hpp"
 
+#include "gola_pipeline_registry.hpp"
+#include "gola_timeline.hpp"
+
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <cstring>
@@ -9,14 +13,35 @@
 #include <stdexcept>
 
 namespace gola {
-    GolaSwapChain::GolaSwapChain(GolaDevice &deviceRef, VkExtent2D extent)
-        : device{deviceRef}, windowExtent{extent}, swapChainExtent{0, 0}, swapChainImageFormat(VK_FORMAT_UNDEFINED), swapChainDepthFormat(VK_FORMAT_UNDEFINED), renderPass(VK_NULL_HANDLE), swapChain(VK_NULL_HANDLE) {
+    static uint32_t clampFramesInFlight(uint32_t framesInFlight) {
+        return std::clamp(framesInFlight, 1u, static_cast<uint32_t>(GolaSwapChain::MAX_FRAMES_IN_FLIGHT));
+    }
+
+    GolaSwapChain::GolaSwapChain(GolaDevice &deviceRef, VkExtent2D extent, const GolaPresentSettings &settings,
+                                 bool dynamicRendering)
+        : swapChainImageFormat(VK_FORMAT_UNDEFINED), swapChainDepthFormat(VK_FORMAT_UNDEFINED), swapChainExtent{0, 0},
+          dynamicRendering(dynamicRendering), requestedPresentMode(settings.presentMode),
+          framesInFlight(clampFramesInFlight(settings.framesInFlight)), renderPass(VK_NULL_HANDLE), device{deviceRef},
+          windowExtent{extent}, swapChain(VK_NULL_HANDLE) {
         init();
     }
 
     GolaSwapChain::GolaSwapChain(
-        GolaDevice &deviceRef, VkExtent2D extent, std::shared_ptr<GolaSwapChain> previous)
-        : device{deviceRef}, windowExtent{extent}, oldSwapChain{previous}, swapChainExtent{0, 0}, swapChainImageFormat(VK_FORMAT_UNDEFINED), swapChainDepthFormat(VK_FORMAT_UNDEFINED), renderPass(VK_NULL_HANDLE), swapChain(VK_NULL_HANDLE) {
+        GolaDevice &deviceRef, VkExtent2D extent, std::shared_ptr<GolaSwapChain> previous,
+        const GolaPresentSettings &settings, bool dynamicRendering)
+        : swapChainImageFormat(VK_FORMAT_UNDEFINED), swapChainDepthFormat(VK_FORMAT_UNDEFINED), swapChainExtent{0, 0},
+          dynamicRendering(dynamicRendering), requestedPresentMode(settings.presentMode),
+          framesInFlight(clampFramesInFlight(settings.framesInFlight)), renderPass(VK_NULL_HANDLE), device{deviceRef},
+          windowExtent{extent}, swapChain(VK_NULL_HANDLE), oldSwapChain{previous} {
+        // 重建时没有等待 GPU 空闲: 继续使用旧交换链的 frame slot 和时间线值, 帧节奏不因重建而中断
+        frameTimelineValues = previous->frameTimelineValues;
+        currentFrame = previous->currentFrame;
+        if (framesInFlight != previous->framesInFlight) {
+            // slot 的划分变了: 每个 slot 都先等待旧交换链上最后提交的一帧, 再从 slot 0 开始
+            const uint64_t lastValue = *std::max_element(frameTimelineValues.begin(), frameTimelineValues.end());
+            frameTimelineValues.fill(lastValue);
+            currentFrame = 0;
+        }
         init();
         oldSwapChain = nullptr;
     }
@@ -24,9 +49,13 @@ namespace gola {
     void GolaSwapChain::init() {
         createSwapChain();
         createImageViews();
-        createRenderPass();
-        createDepthResources();
-        createFramebuffers();
+        swapChainDepthFormat = findDepthFormat();
+        // 动态渲染时 attachment 直接在 vkCmdBeginRendering 中给出, 深度图由渲染图管理
+        if (!dynamicRendering) {
+            createRenderPass();
+            createDepthResources();
+            createFramebuffers();
+        }
         createSyncObjects(); // 确保在所有图像资源创建后再创建同步对象
     }
 
@@ -43,32 +72,30 @@ namespace gola {
 
         for (int i = 0; i < depthImages.size(); i++) {
             vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-            vkDestroyImage(device.device(), depthImages[i], nullptr);
-            vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+            device.destroyImage(depthImages[i], depthImageAllocations[i]);
         }
 
         for (auto framebuffer: swapChainFramebuffers) {
             vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
         }
 
+        if (renderPass != VK_NULL_HANDLE) {
+            device.getPipelineRegistry().unregisterRenderPass(renderPass);
+        }
         vkDestroyRenderPass(device.device(), renderPass, nullptr);
 
         // cleanup synchronization objects
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-            vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
-            vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
-            vkDestroyFence(device.device(), inFlightFences[i], nullptr);
+        for (VkSemaphore semaphore: renderFinishedSemaphores) {
+            vkDestroySemaphore(device.device(), semaphore, nullptr);
+        }
+        for (VkSemaphore semaphore: imageAvailableSemaphores) {
+            vkDestroySemaphore(device.device(), semaphore, nullptr);
         }
     }
 
     VkResult GolaSwapChain::acquireNextImage(uint32_t *imageIndex) {
-        // 等待当前帧的围栏
-        vkWaitForFences(
-            device.device(),
-            1,
-            &inFlightFences[currentFrame],
-            VK_TRUE,
-            std::numeric_limits<uint64_t>::max());
+        // 只等待这个 frame slot 上一次提交的值, 之后提交的帧不受影响
+        device.getGraphicsTimeline().wait(frameTimelineValues[currentFrame]);
 
         VkResult result = vkAcquireNextImageKHR(
             device.device(),
@@ -82,11 +109,8 @@ namespace gola {
     }
 
     VkResult GolaSwapChain::submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex) {
-        if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
-            vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
-        }
-        imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
-
+        // 不需要再等待这张图像上一次的渲染: 它在同一个队列上更早提交, present 已经等待过它,
+        // imageAvailable 信号量保证 presentation engine 已经释放了图像
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
@@ -99,15 +123,11 @@ namespace gola {
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = buffers;
 
-        VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
+        VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[*imageIndex]};
         submitInfo.signalSemaphoreCount = 1;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
-        vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-        if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-            VK_SUCCESS) {
-            throw std::runtime_error("failed to submit draw command buffer!");
-        }
+        frameTimelineValues[currentFrame] = device.getGraphicsTimeline().submit(submitInfo);
 
         VkPresentInfoKHR presentInfo = {};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -123,7 +143,7 @@ namespace gola {
 
         auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
 
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        currentFrame = (currentFrame + 1) % framesInFlight;
 
         return result;
     }
@@ -132,10 +152,11 @@ namespace gola {
         SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
 
         VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-        VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+        presentMode = chooseSwapPresentMode(swapChainSupport.presentModes, requestedPresentMode);
         VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-        uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+        // 图像至少与 frame in flight 一样多, 否则获取图像会比帧节奏先阻塞
+        uint32_t imageCount = std::max(swapChainSupport.capabilities.minImageCount + 1, framesInFlight);
         if (swapChainSupport.capabilities.maxImageCount > 0 &&
             imageCount > swapChainSupport.capabilities.maxImageCount) {
             imageCount = swapChainSupport.capabilities.maxImageCount;
@@ -213,6 +234,15 @@ namespace gola {
 
 
     void GolaSwapChain::createRenderPass() {
+        // 格式不变时 render pass 不变, 直接接管旧交换链的, 已经用它创建的管线和 ImGui 不受影响
+        if (oldSwapChain != nullptr && oldSwapChain->renderPass != VK_NULL_HANDLE &&
+            oldSwapChain->swapChainImageFormat == swapChainImageFormat &&
+            oldSwapChain->swapChainDepthFormat == swapChainDepthFormat) {
+            renderPass = oldSwapChain->renderPass;
+            oldSwapChain->renderPass = VK_NULL_HANDLE;
+            return;
+        }
+
         VkAttachmentDescription depthAttachment{};
         depthAttachment.format = findDepthFormat();
         depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -271,6 +301,7 @@ namespace gola {
         if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
             throw std::runtime_error("failed to create render pass!");
         }
+        device.getPipelineRegistry().registerRenderPass(renderPass, renderPassInfo);
     }
 
     void GolaSwapChain::createFramebuffers() {
@@ -305,7 +336,7 @@ namespace gola {
         VkExtent2D swapChainExtent = getSwapChainExtent();
 
         depthImages.resize(imageCount());
-        depthImageMemorys.resize(imageCount());
+        depthImageAllocations.resize(imageCount());
         depthImageViews.resize(imageCount());
 
         for (int i = 0; i < depthImages.size(); i++) {
@@ -329,7 +360,7 @@ namespace gola {
                 imageInfo,
                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                 depthImages[i],
-                depthImageMemorys[i]);
+                depthImageAllocations[i]);
 
             VkImageViewCreateInfo viewInfo{};
             viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -349,27 +380,22 @@ namespace gola {
     }
 
     void GolaSwapChain::createSyncObjects() {
-        imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-        imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+        imageAvailableSemaphores.resize(framesInFlight);
+        renderFinishedSemaphores.resize(imageCount());
 
         VkSemaphoreCreateInfo semaphoreInfo = {};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-        VkFenceCreateInfo fenceInfo = {};
-        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-            if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
-                VK_SUCCESS ||
-                vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
-                VK_SUCCESS ||
-                vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
+        for (VkSemaphore &semaphore: imageAvailableSemaphores) {
+            if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
                 throw std::runtime_error("failed to create synchronization objects for a frame!");
             }
         }
+        for (VkSemaphore &semaphore: renderFinishedSemaphores) {
+            if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create synchronization objects for an image!");
+            }
+        }
     }
 
     VkSurfaceFormatKHR GolaSwapChain::chooseSwapSurfaceFormat(
@@ -391,37 +417,29 @@ namespace gola {
      * VK_PRESENT_MODE_MAILBOX_KHR 丢弃最老的图像 使用单个元素的队列
      */
     VkPresentModeKHR GolaSwapChain::chooseSwapPresentMode(
-        const std::vector<VkPresentModeKHR> &availablePresentModes) {
-        for (const auto &availablePresentMode: availablePresentModes) {
-            if (availablePresentMode == VK_PRESENT_MODE_FIFO_RELAXED_KHR) {
-                std::cout << "Present mode: Fast V-Sync" << std::endl;
-                return availablePresentMode;
-            }
-        }
-
-        for (const auto& availablePresentMode : availablePresentModes) {
-        	if (availablePresentMode == VK_PRESENT_MODE_FIFO_KHR) {
-        		std::cout << "Present mode: V-Sync" << std::endl;
-        		return availablePresentMode;
-        	}
-        }
-
-        for (const auto& availablePresentMode : availablePresentModes) {
-        	if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-        		std::cout << "Present mode: Mailbox" << std::endl;
-        		return availablePresentMode;
-        	}
+        const std::vector<VkPresentModeKHR> &availablePresentModes, VkPresentModeKHR requestedPresentMode) {
+        VkPresentModeKHR chosen = VK_PRESENT_MODE_FIFO_KHR;
+        if (std::find(availablePresentModes.begin(), availablePresentModes.end(), requestedPresentMode) !=
+            availablePresentModes.end()) {
+            chosen = requestedPresentMode;
         }
+        std::cout << "Present mode: " << getPresentModeName(chosen) << ", " << framesInFlight
+                << " frame(s) in flight" << std::endl;
+        return chosen;
+    }
 
-        for (const auto &availablePresentMode : availablePresentModes) {
-          if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-            std::cout << "Present mode: Immediate" << std::endl;
-            return availablePresentMode;
-          }
+    const char *GolaSwapChain::getPresentModeName(VkPresentModeKHR presentMode) {
+        switch (presentMode) {
+            case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+                return "Fast V-Sync";
+            case VK_PRESENT_MODE_MAILBOX_KHR:
+                return "Mailbox";
+            case VK_PRESENT_MODE_IMMEDIATE_KHR:
+                return "Immediate";
+            case VK_PRESENT_MODE_FIFO_KHR:
+            default:
+                return "V-Sync";
         }
-
-        std::cout << "Present mode: V-Sync" << std::endl;
-        return VK_PRESENT_MODE_FIFO_KHR;
     }
 
     VkExtent2D GolaSwapChain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities) {
@@ -3,19 +3,47 @@
 #include "gola_device.hpp"
 
 #include <vulkan/vulkan.h>
+#include <array>
 #include <memory>
 #include <string>
 #include <vector>
 
 namespace gola {
+    // 运行时的呈现策略. presentMode 和 framesInFlight 改变时 GolaRenderer 重建交换链, 帧率上限不需要重建
+    struct GolaPresentSettings {
+        // 设备不支持时回退到 FIFO (规范保证支持)
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+        // 1 到 GolaSwapChain::MAX_FRAMES_IN_FLIGHT; 越少输入延迟越低, CPU 和 GPU 的重叠也越少
+        uint32_t framesInFlight = 2;
+        // 每秒帧数上限, 0 表示不限制
+        float frameRateLimit = 0.0f;
+
+        bool operator==(const GolaPresentSettings &) const = default;
+    };
+
+    // 最近 GolaRenderer::LATENCY_WINDOW_FRAMES 帧的统计, 输入延迟是采样输入到提交本帧命令之间的时间
+    struct GolaPresentStats {
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+        uint32_t framesInFlight = 0;
+        float averageLatencyMs = 0.0f;
+        float maxLatencyMs = 0.0f;
+        float averageFrameMs = 0.0f;
+    };
+
     class GolaSwapChain {
     public:
-        static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+        // 每帧资源数组的大小; 实际使用的 frame slot 数由 GolaPresentSettings::framesInFlight 决定
+        static constexpr int MAX_FRAMES_IN_FLIGHT = 3;
 
-        GolaSwapChain(GolaDevice &deviceRef, VkExtent2D windowExtent);
+        // dynamicRendering 为 true 时不创建 render pass, 深度图和 framebuffer, 只有交换链图像和同步对象
+        GolaSwapChain(GolaDevice &deviceRef, VkExtent2D windowExtent, const GolaPresentSettings &settings,
+                      bool dynamicRendering);
 
+        // render pass 模式下接管 previous 的 render pass (格式相同时), 用它创建的管线在重建后仍然有效.
+        // 同时接管 previous 的帧状态; previous 可能还在被 GPU 使用, 由调用方延迟销毁
         GolaSwapChain(
-            GolaDevice &deviceRef, VkExtent2D windowExtent, std::shared_ptr<GolaSwapChain> previous);
+            GolaDevice &deviceRef, VkExtent2D windowExtent, std::shared_ptr<GolaSwapChain> previous,
+            const GolaPresentSettings &settings, bool dynamicRendering);
 
         ~GolaSwapChain();
 
@@ -23,14 +51,25 @@ namespace gola {
 
         GolaSwapChain &operator=(const GolaSwapChain &) = delete;
 
+        // 动态渲染时没有 render pass 和 framebuffer
         VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
-        VkRenderPass getRenderPass() { return renderPass; }
+        VkRenderPass getRenderPass() const { return renderPass; }
+        bool isDynamicRendering() const { return dynamicRendering; }
+        VkImage getImage(int index) { return swapChainImages[index]; }
         VkImageView getImageView(int index) { return swapChainImageViews[index]; }
         size_t imageCount() { return swapChainImages.size(); }
-        VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
-        VkExtent2D getSwapChainExtent() { return swapChainExtent; }
+        VkFormat getSwapChainImageFormat() const { return swapChainImageFormat; }
+        VkFormat getDepthFormat() const { return swapChainDepthFormat; }
+        VkExtent2D getSwapChainExtent() const { return swapChainExtent; }
         uint32_t width() { return swapChainExtent.width; }
         uint32_t height() { return swapChainExtent.height; }
+        // 实际使用的呈现模式, 可能与请求的不同
+        VkPresentModeKHR getPresentMode() const { return presentMode; }
+        uint32_t getFramesInFlight() const { return framesInFlight; }
+        // 下一次 acquireNextImage 使用的 frame slot, 每帧资源按它索引
+        uint32_t getFrameIndex() const { return static_cast<uint32_t>(currentFrame); }
+
+        static const char *getPresentModeName(VkPresentModeKHR presentMode);
 
         float extentAspectRatio() {
             return static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height);
@@ -38,8 +77,10 @@ namespace gola {
 
         VkFormat findDepthFormat();
 
+        // 等待这个 frame slot 上一次提交的时间线值, 然后获取下一张图像
         VkResult acquireNextImage(uint32_t *imageIndex);
 
+        // 通过设备的图形队列时间线提交, 记下得到的值供 MAX_FRAMES_IN_FLIGHT 帧之后等待
         VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
 
         bool compareSwapFormats(const GolaSwapChain &swapChain) const {
@@ -47,9 +88,6 @@ namespace gola {
                    swapChain.swapChainImageFormat == swapChainImageFormat;
         }
 
-        void setImagesInFlightFence(uint32_t imageIndex, VkFence fence) { imagesInFlight[imageIndex] = fence; }
-        VkFence getInFlightFence(uint32_t imageIndex) { return inFlightFences[imageIndex]; }
-
     private:
         void init();
 
@@ -70,7 +108,7 @@ namespace gola {
             const std::vector<VkSurfaceFormatKHR> &availableFormats);
 
         VkPresentModeKHR chooseSwapPresentMode(
-            const std::vector<VkPresentModeKHR> &availablePresentModes);
+            const std::vector<VkPresentModeKHR> &availablePresentModes, VkPresentModeKHR requestedPresentMode);
 
         VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities);
 
@@ -78,11 +116,15 @@ namespace gola {
         VkFormat swapChainDepthFormat;
         VkExtent2D swapChainExtent;
 
+        bool dynamicRendering;
+        VkPresentModeKHR requestedPresentMode;
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+        uint32_t framesInFlight;
         std::vector<VkFramebuffer> swapChainFramebuffers;
         VkRenderPass renderPass;
 
         std::vector<VkImage> depthImages;
-        std::vector<VkDeviceMemory> depthImageMemorys;
+        std::vector<GolaAllocation> depthImageAllocations;
         std::vector<VkImageView> depthImageViews;
         std::vector<VkImage> swapChainImages;
         std::vector<VkImageView> swapChainImageViews;
@@ -93,10 +135,11 @@ namespace gola {
         VkSwapchainKHR swapChain;
         std::shared_ptr<GolaSwapChain> oldSwapChain;
 
+        // 每个使用中的 frame slot 一个; 等待 slot 的时间线值之后, 上一次等待它的提交已经完成, 可以重新使用
         std::vector<VkSemaphore> imageAvailableSemaphores;
+        // 每个交换链图像一个, 同一张图像再次被获取时上一次 present 已经不再等待它
         std::vector<VkSemaphore> renderFinishedSemaphores;
-        std::vector<VkFence> inFlightFences;
-        std::vector<VkFence> imagesInFlight;
+        std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> frameTimelineValues{};
         size_t currentFrame = 0;
     };
 } // namespace gola
@@ -0,0 +1,253 @@
+#include "gola_timeline.hpp"
+
+#include "gola_device.hpp"
+#include "gola_swap_chain.hpp"
+
+// std
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <limits>
+#include <print>
+#include <stdexcept>
+
+namespace gola {
+    GolaTimeline::GolaTimeline(VkDevice device, VkQueue queue) : device{device}, queue{queue} {
+        VkSemaphoreTypeCreateInfo typeInfo{};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &typeInfo;
+        if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create timeline semaphore!");
+        }
+    }
+
+    GolaTimeline::~GolaTimeline() {
+        waitIdle();
+        vkDestroySemaphore(device, semaphore, nullptr);
+    }
+
+    uint64_t GolaTimeline::submit(const VkSubmitInfo &submitInfo, const uint64_t *waitValues, VkFence fence) {
+        assert(submitInfo.pNext == nullptr && "The timeline adds its own VkTimelineSemaphoreSubmitInfo");
+        assert(submitInfo.waitSemaphoreCount <= MAX_SUBMIT_SEMAPHORES &&
+            submitInfo.signalSemaphoreCount < MAX_SUBMIT_SEMAPHORES && "Too many semaphores in one submission");
+
+        // 二值信号量的值会被忽略, 填 0 即可
+        std::array<uint64_t, MAX_SUBMIT_SEMAPHORES> waitSemaphoreValues{};
+        for (uint32_t i = 0; waitValues != nullptr && i < submitInfo.waitSemaphoreCount; i++) {
+            waitSemaphoreValues[i] = waitValues[i];
+        }
+        std::array<VkSemaphore, MAX_SUBMIT_SEMAPHORES> signalSemaphores{};
+        std::array<uint64_t, MAX_SUBMIT_SEMAPHORES> signalSemaphoreValues{};
+        for (uint32_t i = 0; i < submitInfo.signalSemaphoreCount; i++) {
+            signalSemaphores[i] = submitInfo.pSignalSemaphores[i];
+        }
+        const uint32_t signalCount = submitInfo.signalSemaphoreCount + 1;
+        signalSemaphores[signalCount - 1] = semaphore;
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = submitInfo.waitSemaphoreCount;
+        timelineInfo.pWaitSemaphoreValues = waitSemaphoreValues.data();
+        timelineInfo.signalSemaphoreValueCount = signalCount;
+        timelineInfo.pSignalSemaphoreValues = signalSemaphoreValues.data();
+
+        VkSubmitInfo timelineSubmitInfo = submitInfo;
+        timelineSubmitInfo.pNext = &timelineInfo;
+        timelineSubmitInfo.signalSemaphoreCount = signalCount;
+        timelineSubmitInfo.pSignalSemaphores = signalSemaphores.data();
+
+        std::lock_guard lock(submitMutex);
+        const uint64_t value = submittedValue.load(std::memory_order_relaxed) + 1;
+        signalSemaphoreValues[signalCount - 1] = value;
+        if (vkQueueSubmit(queue, 1, &timelineSubmitInfo, fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit to the queue!");
+        }
+        submittedValue.store(value, std::memory_order_release);
+        return value;
+    }
+
+    void GolaTimeline::updateCompletedValue(uint64_t value) {
+        uint64_t current = completedValue.load(std::memory_order_relaxed);
+        while (current < value &&
+               !completedValue.compare_exchange_weak(current, value, std::memory_order_release,
+                                                     std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t GolaTimeline::getCompletedValue() {
+        uint64_t value = 0;
+        if (vkGetSemaphoreCounterValue(device, semaphore, &value) != VK_SUCCESS) {
+            throw std::runtime_error("failed to query timeline semaphore!");
+        }
+        updateCompletedValue(value);
+        return value;
+    }
+
+    bool GolaTimeline::isComplete(uint64_t value) {
+        return value <= completedValue.load(std::memory_order_acquire) || value <= getCompletedValue();
+    }
+
+    void GolaTimeline::wait(uint64_t value) {
+        if (value <= completedValue.load(std::memory_order_acquire)) {
+            return;
+        }
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &semaphore;
+        waitInfo.pValues = &value;
+        if (vkWaitSemaphores(device, &waitInfo, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS) {
+            throw std::runtime_error("failed to wait for timeline semaphore!");
+        }
+        updateCompletedValue(value);
+    }
+
+    void GolaTimeline::runBenchmark(GolaDevice &device) {
+        static constexpr uint32_t FRAME_COUNT = 300;
+        static constexpr uint32_t FRAMES_IN_FLIGHT = GolaPresentSettings{}.framesInFlight;
+        // 交换链图像通常比 frame in flight 多一个
+        static constexpr uint32_t IMAGE_COUNT = FRAMES_IN_FLIGHT + 1;
+        static constexpr VkDeviceSize FILL_SIZE = 16 * 1024 * 1024;
+        // 每帧填充多次, 让 GPU 成为瓶颈, CPU 必须等待
+        static constexpr uint32_t FILLS_PER_FRAME = 16;
+
+        GolaTimeline &timeline = device.getGraphicsTimeline();
+        timeline.waitIdle();
+
+        VkBuffer buffer;
+        GolaAllocation bufferAllocation{};
+        device.createBuffer(FILL_SIZE, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer,
+                            bufferAllocation);
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = device.findPhysicalQueueFamilies().graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        VkCommandPool commandPool;
+        if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create benchmark command pool!");
+        }
+        std::array<VkCommandBuffer, FRAMES_IN_FLIGHT> commandBuffers{};
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = commandPool;
+        allocInfo.commandBufferCount = FRAMES_IN_FLIGHT;
+        if (vkAllocateCommandBuffers(device.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate benchmark command buffers!");
+        }
+
+        // 与真实的帧一样, 等待之后重新录制这一帧的命令
+        auto recordFrame = [&](VkCommandBuffer commandBuffer, uint32_t frame) {
+            vkResetCommandBuffer(commandBuffer, 0);
+            VkCommandBufferBeginInfo beginInfo{};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            vkBeginCommandBuffer(commandBuffer, &beginInfo);
+            for (uint32_t i = 0; i < FILLS_PER_FRAME; i++) {
+                vkCmdFillBuffer(commandBuffer, buffer, 0, VK_WHOLE_SIZE, frame + i);
+            }
+            vkEndCommandBuffer(commandBuffer);
+        };
+
+        using Clock = std::chrono::high_resolution_clock;
+        auto elapsedMicroseconds = [](Clock::time_point start) {
+            return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        };
+        struct Result {
+            double waitMicroseconds = 0.0;
+            uint32_t waitCalls = 0;
+            double frameMicroseconds = 0.0;
+        };
+
+        // 之前的 GolaSwapChain: 每帧一个 fence, 再加上每个交换链图像最近使用的 fence, 每帧 reset 一次
+        Result fenceResult{};
+        {
+            std::array<VkFence, FRAMES_IN_FLIGHT> inFlightFences{};
+            std::array<VkFence, IMAGE_COUNT> imagesInFlight{};
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+            for (VkFence &fence: inFlightFences) {
+                if (vkCreateFence(device.device(), &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create benchmark fence!");
+                }
+            }
+
+            const auto startTime = Clock::now();
+            for (uint32_t frame = 0; frame < FRAME_COUNT; frame++) {
+                const uint32_t slot = frame % FRAMES_IN_FLIGHT;
+                const uint32_t image = frame % IMAGE_COUNT;
+                const auto waitStart = Clock::now();
+                vkWaitForFences(device.device(), 1, &inFlightFences[slot], VK_TRUE,
+                                std::numeric_limits<uint64_t>::max());
+                fenceResult.waitCalls++;
+                if (imagesInFlight[image] != VK_NULL_HANDLE) {
+                    vkWaitForFences(device.device(), 1, &imagesInFlight[image], VK_TRUE,
+                                    std::numeric_limits<uint64_t>::max());
+                    fenceResult.waitCalls++;
+                }
+                imagesInFlight[image] = inFlightFences[slot];
+                vkResetFences(device.device(), 1, &inFlightFences[slot]);
+                fenceResult.waitMicroseconds += elapsedMicroseconds(waitStart);
+
+                recordFrame(commandBuffers[slot], frame);
+                VkSubmitInfo submitInfo{};
+                submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+                submitInfo.commandBufferCount = 1;
+                submitInfo.pCommandBuffers = &commandBuffers[slot];
+                timeline.submit(submitInfo, nullptr, inFlightFences[slot]);
+            }
+            vkWaitForFences(device.device(), FRAMES_IN_FLIGHT, inFlightFences.data(), VK_TRUE,
+                            std::numeric_limits<uint64_t>::max());
+            fenceResult.frameMicroseconds = elapsedMicroseconds(startTime) / FRAME_COUNT;
+            for (VkFence fence: inFlightFences) {
+                vkDestroyFence(device.device(), fence, nullptr);
+            }
+        }
+
+        // GolaSwapChain 现在的做法: 每个 frame slot 记住提交时得到的时间线值, 只等待这一个值
+        Result timelineResult{};
+        {
+            std::array<uint64_t, FRAMES_IN_FLIGHT> frameValues{};
+            const auto startTime = Clock::now();
+            for (uint32_t frame = 0; frame < FRAME_COUNT; frame++) {
+                const uint32_t slot = frame % FRAMES_IN_FLIGHT;
+                const auto waitStart = Clock::now();
+                if (!timeline.isComplete(frameValues[slot])) {
+                    timeline.wait(frameValues[slot]);
+                    timelineResult.waitCalls++;
+                }
+                timelineResult.waitMicroseconds += elapsedMicroseconds(waitStart);
+
+                recordFrame(commandBuffers[slot], frame);
+                VkSubmitInfo submitInfo{};
+                submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+                submitInfo.commandBufferCount = 1;
+                submitInfo.pCommandBuffers = &commandBuffers[slot];
+                frameValues[slot] = timeline.submit(submitInfo);
+            }
+            timeline.waitIdle();
+            timelineResult.frameMicroseconds = elapsedMicroseconds(startTime) / FRAME_COUNT;
+        }
+
+        vkDestroyCommandPool(device.device(), commandPool, nullptr);
+        device.destroyBuffer(buffer, bufferAllocation);
+
+        std::print("[DEBUG] Frame pacing benchmark ({} GPU-bound frames, {} in flight, {} images)\n", FRAME_COUNT,
+                   FRAMES_IN_FLIGHT, IMAGE_COUNT);
+        std::print("[DEBUG]   fences: {:.1f} us CPU wait per frame, {:.2f} wait calls + 1 reset per frame, "
+                   "{:.1f} us per frame\n", fenceResult.waitMicroseconds / FRAME_COUNT,
+                   static_cast<double>(fenceResult.waitCalls) / FRAME_COUNT, fenceResult.frameMicroseconds);
+        std::print("[DEBUG]   timeline: {:.1f} us CPU wait per frame, {:.2f} wait calls per frame, "
+                   "{:.1f} us per frame\n", timelineResult.waitMicroseconds / FRAME_COUNT,
+                   static_cast<double>(timelineResult.waitCalls) / FRAME_COUNT, timelineResult.frameMicroseconds);
+        std::print("[DEBUG]   (GPU-bound, so both wait for roughly the GPU frame time; the difference is the "
+                   "extra waits and resets)\n");
+    }
+}
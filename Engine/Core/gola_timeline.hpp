@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace gola {
+    class GolaDevice;
+
+    /*
+     * 一个队列的时间线信号量 (timeline semaphore). 每次 submit() 都在提交中追加 signal 一个单调递增的值,
+     * 所以队列上的任何工作都可以用一个 uint64_t 标识: 帧节奏, 暂存上传的批次和延迟销毁都记住这个值,
+     * CPU 只等待确实需要的那个值, 不再需要 fence 池和 vkResetFences. 值按提交顺序分配, 等待某个值
+     * 也就等待了它之前提交到这个队列的所有工作.
+     */
+    class GolaTimeline {
+    public:
+        // 一次提交中的二值信号量加上时间线本身的上限
+        static constexpr uint32_t MAX_SUBMIT_SEMAPHORES = 8;
+
+        GolaTimeline(VkDevice device, VkQueue queue);
+
+        ~GolaTimeline();
+
+        GolaTimeline(const GolaTimeline &) = delete;
+
+        GolaTimeline &operator=(const GolaTimeline &) = delete;
+
+        VkSemaphore getHandle() const { return semaphore; }
+        VkQueue getQueue() const { return queue; }
+
+        // Submits submitInfo with the next timeline value appended to its signal semaphores and returns that
+        // value. waitValues, if given, parallels submitInfo.pWaitSemaphores (ignored for binary semaphores) so a
+        // submission can wait on another queue's timeline. Values follow submission order; thread safe.
+        uint64_t submit(const VkSubmitInfo &submitInfo, const uint64_t *waitValues = nullptr,
+                        VkFence fence = VK_NULL_HANDLE);
+
+        // 最近一次 submit() 的值, 还没有提交过时为 0
+        uint64_t getSubmittedValue() const { return submittedValue.load(std::memory_order_acquire); }
+
+        // 查询 GPU 已经完成的值
+        uint64_t getCompletedValue();
+
+        // 先比较缓存的完成值, 不够时再查询信号量
+        bool isComplete(uint64_t value);
+
+        // Blocks until value has been signaled. Returns without a Vulkan call for values known to be complete.
+        void wait(uint64_t value);
+
+        void waitIdle() { wait(getSubmittedValue()); }
+
+        // Runs a GPU-bound synthetic frame loop twice on the graphics queue, paced with a fence per frame plus a
+        // fence per swap chain image and then with this timeline, and prints the CPU wait per frame of each.
+        static void runBenchmark(GolaDevice &device);
+
+    private:
+        void updateCompletedValue(uint64_t value);
+
+        VkDevice device;
+        VkQueue queue;
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+
+        // 保证值的分配顺序与 vkQueueSubmit 的顺序一致, 同时满足队列的外部同步要求
+        std::mutex submitMutex;
+        std::atomic<uint64_t> submittedValue{0};
+        std::atomic<uint64_t> completedValue{0};
+    };
+}
@@ -0,0 +1,121 @@
+#include "gola_transform_system.hpp"
+
+#include "gola_job_system.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <print>
+
+namespace gola {
+    void GolaTransformSystem::update(GolaWorld &world, std::vector<GolaEntity> &changedEntities) {
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        // 1. 收集修改过的实体
+        changedEntities.clear();
+        changedTransforms.clear();
+        world.eachChunk<Transform>([&](uint32_t count, const GolaEntity *entities, Transform *transforms) {
+            for (uint32_t i = 0; i < count; i++) {
+                if (transforms[i].hasChanged()) {
+                    transforms[i].clearChanged();
+                    changedEntities.push_back(entities[i]);
+                    changedTransforms.push_back(&transforms[i]);
+                }
+            }
+        });
+
+        // 2. 只重新计算这些实体的矩阵, 每个线程负责连续的一段: 收集到 SoA, 批量计算, 再写回缓存
+        const size_t changedCount = changedTransforms.size();
+        matrixKernel.resize(static_cast<uint32_t>(changedCount));
+        changedMatrices.resize(changedCount);
+        auto updateRange = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                matrixKernel.setTransform(static_cast<uint32_t>(i), *changedTransforms[i]);
+            }
+            matrixKernel.buildModelMatrices(static_cast<uint32_t>(begin), static_cast<uint32_t>(end),
+                                            changedMatrices.data());
+            for (size_t i = begin; i < end; i++) {
+                changedTransforms[i]->setMatrix(changedMatrices[i]);
+            }
+        };
+
+        // 每段的起点对齐到 SIMD 宽度, 最后一组读取的输入不会越过下一段的起点
+        GolaJobSystem &jobs = GolaJobSystem::get();
+        const auto threadCount = static_cast<uint32_t>(
+            std::min<size_t>(jobs.getThreadCount(), changedCount / PARALLEL_THRESHOLD + 1));
+        jobs.parallelFor(static_cast<uint32_t>(changedCount), threadCount,
+                         [&](uint32_t begin, uint32_t end, uint32_t) { updateRange(begin, end); },
+                         GolaMatrixKernel::SIMD_WIDTH);
+
+        lastUpdateMs = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - startTime).count();
+    }
+
+    void GolaTransformSystem::runBenchmark() {
+        using clock = std::chrono::high_resolution_clock;
+        auto elapsedMs = [](clock::time_point start) {
+            return std::chrono::duration<float, std::chrono::milliseconds::period>(clock::now() - start).count();
+        };
+
+        constexpr uint32_t entityCount = 100'000;
+        constexpr int frameCount = 100;
+        std::print("[DEBUG] Transform benchmark ({} entities, {} frames, {} job threads)\n",
+                   entityCount, frameCount, GolaJobSystem::get().getThreadCount());
+
+        GolaWorld world{};
+        for (uint32_t i = 0; i < entityCount; i++) {
+            Transform transform{};
+            transform.setTranslation(glm::vec3(static_cast<float>(i % 316), 0.0f, static_cast<float>(i / 316)));
+            transform.setRotation(glm::vec3(0.1f * static_cast<float>(i % 7), 0.0f, 0.0f));
+            transform.setScale(glm::vec3(0.2f));
+            world.createEntity(transform);
+        }
+
+        GolaTransformSystem transformSystem{};
+        std::vector<GolaEntity> changedEntities;
+        transformSystem.update(world, changedEntities);
+
+        // 防止编译器把没有使用的矩阵计算优化掉
+        float checksum = 0.0f;
+        auto readMatrices = [&] {
+            world.eachChunk<Transform>([&](uint32_t count, const GolaEntity *, Transform *transforms) {
+                for (uint32_t i = 0; i < count; i++) {
+                    checksum += transforms[i].mat4()[3].x;
+                }
+            });
+        };
+
+        // 旧做法: 每帧为所有实体重新计算矩阵
+        auto start = clock::now();
+        for (int frame = 0; frame < frameCount; frame++) {
+            world.each<Transform>([](GolaEntity, Transform &transform) { transform.updateMatrix(); });
+            readMatrices();
+        }
+        float recomputeMs = elapsedMs(start) / frameCount;
+
+        // 静态实体: 每帧只扫描标志
+        start = clock::now();
+        for (int frame = 0; frame < frameCount; frame++) {
+            transformSystem.update(world, changedEntities);
+            readMatrices();
+        }
+        float staticMs = elapsedMs(start) / frameCount;
+
+        // 所有实体每帧旋转
+        start = clock::now();
+        for (int frame = 0; frame < frameCount; frame++) {
+            world.each<Transform>([](GolaEntity, Transform &transform) {
+                glm::vec3 rotation = transform.getRotation();
+                transform.setRotation(glm::vec3(rotation.x, rotation.y + 0.01f, rotation.z));
+            });
+            transformSystem.update(world, changedEntities);
+            readMatrices();
+        }
+        float animatedMs = elapsedMs(start) / frameCount;
+
+        std::print("[DEBUG]   recompute every frame: {:8.3f} ms/frame\n", recomputeMs);
+        std::print("[DEBUG]   cached, static:        {:8.3f} ms/frame\n", staticMs);
+        std::print("[DEBUG]   cached, animated:      {:8.3f} ms/frame (including setters)\n", animatedMs);
+        std::print("[DEBUG]   (checksum {})\n", checksum);
+    }
+}
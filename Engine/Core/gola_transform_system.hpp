@@ -0,0 +1,38 @@
+#pragma once
+
+#include "gola_components.hpp"
+#include "gola_ecs.hpp"
+#include "gola_matrix_kernel.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace gola {
+    /*
+     * 每帧更新修改过的实体的模型矩阵: 按 chunk 扫描 Transform::hasChanged, 只为这些实体重新计算矩阵,
+     * 用 GolaMatrixKernel 批量 SIMD 计算, 数量较多时分块在多个线程上并行计算. 静态实体每帧只需要检查一次标志.
+     */
+    class GolaTransformSystem {
+    public:
+        // 少于这个数量时单线程更新, 避免启动线程的开销
+        static constexpr uint32_t PARALLEL_THRESHOLD = 4096;
+
+        // Recomputes the matrices of every changed entity and writes the entities to changedEntities
+        // (in world iteration order), so that culling data and GPU buffers can be patched.
+        void update(GolaWorld &world, std::vector<GolaEntity> &changedEntities);
+
+        float getLastUpdateMs() const { return lastUpdateMs; }
+
+        // Compares recomputing every matrix each frame with the cached path for 100k static
+        // and 100k animated objects and prints the timings.
+        static void runBenchmark();
+
+    private:
+        // 重复使用, 避免每帧分配
+        std::vector<Transform *> changedTransforms;
+        std::vector<glm::mat4> changedMatrices;
+        GolaMatrixKernel matrixKernel;
+        float lastUpdateMs = 0.0f;
+    };
+}
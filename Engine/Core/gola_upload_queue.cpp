@@ -0,0 +1,506 @@
+#include "gola_upload_queue.hpp"
+
+#include "gola_device.hpp"
+#include "gola_pipeline_compiler.hpp"
+#include "gola_timeline.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <print>
+#include <stdexcept>
+
+namespace gola {
+    // 上传的资源之后可能被任何阶段读写
+    static constexpr VkAccessFlags CONSUMER_ACCESS = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+    static VkBufferMemoryBarrier bufferBarrier(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+                                               VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+                                               uint32_t srcFamily, uint32_t dstFamily) {
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        barrier.srcQueueFamilyIndex = srcFamily;
+        barrier.dstQueueFamilyIndex = dstFamily;
+        barrier.buffer = buffer;
+        barrier.offset = offset;
+        barrier.size = size;
+        return barrier;
+    }
+
+    static VkImageMemoryBarrier imageBarrier(VkImage image, uint32_t layerCount, VkImageLayout oldLayout,
+                                             VkImageLayout newLayout, VkAccessFlags srcAccess,
+                                             VkAccessFlags dstAccess, uint32_t srcFamily, uint32_t dstFamily) {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = srcFamily;
+        barrier.dstQueueFamilyIndex = dstFamily;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = layerCount;
+        return barrier;
+    }
+
+    static VkCommandBuffer allocateCommandBuffer(VkDevice device, VkCommandPool commandPool) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = commandPool;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate upload command buffer!");
+        }
+        return commandBuffer;
+    }
+
+    static VkCommandBuffer beginCommandBuffer(VkDevice device, VkCommandPool commandPool,
+                                              std::vector<VkCommandBuffer> &freeCommandBuffers) {
+        VkCommandBuffer commandBuffer;
+        if (!freeCommandBuffers.empty()) {
+            commandBuffer = freeCommandBuffers.back();
+            freeCommandBuffers.pop_back();
+            vkResetCommandBuffer(commandBuffer, 0);
+        } else {
+            commandBuffer = allocateCommandBuffer(device, commandPool);
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        return commandBuffer;
+    }
+
+    GolaUploadQueue::GolaUploadQueue(GolaDevice &device, VkDeviceSize capacity, VkDeviceSize frameBudget)
+        : device{device},
+          uploadTimeline{device.hasDedicatedTransferQueue() ? device.getTransferTimeline()
+                                                            : device.getGraphicsTimeline()},
+          dedicatedQueue{device.hasDedicatedTransferQueue()},
+          capacity{capacity},
+          frameBudget{frameBudget} {
+        QueueFamilyIndices queueFamilies = device.findPhysicalQueueFamilies();
+        graphicsFamily = queueFamilies.graphicsFamily;
+        transferFamily = dedicatedQueue ? queueFamilies.transferFamily : graphicsFamily;
+
+        createRing();
+        transferPool = createCommandPool(transferFamily);
+        if (dedicatedQueue) {
+            acquirePool = createCommandPool(graphicsFamily);
+        }
+    }
+
+    GolaUploadQueue::~GolaUploadQueue() {
+        waitIdle();
+        if (!submittedAcquires.empty()) {
+            device.getGraphicsTimeline().wait(submittedAcquires.back().timelineValue);
+        }
+        if (benchmark) {
+            for (size_t i = 0; i < benchmark->buffers.size(); i++) {
+                device.destroyBuffer(benchmark->buffers[i], benchmark->allocations[i]);
+            }
+        }
+
+        vkDestroyCommandPool(device.device(), transferPool, nullptr);
+        if (acquirePool != VK_NULL_HANDLE) {
+            vkDestroyCommandPool(device.device(), acquirePool, nullptr);
+        }
+        device.destroyBuffer(ringBuffer, ringAllocation);
+    }
+
+    void GolaUploadQueue::createRing() {
+        device.createBuffer(
+            capacity,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            ringBuffer,
+            ringAllocation);
+
+        // 子分配器对 HOST_VISIBLE 内存做了持久映射
+        mapped = static_cast<char *>(ringAllocation.mapped);
+    }
+
+    VkCommandPool GolaUploadQueue::createCommandPool(uint32_t queueFamilyIndex) {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = queueFamilyIndex;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        VkCommandPool commandPool;
+        if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upload command pool!");
+        }
+        return commandPool;
+    }
+
+    uint64_t GolaUploadQueue::uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size,
+                                           WriteFunction write) {
+        // 没有数据可拷贝: 与前一个请求同时完成
+        if (size == 0) {
+            return nextTicket - 1;
+        }
+        Request request{};
+        request.ticket = nextTicket++;
+        request.buffer = dstBuffer;
+        request.dstOffset = dstOffset;
+        request.size = size;
+        request.write = std::move(write);
+        requests.push_back(std::move(request));
+        return requests.back().ticket;
+    }
+
+    uint64_t GolaUploadQueue::uploadBuffer(VkBuffer dstBuffer, std::vector<char> data, VkDeviceSize dstOffset) {
+        const auto size = static_cast<VkDeviceSize>(data.size());
+        auto source = std::make_shared<std::vector<char>>(std::move(data));
+        return uploadBuffer(dstBuffer, dstOffset, size, [source](void *dst, VkDeviceSize offset, VkDeviceSize size) {
+            std::memcpy(dst, source->data() + offset, static_cast<size_t>(size));
+        });
+    }
+
+    uint64_t GolaUploadQueue::uploadImage(VkImage image, VkExtent2D extent, uint32_t layerCount,
+                                          VkDeviceSize layerSize, WriteFunction write, VkImageLayout finalLayout) {
+        if (layerSize == 0 || layerCount == 0) {
+            return nextTicket - 1;
+        }
+        if (layerSize > capacity) {
+            throw std::runtime_error("image layer does not fit in the upload ring!");
+        }
+        Request request{};
+        request.ticket = nextTicket++;
+        request.image = image;
+        request.size = layerSize * layerCount;
+        request.extent = extent;
+        request.layerCount = layerCount;
+        request.layerSize = layerSize;
+        request.finalLayout = finalLayout;
+        request.write = std::move(write);
+        requests.push_back(std::move(request));
+        return requests.back().ticket;
+    }
+
+    bool GolaUploadQueue::allocate(VkDeviceSize minSize, VkDeviceSize maxSize, VkDeviceSize &offset,
+                                   VkDeviceSize &size, VkDeviceSize &consumed) {
+        if (used == 0) {
+            head = 0;
+            tail = 0;
+        }
+        const VkDeviceSize aligned = (head + UPLOAD_ALIGNMENT - 1) & ~(UPLOAD_ALIGNMENT - 1);
+
+        VkDeviceSize end;
+        if (used == 0 || head > tail) {
+            // 占用的是 [tail, head): 先用到末尾为止的空间, 不够时绕回开头, 跳过的部分也算作占用
+            if (aligned + minSize <= capacity) {
+                offset = aligned;
+                end = capacity;
+            } else if (minSize <= tail) {
+                offset = 0;
+                end = tail;
+            } else {
+                return false;
+            }
+        } else {
+            // 占用区域已经绕回开头, 空闲的只有 [head, tail)
+            if (aligned + minSize > tail) {
+                return false;
+            }
+            offset = aligned;
+            end = tail;
+        }
+
+        size = std::min(maxSize, end - offset);
+        consumed = offset >= head ? offset + size - head : capacity - head + offset + size;
+        head = offset + size;
+        used += consumed;
+        return true;
+    }
+
+    void GolaUploadQueue::submitBatch(VkDeviceSize budget) {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        InFlightBatch batch{};
+        // 批次末尾的 barrier: 专用队列上是所有权释放, 否则是普通的可见性和布局转换
+        std::vector<VkBufferMemoryBarrier> bufferBarriers;
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        const uint32_t srcFamily = dedicatedQueue ? transferFamily : VK_QUEUE_FAMILY_IGNORED;
+        const uint32_t dstFamily = dedicatedQueue ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+
+        VkDeviceSize written = 0;
+        while (!requests.empty() && written < budget) {
+            Request &request = requests.front();
+            const bool isImage = request.image != VK_NULL_HANDLE;
+
+            // image 每次拷贝完整的一层, 也因此不受传输队列 minImageTransferGranularity 的限制;
+            // 每帧的第一块允许超过预算, 保证加载总有进展
+            const VkDeviceSize remaining = request.size - request.written;
+            const VkDeviceSize budgetLeft = budget - written;
+            VkDeviceSize minSize = isImage ? request.layerSize : std::min(remaining, MIN_CHUNK_SIZE);
+            VkDeviceSize maxSize = isImage ? request.layerSize : std::min(remaining, budgetLeft);
+            if (written > 0 && minSize > budgetLeft) {
+                break;
+            }
+            maxSize = std::max(minSize, maxSize);
+
+            VkDeviceSize offset;
+            VkDeviceSize size;
+            VkDeviceSize consumed;
+            if (!allocate(minSize, maxSize, offset, size, consumed)) {
+                break;
+            }
+            if (commandBuffer == VK_NULL_HANDLE) {
+                commandBuffer = beginCommandBuffer(device.device(), transferPool, freeTransferCommandBuffers);
+            }
+
+            request.write(mapped + offset, request.written, size);
+
+            if (isImage) {
+                const auto layer = static_cast<uint32_t>(request.written / request.layerSize);
+                if (layer == 0) {
+                    // 新建的 image 内容可以丢弃
+                    VkImageMemoryBarrier toTransfer = imageBarrier(
+                        request.image, request.layerCount, VK_IMAGE_LAYOUT_UNDEFINED,
+                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+                    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+                }
+
+                VkBufferImageCopy region{};
+                region.bufferOffset = offset;
+                region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                region.imageSubresource.mipLevel = 0;
+                region.imageSubresource.baseArrayLayer = layer;
+                region.imageSubresource.layerCount = 1;
+                region.imageOffset = {0, 0, 0};
+                region.imageExtent = {request.extent.width, request.extent.height, 1};
+                vkCmdCopyBufferToImage(commandBuffer, ringBuffer, request.image,
+                                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+            } else {
+                VkBufferCopy region{};
+                region.srcOffset = offset;
+                region.dstOffset = request.dstOffset + request.written;
+                region.size = size;
+                vkCmdCopyBuffer(commandBuffer, ringBuffer, request.buffer, 1, &region);
+            }
+
+            request.written += size;
+            written += size;
+            batch.bytes += consumed;
+
+            if (request.written < request.size) {
+                continue;
+            }
+            // 最后一块: 专用队列上释放所有权, 图形队列在批次完成后用相同的参数获取
+            if (isImage) {
+                imageBarriers.push_back(imageBarrier(
+                    request.image, request.layerCount, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, request.finalLayout,
+                    VK_ACCESS_TRANSFER_WRITE_BIT, dedicatedQueue ? 0 : CONSUMER_ACCESS, srcFamily, dstFamily));
+                if (dedicatedQueue) {
+                    batch.imageAcquires.push_back(imageBarrier(
+                        request.image, request.layerCount, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        request.finalLayout, 0, CONSUMER_ACCESS, srcFamily, dstFamily));
+                }
+            } else if (dedicatedQueue) {
+                bufferBarriers.push_back(bufferBarrier(request.buffer, request.dstOffset, request.size,
+                                                       VK_ACCESS_TRANSFER_WRITE_BIT, 0, srcFamily, dstFamily));
+                batch.bufferAcquires.push_back(bufferBarrier(request.buffer, request.dstOffset, request.size, 0,
+                                                             CONSUMER_ACCESS, srcFamily, dstFamily));
+            }
+            batch.lastTicket = request.ticket;
+            requests.pop_front();
+        }
+
+        if (commandBuffer == VK_NULL_HANDLE) {
+            return;
+        }
+
+        if (dedicatedQueue) {
+            if (!bufferBarriers.empty() || !imageBarriers.empty()) {
+                vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                     VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                                     static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+                                     static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+            }
+        } else {
+            // 图形队列上之后提交的所有工作都在 barrier 之后, 与 GolaStagingRing 相同
+            VkMemoryBarrier memoryBarrier{};
+            memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            memoryBarrier.dstAccessMask = CONSUMER_ACCESS;
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                 0, 1, &memoryBarrier, 0, nullptr,
+                                 static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+        }
+        vkEndCommandBuffer(commandBuffer);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        batch.timelineValue = uploadTimeline.submit(submitInfo);
+        batch.commandBuffer = commandBuffer;
+        batch.end = head;
+
+        // 没有专用队列时拷贝就在图形队列上, 提交之后的工作已经按顺序排在它后面
+        if (!dedicatedQueue && batch.lastTicket != 0) {
+            completedTicket = batch.lastTicket;
+        }
+        inFlightBatches.push_back(std::move(batch));
+    }
+
+    void GolaUploadQueue::retireBatches(bool wait) {
+        recycleAcquireCommandBuffers();
+
+        std::vector<VkBufferMemoryBarrier> bufferAcquires;
+        std::vector<VkImageMemoryBarrier> imageAcquires;
+        uint64_t waitValue = 0;
+        uint64_t lastTicket = 0;
+        while (!inFlightBatches.empty()) {
+            InFlightBatch &batch = inFlightBatches.front();
+            if (wait && waitValue == 0) {
+                uploadTimeline.wait(batch.timelineValue);
+            } else if (!uploadTimeline.isComplete(batch.timelineValue)) {
+                break;
+            }
+            bufferAcquires.insert(bufferAcquires.end(), batch.bufferAcquires.begin(), batch.bufferAcquires.end());
+            imageAcquires.insert(imageAcquires.end(), batch.imageAcquires.begin(), batch.imageAcquires.end());
+            waitValue = batch.timelineValue;
+            lastTicket = std::max(lastTicket, batch.lastTicket);
+
+            used -= batch.bytes;
+            tail = batch.end;
+            freeTransferCommandBuffers.push_back(batch.commandBuffer);
+            inFlightBatches.pop_front();
+        }
+
+        if (!bufferAcquires.empty() || !imageAcquires.empty()) {
+            // 批次已经完成, 等待立即满足; 只有完成之后才提交获取, 图形队列不会因为上传而停顿
+            VkCommandBuffer commandBuffer =
+                    beginCommandBuffer(device.device(), acquirePool, freeAcquireCommandBuffers);
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr,
+                                 static_cast<uint32_t>(bufferAcquires.size()), bufferAcquires.data(),
+                                 static_cast<uint32_t>(imageAcquires.size()), imageAcquires.data());
+            vkEndCommandBuffer(commandBuffer);
+
+            VkSemaphore waitSemaphore = uploadTimeline.getHandle();
+            VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            VkSubmitInfo submitInfo{};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.waitSemaphoreCount = 1;
+            submitInfo.pWaitSemaphores = &waitSemaphore;
+            submitInfo.pWaitDstStageMask = &waitStage;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &commandBuffer;
+            const uint64_t graphicsValue = device.getGraphicsTimeline().submit(submitInfo, &waitValue);
+            submittedAcquires.push_back({graphicsValue, commandBuffer});
+        }
+        if (dedicatedQueue && lastTicket != 0) {
+            completedTicket = lastTicket;
+        }
+    }
+
+    void GolaUploadQueue::recycleAcquireCommandBuffers() {
+        while (!submittedAcquires.empty() &&
+               device.getGraphicsTimeline().isComplete(submittedAcquires.front().timelineValue)) {
+            freeAcquireCommandBuffers.push_back(submittedAcquires.front().commandBuffer);
+            submittedAcquires.pop_front();
+        }
+    }
+
+    void GolaUploadQueue::endFrame(float frameTime) {
+        const auto start = std::chrono::steady_clock::now();
+        retireBatches(false);
+        submitBatch(frameBudget);
+        const auto mainThreadMicroseconds = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
+        if (!benchmark) {
+            return;
+        }
+        // 第一帧的时间里包含了创建 buffer 和排队, 不计入
+        if (benchmark->frameCount++ > 0) {
+            benchmark->elapsedTime += frameTime;
+            benchmark->maxFrameTime = std::max(benchmark->maxFrameTime, frameTime);
+            if (frameTime > GolaPipelineCompiler::HITCH_FRAME_TIME) {
+                benchmark->hitchFrames++;
+            }
+        }
+        benchmark->mainThreadMicroseconds += mainThreadMicroseconds;
+        benchmark->maxMainThreadMicroseconds = std::max(benchmark->maxMainThreadMicroseconds,
+                                                        mainThreadMicroseconds);
+        if (isComplete(benchmark->lastTicket)) {
+            finishBenchmark();
+        }
+    }
+
+    void GolaUploadQueue::waitIdle() {
+        while (!requests.empty() || !inFlightBatches.empty()) {
+            submitBatch(capacity);
+            retireBatches(true);
+        }
+    }
+
+    void GolaUploadQueue::startBenchmark() {
+        if (benchmark) {
+            std::print("[DEBUG] Upload queue benchmark is already running\n");
+            return;
+        }
+        benchmark = std::make_unique<Benchmark>();
+
+        const auto count = static_cast<size_t>(BENCHMARK_BYTES / BENCHMARK_BUFFER_SIZE);
+        benchmark->buffers.resize(count, VK_NULL_HANDLE);
+        benchmark->allocations.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            device.createBuffer(
+                BENCHMARK_BUFFER_SIZE,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                benchmark->buffers[i],
+                benchmark->allocations[i]);
+            // 数据在写入环时生成, 与从文件流式读取一样不需要整份留在内存里
+            benchmark->lastTicket = uploadBuffer(
+                benchmark->buffers[i], 0, BENCHMARK_BUFFER_SIZE,
+                [i](void *dst, VkDeviceSize, VkDeviceSize size) {
+                    std::memset(dst, static_cast<int>(i & 0xff), static_cast<size_t>(size));
+                });
+        }
+    }
+
+    void GolaUploadQueue::finishBenchmark() {
+        const float averageMs = benchmark->frameCount > 1
+                                    ? benchmark->elapsedTime * 1000.0f / static_cast<float>(benchmark->frameCount - 1)
+                                    : 0.0f;
+        const float megabytes = static_cast<float>(BENCHMARK_BYTES) / (1024.0f * 1024.0f);
+
+        std::print("[DEBUG] Upload queue benchmark ({:.0f} MB in {} buffers, {} queue)\n", megabytes,
+                   benchmark->buffers.size(), dedicatedQueue ? "dedicated transfer" : "graphics");
+        std::print("[DEBUG]   loaded in {:.1f} ms over {} frames ({:.0f} MB/s)\n", benchmark->elapsedTime * 1000.0f,
+                   benchmark->frameCount, benchmark->elapsedTime > 0.0f ? megabytes / benchmark->elapsedTime : 0.0f);
+        std::print("[DEBUG]   frame time: {:.2f} ms average, {:.2f} ms max, {} frames over {:.1f} ms: {}\n",
+                   averageMs, benchmark->maxFrameTime * 1000.0f, benchmark->hitchFrames,
+                   GolaPipelineCompiler::HITCH_FRAME_TIME * 1000.0f, benchmark->hitchFrames == 0 ? "PASS" : "FAIL");
+        std::print("[DEBUG]   main thread: {:.2f} ms per frame average, {:.2f} ms max ({} MB budget)\n",
+                   static_cast<float>(benchmark->mainThreadMicroseconds) / 1000.0f /
+                   static_cast<float>(benchmark->frameCount),
+                   static_cast<float>(benchmark->maxMainThreadMicroseconds) / 1000.0f,
+                   frameBudget / (1024 * 1024));
+
+        // 这些 buffer 从未被绘制使用, 只需要等待引用它们的所有权获取完成
+        if (!submittedAcquires.empty()) {
+            device.getGraphicsTimeline().wait(submittedAcquires.back().timelineValue);
+        }
+        for (size_t i = 0; i < benchmark->buffers.size(); i++) {
+            device.destroyBuffer(benchmark->buffers[i], benchmark->allocations[i]);
+        }
+        benchmark.reset();
+    }
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "gola_allocator.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace gola {
+    class GolaDevice;
+    class GolaTimeline;
+
+    /*
+     * 资源加载的上传队列: 新建的 buffer/image 的数据先排队, 每帧在 endFrame() 中按字节预算写入自己的持久映射环,
+     * 一次提交到专用传输队列 (只有 TRANSFER 的队列族), 从不等待 GPU. 批次完成后在图形队列上获取所有权,
+     * 之后提交到图形队列的工作就可以使用这些资源. 大量数据因此分摊到多帧, 拷贝与渲染并行执行.
+     * 设备没有专用传输族时退回图形队列, 不需要所有权转移. 只能在主线程使用.
+     *
+     * 与 GolaStagingRing 的区别: 暂存环的拷贝与帧按提交顺序排列, 可以更新 GPU 正在使用的 buffer;
+     * 这里的目标必须是 GPU 还没有使用过的资源.
+     */
+    class GolaUploadQueue {
+    public:
+        static constexpr VkDeviceSize DEFAULT_CAPACITY = 64 * 1024 * 1024;
+        // memcpy 在主线程上进行, 每帧的预算决定了加载占用多少帧时间
+        static constexpr VkDeviceSize DEFAULT_FRAME_BUDGET = 16 * 1024 * 1024;
+        static constexpr VkDeviceSize UPLOAD_ALIGNMENT = 16;
+        // 小于它的 buffer 分块不值得单独一次拷贝, 空间不够时留到下一帧
+        static constexpr VkDeviceSize MIN_CHUNK_SIZE = 256 * 1024;
+        static constexpr VkDeviceSize BENCHMARK_BYTES = 1024ull * 1024 * 1024;
+        static constexpr VkDeviceSize BENCHMARK_BUFFER_SIZE = 16 * 1024 * 1024;
+
+        // Writes `size` bytes of the source data, starting `offset` bytes into it, to `dst`. Called on the main
+        // thread from endFrame() or waitIdle(), possibly several times per upload when it is split across frames.
+        using WriteFunction = std::function<void(void *dst, VkDeviceSize offset, VkDeviceSize size)>;
+
+        GolaUploadQueue(GolaDevice &device, VkDeviceSize capacity = DEFAULT_CAPACITY,
+                        VkDeviceSize frameBudget = DEFAULT_FRAME_BUDGET);
+
+        ~GolaUploadQueue();
+
+        GolaUploadQueue(const GolaUploadQueue &) = delete;
+
+        GolaUploadQueue &operator=(const GolaUploadQueue &) = delete;
+
+        // Queues `size` bytes for dstBuffer at dstOffset and returns a ticket for isComplete(). dstBuffer must
+        // not be in use by the GPU, and `write` must keep its source data alive until the ticket completes.
+        uint64_t uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size, WriteFunction write);
+
+        uint64_t uploadBuffer(VkBuffer dstBuffer, std::vector<char> data, VkDeviceSize dstOffset = 0);
+
+        // Queues mip 0 of every layer of a color image; the data is layerCount tightly packed layers of
+        // layerSize bytes, and each layer must fit in the ring. The image ends up in finalLayout.
+        uint64_t uploadImage(VkImage image, VkExtent2D extent, uint32_t layerCount, VkDeviceSize layerSize,
+                             WriteFunction write,
+                             VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+        // True once graphics work submitted from now on can use the resource. Tickets complete in order.
+        bool isComplete(uint64_t ticket) const { return ticket <= completedTicket; }
+
+        bool hasPendingUploads() const { return completedTicket < nextTicket - 1; }
+        bool hasDedicatedQueue() const { return dedicatedQueue; }
+
+        // Called once per frame on the main thread with the previous frame's duration. Hands finished batches
+        // over to the graphics queue and submits up to frameBudget bytes of queued uploads. Never blocks.
+        void endFrame(float frameTime);
+
+        // Uploads everything queued and blocks until every ticket has completed.
+        void waitIdle();
+
+        // Streams BENCHMARK_BYTES into new device-local buffers while the app keeps rendering, then prints the
+        // frame times during loading and the main thread time spent per frame.
+        void startBenchmark();
+
+    private:
+        struct Request {
+            uint64_t ticket;
+            VkBuffer buffer = VK_NULL_HANDLE;
+            VkImage image = VK_NULL_HANDLE;
+            VkDeviceSize dstOffset = 0;
+            VkDeviceSize size = 0;
+            // 已经写入环的字节数
+            VkDeviceSize written = 0;
+            VkExtent2D extent{};
+            uint32_t layerCount = 0;
+            VkDeviceSize layerSize = 0;
+            VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            WriteFunction write;
+        };
+
+        struct InFlightBatch {
+            // uploadTimeline 上的值
+            uint64_t timelineValue;
+            VkCommandBuffer commandBuffer;
+            // 环中占用的字节数 (含对齐和绕回时跳过的部分), 以及批次结束时的 head
+            VkDeviceSize bytes;
+            VkDeviceSize end;
+            // 最后一块在这个批次中的请求里最大的 ticket, 没有时为 0
+            uint64_t lastTicket;
+            // 在图形队列上与传输队列的释放配对的获取
+            std::vector<VkBufferMemoryBarrier> bufferAcquires;
+            std::vector<VkImageMemoryBarrier> imageAcquires;
+        };
+
+        struct SubmittedCommandBuffer {
+            uint64_t timelineValue;
+            VkCommandBuffer commandBuffer;
+        };
+
+        void createRing();
+
+        VkCommandPool createCommandPool(uint32_t queueFamilyIndex);
+
+        // 在环中找一段 [minSize, maxSize] 的连续空间, 不等待 GPU; 空间不够时返回 false
+        bool allocate(VkDeviceSize minSize, VkDeviceSize maxSize, VkDeviceSize &offset, VkDeviceSize &size,
+                      VkDeviceSize &consumed);
+
+        // 把队首的请求写入环并提交一个批次, 最多写入 budget 字节
+        void submitBatch(VkDeviceSize budget);
+
+        // 处理传输时间线上已经完成的批次; wait 为 true 时至少等待最早的一个
+        void retireBatches(bool wait);
+
+        void recycleAcquireCommandBuffers();
+
+        void finishBenchmark();
+
+        GolaDevice &device;
+        GolaTimeline &uploadTimeline;
+        bool dedicatedQueue;
+        uint32_t transferFamily;
+        uint32_t graphicsFamily;
+        VkDeviceSize capacity;
+        VkDeviceSize frameBudget;
+
+        VkBuffer ringBuffer = VK_NULL_HANDLE;
+        GolaAllocation ringAllocation{};
+        char *mapped = nullptr;
+        // 占用的区域从 tail 开始到 head 为止, 可能绕回开头
+        VkDeviceSize head = 0;
+        VkDeviceSize tail = 0;
+        VkDeviceSize used = 0;
+
+        // 传输族上录制拷贝, 图形族上录制所有权获取; 没有专用队列时 acquirePool 为空
+        VkCommandPool transferPool = VK_NULL_HANDLE;
+        VkCommandPool acquirePool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> freeTransferCommandBuffers;
+        std::vector<VkCommandBuffer> freeAcquireCommandBuffers;
+        std::deque<SubmittedCommandBuffer> submittedAcquires;
+
+        std::deque<Request> requests;
+        std::deque<InFlightBatch> inFlightBatches;
+        uint64_t nextTicket = 1;
+        uint64_t completedTicket = 0;
+
+        struct Benchmark {
+            std::vector<VkBuffer> buffers;
+            std::vector<GolaAllocation> allocations;
+            uint64_t lastTicket = 0;
+            float elapsedTime = 0.0f;
+            float maxFrameTime = 0.0f;
+            uint32_t frameCount = 0;
+            uint32_t hitchFrames = 0;
+            // endFrame() 在主线程上的耗时, 微秒
+            uint64_t mainThreadMicroseconds = 0;
+            uint64_t maxMainThreadMicroseconds = 0;
+        };
+        std::unique_ptr<Benchmark> benchmark;
+    };
+}
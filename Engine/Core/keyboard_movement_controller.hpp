@@ -1,6 +1,7 @@
 #pragma once
 
-#include "gola_game_object.hpp"
+#include "gola_components.hpp"
+#include "gola_ecs.hpp"
 #include "../Window/gola_window.hpp"
 
 namespace gola {
@@ -19,7 +20,10 @@ namespace gola {
             int lookDown = GLFW_KEY_DOWN;
         };
 
-        void moveInPlaneXZ(GLFWwindow *window, float dt, GolaGameObject &gameObject);
+        // 移动所有带 KeyboardControlComponent 的实体
+        void moveInPlaneXZ(GLFWwindow *window, float dt, GolaWorld &world);
+
+        void moveInPlaneXZ(GLFWwindow *window, float dt, Transform &transform);
 
         KeyMappings keys{};
         float moveSpeed{3.f};
@@ -1,22 +1,35 @@
 #pragma once
 
+#include "gola_buffer.hpp"
+#include "gola_bvh.hpp"
+#include "gola_command_recorder.hpp"
 #include "gola_device.hpp"
-#include "gola_game_object.hpp"
+#include "gola_frame_info.hpp"
+#include "gola_frustum_culler.hpp"
+#include "gola_gpu_scene.hpp"
+#include "gola_matrix_kernel.hpp"
 #include "gola_pipeline.hpp"
+#include "gola_pipeline_compiler.hpp"
+#include "gola_render_graph.hpp"
+#include "gola_swap_chain.hpp"
 
 // std
+#include <array>
+#include <functional>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "../UI/gola_imgui.hpp"
 
 namespace gola {
-    class GolaCamera;
-
     class RenderSystem {
     public:
+        // 逐对象管线同步创建, 作为其他管线在后台编译完成之前的回退; 实例化和 GPU 驱动管线由 pipelineCompiler 编译,
+        // 使用 surface_shader.frag 按 ImGui 选择的特化组合着色
         RenderSystem(
-            GolaDevice &device, VkRenderPass renderPass, GolaImgui *imguiPtr);
+            GolaDevice &device, GolaPipelineCompiler &pipelineCompiler, const GolaRenderTarget &renderTarget,
+            GolaImgui *imguiPtr);
 
         ~RenderSystem();
 
@@ -24,22 +37,146 @@ namespace gola {
 
         RenderSystem &operator=(const RenderSystem &) = delete;
 
-        void renderGameObjects(
-            VkCommandBuffer commandBuffer,
-            std::vector<GolaGameObject> &gameObjects,
-            const GolaCamera &camera);
+        // 在声明渲染图之前调用: 选定本帧的渲染模式 (管线还在编译时回退到逐对象绘制), GPU 驱动模式下上传场景数据
+        void prepareFrame(GolaWorld &world);
+
+        // Adds this frame's passes to graph: in GPU-driven mode a compute pass that builds the indirect commands,
+        // then a scene pass that clears colorTarget and a transient depth buffer and draws the objects and ImGui.
+        // frameInfo and world are captured by reference and must stay alive until the graph is executed.
+        void addPasses(GolaRenderGraph &graph, FrameInfo &frameInfo, GolaWorld &world,
+                       GolaRenderGraphResource colorTarget, VkFormat depthFormat);
+
+        // 渲染所有带 Transform, ModelComponent 和 ColorComponent 的实体. frameInfo.commandRecorder 处于 render pass 中时
+        // 逐对象绘制分块在多个线程上录制到 secondary command buffer, 其他模式录制到一个 secondary
+        void renderGameObjects(FrameInfo &frameInfo, GolaWorld &world);
+
+        // 对象被增删或修改后调用, GPU 驱动模式会重新上传场景数据
+        void markSceneDirty();
+
+        // 场景 BVH 由拥有场景的一方维护 (按 GolaEntity::index 索引), CPU 路径用它做层次视锥剔除
+        void setSceneBvh(const GolaBvh *bvh) { sceneBvh = bvh; }
 
-        void renderImgui(VkCommandBuffer commandBuffer);
+        // 只有变换改变的实体 (GolaTransformSystem::update 的结果): 更新剔除数据并局部上传 GPU 场景
+        void updateObjects(GolaWorld &world, const std::vector<GolaEntity> &changedEntities);
+
+        void renderImgui(FrameInfo &frameInfo);
+
+        // 在离屏目标上画多层全屏三角形, 用 GPU 时间戳比较 surface_shader.frag 在运行时按 push constant 分支
+        // 与按特化常量编译的管线在每种组合下的片元开销
+        static void runSpecializationBenchmark(GolaDevice &device);
+
+        // 在离屏目标上画大量微小三角形, 用 GPU 时间戳比较顶点缓冲区放在 host visible 与 device local 内存中时的
+        // 绘制吞吐量
+        static void runVertexPlacementBenchmark(GolaDevice &device);
 
     private:
+        // surface_shader.frag 的特化组合, 与 shader 中 push.flags 的位一致
+        static constexpr uint32_t SURFACE_VERTEX_COLOR = 1u << 0;
+        static constexpr uint32_t SURFACE_LIGHTING = 1u << 1;
+        static constexpr uint32_t SURFACE_PERMUTATION_COUNT = 4;
+
+        struct SurfacePipelines {
+            GolaPipelineHandle instanced;
+            // 没有 gpuScene 时不请求
+            GolaPipelineHandle gpuDriven;
+        };
+        // 每个实例的数据, 与 instanced_shader.vert 中 location 2~6 的输入一致
+        struct InstanceData {
+            glm::mat4 transform{1.0f};
+            glm::vec4 color{};
+        };
+
+        struct InstanceGroup {
+            GolaModel *model;
+            uint32_t firstInstance;
+            uint32_t instanceCount;
+        };
+
         void createPipelineLayout();
 
-        void createPipeline(VkRenderPass renderPass);
+        void createPipeline();
+
+        void createGpuDrivenPipelineLayout();
+
+        // 在后台编译一种特化组合 (SURFACE_* 位) 的实例化和 GPU 驱动管线
+        void requestSurfacePipelines(uint32_t permutation);
+
+        static void setSurfaceConstants(PipelineConfigInfo &pipelineConfig, uint32_t permutation);
+
+        // 根据 ImGui 的设置选择本帧的特化组合
+        uint32_t selectSurfacePermutation() const;
+
+        // world 的结构改变后 (实体增删, 组件增删) 重建 renderObjects, 之前缓存的组件指针全部失效
+        void syncRenderObjects(GolaWorld &world);
+
+        // CPU 路径的视锥剔除, 结果写入 visibleIndices (renderObjects 的下标)
+        void cullOnCpu(const glm::mat4 &projectionView, RenderStats &stats);
+
+        // 直接录制到 frameInfo.commandBuffer, 或者录制到一个 secondary 并在 primary 中执行
+        void recordInPass(FrameInfo &frameInfo, const std::function<void(FrameInfo &)> &record);
+
+        void renderPerObject(FrameInfo &frameInfo, const glm::mat4 &projectionView, RenderStats &stats);
+
+        // 录制 [begin, end) 的逐对象绘制, data[i] 是 renderObjects[indices[i]] 的 push constant 数据
+        void recordPerObjectDraws(VkCommandBuffer commandBuffer, const uint32_t *indices, const InstanceData *data,
+                                  uint32_t begin, uint32_t end, RenderStats &stats) const;
+
+        // 用 1 到 N 个线程把所有对象录制为逐对象绘制 (不执行) 并打印耗时, 必须在本帧执行任何 secondary 之前调用
+        void runRecordingBenchmark(GolaCommandRecorder &recorder, const glm::mat4 &projectionView);
+
+        void renderInstanced(FrameInfo &frameInfo, const glm::mat4 &projectionView, RenderStats &stats);
+
+        void renderGpuDriven(FrameInfo &frameInfo, const glm::mat4 &projectionView, RenderStats &stats);
+
+        GolaBuffer &getInstanceBuffer(int frameIndex, uint32_t instanceCount);
 
         GolaDevice &golaDevice;
+        GolaPipelineCompiler &pipelineCompiler;
 
-        std::unique_ptr<GolaPipeline> golaPipeline;
+        // 所有管线都按这个渲染目标创建 (交换链重建后仍然有效), 新的特化组合在第一次被选中时才请求
+        GolaRenderTarget renderTarget;
+        std::shared_ptr<GolaPipeline> golaPipeline;
         VkPipelineLayout pipelineLayout;
         GolaImgui *imgui = nullptr;
+
+        // 设备不支持 multiDrawIndirect 时为空, GPU 驱动模式回退到实例化
+        std::unique_ptr<GolaGpuScene> gpuScene;
+        VkPipelineLayout gpuDrivenPipelineLayout = VK_NULL_HANDLE;
+
+        // 按特化组合索引, 请求过的组合一直保留, 切换回来时不需要重新编译
+        std::array<SurfacePipelines, SURFACE_PERMUTATION_COUNT> surfacePipelines;
+        uint32_t surfacePermutation = SURFACE_VERTEX_COLOR;
+
+        static constexpr uint32_t INVALID_RENDER_INDEX = 0xFFFFFFFF;
+
+        // 可渲染实体的组件指针, 按 world 的遍历顺序排列; renderIndexBySlot 按 GolaEntity::index 查找下标
+        std::vector<RenderObject> renderObjects;
+        std::vector<uint32_t> renderIndexBySlot;
+        std::vector<uint32_t> changedRenderIndices;
+        uint64_t renderObjectsVersion = ~uint64_t{0};
+
+        // CPU 路径的剔除数据: 世界空间包围球只在场景变化时重建
+        GolaFrustumCuller frustumCuller;
+        std::vector<uint32_t> visibleIndices;
+        bool cullingBoundsDirty = true;
+
+        // BVH 返回实体槽位, 通过 renderIndexBySlot 转换为 renderObjects 中的下标
+        const GolaBvh *sceneBvh = nullptr;
+        std::vector<GolaBvh::id_t> visibleIds;
+
+        // prepareFrame 选定的本帧渲染模式及耗时
+        RenderMode frameMode = RenderMode::Instanced;
+        float prepareMs = 0.0f;
+
+        // 每个 frame in flight 一个实例缓冲区, 录制时对应帧的 GPU 工作已经完成
+        std::array<std::unique_ptr<GolaBuffer>, GolaSwapChain::MAX_FRAMES_IN_FLIGHT> instanceBuffers;
+        std::vector<InstanceGroup> instanceGroups;
+        std::unordered_map<GolaModel *, uint32_t> groupLookup;
+
+        // projectionView * model 由 GolaMatrixKernel 批量计算; instanceOrder[slot] 是写入实例 slot 的对象下标
+        GolaMatrixKernel matrixKernel;
+        std::vector<uint32_t> instanceOrder;
+        // 逐对象模式的 push constant 数据, 与实例数据布局相同
+        std::vector<InstanceData> perObjectData;
     };
 }
@@ -3,6 +3,7 @@
 //
 
 #include "gola_imgui.hpp"
+#include "../Core/gola_pipeline_cache.hpp"
 
 // Implementation-only includes
 #include <ostream>
@@ -10,6 +11,9 @@
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_vulkan.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <stdexcept>
 #include <vector>
 
@@ -71,16 +75,34 @@ namespace gola {
         init_info.Device = device_;
         init_info.QueueFamily = device.findPhysicalQueueFamilies().graphicsFamily;
         init_info.Queue = device.graphicsQueue();
-        init_info.PipelineCache = VK_NULL_HANDLE;
+        init_info.PipelineCache = device.getPipelineCache().getHandle();
         init_info.DescriptorPool = imguiDescriptorPool;
         init_info.DescriptorPoolSize = 0;
         init_info.MinImageCount = 2;
-        init_info.ImageCount = static_cast<uint32_t>(swapChain.imageCount());
+        // ImGui 按 ImageCount 轮换顶点缓冲区, 运行时最多可以有 MAX_FRAMES_IN_FLIGHT 帧同时在途
+        init_info.ImageCount = std::max(static_cast<uint32_t>(swapChain.imageCount()),
+                                        static_cast<uint32_t>(GolaSwapChain::MAX_FRAMES_IN_FLIGHT));
         init_info.Allocator = nullptr;
         init_info.CheckVkResultFn = nullptr;
 
         // Fill pipeline info inside init_info
-        init_info.PipelineInfoMain.RenderPass = swapChain.getRenderPass();
+        // 动态渲染时按 attachment 格式创建管线, 交换链重建不影响它. ImGui 在场景 pass 中绘制, 该 pass 带深度
+        const VkFormat colorFormat = swapChain.getSwapChainImageFormat();
+        const VkFormat depthFormat = swapChain.getDepthFormat();
+        if (swapChain.isDynamicRendering()) {
+            const bool hasStencil = depthFormat == VK_FORMAT_D16_UNORM_S8_UINT ||
+                                    depthFormat == VK_FORMAT_D24_UNORM_S8_UINT ||
+                                    depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT;
+            init_info.UseDynamicRendering = true;
+            VkPipelineRenderingCreateInfoKHR &renderingInfo = init_info.PipelineInfoMain.PipelineRenderingCreateInfo;
+            renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+            renderingInfo.colorAttachmentCount = 1;
+            renderingInfo.pColorAttachmentFormats = &colorFormat;
+            renderingInfo.depthAttachmentFormat = depthFormat;
+            renderingInfo.stencilAttachmentFormat = hasStencil ? depthFormat : VK_FORMAT_UNDEFINED;
+        } else {
+            init_info.PipelineInfoMain.RenderPass = swapChain.getRenderPass();
+        }
         init_info.PipelineInfoMain.Subpass = 0;
         init_info.PipelineInfoMain.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
 
@@ -231,24 +253,104 @@ namespace gola {
         colors[ImGuiCol_TableBorderLight] = ImVec4(0.20f, 0.20f, 0.20f, 1.00f);
     }
 
+    static const char *renderModeNames[] = {"per-object", "instanced", "gpu-driven"};
+    static const char *presentModeNames[] = {"FIFO (V-Sync)", "FIFO relaxed", "Mailbox", "Immediate"};
+    static constexpr VkPresentModeKHR presentModes[] = {
+        VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_MAILBOX_KHR,
+        VK_PRESENT_MODE_IMMEDIATE_KHR
+    };
+
+    struct BenchmarkButton {
+        GolaBenchmark benchmark;
+        const char *label;
+    };
+
+    static constexpr BenchmarkButton BENCHMARK_BUTTONS[] = {
+        {GolaBenchmark::Culling, "Run culling benchmark"},
+        {GolaBenchmark::Bvh, "Run BVH benchmark"},
+        {GolaBenchmark::Transform, "Run transform benchmark"},
+        {GolaBenchmark::Ecs, "Run ECS benchmark"},
+        {GolaBenchmark::MatrixKernel, "Run matrix kernel benchmark"},
+        {GolaBenchmark::Recording, "Run recording benchmark"},
+        {GolaBenchmark::JobSystem, "Run job system benchmark"},
+        {GolaBenchmark::RenderGraph, "Run render graph benchmark"},
+        {GolaBenchmark::PipelineCache, "Run pipeline cache benchmark"},
+        {GolaBenchmark::AsyncPipeline, "Run async pipeline benchmark"},
+        {GolaBenchmark::Specialization, "Run specialization benchmark"},
+        {GolaBenchmark::Resize, "Run resize benchmark"},
+        {GolaBenchmark::FramePacing, "Run frame pacing benchmark"},
+        {GolaBenchmark::Upload, "Run upload benchmark"},
+        {GolaBenchmark::ResizeStorm, "Run resize storm"},
+        {GolaBenchmark::PresentLatency, "Run present latency benchmark"},
+        {GolaBenchmark::AllocatorStress, "Run allocator stress test"},
+        {GolaBenchmark::VertexPlacement, "Run vertex placement benchmark"},
+    };
+
     void GolaImgui::buildUI() {
         // 1. Debug window
         ImGui::Begin("Debug Info");
         ImGui::Text("FPS: %.1f (%.3f ms/frame)", ImGui::GetIO().Framerate, 1000.0f / ImGui::GetIO().Framerate);
-        ImGui::Text("Triangles: %d", triangleCount);
-        ImGui::Text("Draw Calls: %d", drawCallCount);
+        ImGui::Text("Objects: %u", renderStats.objectCount);
+        ImGui::Text("Visible: %u  Culled: %u", renderStats.visibleCount, renderStats.culledCount);
+        ImGui::Text("Triangles: %llu", static_cast<unsigned long long>(renderStats.triangleCount));
+        ImGui::Text("Draw Calls: %u", renderStats.drawCalls);
+        ImGui::Text("CPU record: %.3f ms (%s)", renderStats.cpuRecordMs,
+                    renderModeNames[static_cast<int>(renderStats.mode)]);
+        if (renderStats.recordingThreads > 1) {
+            ImGui::Text("Recording threads: %u", renderStats.recordingThreads);
+        }
+        ImGui::Text("Transforms: %u updated (%.3f ms)", transformUpdatedCount, transformUpdateMs);
+        ImGui::Text("Render graph: %u passes (%u culled), %u barriers%s", renderGraphStats.passCount,
+                    renderGraphStats.culledPassCount, renderGraphStats.barrierCount,
+                    renderGraphStats.cached ? ", cached" : "");
+        ImGui::Text("Pipelines: %u compiling, %u ready, %u failed (%.1f ms), %u fallback frames, %u hitches",
+                    pipelineCompilerStats.pendingCount, pipelineCompilerStats.compiledCount,
+                    pipelineCompilerStats.failedCount, pipelineCompilerStats.compileMs,
+                    pipelineCompilerStats.fallbackFrames, pipelineCompilerStats.hitchFrames);
+        ImGui::Text("Pipeline registry: %u pipelines (%llu hits, %llu misses), %u shaders (%llu hits, %llu misses)",
+                    pipelineRegistryStats.pipelineCount,
+                    static_cast<unsigned long long>(pipelineRegistryStats.pipelineHits),
+                    static_cast<unsigned long long>(pipelineRegistryStats.pipelineMisses),
+                    pipelineRegistryStats.shaderModuleCount,
+                    static_cast<unsigned long long>(pipelineRegistryStats.shaderModuleHits),
+                    static_cast<unsigned long long>(pipelineRegistryStats.shaderModuleMisses));
+        ImGui::Text("Present: %s, %u in flight, input->submit %.2f ms (max %.2f ms)",
+                    GolaSwapChain::getPresentModeName(presentStats.presentMode), presentStats.framesInFlight,
+                    presentStats.averageLatencyMs, presentStats.maxLatencyMs);
         ImGui::End();
 
         // 2. Controls panel
         ImGui::Begin("Controls");
         ImGui::SliderFloat("Exposure", &exposure, 0.1f, 5.0f);
         ImGui::ColorEdit3("Main Color", mainColor);
-        ImGui::Checkbox("VSync", &vsyncEnabled);
+        ImGui::Combo("Present mode", &presentModeIndex, presentModeNames, IM_ARRAYSIZE(presentModeNames));
+        ImGui::SliderInt("Frames in flight", &framesInFlight, 1, GolaSwapChain::MAX_FRAMES_IN_FLIGHT);
+        ImGui::SliderFloat("Frame limit (0 = off)", &frameRateLimit, 0.0f, 240.0f, "%.0f fps");
+        ImGui::Combo("Render mode", &renderMode, renderModeNames, IM_ARRAYSIZE(renderModeNames));
+        ImGui::Checkbox("Frustum culling", &frustumCullingEnabled);
+        ImGui::Checkbox("BVH culling", &bvhCullingEnabled);
+        ImGui::Checkbox("Vertex colors", &vertexColorEnabled);
+        ImGui::Checkbox("Lighting", &lightingEnabled);
+        ImGui::Checkbox("Animate objects", &animationEnabled);
+        ImGui::Checkbox("Secondary command buffers", &secondaryCommandBuffersEnabled);
+        ImGui::SliderInt("Recording threads", &recordingThreadCount, 1, maxRecordingThreads);
+        ImGui::InputInt("Benchmark cubes", &benchmarkObjectCount, 1000, 10000);
+        if (ImGui::Button("Load benchmark scene")) {
+            requestedBenchmarkObjects = benchmarkObjectCount > 0 ? benchmarkObjectCount : 0;
+        }
+        for (const BenchmarkButton &button: BENCHMARK_BUTTONS) {
+            if (ImGui::Button(button.label)) {
+                pendingBenchmarks.set(static_cast<size_t>(button.benchmark));
+            }
+        }
         ImGui::End();
 
         // 3. Performance window
         ImGui::Begin("Performance", &showPerformanceWindow);
-        ImGui::Text("Performance graphs would go here测试");
+        buildGpuProfile();
+        if (ImGui::Button("Export GPU profile (JSON)")) {
+            pendingBenchmarks.set(static_cast<size_t>(GolaBenchmark::GpuProfileExport));
+        }
         ImGui::End();
     }
 
@@ -269,6 +371,74 @@ namespace gola {
         }
     }
 
+    int GolaImgui::takeBenchmarkSceneRequest() {
+        int request = requestedBenchmarkObjects;
+        requestedBenchmarkObjects = 0;
+        return request;
+    }
+
+    bool GolaImgui::takeBenchmarkRequest(GolaBenchmark benchmark) {
+        const auto index = static_cast<size_t>(benchmark);
+        bool request = pendingBenchmarks.test(index);
+        pendingBenchmarks.reset(index);
+        return request;
+    }
+
+    void GolaImgui::buildGpuProfile() {
+        if (gpuProfiler == nullptr || !gpuProfiler->isSupported()) {
+            ImGui::Text("GPU timestamps are not supported on the graphics queue");
+            return;
+        }
+        const std::deque<GolaGpuFrameTiming> &history = gpuProfiler->getHistory();
+        if (history.empty()) {
+            ImGui::Text("Waiting for GPU timings...");
+            return;
+        }
+
+        // 按最近一帧的作用域逐个画出历史, 某一帧没有这个作用域时记为 0
+        const GolaGpuFrameTiming &latest = history.back();
+        ImGui::Text("GPU frame %llu (%u frames of history)", static_cast<unsigned long long>(latest.frameNumber),
+                    static_cast<uint32_t>(history.size()));
+        for (size_t index = 0; index < latest.scopes.size(); index++) {
+            const GolaGpuScopeTiming &scope = latest.scopes[index];
+            gpuPlotValues.clear();
+            float maxMs = 0.0f;
+            for (const GolaGpuFrameTiming &frame: history) {
+                float durationMs = 0.0f;
+                for (const GolaGpuScopeTiming &other: frame.scopes) {
+                    if (other.depth == scope.depth && std::strcmp(other.name, scope.name) == 0) {
+                        durationMs = other.durationMs;
+                        break;
+                    }
+                }
+                gpuPlotValues.push_back(durationMs);
+                maxMs = std::max(maxMs, durationMs);
+            }
+
+            char overlay[128];
+            std::snprintf(overlay, sizeof(overlay), "%s: %.3f ms (max %.3f ms)", scope.name, scope.durationMs, maxMs);
+            ImGui::PushID(static_cast<int>(index));
+            if (scope.depth > 0) {
+                ImGui::Indent(16.0f * static_cast<float>(scope.depth));
+            }
+            ImGui::PlotLines("##gpu", gpuPlotValues.data(), static_cast<int>(gpuPlotValues.size()), 0, overlay, 0.0f,
+                             maxMs > 0.0f ? maxMs * 1.2f : 1.0f, ImVec2(0.0f, 40.0f));
+            if (scope.depth > 0) {
+                ImGui::Unindent(16.0f * static_cast<float>(scope.depth));
+            }
+            ImGui::PopID();
+        }
+    }
+
+    GolaPresentSettings GolaImgui::getPresentSettings() const {
+        GolaPresentSettings settings{};
+        settings.presentMode = presentModes[presentModeIndex];
+        settings.framesInFlight = static_cast<uint32_t>(framesInFlight);
+        // 小于 1 fps 的上限没有意义, 滑块拖到底时视为关闭
+        settings.frameRateLimit = frameRateLimit >= 1.0f ? frameRateLimit : 0.0f;
+        return settings;
+    }
+
     glm::vec3 GolaImgui::getMainColor() {
         return glm::vec3(mainColor[0], mainColor[1], mainColor[2]);
     }
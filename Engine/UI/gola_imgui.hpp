@@ -7,10 +7,43 @@
 #include "vec3.hpp"
 
 #include "../Core/gola_device.hpp"
+#include "../Core/gola_frame_info.hpp"
+#include "../Core/gola_gpu_profiler.hpp"
+#include "../Core/gola_pipeline_compiler.hpp"
+#include "../Core/gola_pipeline_registry.hpp"
+#include "../Core/gola_render_graph.hpp"
 #include "../Core/gola_swap_chain.hpp"
 #include "../Window/gola_window.hpp"
 
+// std
+#include <bitset>
+
 namespace gola {
+    // 调试界面上的基准测试按钮, 除 GpuProfileExport 外都在 Controls 窗口中
+    enum class GolaBenchmark : uint32_t {
+        Culling,
+        Bvh,
+        Transform,
+        Ecs,
+        MatrixKernel,
+        Recording,
+        JobSystem,
+        RenderGraph,
+        PipelineCache,
+        AsyncPipeline,
+        Specialization,
+        Resize,
+        FramePacing,
+        Upload,
+        ResizeStorm,
+        PresentLatency,
+        AllocatorStress,
+        VertexPlacement,
+        GpuProfileExport,
+    };
+
+    constexpr size_t GOLA_BENCHMARK_COUNT = static_cast<size_t>(GolaBenchmark::GpuProfileExport) + 1;
+
     class GolaImgui {
     public:
         GolaImgui() = default;
@@ -42,18 +75,96 @@ namespace gola {
 
         glm::vec3 getMainColor();
 
+        RenderMode getRenderMode() const { return static_cast<RenderMode>(renderMode); }
+
+        bool isFrustumCullingEnabled() const { return frustumCullingEnabled; }
+
+        // CPU 路径用场景 BVH 做层次剔除, 关闭时逐个对象测试
+        bool isBvhCullingEnabled() const { return bvhCullingEnabled; }
+
+        void setRenderStats(const RenderStats &stats) { renderStats = stats; }
+
+        void setTransformStats(uint32_t updatedCount, float updateMs) {
+            transformUpdatedCount = updatedCount;
+            transformUpdateMs = updateMs;
+        }
+
+        void setRenderGraphStats(const GolaRenderGraphStats &stats) { renderGraphStats = stats; }
+
+        void setPipelineCompilerStats(const GolaPipelineCompilerStats &stats) { pipelineCompilerStats = stats; }
+
+        void setPipelineRegistryStats(const GolaPipelineRegistryStats &stats) { pipelineRegistryStats = stats; }
+
+        void setPresentStats(const GolaPresentStats &stats) { presentStats = stats; }
+
+        // Performance 窗口按它的历史画出每个作用域的 GPU 时间
+        void setGpuProfiler(const GolaGpuProfiler *profiler) { gpuProfiler = profiler; }
+
+        // 呈现模式, frame in flight 数和帧率上限, 交给 GolaRenderer::setPresentSettings
+        GolaPresentSettings getPresentSettings() const;
+
+        // render pass 内的绘制录制到 secondary command buffer, 逐对象模式分块在多个线程上并行录制
+        bool isSecondaryCommandBuffersEnabled() const { return secondaryCommandBuffersEnabled; }
+
+        uint32_t getRecordingThreadCount() const { return static_cast<uint32_t>(recordingThreadCount); }
+
+        // 设置 "Recording threads" 滑块的上限, 默认使用全部线程
+        void setMaxRecordingThreads(uint32_t count) {
+            maxRecordingThreads = static_cast<int>(count);
+            recordingThreadCount = maxRecordingThreads;
+        }
+
+        // 表面着色的特化常量: 顶点颜色或对象颜色, 是否计算光照; 每种组合是一个单独的管线
+        bool isVertexColorEnabled() const { return vertexColorEnabled; }
+
+        bool isLightingEnabled() const { return lightingEnabled; }
+
+        // 每帧旋转并上下移动所有对象, 用于测量动态对象的开销
+        bool isAnimationEnabled() const { return animationEnabled; }
+
+        // 返回并清除 "加载基准测试场景" 按钮的请求, 未请求时返回 0
+        int takeBenchmarkSceneRequest();
+
+        // 返回并清除 benchmark 对应按钮的请求
+        bool takeBenchmarkRequest(GolaBenchmark benchmark);
+
     private:
         void createDescriptorPool(VkDevice device);
 
+        void buildGpuProfile();
+
         VkDescriptorPool imguiDescriptorPool = VK_NULL_HANDLE;
         VkDevice device_ = VK_NULL_HANDLE;
 
         // Example UI state exposed inside the ImGui wrapper
-        int triangleCount = 2;
-        int drawCallCount = 1;
+        RenderStats renderStats{};
+        GolaRenderGraphStats renderGraphStats{};
+        GolaPipelineCompilerStats pipelineCompilerStats{};
+        GolaPipelineRegistryStats pipelineRegistryStats{};
+        GolaPresentStats presentStats{};
+        const GolaGpuProfiler *gpuProfiler = nullptr;
+        std::vector<float> gpuPlotValues;
+        uint32_t transformUpdatedCount = 0;
+        float transformUpdateMs = 0.0f;
+        int renderMode = static_cast<int>(RenderMode::GpuDriven);
+        bool frustumCullingEnabled = true;
+        bool bvhCullingEnabled = true;
+        bool animationEnabled = false;
+        bool vertexColorEnabled = true;
+        bool lightingEnabled = false;
+        bool secondaryCommandBuffersEnabled = true;
+        int recordingThreadCount = 1;
+        int maxRecordingThreads = 1;
+        int benchmarkObjectCount = 100000;
+        int requestedBenchmarkObjects = 0;
+        // 按下但还没有被取走的基准测试按钮, 下标为 GolaBenchmark
+        std::bitset<GOLA_BENCHMARK_COUNT> pendingBenchmarks;
         float exposure = 1.0f;
         float mainColor[3] = {0.1f, 0.1f, 0.1f};
-        bool vsyncEnabled = true;
+        // 下标对应 presentModes, 默认是 GolaPresentSettings 的 FIFO relaxed
+        int presentModeIndex = 1;
+        int framesInFlight = static_cast<int>(GolaPresentSettings{}.framesInFlight);
+        float frameRateLimit = 0.0f;
         bool showPerformanceWindow = true;
     };
 }
@@ -6,12 +6,25 @@
 #include <gtc/constants.hpp>
 
 #include <chrono>
+#include <cmath>
 #include <iostream>
 #include <thread>
 
 #include "Core/render_system.hpp"
 #include "Core/gola_camera.hpp"
 #include "Core/keyboard_movement_controller.hpp"
+#include "Core/gola_staging_ring.hpp"
+#include "Core/gola_frame_info.hpp"
+#include "Core/gola_frustum_culler.hpp"
+#include "Core/gola_gpu_profiler.hpp"
+#include "Core/gola_job_system.hpp"
+#include "Core/gola_matrix_kernel.hpp"
+#include "Core/gola_pipeline_cache.hpp"
+#include "Core/gola_pipeline_registry.hpp"
+#include "Core/gola_render_graph.hpp"
+#include "Core/gola_timeline.hpp"
+#include "Core/gola_transform_system.hpp"
+#include "Core/gola_upload_queue.hpp"
 
 namespace gola {
     GolaApp::GolaApp() {
@@ -22,38 +35,110 @@ namespace gola {
     }
 
     void GolaApp::run() {
+        // 变换更新, 剔除和命令录制在任务系统上并行执行; 主线程也参与执行任务
+        GolaJobSystem &jobSystem = GolaJobSystem::get();
+        // 启动时同步创建的管线 (后台编译的不计入), 冷启动 (没有缓存文件) 与热启动的差别主要在这里
+        const auto pipelineStartTime = std::chrono::high_resolution_clock::now();
         initImgui();
-        RenderSystem renderSystem(device, renderer.getSwapChainRenderPass(), imgui.get());
+        imgui->setMaxRecordingThreads(renderer.getCommandRecorder().getMaxThreadCount());
+        imgui->setGpuProfiler(&renderer.getGpuProfiler());
+        RenderSystem renderSystem(device, pipelineCompiler, renderer.getSwapChainRenderTarget(), imgui.get());
+        const float pipelineMs = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - pipelineStartTime).count();
+        const size_t pipelineCacheSize = device.getPipelineCache().getLoadedSize();
+        if (pipelineCacheSize > 0) {
+            std::print("[DEBUG] Pipelines created in {:.2f} ms (pipeline cache: {} bytes loaded)\n", pipelineMs,
+                       pipelineCacheSize);
+        } else {
+            std::print("[DEBUG] Pipelines created in {:.2f} ms (pipeline cache: empty)\n", pipelineMs);
+        }
+        renderSystem.setSceneBvh(&sceneBvh);
 
         GolaCamera camera{};
-        auto viewObject = GolaGameObject::createGameObject();
+        GolaEntity viewer = world.createEntity(Transform{}, KeyboardControlComponent{});
         KeyboardMovementController cameraController{};
+        GolaTransformSystem transformSystem{};
+        std::vector<GolaEntity> changedEntities;
 
         auto currentTime = std::chrono::high_resolution_clock::now();
 
         // 主循环逻辑
         while (!window.shouldClose()) {
+            // 帧率限制和呈现设置的切换都在采样输入之前, 输入到提交的延迟从这里开始计算
+            renderer.setPresentSettings(imgui->getPresentSettings());
+            renderer.waitForNextFrame();
             glfwPollEvents();
+            // 任务中需要调用 GLFW 等只能在主线程使用的 API 时, 通过 runOnMainThread 在这里执行
+            jobSystem.pumpMainThreadJobs();
 
             auto newTime = std::chrono::high_resolution_clock::now();
             float frameTime =
                     std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
             currentTime = newTime;
+            // 卡顿统计使用限制之前的帧时间
+            pipelineCompiler.endFrame(frameTime);
+            // 完成的上传交给图形队列, 再提交这一帧预算内的排队数据
+            device.getUploadQueue().endFrame(frameTime);
+            imgui->setPipelineCompilerStats(pipelineCompiler.getStats());
+            imgui->setPipelineRegistryStats(device.getPipelineRegistry().getStats());
+            imgui->setPresentStats(renderer.getPresentStats());
             frameTime = glm::min(frameTime, 0.1f);
 
-            cameraController.moveInPlaneXZ(window.getGLFWwindow(), frameTime, viewObject);
-            camera.setViewYXZ(viewObject.transform.translation,viewObject.transform.rotation);
+            cameraController.moveInPlaneXZ(window.getGLFWwindow(), frameTime, world);
+            // 加载场景不会销毁相机实体, 结构性修改之后需要重新获取组件指针
+            if (Transform *viewTransform = world.getComponent<Transform>(viewer)) {
+                camera.setViewYXZ(viewTransform->getTranslation(), viewTransform->getRotation());
+            }
 
             float aspect = renderer.getAspectRatio();
             // camera.setOrthographicProjection(-aspect, aspect, -1, 1, -1, 1);
             camera.setPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 10.f);
 
+            if (int benchmarkObjects = imgui->takeBenchmarkSceneRequest()) {
+                loadBenchmarkScene(benchmarkObjects);
+                renderSystem.markSceneDirty();
+            }
+            for (size_t index = 0; index < GOLA_BENCHMARK_COUNT; index++) {
+                const auto benchmark = static_cast<GolaBenchmark>(index);
+                // 多线程录制基准测试需要打开的 render pass, 由 RenderSystem 在录制时取走
+                if (benchmark != GolaBenchmark::Recording && imgui->takeBenchmarkRequest(benchmark)) {
+                    runBenchmark(benchmark);
+                }
+            }
+
+            if (imgui->isAnimationEnabled()) {
+                animateObjects(frameTime);
+            }
+            // 只有修改过的实体重新计算矩阵, 并把变化传给 BVH 和渲染系统
+            transformSystem.update(world, changedEntities);
+            if (!changedEntities.empty()) {
+                updateSceneBvh(changedEntities);
+                renderSystem.updateObjects(world, changedEntities);
+            }
+            imgui->setTransformStats(static_cast<uint32_t>(changedEntities.size()), transformSystem.getLastUpdateMs());
+
+            // 只在按下的那一帧拾取, 点击 ImGui 窗口时忽略
+            bool pickButtonDown =
+                    glfwGetMouseButton(window.getGLFWwindow(), GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+            if (pickButtonDown && !pickButtonWasDown && !ImGui::GetIO().WantCaptureMouse) {
+                pickObject(camera);
+            }
+            pickButtonWasDown = pickButtonDown;
+
             if (auto commandBuffer = renderer.beginFrame()) {
-                renderer.beginSwapChainRenderPass(commandBuffer);
-                renderSystem.renderGameObjects(commandBuffer, gameobjects, camera);
-                renderSystem.renderImgui(commandBuffer);
+                int frameIndex = renderer.getFrameIndex();
+                FrameInfo frameInfo{frameIndex, frameTime, commandBuffer, camera, &renderer.getCommandRecorder(),
+                                    &renderer.getGpuProfiler()};
+
+                renderSystem.prepareFrame(world);
+
+                // 每帧重新声明 pass, 拓扑不变时复用上一次的编译结果
+                GolaRenderGraph &renderGraph = renderer.getRenderGraph();
+                renderSystem.addPasses(renderGraph, frameInfo, world, renderer.importSwapChainImage(),
+                                       renderer.getSwapChain().getDepthFormat());
+                renderer.executeRenderGraph(commandBuffer);
+                imgui->setRenderGraphStats(renderGraph.getStats());
 
-                renderer.endSwapChainRenderPass(commandBuffer);
                 renderer.endFrame();
             }
         }
@@ -61,7 +146,75 @@ namespace gola {
         vkDeviceWaitIdle(device.device());
     }
 
-    std::unique_ptr<GolaModel> createCubeModel(GolaDevice &device, glm::vec3 offset) {
+    void GolaApp::runBenchmark(GolaBenchmark benchmark) {
+        switch (benchmark) {
+            case GolaBenchmark::Culling:
+                GolaFrustumCuller::runBenchmark();
+                break;
+            case GolaBenchmark::Bvh:
+                GolaBvh::runBenchmark();
+                break;
+            case GolaBenchmark::Transform:
+                GolaTransformSystem::runBenchmark();
+                break;
+            case GolaBenchmark::Ecs:
+                GolaWorld::runBenchmark();
+                break;
+            case GolaBenchmark::MatrixKernel:
+                GolaMatrixKernel::runBenchmark();
+                break;
+            case GolaBenchmark::Recording:
+                break;
+            case GolaBenchmark::JobSystem:
+                GolaJobSystem::runBenchmark();
+                break;
+            case GolaBenchmark::RenderGraph:
+                GolaRenderGraph::runBenchmark(device);
+                break;
+            case GolaBenchmark::PipelineCache:
+                GolaPipelineCache::runBenchmark(device, renderer.getSwapChainRenderTarget());
+                break;
+            case GolaBenchmark::AsyncPipeline:
+                pipelineCompiler.startBenchmark(renderer.getSwapChainRenderTarget());
+                break;
+            case GolaBenchmark::Specialization:
+                RenderSystem::runSpecializationBenchmark(device);
+                break;
+            case GolaBenchmark::Resize:
+                renderer.runResizeBenchmark();
+                break;
+            case GolaBenchmark::FramePacing:
+                GolaTimeline::runBenchmark(device);
+                break;
+            case GolaBenchmark::Upload:
+                device.getUploadQueue().startBenchmark();
+                break;
+            case GolaBenchmark::ResizeStorm:
+                renderer.startResizeStorm();
+                break;
+            case GolaBenchmark::PresentLatency:
+                renderer.startPresentBenchmark();
+                break;
+            case GolaBenchmark::AllocatorStress:
+                GolaAllocator::runStressTest(device);
+                break;
+            case GolaBenchmark::VertexPlacement:
+                RenderSystem::runVertexPlacementBenchmark(device);
+                break;
+            case GolaBenchmark::GpuProfileExport: {
+                const GolaGpuProfiler &gpuProfiler = renderer.getGpuProfiler();
+                if (gpuProfiler.exportJson(GolaGpuProfiler::EXPORT_PATH)) {
+                    std::print("[DEBUG] Exported {} frames of GPU timings to {}\n", gpuProfiler.getHistory().size(),
+                               GolaGpuProfiler::EXPORT_PATH);
+                } else {
+                    std::print("[DEBUG] Failed to write {}\n", GolaGpuProfiler::EXPORT_PATH);
+                }
+                break;
+            }
+        }
+    }
+
+    std::unique_ptr<GolaModel> createCubeModel(GolaMeshArena &meshArena, glm::vec3 offset) {
         std::vector<GolaModel::Vertex> vertices = {
             // left face (white)
             {{-0.5f, -0.5f, -0.5f}, {1.0f, 1.0f, 1.0f}},
@@ -110,19 +263,134 @@ namespace gola {
             v.position += offset;
         }
 
-        return std::make_unique<GolaModel>(device, vertices);
+        GolaModel::Builder modelBuilder{};
+        modelBuilder.addTriangles(vertices);
+        return std::make_unique<GolaModel>(meshArena, modelBuilder);
     }
 
     void GolaApp::loadGameObjects() {
-        std::shared_ptr<GolaModel> cubeModel = createCubeModel(device, glm::vec3(0.0f, 0.0f, 0.0f));
+        cubeModel = createCubeModel(meshArena, glm::vec3(0.0f, 0.0f, 0.0f));
 
         for (int i = 0; i < 5; i++) {
-            auto gameObject = GolaGameObject::createGameObject();
-            gameObject.model = cubeModel;
-            gameObject.transform.translation = glm::vec3(0.0f, 0.0f, 2.5f);
-            gameObject.transform.scale = glm::vec3(0.5f, 0.5f, 0.5f);
-            gameobjects.push_back(std::move(gameObject));
+            Transform transform{};
+            transform.setTranslation(glm::vec3(0.0f, 0.0f, 2.5f));
+            transform.setScale(glm::vec3(0.5f, 0.5f, 0.5f));
+            world.createEntity(transform, ModelComponent{cubeModel.get()}, ColorComponent{});
+        }
+
+        // 所有模型的上传合并为一次提交
+        device.getStagingRing().flush();
+        rebuildSceneBvh();
+    }
+
+    void GolaApp::loadBenchmarkScene(int count) {
+        // 只销毁带模型的实体, 相机实体保留
+        std::vector<GolaEntity> oldEntities;
+        world.each<ModelComponent>([&](GolaEntity entity, ModelComponent &) { oldEntities.push_back(entity); });
+        for (GolaEntity entity: oldEntities) {
+            world.destroyEntity(entity);
+        }
+
+        // 在相机前方的 XZ 平面上铺成方阵
+        const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+        const float spacing = 0.5f;
+        for (int i = 0; i < count; i++) {
+            Transform transform{};
+            transform.setTranslation(glm::vec3(
+                (static_cast<float>(i % side) - side * 0.5f) * spacing,
+                0.5f,
+                static_cast<float>(i / side) * spacing + 1.0f));
+            transform.setScale(glm::vec3(0.2f));
+            world.createEntity(transform, ModelComponent{cubeModel.get()}, ColorComponent{glm::vec3(1.0f)});
         }
+        std::print("[DEBUG] Loaded benchmark scene with {} cubes\n", count);
+        rebuildSceneBvh();
+    }
+
+    static GolaAabb computeWorldBounds(Transform &transform, const ModelComponent &model) {
+        glm::vec4 sphere = transformBoundingSphere(transform.mat4(), model.model->getBoundingSphere());
+        return GolaAabb::fromSphere(glm::vec3(sphere), sphere.w);
+    }
+
+    void GolaApp::rebuildSceneBvh() {
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        std::vector<GolaBvh::BuildItem> items;
+        items.reserve(world.count<Transform, ModelComponent>());
+        world.each<Transform, ModelComponent>([&](GolaEntity entity, Transform &transform, ModelComponent &model) {
+            items.push_back({entity.index, computeWorldBounds(transform, model)});
+        });
+        sceneBvh.build(items);
+
+        std::print("[DEBUG] Built scene BVH for {} objects in {:.2f} ms (height {})\n", items.size(),
+                   std::chrono::duration<float, std::chrono::milliseconds::period>(
+                       std::chrono::high_resolution_clock::now() - startTime).count(),
+                   sceneBvh.getHeight());
+    }
+
+    void GolaApp::updateSceneBvh(const std::vector<GolaEntity> &changedEntities) {
+        const bool bulkRefit = changedEntities.size() * 8 > sceneBvh.getLeafCount();
+        for (GolaEntity entity: changedEntities) {
+            // 没有模型的实体 (例如相机) 不在 BVH 中
+            const ModelComponent *model = world.getComponent<ModelComponent>(entity);
+            if (model == nullptr) {
+                continue;
+            }
+            GolaAabb bounds = computeWorldBounds(*world.getComponent<Transform>(entity), *model);
+            if (!sceneBvh.contains(entity.index)) {
+                sceneBvh.insert(entity.index, bounds);
+            } else if (bulkRefit) {
+                sceneBvh.setLeafBounds(entity.index, bounds);
+            } else {
+                sceneBvh.update(entity.index, bounds);
+            }
+        }
+        if (bulkRefit) {
+            sceneBvh.refit();
+        }
+    }
+
+    void GolaApp::animateObjects(float frameTime) {
+        const float previousTime = animationTime;
+        animationTime += frameTime;
+        world.each<Transform, ModelComponent>([&](GolaEntity, Transform &transform, ModelComponent &) {
+            glm::vec3 rotation = transform.getRotation();
+            glm::vec3 translation = transform.getTranslation();
+            // 相位随位置变化, 形成波浪; 按增量移动, 停止动画后对象停在当前位置
+            float phase = translation.x + translation.z;
+            translation.y += 0.1f * (glm::sin(animationTime * 2.0f + phase) - glm::sin(previousTime * 2.0f + phase));
+            rotation.y = glm::mod(rotation.y + frameTime, glm::two_pi<float>());
+            transform.setTranslation(translation);
+            transform.setRotation(rotation);
+        });
+    }
+
+    void GolaApp::pickObject(const GolaCamera &camera) {
+        double cursorX, cursorY;
+        glfwGetCursorPos(window.getGLFWwindow(), &cursorX, &cursorY);
+        VkExtent2D extent = window.getExtent();
+
+        // 窗口坐标 -> NDC (Vulkan 的 y 轴向下), 再反投影到近平面和远平面
+        glm::vec2 ndc{
+            2.0f * static_cast<float>(cursorX) / static_cast<float>(extent.width) - 1.0f,
+            2.0f * static_cast<float>(cursorY) / static_cast<float>(extent.height) - 1.0f};
+        glm::mat4 inverseProjectionView = glm::inverse(camera.getProjection() * camera.getView());
+        glm::vec4 nearPoint = inverseProjectionView * glm::vec4(ndc, 0.0f, 1.0f);
+        glm::vec4 farPoint = inverseProjectionView * glm::vec4(ndc, 1.0f, 1.0f);
+        glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+        glm::vec3 toFar = glm::vec3(farPoint) / farPoint.w - origin;
+
+        GolaBvh::RayHit hit{};
+        if (!sceneBvh.raycast(origin, glm::normalize(toFar), glm::length(toFar), hit)) {
+            std::print("[DEBUG] Picked nothing\n");
+            return;
+        }
+
+        glm::vec3 hitPoint = origin + glm::normalize(toFar) * hit.distance;
+        std::vector<GolaBvh::id_t> nearby;
+        sceneBvh.queryAabb({hitPoint - glm::vec3(1.0f), hitPoint + glm::vec3(1.0f)}, nearby);
+        std::print("[DEBUG] Picked entity {} at distance {:.2f}, {} entities within 1 unit\n",
+                   hit.id, hit.distance, nearby.size());
     }
 
     void GolaApp::initImgui() {
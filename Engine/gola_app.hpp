@@ -2,9 +2,15 @@
 
 #include "Window/gola_window.hpp"
 #include "Core/gola_pipeline.hpp"
+#include "Core/gola_pipeline_compiler.hpp"
 #include "Core/gola_device.hpp"
-#include "Core/gola_game_object.hpp"
+#include "Core/gola_bvh.hpp"
+#include "Core/gola_camera.hpp"
+#include "Core/gola_components.hpp"
+#include "Core/gola_ecs.hpp"
 #include "Core/gola_renderer.hpp"
+#include "Core/gola_mesh_arena.hpp"
+#include "Core/gola_model.hpp"
 #include "UI/gola_imgui.hpp"
 
 #include <memory>
@@ -31,11 +37,38 @@ namespace gola {
 
         void loadGameObjects();
 
+        // 基准测试场景: count 个共享同一模型的立方体, 用于比较逐对象绘制与实例化绘制
+        void loadBenchmarkScene(int count);
+
+        // 场景变化后用所有可渲染实体的世界空间包围盒重建 sceneBvh, 叶子 id 为 GolaEntity::index
+        void rebuildSceneBvh();
+
+        // 变换改变的实体: 少量时逐个增量更新 sceneBvh, 大量时只写叶子再整体 refit
+        void updateSceneBvh(const std::vector<GolaEntity> &changedEntities);
+
+        // 所有带模型的实体绕 y 轴旋转并上下浮动
+        void animateObjects(float frameTime);
+
+        // 左键点击: 用 sceneBvh 做射线拾取, 并查询拾取点附近的对象
+        void pickObject(const GolaCamera &camera);
+
+        // 运行调试界面上按下的基准测试, 在帧开始之前调用
+        void runBenchmark(GolaBenchmark benchmark);
+
         GolaWindow window{WIDTH, HEIGHT, "Gola GameEngine Application"};
         GolaDevice device{window};
         GolaRenderer renderer{window, device};
+        // 在 RenderSystem 之前构造, 之后析构; 析构时等待还在编译的管线
+        GolaPipelineCompiler pipelineCompiler{device};
+        // 必须在 world 之前构造, 之后析构
+        GolaMeshArena meshArena{device, sizeof(GolaModel::Vertex)};
 
-        std::vector<GolaGameObject> gameobjects;
+        // 模型由 app 持有, ModelComponent 只保存指针
+        std::shared_ptr<GolaModel> cubeModel;
+        GolaWorld world;
+        GolaBvh sceneBvh;
+        bool pickButtonWasDown = false;
+        float animationTime = 0.0f;
         std::unique_ptr<GolaImgui> imgui;
     };
 }
@@ -1,3 +1,8 @@
 "C:\VulkanSDK\1.4.313.2\Bin\glslc.exe" simple_shader.vert -o simple_shader.vert.spv
 "C:\VulkanSDK\1.4.313.2\Bin\glslc.exe" simple_shader.frag -o simple_shader.frag.spv
+"C:\VulkanSDK\1.4.313.2\Bin\glslc.exe" instanced_shader.vert -o instanced_shader.vert.spv
+"C:\VulkanSDK\1.4.313.2\Bin\glslc.exe" gpu_driven.vert -o gpu_driven.vert.spv
+"C:\VulkanSDK\1.4.313.2\Bin\glslc.exe" fullscreen_triangle.vert -o fullscreen_triangle.vert.spv
+"C:\VulkanSDK\1.4.313.2\Bin\glslc.exe" surface_shader.frag -o surface_shader.frag.spv
+"C:\VulkanSDK\1.4.313.2\Bin\glslc.exe" build_draws.comp -o build_draws.comp.spv
 pause
\ No newline at end of file
@@ -0,0 +1,22 @@
+#version 450
+
+// 不使用顶点缓冲区的全屏三角形, 输出与 surface_shader.frag 的输入一致, 用于测量片元着色的开销
+
+layout (location = 0) out vec3 fragColor;
+layout (location = 1) flat out vec3 fragObjectColor;
+layout (location = 2) out vec3 fragPosition;
+
+layout (push_constant) uniform Push {
+    mat4 transform;
+    vec3 color;
+    uint flags;
+} push;
+
+void main() {
+    vec2 uv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+    fragColor = vec3(uv, 0.5);
+    fragObjectColor = push.color;
+    // 起伏的表面, 让导数得到的法线在屏幕上变化
+    fragPosition = vec3(uv, 0.05 * sin(uv.x * 40.0) * cos(uv.y * 40.0));
+}
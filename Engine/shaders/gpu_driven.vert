@@ -0,0 +1,34 @@
+#version 450
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 color;
+
+layout (location = 0) out vec3 fragColor;
+// surface_shader.frag 使用, simple_shader.frag 忽略
+layout (location = 1) flat out vec3 fragObjectColor;
+layout (location = 2) out vec3 fragPosition;
+
+struct ObjectData {
+    mat4 transform;
+    vec4 color;
+    uint meshIndex;
+};
+
+layout (std430, set = 0, binding = 0) readonly buffer Objects {
+    ObjectData objects[];
+};
+
+// transform 存放 projection * view, 模型矩阵来自对象缓冲区
+layout (push_constant) uniform Push {
+    mat4 transform;
+    vec3 color;
+} push;
+
+void main() {
+    // indirect 命令的 firstInstance 就是对象索引
+    ObjectData object = objects[gl_InstanceIndex];
+    gl_Position = push.transform * object.transform * vec4(position, 1.0);
+    fragColor = color;
+    fragObjectColor = object.color.rgb;
+    fragPosition = position;
+}
@@ -0,0 +1,20 @@
+#version 450
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 color;
+
+// per-instance
+layout (location = 2) in mat4 instanceTransform;
+layout (location = 6) in vec4 instanceColor;
+
+layout (location = 0) out vec3 fragColor;
+// surface_shader.frag 使用, simple_shader.frag 忽略
+layout (location = 1) flat out vec3 fragObjectColor;
+layout (location = 2) out vec3 fragPosition;
+
+void main() {
+    gl_Position = instanceTransform * vec4(position, 1.0);
+    fragColor = color;
+    fragObjectColor = instanceColor.rgb;
+    fragPosition = position;
+}
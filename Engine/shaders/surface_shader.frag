@@ -0,0 +1,46 @@
+#version 450
+
+// 特化常量由 PipelineConfigInfo::fragmentSpecialization 设置, 每种组合是单独编译的管线
+// 0: 使用插值的顶点颜色, 否则使用对象颜色
+layout (constant_id = 0) const bool USE_VERTEX_COLOR = true;
+// 1: 方向光, 顶点没有法线, 由位置的屏幕空间导数得到面法线
+layout (constant_id = 1) const bool LIGHTING = false;
+// 2: 忽略上面两个常量, 在运行时读取 push.flags (只用于比较动态分支与特化的开销)
+layout (constant_id = 2) const bool RUNTIME_BRANCHES = false;
+
+const uint FLAG_VERTEX_COLOR = 1u;
+const uint FLAG_LIGHTING = 2u;
+
+layout (location = 0) in vec3 fragColor;
+layout (location = 1) flat in vec3 fragObjectColor;
+layout (location = 2) in vec3 fragPosition;
+
+layout (location = 0) out vec4 outColor;
+
+// flags 占用 color 之后的 4 字节, 仍在 80 字节的 push constant 范围内
+layout (push_constant) uniform Push {
+    mat4 transform;
+    vec3 color;
+    uint flags;
+} push;
+
+const vec3 LIGHT_DIRECTION = normalize(vec3(1.0, -3.0, -1.0));
+const float AMBIENT = 0.2;
+
+void main() {
+    bool useVertexColor = USE_VERTEX_COLOR;
+    bool lighting = LIGHTING;
+    if (RUNTIME_BRANCHES) {
+        useVertexColor = (push.flags & FLAG_VERTEX_COLOR) != 0u;
+        lighting = (push.flags & FLAG_LIGHTING) != 0u;
+    }
+
+    vec3 color = useVertexColor ? fragColor : fragObjectColor;
+    if (lighting) {
+        // 对象空间的面法线, 叉积的方向取决于三角形的绕向, 因此按双面光照计算
+        vec3 normal = normalize(cross(dFdx(fragPosition), dFdy(fragPosition)));
+        float diffuse = abs(dot(normal, LIGHT_DIRECTION));
+        color *= AMBIENT + (1.0 - AMBIENT) * diffuse;
+    }
+    outColor = vec4(color, 1.0);
+}
@@ -0,0 +1,213 @@
+#include "gola_test.hpp"
+
+#include "../Engine/Core/gola_bvh.hpp"
+#include "../Engine/Core/gola_camera.hpp"
+#include "../Engine/Core/gola_cpu_features.hpp"
+#include "../Engine/Core/gola_frustum_culler.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace gola {
+    // 与剔除和 BVH 基准测试相同的场景: 相机位于原点看向 +z, 对象均匀分布在相机周围
+    static GolaFrustum testFrustum() {
+        GolaCamera camera{};
+        camera.setPerspectiveProjection(glm::radians(50.f), 4.0f / 3.0f, 0.1f, 100.f);
+        camera.setViewYXZ(glm::vec3(0.0f), glm::vec3(0.0f));
+        return GolaFrustum::fromMatrix(camera.getProjection() * camera.getView());
+    }
+
+    static std::vector<GolaBvh::BuildItem> randomItems(uint32_t count, std::mt19937 &rng) {
+        std::uniform_real_distribution<float> position{-100.0f, 100.0f};
+        std::uniform_real_distribution<float> radius{0.1f, 2.0f};
+        std::vector<GolaBvh::BuildItem> items(count);
+        for (uint32_t i = 0; i < count; i++) {
+            items[i] = {i, GolaAabb::fromSphere(glm::vec3(position(rng), position(rng), position(rng)), radius(rng))};
+        }
+        return items;
+    }
+
+    // 以下是逐个对象的参考实现
+    static bool bruteForceIntersectsFrustum(const GolaAabb &bounds, const GolaFrustum &frustum) {
+        for (const auto &plane: frustum.planes) {
+            glm::vec3 normal{plane};
+            glm::vec3 farthest = glm::mix(bounds.min, bounds.max, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+            if (glm::dot(normal, farthest) + plane.w < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static std::vector<GolaBvh::id_t> bruteForceFrustum(const std::vector<GolaBvh::BuildItem> &items,
+                                                        const GolaFrustum &frustum) {
+        std::vector<GolaBvh::id_t> ids;
+        for (const auto &item: items) {
+            if (bruteForceIntersectsFrustum(item.bounds, frustum)) {
+                ids.push_back(item.id);
+            }
+        }
+        return ids;
+    }
+
+    static std::vector<GolaBvh::id_t> bruteForceAabb(const std::vector<GolaBvh::BuildItem> &items,
+                                                     const GolaAabb &box) {
+        std::vector<GolaBvh::id_t> ids;
+        for (const auto &item: items) {
+            if (item.bounds.overlaps(box)) {
+                ids.push_back(item.id);
+            }
+        }
+        return ids;
+    }
+
+    static bool bruteForceRaycast(const std::vector<GolaBvh::BuildItem> &items, const glm::vec3 &origin,
+                                  const glm::vec3 &direction, float maxDistance, float &closest) {
+        const glm::vec3 inverseDirection = 1.0f / direction;
+        bool found = false;
+        closest = maxDistance;
+        for (const auto &item: items) {
+            glm::vec3 t1 = (item.bounds.min - origin) * inverseDirection;
+            glm::vec3 t2 = (item.bounds.max - origin) * inverseDirection;
+            glm::vec3 tNear = glm::min(t1, t2);
+            glm::vec3 tFar = glm::max(t1, t2);
+            float tEnter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+            float tExit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, closest));
+            if (tEnter <= tExit && (!found || tEnter < closest)) {
+                closest = tEnter;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    // 视锥, 射线和 AABB 查询都与逐个对象测试一致
+    static void checkQueries(const GolaBvh &bvh, const std::vector<GolaBvh::BuildItem> &items, std::mt19937 &rng) {
+        const GolaFrustum frustum = testFrustum();
+        std::vector<GolaBvh::id_t> results;
+        bvh.queryFrustum(frustum, results);
+        std::sort(results.begin(), results.end());
+        GOLA_CHECK(results == bruteForceFrustum(items, frustum));
+
+        std::uniform_real_distribution<float> position{-100.0f, 100.0f};
+        std::uniform_real_distribution<float> unit{-1.0f, 1.0f};
+        uint32_t rayMismatches = 0;
+        for (int r = 0; r < 100; r++) {
+            const glm::vec3 origin{position(rng), position(rng), position(rng)};
+            const glm::vec3 direction =
+                    glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 1e-3f));
+            float closest;
+            const bool found = bruteForceRaycast(items, origin, direction, 1000.0f, closest);
+            GolaBvh::RayHit hit{};
+            const bool bvhFound = bvh.raycast(origin, direction, 1000.0f, hit);
+            if (bvhFound != found || (found && std::abs(hit.distance - closest) > 1e-4f * std::max(1.0f, closest))) {
+                rayMismatches++;
+            }
+        }
+        GOLA_CHECK(rayMismatches == 0);
+
+        uint32_t overlapMismatches = 0;
+        for (int q = 0; q < 100; q++) {
+            const glm::vec3 center{position(rng), position(rng), position(rng)};
+            const GolaAabb box{center - glm::vec3(5.0f), center + glm::vec3(5.0f)};
+            bvh.queryAabb(box, results);
+            std::sort(results.begin(), results.end());
+            if (results != bruteForceAabb(items, box)) {
+                overlapMismatches++;
+            }
+        }
+        GOLA_CHECK(overlapMismatches == 0);
+    }
+
+    GOLA_TEST(culling, frustum_culler_simd_matches_scalar) {
+        const auto &cpu = GolaCpuFeatures::get();
+        std::vector implementations{GolaFrustumCuller::Implementation::Scalar};
+        if (cpu.sse2) implementations.push_back(GolaFrustumCuller::Implementation::Sse2);
+        if (cpu.avx2) implementations.push_back(GolaFrustumCuller::Implementation::Avx2);
+
+        const GolaFrustum frustum = testFrustum();
+        std::mt19937 rng{12345};
+        std::uniform_real_distribution<float> position{-100.0f, 100.0f};
+        std::uniform_real_distribution<float> radius{0.1f, 2.0f};
+        // 不是 SIMD 宽度的倍数; 第二个数量超过 PARALLEL_THRESHOLD, 走并行剔除
+        for (uint32_t objectCount: {1'003u, GolaFrustumCuller::PARALLEL_THRESHOLD * 2 + 5}) {
+            GolaFrustumCuller culler{};
+            culler.resize(objectCount);
+            std::vector<uint32_t> reference;
+            for (uint32_t i = 0; i < objectCount; i++) {
+                const glm::vec3 center{position(rng), position(rng), position(rng)};
+                const float r = radius(rng);
+                culler.setSphere(i, center, r);
+                if (frustum.intersectsSphere(center, r)) {
+                    reference.push_back(i);
+                }
+            }
+            GOLA_CHECK(!reference.empty());
+
+            std::vector<uint32_t> visible;
+            for (auto impl: implementations) {
+                const uint32_t visibleCount = culler.cull(frustum, visible, impl);
+                GOLA_CHECK(visibleCount == visible.size());
+                GOLA_CHECK(visible == reference);
+            }
+        }
+    }
+
+    GOLA_TEST(culling, bvh_serial_and_parallel_builds_match_brute_force) {
+        // 超过 PARALLEL_BUILD_THRESHOLD, 并行构建真正拆分子树
+        std::mt19937 rng{12345};
+        const std::vector<GolaBvh::BuildItem> items = randomItems(GolaBvh::PARALLEL_BUILD_THRESHOLD * 3, rng);
+        for (bool parallel: {false, true}) {
+            GolaBvh bvh{};
+            bvh.build(items, parallel);
+            GOLA_CHECK(bvh.getLeafCount() == items.size());
+            checkQueries(bvh, items, rng);
+        }
+    }
+
+    GOLA_TEST(culling, bvh_queries_stay_correct_after_updates) {
+        std::mt19937 rng{54321};
+        std::vector<GolaBvh::BuildItem> items = randomItems(20'000, rng);
+        GolaBvh bvh{};
+        bvh.build(items);
+
+        // 所有对象小幅移动: 只写叶子再整体 refit
+        std::uniform_real_distribution<float> jitter{-0.5f, 0.5f};
+        for (auto &item: items) {
+            const glm::vec3 offset{jitter(rng), jitter(rng), jitter(rng)};
+            item.bounds = {item.bounds.min + offset, item.bounds.max + offset};
+            bvh.setLeafBounds(item.id, item.bounds);
+        }
+        bvh.refit();
+        checkQueries(bvh, items, rng);
+
+        // 10% 的对象大幅移动: 增量更新 + 旋转
+        std::uniform_real_distribution<float> position{-100.0f, 100.0f};
+        std::uniform_int_distribution<size_t> pick{0, items.size() - 1};
+        for (size_t i = 0; i < items.size() / 10; i++) {
+            auto &item = items[pick(rng)];
+            const glm::vec3 center{position(rng), position(rng), position(rng)};
+            const glm::vec3 halfExtent = item.bounds.extent() * 0.5f;
+            item.bounds = {center - halfExtent, center + halfExtent};
+            bvh.update(item.id, item.bounds);
+        }
+        checkQueries(bvh, items, rng);
+
+        // 删除一部分, 再把其中一半插回去
+        std::vector<GolaBvh::BuildItem> removed(items.end() - 2'000, items.end());
+        items.resize(items.size() - removed.size());
+        for (const auto &item: removed) {
+            bvh.remove(item.id);
+        }
+        for (size_t i = 0; i < removed.size(); i += 2) {
+            bvh.insert(removed[i].id, removed[i].bounds);
+            items.push_back(removed[i]);
+        }
+        GOLA_CHECK(bvh.getLeafCount() == items.size());
+        GOLA_CHECK(bvh.contains(removed[0].id) && !bvh.contains(removed[1].id));
+        checkQueries(bvh, items, rng);
+    }
+}
@@ -0,0 +1,125 @@
+#include "gola_test.hpp"
+
+#include "../Engine/Core/gola_ecs.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace gola {
+    // 只在测试中使用的组件, 值由实体的创建顺序决定, 用于检查句柄解析到的是不是自己的组件
+    struct TestIdComponent {
+        uint32_t id;
+    };
+
+    struct TestVelocityComponent {
+        float value;
+    };
+
+    GOLA_TEST(ecs, destroyed_handle_is_dead) {
+        GolaWorld world{};
+        const GolaEntity entity = world.createEntity(TestIdComponent{7});
+        GOLA_CHECK(world.isAlive(entity));
+        GOLA_CHECK(world.getComponent<TestIdComponent>(entity)->id == 7);
+
+        world.destroyEntity(entity);
+        GOLA_CHECK(!world.isAlive(entity));
+        GOLA_CHECK(world.getComponent<TestIdComponent>(entity) == nullptr);
+        GOLA_CHECK(!world.hasComponent<TestIdComponent>(entity));
+        GOLA_CHECK(world.getEntityCount() == 0);
+        GOLA_CHECK(!world.isAlive(GolaEntity{}));
+    }
+
+    GOLA_TEST(ecs, recycled_index_gets_new_generation) {
+        GolaWorld world{};
+        const GolaEntity first = world.createEntity(TestIdComponent{1});
+        world.destroyEntity(first);
+        const GolaEntity second = world.createEntity(TestIdComponent{2});
+
+        GOLA_CHECK(second.index == first.index);
+        GOLA_CHECK(second.generation != first.generation);
+        GOLA_CHECK(!world.isAlive(first));
+        GOLA_CHECK(world.isAlive(second));
+        // 旧句柄不会指向复用槽位的新实体
+        GOLA_CHECK(world.getComponent<TestIdComponent>(first) == nullptr);
+        GOLA_CHECK(world.getComponent<TestIdComponent>(second)->id == 2);
+    }
+
+    GOLA_TEST(ecs, swap_remove_keeps_other_handles_valid) {
+        // 跨越多个 chunk, 被删除的行由最后一个 chunk 的最后一行填补
+        constexpr uint32_t entityCount = 5'000;
+        GolaWorld world{};
+        std::vector<GolaEntity> entities;
+        for (uint32_t i = 0; i < entityCount; i++) {
+            entities.push_back(world.createEntity(TestIdComponent{i}));
+        }
+
+        std::vector<bool> destroyed(entityCount, false);
+        for (uint32_t i = 0; i < entityCount; i += 7) {
+            world.destroyEntity(entities[i]);
+            destroyed[i] = true;
+        }
+
+        uint32_t mismatches = 0;
+        uint32_t alive = 0;
+        for (uint32_t i = 0; i < entityCount; i++) {
+            if (destroyed[i]) {
+                mismatches += world.isAlive(entities[i]) ? 1 : 0;
+                continue;
+            }
+            alive++;
+            const TestIdComponent *component = world.getComponent<TestIdComponent>(entities[i]);
+            if (component == nullptr || component->id != i) {
+                mismatches++;
+            }
+        }
+        GOLA_CHECK(mismatches == 0);
+        GOLA_CHECK(world.getEntityCount() == alive);
+        GOLA_CHECK(world.count<TestIdComponent>() == alive);
+    }
+
+    GOLA_TEST(ecs, handles_survive_archetype_moves) {
+        constexpr uint32_t entityCount = 3'000;
+        GolaWorld world{};
+        std::vector<GolaEntity> entities;
+        for (uint32_t i = 0; i < entityCount; i++) {
+            entities.push_back(world.createEntity(TestIdComponent{i}));
+        }
+
+        // 每隔一个实体移动到 {Id, Velocity}, 源 archetype 中的空位由其他实体填补
+        for (uint32_t i = 0; i < entityCount; i += 2) {
+            world.addComponent(entities[i], TestVelocityComponent{static_cast<float>(i)});
+        }
+        // 其中一部分再移动到 {Velocity}
+        for (uint32_t i = 0; i < entityCount; i += 6) {
+            world.removeComponent<TestIdComponent>(entities[i]);
+        }
+
+        uint32_t mismatches = 0;
+        for (uint32_t i = 0; i < entityCount; i++) {
+            const GolaEntity entity = entities[i];
+            const bool hasVelocity = i % 2 == 0;
+            const bool hasId = i % 6 != 0;
+            if (!world.isAlive(entity) || world.hasComponent<TestVelocityComponent>(entity) != hasVelocity ||
+                world.hasComponent<TestIdComponent>(entity) != hasId) {
+                mismatches++;
+                continue;
+            }
+            if (hasId && world.getComponent<TestIdComponent>(entity)->id != i) {
+                mismatches++;
+            }
+            if (hasVelocity && world.getComponent<TestVelocityComponent>(entity)->value != static_cast<float>(i)) {
+                mismatches++;
+            }
+        }
+        GOLA_CHECK(mismatches == 0);
+        GOLA_CHECK(world.getEntityCount() == entityCount);
+        const uint32_t idAndVelocity = world.count<TestIdComponent, TestVelocityComponent>();
+        GOLA_CHECK(idAndVelocity == entityCount / 2 - entityCount / 6);
+
+        // 移动之后销毁一个实体, 仍然只影响它自己
+        world.destroyEntity(entities[1]);
+        GOLA_CHECK(!world.isAlive(entities[1]));
+        GOLA_CHECK(world.getComponent<TestIdComponent>(entities[3])->id == 3);
+    }
+}
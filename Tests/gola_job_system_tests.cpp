@@ -0,0 +1,203 @@
+#include "gola_test.hpp"
+
+#include "../Engine/Core/gola_job_system.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace gola {
+    GOLA_TEST(job_system, deque_owner_pops_lifo_thief_steals_fifo) {
+        GolaWorkStealingDeque<uint32_t> deque{4};
+        GOLA_CHECK(deque.empty());
+        // 超过初始容量, 触发扩容
+        for (uint32_t i = 0; i < 100; i++) {
+            deque.push(i);
+        }
+
+        uint32_t item = 0;
+        GOLA_CHECK(deque.steal(item) && item == 0);
+        GOLA_CHECK(deque.pop(item) && item == 99);
+        for (uint32_t expected = 98; expected >= 1; expected--) {
+            GOLA_CHECK(deque.pop(item) && item == expected);
+        }
+        GOLA_CHECK(deque.empty());
+        GOLA_CHECK(!deque.pop(item));
+        GOLA_CHECK(!deque.steal(item));
+    }
+
+    GOLA_TEST(job_system, deque_concurrent_steal_takes_each_item_once) {
+        constexpr uint32_t itemCount = 200'000;
+        constexpr uint32_t thiefCount = 3;
+        GolaWorkStealingDeque<uint32_t> deque{64};
+        std::vector<std::atomic<uint32_t>> taken(itemCount);
+        std::atomic<bool> ownerDone{false};
+
+        std::vector<std::thread> thieves;
+        for (uint32_t t = 0; t < thiefCount; t++) {
+            thieves.emplace_back([&] {
+                uint32_t item;
+                while (!ownerDone.load(std::memory_order_acquire) || !deque.empty()) {
+                    if (deque.steal(item)) {
+                        taken[item].fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            });
+        }
+
+        // 所有者交替 push 和 pop, 与窃取者竞争最后一个元素
+        uint32_t item;
+        for (uint32_t i = 0; i < itemCount; i++) {
+            deque.push(i);
+            if (i % 3 == 0 && deque.pop(item)) {
+                taken[item].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        while (deque.pop(item)) {
+            taken[item].fetch_add(1, std::memory_order_relaxed);
+        }
+        ownerDone.store(true, std::memory_order_release);
+        for (auto &thief: thieves) {
+            thief.join();
+        }
+
+        GOLA_CHECK(std::all_of(taken.begin(), taken.end(), [](const std::atomic<uint32_t> &count) {
+            return count.load() == 1;
+        }));
+    }
+
+    GOLA_TEST(job_system, counter_reaches_zero_after_all_jobs) {
+        GolaJobSystem &jobs = GolaJobSystem::get();
+        GolaJobCounter counter;
+        GOLA_CHECK(counter.isDone());
+
+        std::atomic<uint32_t> executed{0};
+        for (int round = 0; round < 3; round++) {
+            for (uint32_t i = 0; i < 10'000; i++) {
+                jobs.run([&executed] { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+            }
+            jobs.wait(counter);
+            GOLA_CHECK(counter.isDone());
+            GOLA_CHECK(executed.load() == 10'000u * (round + 1));
+        }
+    }
+
+    GOLA_TEST(job_system, nested_jobs_wait_for_children) {
+        GolaJobSystem &jobs = GolaJobSystem::get();
+        std::atomic<uint32_t> leafCount{0};
+        std::function<void(int)> spawn = [&](int depth) {
+            if (depth == 0) {
+                leafCount.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            GolaJobCounter children;
+            jobs.run([&spawn, depth] { spawn(depth - 1); }, &children);
+            jobs.run([&spawn, depth] { spawn(depth - 1); }, &children);
+            jobs.wait(children);
+        };
+        spawn(12);
+        GOLA_CHECK(leafCount.load() == 1u << 12);
+    }
+
+    GOLA_TEST(job_system, run_after_starts_once_dependency_is_done) {
+        GolaJobSystem &jobs = GolaJobSystem::get();
+        constexpr uint32_t producerCount = 256;
+        std::vector<uint32_t> values(producerCount, 0);
+        std::atomic<bool> allProduced{false};
+        GolaJobCounter produced;
+        GolaJobCounter consumed;
+        for (uint32_t i = 0; i < producerCount; i++) {
+            jobs.run([&values, i] { values[i] = i + 1; }, &produced);
+        }
+        jobs.runAfter(produced, [&] {
+            bool ok = true;
+            for (uint32_t i = 0; i < producerCount; i++) {
+                ok &= values[i] == i + 1;
+            }
+            allProduced = ok;
+        }, &consumed);
+        jobs.wait(consumed);
+        jobs.wait(produced);
+        GOLA_CHECK(allProduced.load());
+
+        // 依赖已经归零时立即提交
+        std::atomic<bool> ran{false};
+        jobs.runAfter(produced, [&ran] { ran = true; }, &consumed);
+        jobs.wait(consumed);
+        GOLA_CHECK(ran.load());
+    }
+
+    GOLA_TEST(job_system, main_thread_jobs_run_on_main_thread) {
+        GolaJobSystem &jobs = GolaJobSystem::get();
+        std::atomic<bool> onMainThread{false};
+        GolaJobCounter done;
+        GolaJobCounter mainJob;
+        jobs.run([&] {
+            jobs.runOnMainThread([&] { onMainThread = jobs.isMainThread(); }, &mainJob);
+        }, &done);
+        jobs.wait(done);
+        jobs.wait(mainJob);
+        GOLA_CHECK(onMainThread.load());
+    }
+
+    GOLA_TEST(job_system, worker_jobs_never_run_on_main_thread) {
+        GolaJobSystem &jobs = GolaJobSystem::get();
+        std::atomic<uint32_t> onMainThread{0};
+        GolaJobCounter counter;
+        for (uint32_t i = 0; i < 1'000; i++) {
+            jobs.runOnWorker([&] {
+                if (jobs.isMainThread()) {
+                    onMainThread.fetch_add(1, std::memory_order_relaxed);
+                }
+            }, &counter);
+        }
+        jobs.wait(counter);
+        // 没有工作线程时 runOnWorker 退化为 run
+        GOLA_CHECK(jobs.getThreadCount() == 1 || onMainThread.load() == 0);
+    }
+
+    GOLA_TEST(job_system, parallel_for_visits_each_index_once) {
+        GolaJobSystem &jobs = GolaJobSystem::get();
+        constexpr uint32_t count = 1'000'003;
+        constexpr uint32_t alignment = 16;
+        std::vector<uint8_t> visits(count, 0);
+        for (uint32_t chunks: {1u, 2u, 3u, jobs.getThreadCount(), 64u}) {
+            std::fill(visits.begin(), visits.end(), 0);
+            std::atomic<bool> aligned{true};
+            const uint32_t used = jobs.parallelFor(count, chunks, [&](uint32_t begin, uint32_t end, uint32_t) {
+                if (begin % alignment != 0) {
+                    aligned = false;
+                }
+                for (uint32_t i = begin; i < end; i++) {
+                    visits[i]++;
+                }
+            }, alignment);
+            GOLA_CHECK(used >= 1 && used <= chunks);
+            GOLA_CHECK(aligned.load());
+            GOLA_CHECK(std::all_of(visits.begin(), visits.end(), [](uint8_t v) { return v == 1; }));
+        }
+        GOLA_CHECK(jobs.parallelFor(0, 8, [](uint32_t, uint32_t, uint32_t) {}) == 0);
+    }
+
+    GOLA_TEST(job_system, parallel_for_rethrows_after_all_chunks) {
+        GolaJobSystem &jobs = GolaJobSystem::get();
+        std::atomic<uint32_t> finishedChunks{0};
+        bool caught = false;
+        try {
+            jobs.parallelFor(64, 8, [&](uint32_t, uint32_t, uint32_t chunk) {
+                finishedChunks.fetch_add(1, std::memory_order_relaxed);
+                if (chunk == 5) {
+                    throw std::runtime_error("chunk failed");
+                }
+            });
+        } catch (const std::runtime_error &) {
+            caught = true;
+        }
+        GOLA_CHECK(caught);
+        GOLA_CHECK(finishedChunks.load() == 8);
+    }
+}
@@ -0,0 +1,156 @@
+#include "gola_test.hpp"
+
+#include "../Engine/Core/gola_cpu_features.hpp"
+#include "../Engine/Core/gola_matrix_kernel.hpp"
+
+#include <gtc/matrix_transform.hpp>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace gola {
+    // 超过这个误差 (相对于矩阵中绝对值最大的元素) 视为与参考结果不一致
+    static constexpr float MAX_RELATIVE_ERROR = 1e-5f;
+
+    static float relativeError(const glm::mat4 &actual, const glm::mat4 &expected) {
+        float magnitude = 1.0f;
+        float error = 0.0f;
+        for (int column = 0; column < 4; column++) {
+            for (int row = 0; row < 4; row++) {
+                magnitude = std::max(magnitude, std::abs(expected[column][row]));
+                error = std::max(error, std::abs(actual[column][row] - expected[column][row]));
+            }
+        }
+        return error / magnitude;
+    }
+
+    static std::vector<GolaMatrixKernel::Implementation> availableImplementations() {
+        const auto &cpu = GolaCpuFeatures::get();
+        std::vector implementations{GolaMatrixKernel::Implementation::Scalar};
+        if (cpu.avx2) implementations.push_back(GolaMatrixKernel::Implementation::Avx2);
+        if (cpu.avx512f) implementations.push_back(GolaMatrixKernel::Implementation::Avx512);
+        return implementations;
+    }
+
+    // 包含较大的角度, 覆盖 sin/cos 的范围缩减
+    static std::vector<Transform> randomTransforms(uint32_t count) {
+        std::mt19937 rng{12345};
+        std::uniform_real_distribution<float> position{-100.0f, 100.0f};
+        std::uniform_real_distribution<float> angle{-50.0f, 50.0f};
+        std::uniform_real_distribution<float> scale{0.1f, 2.0f};
+        std::vector<Transform> transforms(count);
+        for (auto &transform: transforms) {
+            transform.setTranslation(glm::vec3(position(rng), position(rng), position(rng)));
+            transform.setRotation(glm::vec3(angle(rng), angle(rng), angle(rng)));
+            transform.setScale(glm::vec3(scale(rng), scale(rng), scale(rng)));
+        }
+        return transforms;
+    }
+
+    GOLA_TEST(matrix_kernel, build_model_matrices_matches_transform_mat4) {
+        // 不是 SIMD_WIDTH 的倍数, 覆盖补齐项
+        constexpr uint32_t count = 10'007;
+        std::vector<Transform> transforms = randomTransforms(count);
+        GolaMatrixKernel kernel{};
+        kernel.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            kernel.setTransform(i, transforms[i]);
+        }
+
+        for (auto impl: availableImplementations()) {
+            std::vector<glm::mat4> matrices(count + 1, glm::mat4{-1.0f});
+            kernel.buildModelMatrices(0, count, matrices.data(), impl);
+            float maxError = 0.0f;
+            for (uint32_t i = 0; i < count; i++) {
+                maxError = std::max(maxError, relativeError(matrices[i], transforms[i].mat4()));
+            }
+            GOLA_CHECK(maxError <= MAX_RELATIVE_ERROR);
+            // 最后一个对象之后不写入
+            GOLA_CHECK(matrices[count] == glm::mat4{-1.0f});
+        }
+    }
+
+    GOLA_TEST(matrix_kernel, build_model_matrices_writes_only_its_range) {
+        constexpr uint32_t count = 100;
+        constexpr uint32_t begin = GolaMatrixKernel::SIMD_WIDTH * 2;
+        constexpr uint32_t end = 77;
+        std::vector<Transform> transforms = randomTransforms(count);
+        GolaMatrixKernel kernel{};
+        kernel.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            kernel.setTransform(i, transforms[i]);
+        }
+
+        for (auto impl: availableImplementations()) {
+            std::vector<glm::mat4> matrices(count, glm::mat4{-1.0f});
+            kernel.buildModelMatrices(begin, end, matrices.data(), impl);
+            bool outsideUntouched = true;
+            float maxError = 0.0f;
+            for (uint32_t i = 0; i < count; i++) {
+                if (i < begin || i >= end) {
+                    outsideUntouched &= matrices[i] == glm::mat4{-1.0f};
+                } else {
+                    maxError = std::max(maxError, relativeError(matrices[i], transforms[i].mat4()));
+                }
+            }
+            GOLA_CHECK(outsideUntouched);
+            GOLA_CHECK(maxError <= MAX_RELATIVE_ERROR);
+        }
+    }
+
+    GOLA_TEST(matrix_kernel, write_instances_matches_glm) {
+        constexpr uint32_t objectCount = 1'003;
+        std::vector<Transform> transforms = randomTransforms(objectCount);
+        std::vector<RenderObject> objects(objectCount);
+        for (uint32_t i = 0; i < objectCount; i++) {
+            const float shade = static_cast<float>(i) / objectCount;
+            objects[i] = {GolaEntity{i, 0}, &transforms[i], nullptr, glm::vec3(shade, 1.0f - shade, 0.5f)};
+        }
+        // 渲染路径按可见对象的下标收集: 跳过一部分并打乱顺序
+        std::vector<uint32_t> indices;
+        for (uint32_t i = 0; i < objectCount; i += 3) {
+            indices.push_back(i);
+        }
+        std::shuffle(indices.begin(), indices.end(), std::mt19937{7});
+        const auto instanceCount = static_cast<uint32_t>(indices.size());
+
+        const glm::mat4 projection = glm::perspective(glm::radians(50.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+        const glm::mat4 view =
+                glm::lookAt(glm::vec3(1.0f, -2.0f, -5.0f), glm::vec3(0.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+        const glm::mat4 projectionView = projection * view;
+
+        // stride 大于一个实例, 检查每个实例之后的填充不被写入
+        constexpr size_t stride = GolaMatrixKernel::INSTANCE_FLOATS * sizeof(float) + 16;
+        constexpr uint8_t PADDING_BYTE = 0xCD;
+        for (auto impl: availableImplementations()) {
+            std::vector<std::byte> output(stride * instanceCount, std::byte{PADDING_BYTE});
+            GolaMatrixKernel{}.writeInstances(projectionView, objects.data(), indices.data(), instanceCount,
+                                              output.data(), stride, impl);
+
+            float maxError = 0.0f;
+            bool colorsMatch = true;
+            bool paddingUntouched = true;
+            for (uint32_t i = 0; i < instanceCount; i++) {
+                const std::byte *instance = output.data() + stride * i;
+                glm::mat4 matrix;
+                glm::vec4 color;
+                std::memcpy(&matrix, instance, sizeof(matrix));
+                std::memcpy(&color, instance + sizeof(matrix), sizeof(color));
+
+                const RenderObject &object = objects[indices[i]];
+                maxError = std::max(maxError, relativeError(matrix, projectionView * object.transform->mat4()));
+                colorsMatch &= color == glm::vec4(object.color, 1.0f);
+                for (size_t byte = GolaMatrixKernel::INSTANCE_FLOATS * sizeof(float); byte < stride; byte++) {
+                    paddingUntouched &= instance[byte] == std::byte{PADDING_BYTE};
+                }
+            }
+            GOLA_CHECK(maxError <= MAX_RELATIVE_ERROR);
+            GOLA_CHECK(colorsMatch);
+            GOLA_CHECK(paddingUntouched);
+        }
+    }
+}
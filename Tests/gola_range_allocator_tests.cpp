@@ -0,0 +1,97 @@
+#include "gola_test.hpp"
+
+#include "../Engine/Core/gola_range_allocator.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace gola {
+    GOLA_TEST(range_allocator, allocations_are_aligned_and_disjoint) {
+        GolaRangeAllocator allocator{4096};
+        GOLA_CHECK(allocator.allocate(3) == 0);
+        // 对齐留下的 [3, 256) 仍是空闲区间, best-fit 会把之后放得下的小分配放进去
+        GOLA_CHECK(allocator.allocate(16, 256) == 256);
+        GOLA_CHECK(allocator.allocate(200) == 3);
+        GOLA_CHECK(allocator.getUsedBytes() == 219);
+
+        std::mt19937 rng{12345};
+        std::uniform_int_distribution<uint64_t> size{1, 300};
+        std::uniform_int_distribution<uint32_t> alignmentShift{0, 8};
+        GolaRangeAllocator randomAllocator{1 << 20};
+        std::vector<std::pair<uint64_t, uint64_t>> ranges;
+        bool aligned = true;
+        for (int i = 0; i < 2'000; i++) {
+            const uint64_t alignment = uint64_t{1} << alignmentShift(rng);
+            const uint64_t rangeSize = size(rng);
+            const uint64_t offset = randomAllocator.allocate(rangeSize, alignment);
+            GOLA_CHECK(offset != GolaRangeAllocator::INVALID_OFFSET);
+            aligned &= offset % alignment == 0;
+            ranges.emplace_back(offset, rangeSize);
+        }
+        GOLA_CHECK(aligned);
+
+        std::sort(ranges.begin(), ranges.end());
+        bool disjoint = true;
+        for (size_t i = 1; i < ranges.size(); i++) {
+            disjoint &= ranges[i - 1].first + ranges[i - 1].second <= ranges[i].first;
+        }
+        GOLA_CHECK(disjoint);
+        GOLA_CHECK(ranges.back().first + ranges.back().second <= randomAllocator.getCapacity());
+    }
+
+    GOLA_TEST(range_allocator, adjacent_free_ranges_coalesce_in_any_order) {
+        constexpr uint64_t rangeSize = 100;
+        std::array<int, 3> order{0, 1, 2};
+        // 三个相邻区间的全部 6 种释放顺序, 覆盖只与前一个, 只与后一个, 同时与两侧合并
+        do {
+            GolaRangeAllocator allocator{rangeSize * 3};
+            std::array<uint64_t, 3> offsets{};
+            for (auto &offset: offsets) {
+                offset = allocator.allocate(rangeSize);
+            }
+            GOLA_CHECK(allocator.getFreeRangeCount() == 0);
+
+            for (int freed = 0; freed < 3; freed++) {
+                allocator.free(offsets[order[freed]], rangeSize);
+            }
+            GOLA_CHECK(allocator.isEmpty());
+            GOLA_CHECK(allocator.getFreeRangeCount() == 1);
+            GOLA_CHECK(allocator.getLargestFreeRange() == rangeSize * 3);
+            GOLA_CHECK(allocator.allocate(rangeSize * 3) == 0);
+        } while (std::next_permutation(order.begin(), order.end()));
+
+        // 不相邻的区间不合并
+        GolaRangeAllocator allocator{rangeSize * 3};
+        const uint64_t first = allocator.allocate(rangeSize);
+        allocator.allocate(rangeSize);
+        const uint64_t third = allocator.allocate(rangeSize);
+        allocator.free(first, rangeSize);
+        allocator.free(third, rangeSize);
+        GOLA_CHECK(allocator.getFreeRangeCount() == 2);
+        GOLA_CHECK(allocator.getLargestFreeRange() == rangeSize);
+    }
+
+    GOLA_TEST(range_allocator, allocation_fails_when_nothing_fits) {
+        GolaRangeAllocator allocator{256};
+        GOLA_CHECK(allocator.allocate(256) == 0);
+        GOLA_CHECK(allocator.allocate(1) == GolaRangeAllocator::INVALID_OFFSET);
+        allocator.free(0, 256);
+
+        // 空闲的总字节数足够, 但没有一个区间放得下
+        GOLA_CHECK(allocator.allocate(100) == 0);
+        GOLA_CHECK(allocator.allocate(100, 128) == 128);
+        GOLA_CHECK(allocator.getFreeRangeCount() == 2);
+        GOLA_CHECK(allocator.allocate(56) == GolaRangeAllocator::INVALID_OFFSET);
+        // 放得下大小但放不下对齐
+        GOLA_CHECK(allocator.allocate(16, 64) == GolaRangeAllocator::INVALID_OFFSET);
+        GOLA_CHECK(allocator.getUsedBytes() == 200);
+        GOLA_CHECK(allocator.allocate(28) != GolaRangeAllocator::INVALID_OFFSET);
+
+        GolaRangeAllocator empty{};
+        GOLA_CHECK(empty.allocate(1) == GolaRangeAllocator::INVALID_OFFSET);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gola::test {
+    /*
+     * 无窗口, 无 GPU 的单元测试. 每个测试用 GOLA_TEST(suite, name) 注册, GolaTests <suite> 运行一个 suite
+     * (CTest 为每个 suite 注册一个测试), 不带参数时运行全部. GOLA_CHECK 失败时记录位置并继续执行,
+     * 有任何失败时进程返回 1.
+     */
+    struct TestCase {
+        const char *suite;
+        const char *name;
+        void (*function)();
+    };
+
+    std::vector<TestCase> &registry();
+
+    struct Registrar {
+        Registrar(const char *suite, const char *name, void (*function)()) {
+            registry().push_back({suite, name, function});
+        }
+    };
+
+    void reportFailure(const char *file, int line, const std::string &expression);
+}
+
+#define GOLA_TEST(suite, name)                                                                                     \
+    static void suite##_##name();                                                                                  \
+    static gola::test::Registrar suite##_##name##Registrar{#suite, #name, &suite##_##name};                        \
+    static void suite##_##name()
+
+#define GOLA_CHECK(condition)                                                                                      \
+    do {                                                                                                           \
+        if (!(condition)) {                                                                                        \
+            gola::test::reportFailure(__FILE__, __LINE__, #condition);                                             \
+        }                                                                                                          \
+    } while (false)
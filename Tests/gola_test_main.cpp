@@ -0,0 +1,48 @@
+#include "gola_test.hpp"
+
+#include "../Engine/Core/gola_job_system.hpp"
+
+// std
+#include <cstring>
+#include <print>
+
+namespace gola::test {
+    static uint32_t failureCount = 0;
+
+    std::vector<TestCase> &registry() {
+        static std::vector<TestCase> testCases;
+        return testCases;
+    }
+
+    void reportFailure(const char *file, int line, const std::string &expression) {
+        std::print(stderr, "{}:{}: check failed: {}\n", file, line, expression);
+        failureCount++;
+    }
+}
+
+int main(int argc, char **argv) {
+    using namespace gola::test;
+
+    // 第一个调用 get() 的线程被视为任务系统的主线程
+    gola::GolaJobSystem::get();
+
+    const char *suite = argc > 1 ? argv[1] : nullptr;
+    uint32_t testCount = 0;
+    for (const TestCase &testCase: registry()) {
+        if (suite != nullptr && std::strcmp(suite, testCase.suite) != 0) {
+            continue;
+        }
+        const uint32_t failuresBefore = failureCount;
+        testCase.function();
+        std::print("[{}] {}.{}\n", failureCount == failuresBefore ? "  OK  " : "FAILED", testCase.suite,
+                   testCase.name);
+        testCount++;
+    }
+
+    if (testCount == 0) {
+        std::print(stderr, "no tests in suite {}\n", suite ? suite : "(all)");
+        return 1;
+    }
+    std::print("{} tests, {} failed checks\n", testCount, failureCount);
+    return failureCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+#include "gola_test.hpp"
+
+#include "../Engine/Core/gola_transform_system.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace gola {
+    // 与 matrix_kernel 测试相同: SIMD 结果与标量计算的差异相对于矩阵中绝对值最大的元素
+    static constexpr float MAX_RELATIVE_ERROR = 1e-5f;
+
+    static float maxRelativeError(const glm::mat4 &actual, const glm::mat4 &expected) {
+        float magnitude = 1.0f;
+        float error = 0.0f;
+        for (int column = 0; column < 4; column++) {
+            for (int row = 0; row < 4; row++) {
+                magnitude = std::max(magnitude, std::abs(expected[column][row]));
+                error = std::max(error, std::abs(actual[column][row] - expected[column][row]));
+            }
+        }
+        return error / magnitude;
+    }
+
+    static std::vector<GolaEntity> createEntities(GolaWorld &world, uint32_t count, std::mt19937 &rng) {
+        std::uniform_real_distribution<float> position{-100.0f, 100.0f};
+        std::uniform_real_distribution<float> angle{-10.0f, 10.0f};
+        std::uniform_real_distribution<float> scale{0.1f, 2.0f};
+        std::vector<GolaEntity> entities;
+        for (uint32_t i = 0; i < count; i++) {
+            Transform transform{};
+            transform.setTranslation(glm::vec3(position(rng), position(rng), position(rng)));
+            transform.setRotation(glm::vec3(angle(rng), angle(rng), angle(rng)));
+            transform.setScale(glm::vec3(scale(rng), scale(rng), scale(rng)));
+            entities.push_back(world.createEntity(transform));
+        }
+        return entities;
+    }
+
+    // 每个实体缓存的矩阵与重新计算的结果之间的最大误差
+    static float cachedMatrixError(GolaWorld &world) {
+        float maxError = 0.0f;
+        world.each<Transform>([&](GolaEntity, Transform &transform) {
+            Transform recomputed = transform;
+            recomputed.updateMatrix();
+            maxError = std::max(maxError, maxRelativeError(transform.mat4(), recomputed.mat4()));
+        });
+        return maxError;
+    }
+
+    GOLA_TEST(transform_system, only_changed_entities_are_reported) {
+        std::mt19937 rng{12345};
+        GolaWorld world{};
+        const std::vector<GolaEntity> entities = createEntities(world, 1'000, rng);
+        GolaTransformSystem transformSystem{};
+        std::vector<GolaEntity> changedEntities;
+
+        // 新实体在第一次更新时都算作修改过
+        transformSystem.update(world, changedEntities);
+        GOLA_CHECK(changedEntities.size() == entities.size());
+        transformSystem.update(world, changedEntities);
+        GOLA_CHECK(changedEntities.empty());
+
+        // 每 10 个修改一个; 用相同的值调用 setter 不算修改
+        std::vector<GolaEntity> expected;
+        for (uint32_t i = 0; i < entities.size(); i++) {
+            Transform *transform = world.getComponent<Transform>(entities[i]);
+            if (i % 10 == 0) {
+                transform->setTranslation(transform->getTranslation() + glm::vec3(1.0f, 0.0f, 0.0f));
+                expected.push_back(entities[i]);
+            } else {
+                transform->setRotation(transform->getRotation());
+            }
+        }
+        transformSystem.update(world, changedEntities);
+        // 按遍历顺序上报, 与创建顺序不一定相同
+        auto byIndex = [](GolaEntity a, GolaEntity b) { return a.index < b.index; };
+        std::sort(changedEntities.begin(), changedEntities.end(), byIndex);
+        std::sort(expected.begin(), expected.end(), byIndex);
+        GOLA_CHECK(changedEntities == expected);
+        GOLA_CHECK(cachedMatrixError(world) <= MAX_RELATIVE_ERROR);
+
+        transformSystem.update(world, changedEntities);
+        GOLA_CHECK(changedEntities.empty());
+    }
+
+    GOLA_TEST(transform_system, changed_matrices_match_update_matrix) {
+        // 超过 PARALLEL_THRESHOLD, 有多个工作线程时分块并行计算; 不是 SIMD 宽度的倍数
+        constexpr uint32_t entityCount = GolaTransformSystem::PARALLEL_THRESHOLD * 3 + 5;
+        std::mt19937 rng{54321};
+        GolaWorld world{};
+        createEntities(world, entityCount, rng);
+        GolaTransformSystem transformSystem{};
+        std::vector<GolaEntity> changedEntities;
+
+        transformSystem.update(world, changedEntities);
+        GOLA_CHECK(changedEntities.size() == entityCount);
+        GOLA_CHECK(cachedMatrixError(world) <= MAX_RELATIVE_ERROR);
+
+        // 所有实体旋转一次, 矩阵重新计算
+        world.each<Transform>([](GolaEntity, Transform &transform) {
+            const glm::vec3 rotation = transform.getRotation();
+            transform.setRotation(glm::vec3(rotation.x, rotation.y + 0.5f, rotation.z));
+        });
+        transformSystem.update(world, changedEntities);
+        GOLA_CHECK(changedEntities.size() == entityCount);
+        GOLA_CHECK(cachedMatrixError(world) <= MAX_RELATIVE_ERROR);
+    }
+}